@@ -30,6 +30,10 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <assert.h>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define TMAP_BWT_OCC_LINE_X86
+#endif
 
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
@@ -48,11 +52,69 @@ tmap_bwt_get_hash_length(uint64_t i)
   return ((uint64_t)1) << (i << 1); // 4^{hash_width} entries
 }
 
+// the number of bytes in the file before the bwt string
+#define TMAP_BWT_FILE_HEADER_SIZE (sizeof(uint32_t) + sizeof(int32_t) + 8*sizeof(tmap_bwt_int_t))
+
+// the occurrence interval as stored, with the cache-line layout in its lowest bit, the 32-bit hash in the next,
+// and the 32-bit occurrences in the next
+#define tmap_bwt_get_occ_interval_stored(_bwt) ((_bwt)->occ_interval \
+                                                | ((TMAP_BWT_OCC_LAYOUT_LINE == (_bwt)->occ_layout) ? 1 : 0) \
+                                                | ((32 == (_bwt)->int_width) ? 2 : 0) \
+                                                | ((32 == (_bwt)->occ_int_width) ? 4 : 0))
+
+// the number of bytes in an occurrence hash entry
+#define tmap_bwt_get_hash_int_size(_bwt) ((32 == (_bwt)->int_width) ? sizeof(uint32_t) : sizeof(tmap_bwt_int_t))
+
+// the number of bytes preceding the bwt string so that the cache lines are aligned
+#define tmap_bwt_get_line_padding(_bwt, _offset) \
+  ((TMAP_BWT_OCC_LAYOUT_LINE == (_bwt)->occ_layout) ? ((TMAP_BWT_OCC_LINE_ALIGN - ((_offset) % TMAP_BWT_OCC_LINE_ALIGN)) % TMAP_BWT_OCC_LINE_ALIGN) : 0)
+
+static inline void
+tmap_bwt_set_occ_interval_stored(tmap_bwt_t *bwt)
+{
+  if(2 == (bwt->occ_interval & 2)) {
+      bwt->int_width = 32;
+      bwt->occ_interval &= ~((tmap_bwt_int_t)2);
+  }
+  else {
+      bwt->int_width = 64;
+  }
+  if(4 == (bwt->occ_interval & 4)) {
+      bwt->occ_int_width = 32;
+      bwt->occ_interval &= ~((tmap_bwt_int_t)4);
+  }
+  else {
+      bwt->occ_int_width = 64;
+  }
+  if(1 == (bwt->occ_interval & 1)) {
+      bwt->occ_layout = TMAP_BWT_OCC_LAYOUT_LINE;
+      bwt->occ_interval &= ~((tmap_bwt_int_t)1);
+      if(TMAP_BWT_OCC_LINE_INTERVAL != bwt->occ_interval || 32 == bwt->occ_int_width) {
+          tmap_error("BWT interval not supported", Exit, OutOfRange);
+      }
+  }
+  else {
+      bwt->occ_layout = TMAP_BWT_OCC_LAYOUT_PACKED;
+  }
+  // the remaining low bits are reserved
+  if(0 == bwt->occ_interval || 0 != (bwt->occ_interval % TMAP_BWT_OCC_MOD)) {
+      tmap_error("unsupported index format (unknown BWT header flags)", Exit, OutOfRange);
+  }
+}
+
 static inline void
 tmap_bwt_update_optimizations(tmap_bwt_t *bwt)
 {
   bwt->occ_interval_log2 = tmap_log2(bwt->occ_interval);
-  bwt->occ_array_16_pt2 = (bwt->occ_interval/(sizeof(uint32_t)<<3>>1) + (sizeof(tmap_bwt_int_t)>>2<<2));
+  if(TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout) {
+      bwt->occ_array_16_pt2 = TMAP_BWT_OCC_LINE_WORDS; // so tmap_bwt_occ_intv is the start of the cache line
+      bwt->occ_cnt_words = sizeof(tmap_bwt_int_t);
+      tmap_bwt_set_occ_simd(bwt, TMAP_BWT_OCC_SIMD_AVX2);
+  }
+  else {
+      bwt->occ_cnt_words = (32 == bwt->occ_int_width) ? 4 : (sizeof(tmap_bwt_int_t)>>2<<2);
+      bwt->occ_array_16_pt2 = (bwt->occ_interval/(sizeof(uint32_t)<<3>>1) + bwt->occ_cnt_words);
+  }
 }
 
 tmap_bwt_t *
@@ -76,30 +138,43 @@ tmap_bwt_read(const char *fn_fasta)
       tmap_error("version id did not match", Exit, ReadFileError);
   }
 
-  bwt->bwt = tmap_calloc(bwt->bwt_size, sizeof(tmap_bwt_int_t), "bwt->bwt");
-
   if(1 != tmap_file_fread(&bwt->hash_width, sizeof(int32_t), 1, fp_bwt)
      || 1 != tmap_file_fread(&bwt->primary, sizeof(tmap_bwt_int_t), 1, fp_bwt)
      || 4 != tmap_file_fread(bwt->L2+1, sizeof(tmap_bwt_int_t), 4, fp_bwt)
      || 1 != tmap_file_fread(&bwt->occ_interval, sizeof(tmap_bwt_int_t), 1, fp_bwt)
-     || 1 != tmap_file_fread(&bwt->seq_len, sizeof(tmap_bwt_int_t), 1, fp_bwt)
-     || bwt->bwt_size != tmap_file_fread(bwt->bwt, sizeof(uint32_t), bwt->bwt_size, fp_bwt)) {
+     || 1 != tmap_file_fread(&bwt->seq_len, sizeof(tmap_bwt_int_t), 1, fp_bwt)) {
       tmap_error(NULL, Exit, ReadFileError);
   }
+  tmap_bwt_set_occ_interval_stored(bwt);
   if(0 != (bwt->occ_interval % 2)) {
       tmap_error("BWT interval not supported", Exit, OutOfRange);
   }
 
+  if(TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout) {
+      uint8_t pad[TMAP_BWT_OCC_LINE_ALIGN];
+      size_t pad_len = tmap_bwt_get_line_padding(bwt, TMAP_BWT_FILE_HEADER_SIZE);
+      if(pad_len != tmap_file_fread(pad, sizeof(uint8_t), pad_len, fp_bwt)) {
+          tmap_error(NULL, Exit, ReadFileError);
+      }
+      bwt->bwt = tmap_memalign(TMAP_BWT_OCC_LINE_ALIGN, bwt->bwt_size * sizeof(uint32_t), "bwt->bwt");
+  }
+  else {
+      bwt->bwt = tmap_calloc(bwt->bwt_size, sizeof(tmap_bwt_int_t), "bwt->bwt");
+  }
+  if(bwt->bwt_size != tmap_file_fread(bwt->bwt, sizeof(uint32_t), bwt->bwt_size, fp_bwt)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+
   if(0 < bwt->hash_width) {
       uint32_t i;
       bwt->hash_k = tmap_malloc(bwt->hash_width*sizeof(tmap_bwt_int_t*), "bwt->hash_k");
       bwt->hash_l = tmap_malloc(bwt->hash_width*sizeof(tmap_bwt_int_t*), "bwt->hash_l");
       for(i=1;i<=bwt->hash_width;i++) {
           uint64_t hash_length = tmap_bwt_get_hash_length(i);
-          bwt->hash_k[i-1] = tmap_malloc(hash_length*sizeof(tmap_bwt_int_t), "bwt->hash_k[i-1]");
-          bwt->hash_l[i-1] = tmap_malloc(hash_length*sizeof(tmap_bwt_int_t), "bwt->hash_l[i-1]");
-          if(hash_length != tmap_file_fread(bwt->hash_k[i-1], sizeof(tmap_bwt_int_t), hash_length, fp_bwt)
-             || hash_length != tmap_file_fread(bwt->hash_l[i-1], sizeof(tmap_bwt_int_t), hash_length, fp_bwt)) {
+          bwt->hash_k[i-1] = tmap_malloc(hash_length*tmap_bwt_get_hash_int_size(bwt), "bwt->hash_k[i-1]");
+          bwt->hash_l[i-1] = tmap_malloc(hash_length*tmap_bwt_get_hash_int_size(bwt), "bwt->hash_l[i-1]");
+          if(hash_length != tmap_file_fread(bwt->hash_k[i-1], tmap_bwt_get_hash_int_size(bwt), hash_length, fp_bwt)
+             || hash_length != tmap_file_fread(bwt->hash_l[i-1], tmap_bwt_get_hash_int_size(bwt), hash_length, fp_bwt)) {
               tmap_error(NULL, Exit, ReadFileError);
           }
       }
@@ -120,22 +195,101 @@ tmap_bwt_read(const char *fn_fasta)
   return bwt;
 }
 
+tmap_bwt_t *
+tmap_bwt_mmap(const char *fn_fasta, int32_t populate)
+{
+  tmap_bwt_t *bwt = NULL;
+  char *fn_bwt = NULL;
+  uint8_t *buf = NULL;
+  size_t n;
+  uint32_t i;
+
+  fn_bwt = tmap_get_file_name(fn_fasta, TMAP_BWT_FILE);
+
+  bwt = tmap_calloc(1, sizeof(tmap_bwt_t), "bwt");
+  bwt->mmap_buf = buf = tmap_file_mmap(fn_bwt, &bwt->mmap_len, populate);
+
+  // fixed length data, in the order written by tmap_bwt_write
+  n = TMAP_BWT_FILE_HEADER_SIZE;
+  if(bwt->mmap_len < n) {
+      tmap_error(fn_bwt, Exit, ReadFileError);
+  }
+  memcpy(&bwt->version_id, buf, sizeof(uint32_t)); buf += sizeof(uint32_t);
+  memcpy(&bwt->bwt_size, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(&bwt->hash_width, buf, sizeof(int32_t)); buf += sizeof(int32_t);
+  memcpy(&bwt->primary, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(bwt->L2+1, buf, 4*sizeof(tmap_bwt_int_t)); buf += 4*sizeof(tmap_bwt_int_t);
+  memcpy(&bwt->occ_interval, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(&bwt->seq_len, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+
+  if(bwt->version_id != TMAP_VERSION_ID) {
+      tmap_error("version id did not match", Exit, ReadFileError);
+  }
+  tmap_bwt_set_occ_interval_stored(bwt);
+  if(0 != (bwt->occ_interval % 2)) {
+      tmap_error("BWT interval not supported", Exit, OutOfRange);
+  }
+
+  // variable length data, used in place
+  i = tmap_bwt_get_line_padding(bwt, n); // the mapping is page aligned
+  buf += i;
+  n += i + bwt->bwt_size*sizeof(uint32_t);
+  for(i=1;0 < bwt->hash_width && i<=bwt->hash_width;i++) {
+      n += 2*tmap_bwt_get_hash_length(i)*tmap_bwt_get_hash_int_size(bwt);
+  }
+  if(bwt->mmap_len < n) {
+      tmap_error(fn_bwt, Exit, ReadFileError);
+  }
+  bwt->bwt = (uint32_t*)buf; buf += bwt->bwt_size*sizeof(uint32_t);
+  if(0 < bwt->hash_width) {
+      bwt->hash_k = tmap_calloc(bwt->hash_width, sizeof(tmap_bwt_int_t*), "bwt->hash_k");
+      bwt->hash_l = tmap_calloc(bwt->hash_width, sizeof(tmap_bwt_int_t*), "bwt->hash_l");
+      for(i=1;i<=bwt->hash_width;i++) {
+          uint64_t hash_length = tmap_bwt_get_hash_length(i);
+          bwt->hash_k[i-1] = (tmap_bwt_int_t*)buf; buf += hash_length*tmap_bwt_get_hash_int_size(bwt);
+          bwt->hash_l[i-1] = (tmap_bwt_int_t*)buf; buf += hash_length*tmap_bwt_get_hash_int_size(bwt);
+      }
+  }
+  else {
+      bwt->hash_k = bwt->hash_l = NULL;
+  }
+
+  tmap_bwt_gen_cnt_table(bwt);
+
+  free(fn_bwt);
+
+  bwt->is_shm = 0;
+
+  tmap_bwt_update_optimizations(bwt);
+
+  return bwt;
+}
+
 void 
 tmap_bwt_write(const char *fn_fasta, tmap_bwt_t *bwt)
 {
   char *fn_bwt = NULL;
   tmap_file_t *fp_bwt = NULL;
 
+  uint8_t pad[TMAP_BWT_OCC_LINE_ALIGN];
+  size_t pad_len;
+  tmap_bwt_int_t occ_interval;
+
   fn_bwt = tmap_get_file_name(fn_fasta, TMAP_BWT_FILE);
   fp_bwt = tmap_file_fopen(fn_bwt, "wb", TMAP_BWT_COMPRESSION);
 
+  occ_interval = tmap_bwt_get_occ_interval_stored(bwt);
+  pad_len = tmap_bwt_get_line_padding(bwt, TMAP_BWT_FILE_HEADER_SIZE);
+  memset(pad, 0, TMAP_BWT_OCC_LINE_ALIGN);
+
   if(1 != tmap_file_fwrite(&bwt->version_id, sizeof(uint32_t), 1, fp_bwt)
      || 1 != tmap_file_fwrite(&bwt->bwt_size, sizeof(tmap_bwt_int_t), 1, fp_bwt)
      || 1 != tmap_file_fwrite(&bwt->hash_width, sizeof(int32_t), 1, fp_bwt)
      || 1 != tmap_file_fwrite(&bwt->primary, sizeof(tmap_bwt_int_t), 1, fp_bwt) 
      || 4 != tmap_file_fwrite(bwt->L2+1, sizeof(tmap_bwt_int_t), 4, fp_bwt)
-     || 1 != tmap_file_fwrite(&bwt->occ_interval, sizeof(tmap_bwt_int_t), 1, fp_bwt)
+     || 1 != tmap_file_fwrite(&occ_interval, sizeof(tmap_bwt_int_t), 1, fp_bwt)
      || 1 != tmap_file_fwrite(&bwt->seq_len, sizeof(tmap_bwt_int_t), 1, fp_bwt)
+     || pad_len != tmap_file_fwrite(pad, sizeof(uint8_t), pad_len, fp_bwt)
      || bwt->bwt_size != tmap_file_fwrite(bwt->bwt, sizeof(uint32_t), bwt->bwt_size, fp_bwt)) {
       tmap_error(NULL, Exit, WriteFileError);
   }
@@ -143,8 +297,8 @@ tmap_bwt_write(const char *fn_fasta, tmap_bwt_t *bwt)
       uint32_t i;
       for(i=1;i<=bwt->hash_width;i++) {
           uint64_t hash_length = tmap_bwt_get_hash_length(i);
-          if(hash_length != tmap_file_fwrite(bwt->hash_k[i-1], sizeof(tmap_bwt_int_t), hash_length, fp_bwt)
-             || hash_length != tmap_file_fwrite(bwt->hash_l[i-1], sizeof(tmap_bwt_int_t), hash_length, fp_bwt)) {
+          if(hash_length != tmap_file_fwrite(bwt->hash_k[i-1], tmap_bwt_get_hash_int_size(bwt), hash_length, fp_bwt)
+             || hash_length != tmap_file_fwrite(bwt->hash_l[i-1], tmap_bwt_get_hash_int_size(bwt), hash_length, fp_bwt)) {
               tmap_error(NULL, Exit, WriteFileError);
           }
       }
@@ -209,11 +363,14 @@ tmap_bwt_shm_num_bytes(tmap_bwt_t *bwt)
   n += sizeof(int32_t); // hash_width
 
   //variable length data
+  if(TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout) {
+      n += TMAP_BWT_OCC_LINE_ALIGN; // to align the cache lines
+  }
   n += sizeof(uint32_t)*bwt->bwt_size; // bwt
   for(i=1;i<=bwt->hash_width;i++) {
       uint64_t hash_length = tmap_bwt_get_hash_length(i);
-      n += sizeof(tmap_bwt_int_t)*hash_length; // hash_k[i-1]
-      n += sizeof(tmap_bwt_int_t)*hash_length; // hash_l[i-1]
+      n += tmap_bwt_get_hash_int_size(bwt)*hash_length; // hash_k[i-1]
+      n += tmap_bwt_get_hash_int_size(bwt)*hash_length; // hash_l[i-1]
   }
 
   return n;
@@ -248,6 +405,7 @@ tmap_bwt_shm_read_num_bytes(const char *fn_fasta)
      || 1 != tmap_file_fread(&bwt->seq_len, sizeof(tmap_bwt_int_t), 1, fp_bwt)) {
       tmap_error(NULL, Exit, ReadFileError);
   }
+  tmap_bwt_set_occ_interval_stored(bwt);
 
   // No need to read in bwt->bwt, bwt->hash_k, bwt->hash_l
   bwt->bwt = NULL;
@@ -270,21 +428,23 @@ uint8_t *
 tmap_bwt_shm_pack(tmap_bwt_t *bwt, uint8_t *buf)
 {
   uint32_t i;
+  tmap_bwt_int_t occ_interval = tmap_bwt_get_occ_interval_stored(bwt);
   // fixed length data
   memcpy(buf, &bwt->version_id, sizeof(uint32_t)); buf += sizeof(uint32_t);
   memcpy(buf, &bwt->primary, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(buf, bwt->L2, 5*sizeof(tmap_bwt_int_t)); buf += 5*sizeof(tmap_bwt_int_t);
   memcpy(buf, &bwt->seq_len, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(buf, &bwt->bwt_size, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
-  memcpy(buf, &bwt->occ_interval, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(buf, &occ_interval, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(buf, bwt->cnt_table, 256*sizeof(uint32_t)); buf += 256*sizeof(uint32_t);
   memcpy(buf, &bwt->hash_width, sizeof(int32_t)); buf += sizeof(uint32_t);
   // variable length data
+  buf += tmap_bwt_get_line_padding(bwt, (uintptr_t)buf); // the shared memory is page aligned in every process
   memcpy(buf, bwt->bwt, bwt->bwt_size*sizeof(uint32_t)); buf += bwt->bwt_size*sizeof(uint32_t);
   for(i=1;i<=bwt->hash_width;i++) {
       uint64_t hash_length = tmap_bwt_get_hash_length(i);
-      memcpy(buf, bwt->hash_k[i-1], hash_length*sizeof(tmap_bwt_int_t)); buf += hash_length*sizeof(tmap_bwt_int_t);
-      memcpy(buf, bwt->hash_l[i-1], hash_length*sizeof(tmap_bwt_int_t)); buf += hash_length*sizeof(tmap_bwt_int_t);
+      memcpy(buf, bwt->hash_k[i-1], hash_length*tmap_bwt_get_hash_int_size(bwt)); buf += hash_length*tmap_bwt_get_hash_int_size(bwt);
+      memcpy(buf, bwt->hash_l[i-1], hash_length*tmap_bwt_get_hash_int_size(bwt)); buf += hash_length*tmap_bwt_get_hash_int_size(bwt);
   }
   return buf;
 }
@@ -308,17 +468,19 @@ tmap_bwt_shm_unpack(uint8_t *buf)
   memcpy(&bwt->occ_interval, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(bwt->cnt_table, buf, 256*sizeof(uint32_t)); buf += 256*sizeof(uint32_t);
   memcpy(&bwt->hash_width, buf, sizeof(int32_t)); buf += sizeof(uint32_t);
+  tmap_bwt_set_occ_interval_stored(bwt);
 
   // allocate memory 
   bwt->hash_k = tmap_calloc(bwt->hash_width, sizeof(tmap_bwt_int_t*), "bwt->hash_k");
   bwt->hash_l = tmap_calloc(bwt->hash_width, sizeof(tmap_bwt_int_t*), "bwt->hash_l");
 
   // variable length data
+  buf += tmap_bwt_get_line_padding(bwt, (uintptr_t)buf);
   bwt->bwt = (uint32_t*)buf; buf += bwt->bwt_size*sizeof(uint32_t);
   for(i=1;i<=bwt->hash_width;i++) {
       uint64_t hash_length = tmap_bwt_get_hash_length(i);
-      bwt->hash_k[i-1] = (tmap_bwt_int_t*)buf; buf += hash_length*sizeof(tmap_bwt_int_t);
-      bwt->hash_l[i-1] = (tmap_bwt_int_t*)buf; buf += hash_length*sizeof(tmap_bwt_int_t);
+      bwt->hash_k[i-1] = (tmap_bwt_int_t*)buf; buf += hash_length*tmap_bwt_get_hash_int_size(bwt);
+      bwt->hash_l[i-1] = (tmap_bwt_int_t*)buf; buf += hash_length*tmap_bwt_get_hash_int_size(bwt);
   }
 
   bwt->is_shm = 1;
@@ -333,9 +495,10 @@ tmap_bwt_destroy(tmap_bwt_t *bwt)
 {
   uint32_t i;
   if(bwt == NULL) return;
-  if(1 == bwt->is_shm) {
+  if(1 == bwt->is_shm || NULL != bwt->mmap_buf) {
       free(bwt->hash_k);
       free(bwt->hash_l);
+      tmap_file_munmap(bwt->mmap_buf, bwt->mmap_len);
       free(bwt);
   }
   else {
@@ -394,6 +557,78 @@ tmap_bwt_update_occ_interval(tmap_bwt_t *bwt, tmap_bwt_int_t occ_interval)
   tmap_bwt_update_optimizations(bwt);
 }
 
+void
+tmap_bwt_update_occ_int32(tmap_bwt_t *bwt)
+{
+  tmap_bwt_int_t i, j, n, n_bwt;
+  tmap_bwt_int_t c[4];
+
+  if(TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout || 32 == bwt->occ_int_width
+     || sizeof(uint32_t) == sizeof(tmap_bwt_int_t) || 32 != tmap_bwt_int_width(bwt->seq_len)) {
+      return; // already as narrow as possible, or will not fit
+  }
+
+  // compact the occurrences at the start of each interval in place
+  n_bwt = (bwt->seq_len + 15) >> 4; // the number of words of the 2-bit packed BWT string
+  i = j = 0;
+  while(1) {
+      memcpy(c, bwt->bwt + i, 4 * sizeof(tmap_bwt_int_t));
+      bwt->bwt[j] = c[0]; bwt->bwt[j+1] = c[1]; bwt->bwt[j+2] = c[2]; bwt->bwt[j+3] = c[3];
+      i += sizeof(tmap_bwt_int_t);
+      j += 4;
+      if(0 == n_bwt) break; // the last element
+      n = (n_bwt < (bwt->occ_interval >> 4)) ? n_bwt : (bwt->occ_interval >> 4);
+      memmove(bwt->bwt + j, bwt->bwt + i, n * sizeof(uint32_t));
+      i += n;
+      j += n;
+      n_bwt -= n;
+  }
+  if(i != bwt->bwt_size) {
+      tmap_error(NULL, Exit, OutOfRange);
+  }
+  bwt->bwt_size = j;
+  bwt->bwt = tmap_realloc(bwt->bwt, bwt->bwt_size * sizeof(uint32_t), "bwt->bwt");
+  bwt->occ_int_width = 32;
+  tmap_bwt_update_optimizations(bwt);
+}
+
+void 
+tmap_bwt_update_occ_line(tmap_bwt_t *bwt)
+{
+  tmap_bwt_int_t i, c[4], n_lines;
+  uint32_t *buf = NULL;
+  uint64_t *q = NULL;
+  uint32_t b;
+
+  if(1 != bwt->occ_interval) {
+      tmap_bug();
+  }
+
+  n_lines = (bwt->seq_len >> TMAP_BWT_OCC_LINE_INTERVAL_LOG2) + 1; // the last line stores the total occurrences
+  bwt->bwt_size = n_lines * TMAP_BWT_OCC_LINE_WORDS; // the new size
+  buf = tmap_memalign(TMAP_BWT_OCC_LINE_ALIGN, bwt->bwt_size * sizeof(uint32_t), "buf"); // will be the new bwt
+  memset(buf, 0, bwt->bwt_size * sizeof(uint32_t));
+  c[0] = c[1] = c[2] = c[3] = 0;
+  for(i = 0; i <= bwt->seq_len; ++i) {
+      // store the occurrences
+      if(0 == (i & (TMAP_BWT_OCC_LINE_INTERVAL - 1))) {
+          memcpy(buf + (i >> TMAP_BWT_OCC_LINE_INTERVAL_LOG2) * TMAP_BWT_OCC_LINE_WORDS, c, sizeof(tmap_bwt_int_t) * 4);
+      }
+      if(i == bwt->seq_len) break;
+      // store the base in the two bit-planes
+      q = (uint64_t*)(buf + (i >> TMAP_BWT_OCC_LINE_INTERVAL_LOG2) * TMAP_BWT_OCC_LINE_WORDS + TMAP_BWT_OCC_LINE_PLANES);
+      b = bwt_B00(bwt, i);
+      q[(i >> 6) & 1] |= (uint64_t)(b >> 1) << (i & 63);
+      q[2 + ((i >> 6) & 1)] |= (uint64_t)(b & 1) << (i & 63);
+      ++c[b];
+  }
+  // update bwt
+  free(bwt->bwt); bwt->bwt = buf;
+  bwt->occ_interval = TMAP_BWT_OCC_LINE_INTERVAL;
+  bwt->occ_layout = TMAP_BWT_OCC_LAYOUT_LINE;
+  tmap_bwt_update_optimizations(bwt);
+}
+
 void 
 tmap_bwt_gen_cnt_table(tmap_bwt_t *bwt)
 {
@@ -482,7 +717,7 @@ tmap_bwt_gen_hash_helper(tmap_bwt_t *bwt, uint32_t len)
 }
 
 void
-tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash)
+tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash, int32_t int_width)
 {
   int32_t i;
 
@@ -502,6 +737,7 @@ tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash)
   bwt->hash_l = tmap_malloc(sizeof(tmap_bwt_int_t*)*hash_width, "bwt->hash_l");
 
   bwt->hash_width = 0;
+  bwt->int_width = 64; // compacted below
   for(i=1;i<=hash_width;i++) {
       uint64_t hash_length = tmap_bwt_get_hash_length(i);
   
@@ -515,6 +751,16 @@ tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash)
       bwt->hash_width = i; // updated the hash width
   }
 
+  // store the SA intervals in 32 bits if asked and they fit
+  if(32 == int_width && sizeof(uint32_t) < sizeof(tmap_bwt_int_t) && 32 == tmap_bwt_int_width(bwt->seq_len)) {
+      for(i=1;i<=bwt->hash_width;i++) {
+          uint64_t hash_length = tmap_bwt_get_hash_length(i);
+          bwt->hash_k[i-1] = tmap_bwt_int_pack32(bwt->hash_k[i-1], hash_length);
+          bwt->hash_l[i-1] = tmap_bwt_int_pack32(bwt->hash_l[i-1], hash_length);
+      }
+      bwt->int_width = 32;
+  }
+
   // test the BWT hash
   if(1 == check_hash) {
       tmap_progress_print2("testing the BWT hash");
@@ -524,6 +770,143 @@ tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash)
   tmap_progress_print2("constructed the occurrence hash for the BWT string");
 }
 
+/**
+ * Cache-line layout
+ */
+
+// the bases of a cache line at or before the r-th base, within its first and second 64-bit words
+#define __occ_line_mask0(r) (((r) < 64) ? (~0ull >> (63 - (r))) : ~0ull)
+#define __occ_line_mask1(r) (((r) < 64) ? 0ull : (~0ull >> (127 - (r))))
+
+// the bases equal to c, given the high and low bit-planes
+#define __occ_line_match(h, l, c) ((((c)&2)? (h) : ~(h)) & (((c)&1)? (l) : ~(l)))
+
+static inline uint32_t
+__occ_line_popcount_swar(uint64_t y)
+{
+  // from http://graphics.stanford.edu/~seander/bithacks.html
+  y = y - ((y >> 1) & 0x5555555555555555ull);
+  y = (y & 0x3333333333333333ull) + ((y >> 2) & 0x3333333333333333ull);
+  return ((y + (y >> 4)) & 0x0f0f0f0f0f0f0f0full) * 0x101010101010101ull >> 56;
+}
+
+// NB: inlined into each instruction set below, so __builtin_popcountll becomes the hardware instruction where enabled
+#define __occ_line_popcount(y, hw) ((hw) ? (uint32_t)__builtin_popcountll(y) : __occ_line_popcount_swar(y))
+
+static inline __attribute__((always_inline)) uint32_t
+__occ_line_occ(const uint64_t *q, uint32_t r, uint8_t c, int32_t hw)
+{
+  return __occ_line_popcount(__occ_line_match(q[0], q[2], c) & __occ_line_mask0(r), hw)
+    + __occ_line_popcount(__occ_line_match(q[1], q[3], c) & __occ_line_mask1(r), hw);
+}
+
+static inline __attribute__((always_inline)) void
+__occ_line_occ4(const uint64_t *q, uint32_t r, tmap_bwt_int_t cnt[4], int32_t hw)
+{
+  uint64_t m0, m1;
+  uint32_t n1, n2, n3;
+  m0 = __occ_line_mask0(r);
+  m1 = __occ_line_mask1(r);
+  n1 = __occ_line_popcount(~q[0] & q[2] & m0, hw) + __occ_line_popcount(~q[1] & q[3] & m1, hw);
+  n2 = __occ_line_popcount(q[0] & ~q[2] & m0, hw) + __occ_line_popcount(q[1] & ~q[3] & m1, hw);
+  n3 = __occ_line_popcount(q[0] & q[2] & m0, hw) + __occ_line_popcount(q[1] & q[3] & m1, hw);
+  cnt[0] += r + 1 - n1 - n2 - n3; 
+  cnt[1] += n1; cnt[2] += n2; cnt[3] += n3;
+}
+
+static uint32_t
+tmap_bwt_occ_line_none(const uint64_t *q, uint32_t r, uint8_t c)
+{
+  return __occ_line_occ(q, r, c, 0);
+}
+
+static void
+tmap_bwt_occ4_line_none(const uint64_t *q, uint32_t r, tmap_bwt_int_t cnt[4])
+{
+  __occ_line_occ4(q, r, cnt, 0);
+}
+
+#ifdef TMAP_BWT_OCC_LINE_X86
+__attribute__((target("sse4.2,popcnt"))) static uint32_t
+tmap_bwt_occ_line_sse42(const uint64_t *q, uint32_t r, uint8_t c)
+{
+  return __occ_line_occ(q, r, c, 1);
+}
+
+__attribute__((target("sse4.2,popcnt"))) static void
+tmap_bwt_occ4_line_sse42(const uint64_t *q, uint32_t r, tmap_bwt_int_t cnt[4])
+{
+  __occ_line_occ4(q, r, cnt, 1);
+}
+
+__attribute__((target("avx2"))) static void
+tmap_bwt_occ4_line_avx2(const uint64_t *q, uint32_t r, tmap_bwt_int_t cnt[4])
+{
+  __m256i h, l, m, x, y, lut, nib;
+  // the bases as (~l, l) and (h, h) in the two lanes, masked to those at or before r
+  h = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)q));
+  l = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)(q + 2)));
+  l = _mm256_xor_si256(l, _mm256_set_epi64x(0, 0, -1, -1));
+  m = _mm256_set_epi64x(__occ_line_mask1(r), __occ_line_mask0(r), __occ_line_mask1(r), __occ_line_mask0(r));
+  x = _mm256_and_si256(_mm256_andnot_si256(h, l), m); // bases 0 and 1
+  y = _mm256_and_si256(_mm256_and_si256(h, l), m); // bases 2 and 3
+  // count the bits in each 64-bit word with nibble look-ups
+  lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  nib = _mm256_set1_epi8(0x0f);
+  x = _mm256_sad_epu8(_mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(x, nib)),
+                                      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), nib))),
+                      _mm256_setzero_si256());
+  y = _mm256_sad_epu8(_mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(y, nib)),
+                                      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(y, 4), nib))),
+                      _mm256_setzero_si256());
+  // add the two words of each base
+  x = _mm256_add_epi64(x, _mm256_srli_si256(x, 8));
+  y = _mm256_add_epi64(y, _mm256_srli_si256(y, 8));
+  cnt[0] += _mm256_extract_epi64(x, 0); cnt[1] += _mm256_extract_epi64(x, 2);
+  cnt[2] += _mm256_extract_epi64(y, 0); cnt[3] += _mm256_extract_epi64(y, 2);
+}
+#endif
+
+int32_t
+tmap_bwt_set_occ_simd(tmap_bwt_t *bwt, int32_t simd)
+{
+  bwt->occ_simd = TMAP_BWT_OCC_SIMD_NONE;
+  bwt->occ_line = tmap_bwt_occ_line_none;
+  bwt->occ4_line = tmap_bwt_occ4_line_none;
+#ifdef TMAP_BWT_OCC_LINE_X86
+  __builtin_cpu_init();
+  if(TMAP_BWT_OCC_SIMD_SSE42 <= simd && __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+      bwt->occ_simd = TMAP_BWT_OCC_SIMD_SSE42;
+      bwt->occ_line = tmap_bwt_occ_line_sse42;
+      bwt->occ4_line = tmap_bwt_occ4_line_sse42;
+      if(TMAP_BWT_OCC_SIMD_AVX2 <= simd && __builtin_cpu_supports("avx2")) {
+          // NB: a single base is still counted fastest with two hardware popcounts
+          bwt->occ_simd = TMAP_BWT_OCC_SIMD_AVX2;
+          bwt->occ4_line = tmap_bwt_occ4_line_avx2;
+      }
+  }
+#endif
+  return bwt->occ_simd;
+}
+
+const char *
+tmap_bwt_occ_layout_name(const tmap_bwt_t *bwt)
+{
+  if(TMAP_BWT_OCC_LAYOUT_LINE != bwt->occ_layout) {
+      return "packed";
+  }
+  switch(bwt->occ_simd) {
+    case TMAP_BWT_OCC_SIMD_AVX2:
+      return "cache line (AVX2)";
+    case TMAP_BWT_OCC_SIMD_SSE42:
+      return "cache line (SSE4.2)";
+    default:
+      break;
+  }
+  return "cache line (scalar)";
+}
+
 /**
  * Main BWT API
  */
@@ -561,8 +944,11 @@ tmap_bwt_occ(const tmap_bwt_t *bwt, tmap_bwt_int_t k, uint8_t c)
   if(k >= bwt->primary) --k; // because $ is not in bwt
 
   // retrieve Occ at k/bwt->occ_interval
-  n = ((tmap_bwt_int_t*)(p = tmap_bwt_occ_intv(bwt, k)))[c];
-  p += sizeof(tmap_bwt_int_t); // jump to the start of the first BWT cell
+  n = tmap_bwt_get_occ_cnt(bwt, (p = tmap_bwt_occ_intv(bwt, k)), c);
+  if(TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout) {
+      return n + bwt->occ_line((const uint64_t*)(p + TMAP_BWT_OCC_LINE_PLANES), k & (TMAP_BWT_OCC_LINE_INTERVAL - 1), c);
+  }
+  p += bwt->occ_cnt_words; // jump to the start of the first BWT cell
 
 #ifndef TMAP_BWT_BY_16
   j = k >> 4 << 4; // divide by 16, then multiply by 16, to subtract k % 16.
@@ -597,7 +983,8 @@ tmap_bwt_2occ_orig(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, ui
   }
   _k = (k >= bwt->primary)? k-1 : k;
   _l = (l >= bwt->primary)? l-1 : l;
-  if((_l >> bwt->occ_interval_log2) != (_k >> bwt->occ_interval_log2) || TMAP_BWT_INT_MAX == k || TMAP_BWT_INT_MAX == l) {
+  if((_l >> bwt->occ_interval_log2) != (_k >> bwt->occ_interval_log2) || TMAP_BWT_INT_MAX == k || TMAP_BWT_INT_MAX == l
+     || TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout) { // NB: the second look-up is in the same cache line
       if(l == TMAP_BWT_INT_MAX) k = TMAP_BWT_INT_MAX; 
       *ok = tmap_bwt_occ(bwt, k, c);
       *ol = tmap_bwt_occ(bwt, l, c);
@@ -606,8 +993,8 @@ tmap_bwt_2occ_orig(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, ui
       uint32_t *p;
       k = _k;
       l = _l;
-      n = ((tmap_bwt_int_t*)(p = tmap_bwt_occ_intv(bwt, k)))[c];
-      p += sizeof(tmap_bwt_int_t);
+      n = tmap_bwt_get_occ_cnt(bwt, (p = tmap_bwt_occ_intv(bwt, k)), c);
+      p += bwt->occ_cnt_words;
       // calculate *ok
 #ifndef TMAP_BWT_BY_16
       j = k >> 4 << 4; // divide by 16, then multiply by 16, to subtract k % 16.
@@ -744,8 +1131,12 @@ tmap_bwt_occ4(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t cnt[4])
   }
   if(k >= bwt->primary) --k; // because $ is not in bwt
   p = tmap_bwt_occ_intv(bwt, k);
-  memcpy(cnt, p, 4 * sizeof(tmap_bwt_int_t));
-  p += sizeof(tmap_bwt_int_t); // move to the first bwt cell
+  tmap_bwt_get_occ_cnt4(bwt, p, cnt);
+  if(TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout) {
+      bwt->occ4_line((const uint64_t*)(p + TMAP_BWT_OCC_LINE_PLANES), k & (TMAP_BWT_OCC_LINE_INTERVAL - 1), cnt);
+      return;
+  }
+  p += bwt->occ_cnt_words; // move to the first bwt cell
 
 #ifndef TMAP_BWT_BY_16
   j = (k >> 4) << 4;
@@ -778,7 +1169,8 @@ tmap_bwt_2occ4(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, tmap_b
   }
   _k = (k >= bwt->primary)? k-1 : k;
   _l = (l >= bwt->primary)? l-1 : l;
-  if((_l >> bwt->occ_interval_log2) != (_k >> bwt->occ_interval_log2) || TMAP_BWT_INT_MAX == k || TMAP_BWT_INT_MAX == l) {
+  if((_l >> bwt->occ_interval_log2) != (_k >> bwt->occ_interval_log2) || TMAP_BWT_INT_MAX == k || TMAP_BWT_INT_MAX == l
+     || TMAP_BWT_OCC_LAYOUT_LINE == bwt->occ_layout) { // NB: the second look-up is in the same cache line
       if(l == TMAP_BWT_INT_MAX) k = TMAP_BWT_INT_MAX; 
       tmap_bwt_occ4(bwt, k, cntk);
       tmap_bwt_occ4(bwt, l, cntl);
@@ -788,8 +1180,8 @@ tmap_bwt_2occ4(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, tmap_b
       k = _k;
       l = _l;
           p = tmap_bwt_occ_intv(bwt, k);
-          memcpy(cntk, p, 4 * sizeof(tmap_bwt_int_t));
-          p += sizeof(tmap_bwt_int_t);
+          tmap_bwt_get_occ_cnt4(bwt, p, cntk);
+          p += bwt->occ_cnt_words;
 #ifndef TMAP_BWT_BY_16
           // prepare cntk[]
           j = k >> 4 << 4;
@@ -834,11 +1226,14 @@ int
 tmap_bwt_pac2bwt_main(int argc, char *argv[])
 {
   int c, is_large = 0, occ_interval = TMAP_BWT_OCC_INTERVAL, help = 0;
-  int32_t hash_width = INT32_MAX, check_hash = 1;
+  int32_t hash_width = INT32_MAX, check_hash = 1, num_threads = 1, occ_layout = TMAP_BWT_OCC_LAYOUT_PACKED, int_width = 64;
 
-  while((c = getopt(argc, argv, "o:lw:vhH")) >= 0) {
+  while((c = getopt(argc, argv, "o:clw:n:NvhH")) >= 0) {
       switch(c) {
+        case 'c': occ_layout = TMAP_BWT_OCC_LAYOUT_LINE; break;
+        case 'N': int_width = 32; break;
         case 'l': is_large = 1; break;
+        case 'n': num_threads = atoi(optarg); break;
         case 'o': occ_interval = atoi(optarg); break;
         case 'w': hash_width = atoi(optarg); break;
         case 'v': tmap_progress_set_verbosity(1); break;
@@ -848,14 +1243,17 @@ tmap_bwt_pac2bwt_main(int argc, char *argv[])
       }
   }
   if(1 != argc - optind || 1 == help) {
-      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-l -o INT -w INT -H -v -h] <in.fasta>\n", PACKAGE, argv[0]);
+      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-l -o INT -c -w INT -n INT -N -H -v -h] <in.fasta>\n", PACKAGE, argv[0]);
       return 1;
   }
+  if(num_threads < 1) {
+      tmap_error("option -n out of range", Exit, CommandLineArgument);
+  }
   if(occ_interval < TMAP_BWT_OCC_MOD || 0 != (occ_interval % 2) ||  0 != (occ_interval % TMAP_BWT_OCC_MOD)) {
       tmap_error("option -o out of range", Exit, CommandLineArgument);
   }
 
-  tmap_bwt_pac2bwt(argv[optind], is_large, occ_interval, hash_width, check_hash);
+  tmap_bwt_pac2bwt(argv[optind], is_large, occ_interval, occ_layout, hash_width, check_hash, int_width, num_threads);
 
   return 0;
 }
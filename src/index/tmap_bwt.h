@@ -56,6 +56,37 @@ typedef uint8_t ubyte_t;
 #define TMAP_BWT_HASH_WIDTH_AUTO_MIN 8
 #define TMAP_BWT_HASH_WIDTH_AUTO_MAX 12
 
+/*!
+  The occurrence array layouts
+  */
+enum {
+    TMAP_BWT_OCC_LAYOUT_PACKED = 0, /*!< the occurrences stored ahead of every occ_interval 2-bit packed bases */
+    TMAP_BWT_OCC_LAYOUT_LINE = 1 /*!< one 64-byte cache line per TMAP_BWT_OCC_LINE_INTERVAL bases, stored as two bit-planes */
+};
+
+/*
+ * The cache-line layout: each 64-byte block (TMAP_BWT_OCC_LINE_WORDS words) 
+ * holds the four occurrences before the block, padded to 32 bytes, followed 
+ * by the high bits and then the low bits of its 128 bases, with the i-th 
+ * base in bit (i&63) of the (i>>6)-th 64-bit word of each plane.  The 
+ * blocks are aligned to 64 bytes in memory, so retrieving an occurrence 
+ * touches exactly one cache line.
+ */
+#define TMAP_BWT_OCC_LINE_INTERVAL 128
+#define TMAP_BWT_OCC_LINE_INTERVAL_LOG2 7
+#define TMAP_BWT_OCC_LINE_WORDS 16
+#define TMAP_BWT_OCC_LINE_PLANES 8
+#define TMAP_BWT_OCC_LINE_ALIGN 64
+
+/*!
+  The instruction sets used to count the occurrences in the cache-line layout
+  */
+enum {
+    TMAP_BWT_OCC_SIMD_NONE = 0, /*!< scalar bit counting */
+    TMAP_BWT_OCC_SIMD_SSE42 = 1, /*!< SSE4.2 hardware popcount */
+    TMAP_BWT_OCC_SIMD_AVX2 = 2 /*!< AVX2 for all four bases at once, hardware popcount otherwise */
+};
+
 // NB: we do not need a multi-level hash, just the highest-level hash.  We can
 // simulate the others from this one...
 /*! 
@@ -76,9 +107,61 @@ typedef struct {
     uint32_t is_shm;  /*!< 1 if loaded from shared memory, 0 otherwise */
     // Not stored in the file
     uint32_t occ_interval_log2; /*!< log2 value of of the the occurrence array interval */
-    uint32_t occ_array_16_pt2; /*!< equal to ((bwt)->occ_interval/(sizeof(uint32_t)<<3>>1) + (sizeof(tmap_bwt_int_t)>>2<<2))) */
+    uint32_t occ_array_16_pt2; /*!< equal to ((bwt)->occ_interval/(sizeof(uint32_t)<<3>>1) + (bwt)->occ_cnt_words) */
+    uint32_t occ_cnt_words; /*!< the number of 32-bit words holding the four occurrences at the start of each occurrence interval */
+    void *mmap_buf; /*!< the memory mapped BWT file, NULL if not memory mapped */
+    size_t mmap_len; /*!< the length of the memory mapped BWT file */
+    uint32_t occ_layout; /*!< the occurrence array layout, stored in the file as the lowest bit of the occurrence interval */
+    int32_t occ_simd; /*!< the instruction set used to count the occurrences in the cache-line layout */
+    uint32_t (*occ_line)(const uint64_t *planes, uint32_t r, uint8_t c); /*!< the occurrences of a base in a cache line up to and including the r-th base */
+    void (*occ4_line)(const uint64_t *planes, uint32_t r, tmap_bwt_int_t cnt[4]); /*!< adds the occurrences of all four bases in a cache line up to and including the r-th base */
+    struct __tmap_bwt_kmer_t *kmer; /*!< the k-mer prefix table, NULL if none (stored in its own file) */
+    uint32_t int_width; /*!< the width in bits of the occurrence hash entries, stored in the file as the second lowest bit of the occurrence interval (32 if set) */
+    uint32_t occ_int_width; /*!< the width in bits of the occurrences stored in the packed layout, stored in the file as the third lowest bit of the occurrence interval (32 if set) */
 } tmap_bwt_t;
 
+/*!
+  @param  b   pointer to the bwt structure
+  @param  p   pointer to the occurrences stored at the start of an occurrence interval
+  @param  c   the base
+  @return     the occurrences of the base before the occurrence interval
+  */
+#define tmap_bwt_get_occ_cnt(b, p, c) \
+  ((4 == (b)->occ_cnt_words) ? (tmap_bwt_int_t)((const uint32_t*)(p))[c] : ((const tmap_bwt_int_t*)(p))[c])
+
+/*!
+  @param  b    pointer to the bwt structure
+  @param  p    pointer to the occurrences stored at the start of an occurrence interval
+  @param  cnt  the occurrences of each base before the occurrence interval
+  */
+#define tmap_bwt_get_occ_cnt4(b, p, cnt) do { \
+    if(4 == (b)->occ_cnt_words) { \
+        (cnt)[0] = ((const uint32_t*)(p))[0]; (cnt)[1] = ((const uint32_t*)(p))[1]; \
+        (cnt)[2] = ((const uint32_t*)(p))[2]; (cnt)[3] = ((const uint32_t*)(p))[3]; \
+    } \
+    else { \
+        memcpy(cnt, p, 4 * sizeof(tmap_bwt_int_t)); \
+    } \
+} while(0)
+
+/*!
+  @param  _bwt  the bwt structure
+  @param  _i    the hashed k-mer length less one
+  @param  _j    the hashed k-mer
+  @return       the lower bound of the SA interval of the k-mer
+  */
+#define tmap_bwt_get_hash_k(_bwt, _i, _j) \
+  ((32 == (_bwt)->int_width) ? tmap_bwt_int_from32(((const uint32_t*)(_bwt)->hash_k[_i])[_j]) : (_bwt)->hash_k[_i][_j])
+
+/*!
+  @param  _bwt  the bwt structure
+  @param  _i    the hashed k-mer length less one
+  @param  _j    the hashed k-mer
+  @return       the upper bound of the SA interval of the k-mer
+  */
+#define tmap_bwt_get_hash_l(_bwt, _i, _j) \
+  ((32 == (_bwt)->int_width) ? tmap_bwt_int_from32(((const uint32_t*)(_bwt)->hash_l[_i])[_j]) : (_bwt)->hash_l[_i][_j])
+
 /*! 
   @param  fn_fasta  the FASTA file name
   @return           pointer to the bwt structure 
@@ -86,6 +169,14 @@ typedef struct {
 tmap_bwt_t *
 tmap_bwt_read(const char *fn_fasta);
 
+/*! 
+  @param  fn_fasta  the FASTA file name
+  @param  populate  1 to read the whole file into memory now, 0 to read each page upon first access
+  @return           pointer to the bwt structure, using the memory mapped file in place
+  */
+tmap_bwt_t *
+tmap_bwt_mmap(const char *fn_fasta, int32_t populate);
+
 /*! 
   @param  fn_fasta  the FASTA file name
   @param  bwt       the bwt structure to write
@@ -144,6 +235,37 @@ tmap_bwt_destroy(tmap_bwt_t *bwt);
 void 
 tmap_bwt_update_occ_interval(tmap_bwt_t *bwt, tmap_bwt_int_t occ_interval);
 
+/*! 
+  stores the occurrences of the packed layout in 32 bits if they fit
+  @param  bwt  pointer to the bwt structure to update
+  @details     the cache-line layout keeps its 64-bit occurrences
+  */
+void
+tmap_bwt_update_occ_int32(tmap_bwt_t *bwt);
+
+/*! 
+  @param  bwt  pointer to the bwt structure to update
+  @details     the bwt must hold the 2-bit packed BWT string without occurrences (the occurrence interval is one)
+  */
+void 
+tmap_bwt_update_occ_line(tmap_bwt_t *bwt);
+
+/*! 
+  selects the instruction set used to count the occurrences in the cache-line layout
+  @param  bwt   pointer to the bwt structure to update
+  @param  simd  the highest instruction set to use (TMAP_BWT_OCC_SIMD_*)
+  @return       the instruction set supported by this CPU and used
+  */
+int32_t
+tmap_bwt_set_occ_simd(tmap_bwt_t *bwt, int32_t simd);
+
+/*! 
+  @param  bwt  pointer to the bwt structure
+  @return      a description of the occurrence array layout and how it is counted
+  */
+const char *
+tmap_bwt_occ_layout_name(const tmap_bwt_t *bwt);
+
 /*! 
   generates the occurrence array
   @param  bwt  pointer to the bwt structure to update 
@@ -156,9 +278,10 @@ tmap_bwt_gen_cnt_table(tmap_bwt_t *bwt);
   @param  bwt         pointer to the bwt structure to update 
   @param  hash_width  the k-mer length to hash
   @param  check_hash  1 if we are to validate the hash, zero otherwise
+  @param  int_width   32 to store the hash entries in 32 bits if the sequence is short enough, 64 otherwise
   */
 void
-tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash);
+tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash, int32_t int_width);
 
 /*! 
   calculates the next occurrence given the previous occurrence and the next base
@@ -219,7 +342,7 @@ tmap_bwt_2occ4(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, tmap_b
   @param  k   the zero-based index of the bwt character to retrieve
   @return     the array 16 of bwt characters from the $-removed BWT string at [(k-(k%16),k+(16-(k%16))-1]
  */
-#define tmap_bwt_get_bwt16(b, k) ((b)->bwt[tmap_bwt_get_occ_array_i16(b, k) + (sizeof(tmap_bwt_int_t)>>2<<2) + (((k)&((b)->occ_interval-1))>>4)])
+#define tmap_bwt_get_bwt16(b, k) ((b)->bwt[tmap_bwt_get_occ_array_i16(b, k) + (b)->occ_cnt_words + (((k)&((b)->occ_interval-1))>>4)])
 //#define tmap_bwt_get_bwt16(b, k) ((b)->bwt[tmap_bwt_get_occ_array_i16(b, k) + sizeof(tmap_bwt_int_t)/4*4 + (k)%(b)->occ_interval/16])
 
 
@@ -230,7 +353,22 @@ tmap_bwt_2occ4(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, tmap_b
   @details    Note that tmap_bwt_t::bwt is not exactly the BWT string 
   and therefore this define is called tmap_bwt_B0 instead of tmap_bwt_B. 
   */
-#define tmap_bwt_B0(b, k) (tmap_bwt_get_bwt16(b, k)>>((~(k)&0xf)<<1)&3)
+#define tmap_bwt_B0(b, k) ((TMAP_BWT_OCC_LAYOUT_LINE == (b)->occ_layout) ? tmap_bwt_line_B0(b, k) : (tmap_bwt_get_bwt16(b, k)>>((~(k)&0xf)<<1)&3))
+
+/*!
+  @param  b   pointer to the bwt structure
+  @param  k   the zero-based index of the bwt character to retrieve
+  @return     the bit-planes of the cache line holding the bwt character (cache-line layout only)
+  */
+#define tmap_bwt_get_line_planes(b, k) ((const uint64_t*)((b)->bwt + ((k) >> TMAP_BWT_OCC_LINE_INTERVAL_LOG2) * TMAP_BWT_OCC_LINE_WORDS + TMAP_BWT_OCC_LINE_PLANES))
+
+/*! 
+  @param  b   pointer to the bwt structure
+  @param  k   the zero-based index of the bwt character to retrieve
+  @return     the bwt character from the $-removed BWT string (cache-line layout only)
+  */
+#define tmap_bwt_line_B0(b, k) ((uint32_t)((tmap_bwt_get_line_planes(b, k)[((k)>>6)&1] >> ((k)&63) & 1) << 1 \
+                                           | (tmap_bwt_get_line_planes(b, k)[2+(((k)>>6)&1)] >> ((k)&63) & 1)))
 
 /*!
   @param  b   pointer to the bwt structure
@@ -239,6 +377,21 @@ tmap_bwt_2occ4(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, tmap_b
   */
 #define tmap_bwt_occ_intv(b, k) ((b)->bwt + tmap_bwt_get_occ_array_i16(b, k))
 
+/*!
+  @param  b   pointer to the bwt structure
+  @param  k   the occurrence position, as would be given to tmap_bwt_occ
+  @details    issues a software prefetch for the occurrence array and bwt characters read by tmap_bwt_occ;
+  nothing is fetched for positions that do not touch the occurrence array (-1 and the sequence length)
+  */
+#define tmap_bwt_prefetch_occ(b, k) do { \
+    tmap_bwt_int_t __pk = (k); \
+    if(__pk < (b)->seq_len) { \
+        if((b)->primary <= __pk) __pk--; \
+        __builtin_prefetch(tmap_bwt_occ_intv(b, __pk)); \
+        __builtin_prefetch(&tmap_bwt_get_bwt16(b, __pk)); \
+    } \
+} while(0)
+
 /*!  
   inverse Psi function
   @param  bwt  pointer to the bwt structure
@@ -159,12 +159,12 @@ tmap_bwt_aux_2occ(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t *l, ui
   tmap_bwt_int_t n = *l;
 
   --k;
-  *l = ((const tmap_bwt_int_t *)(p = tmap_bwt_occ_intv(bwt, n)))[c] + bwt->L2[c];
+  *l = tmap_bwt_get_occ_cnt(bwt, (p = tmap_bwt_occ_intv(bwt, n)), c) + bwt->L2[c];
   const uint64_t x = (c == 1 ? 0xaaaaaaaaaaaaaaaaul :
                       (c == 2 ? 0x5555555555555555ul :
                        (c == 3 ? 0x0ul : 0xfffffffffffffffful)));
 
-  p += sizeof(tmap_bwt_int_t) + ((n&0x60)>>4);
+  p += bwt->occ_cnt_words + ((n&0x60)>>4);
   w = ((uint64_t)p[0]<<32 | p[1]) ^ x;
   y = w & (w >> 1) & occ_mask2(n);
   n = ((n^k)&~31) | ((k&0x60) >> 4);
@@ -200,9 +200,9 @@ tmap_bwt_aux_2occ(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t *l, ui
                k = *l;
                break;
     default:
-               k = ((const tmap_bwt_int_t *)(p2 = tmap_bwt_occ_intv(bwt, k)))[c] + bwt->L2[c];
+               k = tmap_bwt_get_occ_cnt(bwt, (p2 = tmap_bwt_occ_intv(bwt, k)), c) + bwt->L2[c];
                n &= 0x66;
-               p2 += sizeof(tmap_bwt_int_t) + (n & 0x6); //is really k
+               p2 += bwt->occ_cnt_words + (n & 0x6); //is really k
                w = ((uint64_t)p2[0]<<32 | p2[1]) ^ x;
                z &= w & (w >> 1);
                w = 0ul;
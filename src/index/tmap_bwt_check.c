@@ -133,7 +133,7 @@ tmap_bwt_check_core(const char *fn_fasta, int32_t length, int32_t print_sa, int3
   int32_t hash_width = 0;
 
 #ifdef TMAP_BWT_CHECK_DEBUG 
-  tmap_bwt_index = tmap_index_init(fn_fasta, 0);
+  tmap_bwt_index = tmap_index_init(fn_fasta, 0, 0);
   bwt = tmap_bwt_index->bwt;
 #else
   bwt = tmap_bwt_read(fn_fasta);
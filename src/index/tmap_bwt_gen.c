@@ -38,6 +38,7 @@
 #include "tmap_bwt.h"
 #include "tmap_sa.h"
 #include "tmap_bwt_gen.h"
+#include "tmap_bwt_gen_dc.h"
 
 #define ALPHABET_SIZE				4
 #define BIT_PER_CHAR				2
@@ -1609,7 +1610,7 @@ BWTFileSizeInWord(const tmap_bwt_int_t numChar)
 }
 
 void 
-BWTSaveBwtCodeAndOcc(tmap_bwt_t *bwt_out, const tmap_bwt_gen_t *bwt, const char *fn_fasta, int32_t occ_interval) 
+BWTSaveBwtCodeAndOcc(tmap_bwt_t *bwt_out, const tmap_bwt_gen_t *bwt, const char *fn_fasta, int32_t occ_interval, int32_t occ_layout) 
 {
   tmap_bwt_int_t i;
   tmap_bwt_t *bwt_tmp=NULL;
@@ -1633,7 +1634,14 @@ BWTSaveBwtCodeAndOcc(tmap_bwt_t *bwt_out, const tmap_bwt_gen_t *bwt, const char
   bwt_out->bwt = NULL;
 
   // update occurrence interval, if necessary
-  if(occ_interval != bwt_out->occ_interval) {
+  if(TMAP_BWT_OCC_LAYOUT_LINE == occ_layout) {
+      bwt_tmp = tmap_bwt_read(fn_fasta);
+      bwt_tmp->occ_interval = 1; // the 2-bit packed BWT string was written
+      tmap_bwt_update_occ_line(bwt_tmp);
+      tmap_bwt_write(fn_fasta, bwt_tmp);
+      tmap_bwt_destroy(bwt_tmp);
+  }
+  else if(occ_interval != bwt_out->occ_interval) {
       bwt_tmp = tmap_bwt_read(fn_fasta);
       tmap_bwt_update_occ_interval(bwt_tmp, occ_interval);
       tmap_bwt_write(fn_fasta, bwt_tmp);
@@ -1660,7 +1668,7 @@ tmap_bwt_tune_hash_width(uint64_t ref_len)
 }
 
 void 
-tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t hash_width, int32_t check_hash)
+tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t occ_layout, int32_t hash_width, int32_t check_hash, int32_t int_width, int32_t num_threads)
 {
   tmap_bwt_gen_inc_t *bwtInc=NULL;
   tmap_bwt_t *bwt=NULL;
@@ -1682,7 +1690,36 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
   bwt->bwt_size = (bwt->seq_len + 15) >> 4; // 2-bit packed
   bwt->version_id = TMAP_VERSION_ID;
 
-  if(1 == is_large) {
+  if(1 < num_threads) {
+      tmap_progress_print2("using %d threads", num_threads);
+
+      for(i=0;i<ALPHABET_SIZE+1;i++) {
+          bwt->L2[i]=0;
+      }
+      for(i=0;i<bwt->seq_len;i++) {
+          ++bwt->L2[1+tmap_refseq_seq_i(refseq, i)];
+      }
+      for(i=2;i<ALPHABET_SIZE+1;i++) {
+          bwt->L2[i] += bwt->L2[i-1];
+      }
+
+      // Burrows-Wheeler Transform
+      tmap_bwt_gen_dc(refseq, bwt, num_threads);
+      tmap_refseq_destroy(refseq);
+      bwt->occ_interval = 1; 
+
+      // update occurrence interval
+      if(TMAP_BWT_OCC_LAYOUT_LINE == occ_layout) {
+          tmap_bwt_update_occ_line(bwt);
+      }
+      else {
+          tmap_bwt_update_occ_interval(bwt, occ_interval);
+      }
+
+      bwt->hash_width = 0; // none yet
+      tmap_bwt_write(fn_fasta, bwt);
+  }
+  else if(1 == is_large) {
       // destroy the reference sequence
       tmap_refseq_destroy(refseq);
       // create the bwt
@@ -1691,7 +1728,7 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
           tmap_error("PAC compression not supported", Exit, OutOfRange);
       }
       bwtInc = BWTIncConstructFromPacked(fn_pac, 10000000, 10000000);
-      BWTSaveBwtCodeAndOcc(bwt, bwtInc->bwt, fn_fasta, occ_interval);
+      BWTSaveBwtCodeAndOcc(bwt, bwtInc->bwt, fn_fasta, occ_interval, occ_layout);
       BWTIncFree(bwtInc);
       free(fn_pac);
   }
@@ -1724,7 +1761,12 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
       bwt->occ_interval = 1; 
 
       // update occurrence interval
-      tmap_bwt_update_occ_interval(bwt, occ_interval);
+      if(TMAP_BWT_OCC_LAYOUT_LINE == occ_layout) {
+          tmap_bwt_update_occ_line(bwt);
+      }
+      else {
+          tmap_bwt_update_occ_interval(bwt, occ_interval);
+      }
 
       bwt->hash_width = 0; // none yet
       tmap_bwt_write(fn_fasta, bwt);
@@ -1738,9 +1780,17 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
       tmap_progress_print2("setting the BWT hash width to %d", hash_width);
   }
 
-  if(0 < hash_width) {
+  if(0 < hash_width || 32 == int_width) {
       bwt = tmap_bwt_read(fn_fasta); 
-      tmap_bwt_gen_hash(bwt, hash_width, check_hash);
+      if(32 == int_width) {
+          tmap_bwt_update_occ_int32(bwt);
+      }
+      if(0 < hash_width) {
+          tmap_bwt_gen_hash(bwt, hash_width, check_hash, int_width);
+      }
+      else {
+          tmap_progress_print("skipping occurrence hash creation");
+      }
       tmap_bwt_write(fn_fasta, bwt);
       tmap_bwt_destroy(bwt);
   }
@@ -1775,8 +1825,8 @@ tmap_bwt_update_hash(const char *fn_fasta, int32_t hash_width, int32_t check_has
       free(bwt->hash_l);
       bwt->hash_k = bwt->hash_l = NULL;
 
-      // new hash
-      tmap_bwt_gen_hash(bwt, hash_width, check_hash);
+      // new hash, keeping the integer width
+      tmap_bwt_gen_hash(bwt, hash_width, check_hash, bwt->int_width);
 
       // write
       tmap_bwt_write(fn_fasta, bwt);
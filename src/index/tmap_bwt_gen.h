@@ -45,11 +45,14 @@ tmap_bwt_tune_hash_width(uint64_t ref_len);
   @param  fn_fasta      file name of the FASTA file
   @param  is_large      0 to use the short BWT construction algorith, 1 otherwise (large BWT construction algorithm) 
   @param  occ_interval  the desired occurrence interval
+  @param  occ_layout    the occurrence array layout (TMAP_BWT_OCC_LAYOUT_*); the cache-line layout ignores occ_interval
   @param  hash_width    the desired k-mer hash width
   @param  check_hash    1 to validate the hash, 0 otherwise
+  @param  int_width     32 to store the hash entries and the packed occurrences in 32 bits if the reference is short enough, 64 otherwise
+  @param  num_threads   the number of threads; more than one uses the multi-threaded construction regardless of is_large
   */
 void 
-tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t hash_width, int32_t check_hash);
+tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t occ_layout, int32_t hash_width, int32_t check_hash, int32_t int_width, int32_t num_threads);
 
 /*! 
   updates a bwt FASTA file for a new hash width
@@ -0,0 +1,733 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <config.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+#include "../util/tmap_error.h"
+#include "../util/tmap_alloc.h"
+#include "../util/tmap_progress.h"
+#include "../util/tmap_definitions.h"
+#include "tmap_refseq.h"
+#include "tmap_bwt.h"
+#include "tmap_sa.h"
+#include "tmap_bwt_gen_dc.h"
+
+#define __tmap_bwt_gen_dc_num_buckets (1 << (2 * TMAP_BWT_GEN_DC_BUCKET_WIDTH))
+
+/*
+  The text and the difference cover sample shared by all threads
+ */
+typedef struct {
+    uint64_t *text; /*!< the 2-bit packed text, 32 bases per word with the first base in the most significant bits */
+    tmap_bwt_int_t n; /*!< the length of the text */
+    uint32_t v; /*!< the difference cover modulus */
+    uint32_t v_log2; /*!< log2 of the modulus */
+    uint32_t *cover; /*!< the residues in the difference cover, in increasing order */
+    int32_t cover_size; /*!< the number of residues in the difference cover */
+    int32_t *cover_class; /*!< the index of each residue in the difference cover, -1 if it is not in the cover */
+    uint32_t *delta; /*!< for each difference d, a residue r such that r and r + d are both in the cover */
+    tmap_bwt_int_t *class_start; /*!< the index of the first sample with each residue */
+    tmap_bwt_int_t num_samples; /*!< the number of sampled suffixes */
+    uint32_t *rank; /*!< the rank of each sampled suffix */
+} tmap_bwt_gen_dc_t;
+
+/*
+  A block of buckets being sorted
+ */
+typedef struct {
+    tmap_bwt_gen_dc_t *dc; /*!< the text and sample */
+    int32_t mode; /*!< 0 to sort by the first modulus bases, 1 to sort the suffixes */
+    tmap_bwt_int_t *pos; /*!< the suffixes in the block, by bucket */
+    tmap_bwt_int_t *tmp; /*!< scratch memory of the same size */
+    tmap_bwt_int_t *bucket_start; /*!< the start of each bucket in the block */
+    int32_t bucket_next; /*!< the next bucket to sort */
+    int32_t bucket_high; /*!< one past the last bucket in the block */
+    tmap_bwt_int_t big; /*!< buckets larger than this are sorted by all threads */
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_t *mutex; /*!< the mutex guarding the next bucket */
+#endif
+} tmap_bwt_gen_dc_block_t;
+
+/*
+  The data for one thread
+ */
+typedef struct {
+    tmap_bwt_gen_dc_t *dc; /*!< the text and sample */
+    tmap_bwt_gen_dc_block_t *block; /*!< the block being sorted */
+    int32_t samples; /*!< 1 to enumerate the sampled suffixes, 0 to enumerate all suffixes */
+    tmap_bwt_int_t low; /*!< the first suffix (or sample) handled by this thread */
+    tmap_bwt_int_t high; /*!< one past the last suffix (or sample) handled by this thread */
+    tmap_bwt_int_t bucket_low; /*!< the first bucket of the block being filled */
+    tmap_bwt_int_t bucket_high; /*!< one past the last bucket of the block being filled */
+    tmap_bwt_int_t *cnt; /*!< the bucket counts of this thread, later the bucket offsets */
+    tmap_bwt_int_t *src; /*!< the sorted runs to merge */
+    tmap_bwt_int_t *dst; /*!< the merged runs */
+    tmap_bwt_int_t mid; /*!< the start of the second run to merge */
+    tmap_bwt_int_t k_low; /*!< the first merged suffix written by this thread, relative to low */
+    tmap_bwt_int_t k_high; /*!< one past the last merged suffix written by this thread, relative to low */
+    uint8_t *bases; /*!< the BWT bases of the block, 4 for the primary */
+} tmap_bwt_gen_dc_thread_t;
+
+static inline uint64_t
+tmap_bwt_gen_dc_get64(const uint64_t *text, tmap_bwt_int_t i)
+{
+  uint32_t s = (i & 31) << 1;
+  if(0 == s) return text[i >> 5];
+  return (text[i >> 5] << s) | (text[(i >> 5) + 1] >> (64 - s));
+}
+
+static inline uint8_t
+tmap_bwt_gen_dc_get(const uint64_t *text, tmap_bwt_int_t i)
+{
+  return (text[i >> 5] >> (62 - ((i & 31) << 1))) & 0x3;
+}
+
+// compares the first len bases of two suffixes, a suffix being less than its extensions
+static inline int32_t
+tmap_bwt_gen_dc_cmp_prefix(const tmap_bwt_gen_dc_t *dc, tmap_bwt_int_t i, tmap_bwt_int_t j, tmap_bwt_int_t len)
+{
+  tmap_bwt_int_t k, lim, ri, rj;
+  uint64_t a, b;
+  uint32_t s;
+
+  ri = dc->n - i;
+  rj = dc->n - j;
+  lim = (ri < rj) ? ri : rj;
+  if(len < lim) lim = len;
+  for(k = 0; k < lim; k += 32) {
+      a = tmap_bwt_gen_dc_get64(dc->text, i + k);
+      b = tmap_bwt_gen_dc_get64(dc->text, j + k);
+      if(a != b) {
+          if(lim - k < 32) { // ignore the bases past the limit
+              s = (32 - (lim - k)) << 1;
+              a >>= s;
+              b >>= s;
+              if(a == b) break;
+          }
+          return (a < b) ? -1 : 1;
+      }
+  }
+  if(lim == len) return 0;
+  return (ri < rj) ? -1 : 1;
+}
+
+static inline uint32_t
+tmap_bwt_gen_dc_rank(const tmap_bwt_gen_dc_t *dc, tmap_bwt_int_t i)
+{
+  return dc->rank[dc->class_start[dc->cover_class[i & (dc->v - 1)]] + (i >> dc->v_log2)];
+}
+
+static inline int32_t
+tmap_bwt_gen_dc_cmp(const tmap_bwt_gen_dc_t *dc, int32_t mode, tmap_bwt_int_t i, tmap_bwt_int_t j)
+{
+  tmap_bwt_int_t l;
+  int32_t c;
+
+  if(0 == mode) return tmap_bwt_gen_dc_cmp_prefix(dc, i, j, dc->v);
+
+  // compare up to the first offset where both suffixes are sampled, then by their ranks
+  l = (dc->delta[(j - i) & (dc->v - 1)] - i) & (dc->v - 1);
+  if(0 < l) {
+      c = tmap_bwt_gen_dc_cmp_prefix(dc, i, j, l);
+      if(0 != c) return c;
+  }
+  return (tmap_bwt_gen_dc_rank(dc, i + l) < tmap_bwt_gen_dc_rank(dc, j + l)) ? -1 : 1;
+}
+
+// merges the sorted runs a[0..h) and a[h..n) in place
+static void
+tmap_bwt_gen_dc_merge(const tmap_bwt_gen_dc_t *dc, int32_t mode, tmap_bwt_int_t *a, tmap_bwt_int_t *tmp, tmap_bwt_int_t h, tmap_bwt_int_t n)
+{
+  tmap_bwt_int_t i, j, k;
+
+  if(tmap_bwt_gen_dc_cmp(dc, mode, a[h-1], a[h]) <= 0) return; // already in order
+  i = k = 0;
+  j = h;
+  while(i < h && j < n) {
+      tmp[k++] = (tmap_bwt_gen_dc_cmp(dc, mode, a[j], a[i]) < 0) ? a[j++] : a[i++];
+  }
+  while(i < h) tmp[k++] = a[i++];
+  memcpy(a, tmp, k * sizeof(tmap_bwt_int_t)); // the rest of the second run is in place
+}
+
+static void
+tmap_bwt_gen_dc_sort(const tmap_bwt_gen_dc_t *dc, int32_t mode, tmap_bwt_int_t *a, tmap_bwt_int_t *tmp, tmap_bwt_int_t n)
+{
+  tmap_bwt_int_t i, j, x, h;
+
+  if(n <= TMAP_BWT_GEN_DC_INSERTION_SORT) {
+      for(i = 1; i < n; i++) {
+          x = a[i];
+          for(j = i; 0 < j && 0 < tmap_bwt_gen_dc_cmp(dc, mode, a[j-1], x); j--) {
+              a[j] = a[j-1];
+          }
+          a[j] = x;
+      }
+      return;
+  }
+  h = n >> 1;
+  tmap_bwt_gen_dc_sort(dc, mode, a, tmp, h);
+  tmap_bwt_gen_dc_sort(dc, mode, a + h, tmp + h, n - h);
+  tmap_bwt_gen_dc_merge(dc, mode, a, tmp, h, n);
+}
+
+// runs the function on each thread's data, in parallel if possible
+static void
+tmap_bwt_gen_dc_run(void *(*func)(void*), tmap_bwt_gen_dc_thread_t *thread_data, int32_t num_threads)
+{
+  int32_t i;
+#ifdef HAVE_LIBPTHREAD
+  if(1 < num_threads) {
+      pthread_t *threads = NULL;
+      pthread_attr_t attr;
+
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+      threads = tmap_calloc(num_threads, sizeof(pthread_t), "threads");
+      for(i = 0; i < num_threads; i++) {
+          if(0 != pthread_create(&threads[i], &attr, func, &thread_data[i])) {
+              tmap_error("error creating threads", Exit, ThreadError);
+          }
+      }
+      for(i = 0; i < num_threads; i++) {
+          if(0 != pthread_join(threads[i], NULL)) {
+              tmap_error("error joining threads", Exit, ThreadError);
+          }
+      }
+      free(threads);
+      pthread_attr_destroy(&attr);
+      return;
+  }
+#endif
+  for(i = 0; i < num_threads; i++) {
+      func(&thread_data[i]);
+  }
+}
+
+static inline tmap_bwt_int_t
+tmap_bwt_gen_dc_bucket(const tmap_bwt_gen_dc_t *dc, tmap_bwt_int_t i)
+{
+  // NB: the bases past the end of the text are zero
+  return tmap_bwt_gen_dc_get64(dc->text, i) >> (64 - (TMAP_BWT_GEN_DC_BUCKET_WIDTH << 1));
+}
+
+// the class of the sample, advanced from the previous class
+static inline int32_t
+tmap_bwt_gen_dc_sample_class(const tmap_bwt_gen_dc_t *dc, tmap_bwt_int_t s, int32_t c)
+{
+  while(dc->class_start[c+1] <= s) c++;
+  return c;
+}
+
+static inline tmap_bwt_int_t
+tmap_bwt_gen_dc_sample_pos(const tmap_bwt_gen_dc_t *dc, tmap_bwt_int_t s, int32_t c)
+{
+  return dc->cover[c] + ((s - dc->class_start[c]) << dc->v_log2);
+}
+
+static void *
+tmap_bwt_gen_dc_count_worker(void *arg)
+{
+  tmap_bwt_gen_dc_thread_t *thread_data = (tmap_bwt_gen_dc_thread_t*)arg;
+  tmap_bwt_gen_dc_t *dc = thread_data->dc;
+  tmap_bwt_int_t i;
+  int32_t c = 0;
+
+  memset(thread_data->cnt, 0, __tmap_bwt_gen_dc_num_buckets * sizeof(tmap_bwt_int_t));
+  for(i = thread_data->low; i < thread_data->high; i++) {
+      if(1 == thread_data->samples) {
+          c = tmap_bwt_gen_dc_sample_class(dc, i, c);
+          thread_data->cnt[tmap_bwt_gen_dc_bucket(dc, tmap_bwt_gen_dc_sample_pos(dc, i, c))]++;
+      }
+      else {
+          thread_data->cnt[tmap_bwt_gen_dc_bucket(dc, i)]++;
+      }
+  }
+  return arg;
+}
+
+static void *
+tmap_bwt_gen_dc_fill_worker(void *arg)
+{
+  tmap_bwt_gen_dc_thread_t *thread_data = (tmap_bwt_gen_dc_thread_t*)arg;
+  tmap_bwt_gen_dc_t *dc = thread_data->dc;
+  tmap_bwt_int_t i, p, b;
+  int32_t c = 0;
+
+  for(i = thread_data->low; i < thread_data->high; i++) {
+      if(1 == thread_data->samples) {
+          c = tmap_bwt_gen_dc_sample_class(dc, i, c);
+          p = tmap_bwt_gen_dc_sample_pos(dc, i, c);
+      }
+      else {
+          p = i;
+      }
+      b = tmap_bwt_gen_dc_bucket(dc, p);
+      if(thread_data->bucket_low <= b && b < thread_data->bucket_high) {
+          thread_data->block->pos[thread_data->cnt[b]++] = p;
+      }
+  }
+  return arg;
+}
+
+static void *
+tmap_bwt_gen_dc_sort_worker(void *arg)
+{
+  tmap_bwt_gen_dc_thread_t *thread_data = (tmap_bwt_gen_dc_thread_t*)arg;
+  tmap_bwt_gen_dc_block_t *block = thread_data->block;
+  tmap_bwt_int_t start, end, size;
+  int32_t low, high, b;
+
+  while(1) {
+      // get the next buckets to sort
+#ifdef HAVE_LIBPTHREAD
+      if(NULL != block->mutex) pthread_mutex_lock(block->mutex);
+#endif
+      low = high = block->bucket_next;
+      size = 0;
+      while(high < block->bucket_high && size < block->big) {
+          size += block->bucket_start[high+1] - block->bucket_start[high];
+          high++;
+      }
+      block->bucket_next = high;
+#ifdef HAVE_LIBPTHREAD
+      if(NULL != block->mutex) pthread_mutex_unlock(block->mutex);
+#endif
+      if(low == high) break;
+
+      for(b = low; b < high; b++) {
+          start = block->bucket_start[b];
+          end = block->bucket_start[b+1];
+          if(end - start <= block->big) { // NB: big buckets are sorted by all threads
+              tmap_bwt_gen_dc_sort(block->dc, block->mode, block->pos + start, block->tmp + start, end - start);
+          }
+      }
+  }
+  return arg;
+}
+
+static void *
+tmap_bwt_gen_dc_run_worker(void *arg)
+{
+  tmap_bwt_gen_dc_thread_t *thread_data = (tmap_bwt_gen_dc_thread_t*)arg;
+  tmap_bwt_gen_dc_block_t *block = thread_data->block;
+
+  tmap_bwt_gen_dc_sort(block->dc, block->mode,
+                       block->pos + thread_data->low, block->tmp + thread_data->low,
+                       thread_data->high - thread_data->low);
+  return arg;
+}
+
+// the number of suffixes from the first run among the first k merged suffixes
+static tmap_bwt_int_t
+tmap_bwt_gen_dc_corank(const tmap_bwt_gen_dc_t *dc, int32_t mode, const tmap_bwt_int_t *a, tmap_bwt_int_t m,
+                       const tmap_bwt_int_t *b, tmap_bwt_int_t n, tmap_bwt_int_t k)
+{
+  tmap_bwt_int_t low, high, i, j;
+
+  low = (n < k) ? k - n : 0;
+  high = (k < m) ? k : m;
+  while(low < high) {
+      i = low + ((high - low) >> 1);
+      j = k - i;
+      if(0 < j && 0 <= tmap_bwt_gen_dc_cmp(dc, mode, b[j-1], a[i])) { // a[i] is merged before b[j-1]
+          low = i + 1;
+      }
+      else {
+          high = i;
+      }
+  }
+  return low;
+}
+
+static void *
+tmap_bwt_gen_dc_merge_worker(void *arg)
+{
+  tmap_bwt_gen_dc_thread_t *thread_data = (tmap_bwt_gen_dc_thread_t*)arg;
+  tmap_bwt_gen_dc_block_t *block = thread_data->block;
+  const tmap_bwt_int_t *a, *b;
+  tmap_bwt_int_t m, n, i, j, i_end, j_end, k;
+
+  a = thread_data->src + thread_data->low;
+  m = thread_data->mid - thread_data->low;
+  b = thread_data->src + thread_data->mid;
+  n = thread_data->high - thread_data->mid;
+
+  i = tmap_bwt_gen_dc_corank(block->dc, block->mode, a, m, b, n, thread_data->k_low);
+  j = thread_data->k_low - i;
+  i_end = tmap_bwt_gen_dc_corank(block->dc, block->mode, a, m, b, n, thread_data->k_high);
+  j_end = thread_data->k_high - i_end;
+
+  k = thread_data->low + thread_data->k_low;
+  while(i < i_end && j < j_end) {
+      thread_data->dst[k++] = (tmap_bwt_gen_dc_cmp(block->dc, block->mode, b[j], a[i]) < 0) ? b[j++] : a[i++];
+  }
+  while(i < i_end) thread_data->dst[k++] = a[i++];
+  while(j < j_end) thread_data->dst[k++] = b[j++];
+  return arg;
+}
+
+// sorts one bucket with all threads: each sorts a run, then the runs are merged in parallel
+static void
+tmap_bwt_gen_dc_sort_big(tmap_bwt_gen_dc_block_t *block, tmap_bwt_gen_dc_thread_t *thread_data, int32_t num_threads,
+                         tmap_bwt_int_t start, tmap_bwt_int_t end)
+{
+  tmap_bwt_int_t len = end - start;
+  tmap_bwt_int_t *bounds = NULL, *src, *dst, *swap;
+  int32_t i, j, width, num_merges, per_merge, num_tasks;
+
+  bounds = tmap_malloc(sizeof(tmap_bwt_int_t) * (num_threads + 1), "bounds");
+  for(i = 0; i <= num_threads; i++) {
+      bounds[i] = start + (len * i) / num_threads;
+  }
+
+  // sort the runs
+  for(i = 0; i < num_threads; i++) {
+      thread_data[i].block = block;
+      thread_data[i].low = bounds[i];
+      thread_data[i].high = bounds[i+1];
+  }
+  tmap_bwt_gen_dc_run(tmap_bwt_gen_dc_run_worker, thread_data, num_threads);
+
+  // merge pairs of runs, splitting each merge across threads
+  src = block->pos;
+  dst = block->tmp;
+  for(width = 1; width < num_threads; width <<= 1) {
+      num_merges = (num_threads + (2 * width) - 1) / (2 * width);
+      per_merge = num_threads / num_merges;
+      if(per_merge < 1) per_merge = 1;
+      num_tasks = 0;
+      for(i = 0; i < num_threads; i += 2 * width) {
+          tmap_bwt_int_t low = bounds[i];
+          tmap_bwt_int_t mid = bounds[(i + width < num_threads) ? i + width : num_threads];
+          tmap_bwt_int_t high = bounds[(i + 2 * width < num_threads) ? i + 2 * width : num_threads];
+          for(j = 0; j < per_merge; j++) {
+              thread_data[num_tasks].block = block;
+              thread_data[num_tasks].src = src;
+              thread_data[num_tasks].dst = dst;
+              thread_data[num_tasks].low = low;
+              thread_data[num_tasks].mid = mid;
+              thread_data[num_tasks].high = high;
+              thread_data[num_tasks].k_low = ((high - low) * j) / per_merge;
+              thread_data[num_tasks].k_high = ((high - low) * (j + 1)) / per_merge;
+              num_tasks++;
+          }
+      }
+      tmap_bwt_gen_dc_run(tmap_bwt_gen_dc_merge_worker, thread_data, num_tasks);
+      swap = src; src = dst; dst = swap;
+  }
+  if(src != block->pos) {
+      memcpy(block->pos + start, src + start, len * sizeof(tmap_bwt_int_t));
+  }
+
+  free(bounds);
+}
+
+// sorts each bucket of the block
+static void
+tmap_bwt_gen_dc_sort_block(tmap_bwt_gen_dc_block_t *block, tmap_bwt_gen_dc_thread_t *thread_data, int32_t num_threads, int32_t bucket_low)
+{
+  tmap_bwt_int_t len;
+  int32_t i, b;
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  block->mutex = (1 < num_threads) ? &mutex : NULL;
+#endif
+
+  len = block->bucket_start[block->bucket_high] - block->bucket_start[bucket_low];
+  block->big = len / (4 * num_threads);
+  if(block->big < 1024) block->big = 1024;
+  block->bucket_next = bucket_low;
+
+  // the small buckets, each by one thread
+  for(i = 0; i < num_threads; i++) {
+      thread_data[i].block = block;
+  }
+  tmap_bwt_gen_dc_run(tmap_bwt_gen_dc_sort_worker, thread_data, num_threads);
+
+  // the big buckets, each by all threads
+  for(b = bucket_low; b < block->bucket_high; b++) {
+      if(block->big < block->bucket_start[b+1] - block->bucket_start[b]) {
+          tmap_bwt_gen_dc_sort_big(block, thread_data, num_threads, block->bucket_start[b], block->bucket_start[b+1]);
+      }
+  }
+#ifdef HAVE_LIBPTHREAD
+  block->mutex = NULL;
+#endif
+}
+
+// counts the suffixes (or samples) in each bucket, with the per-thread counts kept in thread_data
+static tmap_bwt_int_t *
+tmap_bwt_gen_dc_count(tmap_bwt_gen_dc_t *dc, tmap_bwt_gen_dc_thread_t *thread_data, int32_t num_threads, int32_t samples, tmap_bwt_int_t num)
+{
+  tmap_bwt_int_t *bucket_start = NULL;
+  int32_t i, b;
+
+  for(i = 0; i < num_threads; i++) {
+      thread_data[i].samples = samples;
+      thread_data[i].low = (num * i) / num_threads;
+      thread_data[i].high = (num * (i + 1)) / num_threads;
+  }
+  tmap_bwt_gen_dc_run(tmap_bwt_gen_dc_count_worker, thread_data, num_threads);
+
+  bucket_start = tmap_calloc(__tmap_bwt_gen_dc_num_buckets + 1, sizeof(tmap_bwt_int_t), "bucket_start");
+  for(b = 0; b < __tmap_bwt_gen_dc_num_buckets; b++) {
+      bucket_start[b+1] = bucket_start[b];
+      for(i = 0; i < num_threads; i++) {
+          bucket_start[b+1] += thread_data[i].cnt[b];
+      }
+  }
+  return bucket_start;
+}
+
+// gathers the suffixes (or samples) of the buckets [bucket_low, bucket_high) into the block
+static void
+tmap_bwt_gen_dc_fill(tmap_bwt_gen_dc_block_t *block, tmap_bwt_gen_dc_thread_t *thread_data, int32_t num_threads,
+                     tmap_bwt_int_t *bucket_start, int32_t bucket_low, int32_t bucket_high, tmap_bwt_int_t num)
+{
+  tmap_bwt_int_t offset, cnt;
+  int32_t i, b;
+
+  // the offset of each thread in each bucket, relative to the start of the block
+  for(b = bucket_low; b < bucket_high; b++) {
+      offset = bucket_start[b] - bucket_start[bucket_low];
+      for(i = 0; i < num_threads; i++) {
+          cnt = thread_data[i].cnt[b];
+          thread_data[i].cnt[b] = offset;
+          offset += cnt;
+      }
+  }
+  for(i = 0; i < num_threads; i++) {
+      thread_data[i].block = block;
+      thread_data[i].low = (num * i) / num_threads;
+      thread_data[i].high = (num * (i + 1)) / num_threads;
+      thread_data[i].bucket_low = bucket_low;
+      thread_data[i].bucket_high = bucket_high;
+  }
+  tmap_bwt_gen_dc_run(tmap_bwt_gen_dc_fill_worker, thread_data, num_threads);
+}
+
+static void
+tmap_bwt_gen_dc_init_cover(tmap_bwt_gen_dc_t *dc)
+{
+  uint32_t r = TMAP_BWT_GEN_DC_ROOT, d, i;
+  int32_t c;
+
+  // {0, 1, ..., r} and {2r, 3r, ..., (r-1)r} cover every difference modulo r^2
+  dc->v = r * r;
+  for(dc->v_log2 = 0; (1U << dc->v_log2) < dc->v; dc->v_log2++);
+  dc->cover = tmap_malloc(sizeof(uint32_t) * 2 * r, "dc->cover");
+  dc->cover_size = 0;
+  for(i = 0; i <= r; i++) dc->cover[dc->cover_size++] = i;
+  for(i = 2; i < r; i++) dc->cover[dc->cover_size++] = i * r;
+
+  dc->cover_class = tmap_malloc(sizeof(int32_t) * dc->v, "dc->cover_class");
+  for(i = 0; i < dc->v; i++) dc->cover_class[i] = -1;
+  for(c = 0; c < dc->cover_size; c++) dc->cover_class[dc->cover[c]] = c;
+
+  dc->delta = tmap_malloc(sizeof(uint32_t) * dc->v, "dc->delta");
+  for(d = 0; d < dc->v; d++) {
+      for(c = 0; c < dc->cover_size; c++) {
+          if(0 <= dc->cover_class[(dc->cover[c] + d) & (dc->v - 1)]) break;
+      }
+      if(c == dc->cover_size) {
+          tmap_error("bug encountered", Exit, OutOfRange);
+      }
+      dc->delta[d] = dc->cover[c];
+  }
+
+  // the samples are the suffixes in [0, n] starting at a residue in the cover
+  dc->class_start = tmap_malloc(sizeof(tmap_bwt_int_t) * (dc->cover_size + 1), "dc->class_start");
+  dc->class_start[0] = 0;
+  for(c = 0; c < dc->cover_size; c++) {
+      dc->class_start[c+1] = dc->class_start[c];
+      if(dc->cover[c] <= dc->n) {
+          dc->class_start[c+1] += ((dc->n - dc->cover[c]) >> dc->v_log2) + 1;
+      }
+  }
+  dc->num_samples = dc->class_start[dc->cover_size];
+  if(INT32_MAX <= dc->num_samples) {
+      tmap_error("Reference sequence too large", Exit, OutOfRange);
+  }
+}
+
+// ranks the sampled suffixes: the samples are named by their first modulus
+// bases, and the suffixes of the names in sample order give the ranks
+static void
+tmap_bwt_gen_dc_init_rank(tmap_bwt_gen_dc_t *dc, tmap_bwt_gen_dc_thread_t *thread_data, int32_t num_threads)
+{
+  tmap_bwt_gen_dc_block_t block;
+  tmap_bwt_int_t *bucket_start = NULL, i, m = dc->num_samples;
+  int32_t *names = NULL, *sa = NULL, name;
+
+  tmap_progress_print2("sorting %llu sampled suffixes", (unsigned long long int)m);
+
+  bucket_start = tmap_bwt_gen_dc_count(dc, thread_data, num_threads, 1, m);
+  memset(&block, 0, sizeof(tmap_bwt_gen_dc_block_t));
+  block.dc = dc;
+  block.mode = 0;
+  block.pos = tmap_malloc(sizeof(tmap_bwt_int_t) * m, "block.pos");
+  block.tmp = tmap_malloc(sizeof(tmap_bwt_int_t) * m, "block.tmp");
+  block.bucket_start = bucket_start;
+  block.bucket_high = __tmap_bwt_gen_dc_num_buckets;
+  tmap_bwt_gen_dc_fill(&block, thread_data, num_threads, bucket_start, 0, __tmap_bwt_gen_dc_num_buckets, m);
+  tmap_bwt_gen_dc_sort_block(&block, thread_data, num_threads, 0);
+  free(block.tmp);
+
+  // name the samples in sample order
+  names = tmap_malloc(sizeof(int32_t) * m, "names");
+  for(i = 0, name = 0; i < m; i++) {
+      tmap_bwt_int_t p = block.pos[i];
+      if(0 < i && 0 != tmap_bwt_gen_dc_cmp_prefix(dc, block.pos[i-1], p, dc->v)) name++;
+      names[dc->class_start[dc->cover_class[p & (dc->v - 1)]] + (p >> dc->v_log2)] = name;
+  }
+  free(block.pos);
+  free(bucket_start);
+
+  dc->rank = (uint32_t*)names;
+  if(name + 1 < m) { // not yet unique
+      tmap_progress_print2("ranking %llu sampled suffixes with %d names", (unsigned long long int)m, name + 1);
+      sa = tmap_malloc(sizeof(int32_t) * m, "sa");
+      if(0 != tmap_sa_gen_int(names, sa, m, name + 1)) {
+          tmap_error("bug encountered", Exit, OutOfRange);
+      }
+      for(i = 0; i < m; i++) {
+          dc->rank[sa[i]] = i;
+      }
+      free(sa);
+  }
+}
+
+static void *
+tmap_bwt_gen_dc_bases_worker(void *arg)
+{
+  tmap_bwt_gen_dc_thread_t *thread_data = (tmap_bwt_gen_dc_thread_t*)arg;
+  tmap_bwt_int_t i, p;
+
+  for(i = thread_data->low; i < thread_data->high; i++) {
+      p = thread_data->block->pos[i];
+      thread_data->bases[i] = (0 == p) ? 4 : tmap_bwt_gen_dc_get(thread_data->dc->text, p - 1);
+  }
+  return arg;
+}
+
+void
+tmap_bwt_gen_dc(const tmap_refseq_t *refseq, tmap_bwt_t *bwt, int32_t num_threads)
+{
+  tmap_bwt_gen_dc_t dc;
+  tmap_bwt_gen_dc_block_t block;
+  tmap_bwt_gen_dc_thread_t *thread_data = NULL;
+  tmap_bwt_int_t *bucket_start = NULL;
+  tmap_bwt_int_t i, n, num_words, block_max, block_len, row, out;
+  uint8_t *bases = NULL;
+  int32_t t, b, k, bucket_low, bucket_high, num_blocks;
+
+  memset(&dc, 0, sizeof(tmap_bwt_gen_dc_t));
+  n = dc.n = bwt->seq_len;
+  if(num_threads < 1) num_threads = 1;
+
+  // pack the text into words, with zeros past the end
+  num_words = (n >> 5) + 2;
+  dc.text = tmap_calloc(num_words, sizeof(uint64_t), "dc.text");
+  for(i = 0; i < ((n + 3) >> 2); i++) {
+      dc.text[i >> 3] |= (uint64_t)refseq->seq[i] << ((7 - (i & 7)) << 3);
+  }
+  if(0 != (n & 31)) {
+      dc.text[n >> 5] &= ~(UINT64_MAX >> ((n & 31) << 1));
+  }
+
+  thread_data = tmap_calloc(num_threads, sizeof(tmap_bwt_gen_dc_thread_t), "thread_data");
+  for(t = 0; t < num_threads; t++) {
+      thread_data[t].dc = &dc;
+      thread_data[t].cnt = tmap_malloc(sizeof(tmap_bwt_int_t) * __tmap_bwt_gen_dc_num_buckets, "thread_data[t].cnt");
+  }
+
+  // rank the difference cover sample
+  tmap_bwt_gen_dc_init_cover(&dc);
+  tmap_bwt_gen_dc_init_rank(&dc, thread_data, num_threads);
+
+  // bucket the suffixes, except the empty suffix (always the first)
+  bucket_start = tmap_bwt_gen_dc_count(&dc, thread_data, num_threads, 0, n);
+  block_max = n / TMAP_BWT_GEN_DC_NUM_BLOCKS;
+  if(block_max < (1 << 20)) block_max = (1 << 20);
+  for(b = 0, block_len = 0, num_blocks = 0; b < __tmap_bwt_gen_dc_num_buckets; b = bucket_high, num_blocks++) { // the longest block
+      for(bucket_high = b + 1; bucket_high < __tmap_bwt_gen_dc_num_buckets
+          && bucket_start[bucket_high+1] - bucket_start[b] <= block_max; bucket_high++);
+      if(block_len < bucket_start[bucket_high] - bucket_start[b]) block_len = bucket_start[bucket_high] - bucket_start[b];
+  }
+
+  memset(&block, 0, sizeof(tmap_bwt_gen_dc_block_t));
+  block.dc = &dc;
+  block.mode = 1;
+  block.pos = tmap_malloc(sizeof(tmap_bwt_int_t) * (block_len + 1), "block.pos");
+  block.tmp = tmap_malloc(sizeof(tmap_bwt_int_t) * (block_len + 1), "block.tmp");
+  bases = tmap_malloc(sizeof(uint8_t) * (block_len + 1), "bases");
+  block.bucket_start = tmap_malloc(sizeof(tmap_bwt_int_t) * (__tmap_bwt_gen_dc_num_buckets + 1), "block.bucket_start");
+
+  bwt->bwt = tmap_calloc(bwt->bwt_size, sizeof(uint32_t), "bwt->bwt");
+  bwt->primary = 0;
+  row = 1;
+  out = 0;
+  // the empty suffix
+  bwt->bwt[0] |= (uint32_t)tmap_bwt_gen_dc_get(dc.text, n - 1) << 30;
+  out++;
+
+  for(bucket_low = 0, k = 0; bucket_low < __tmap_bwt_gen_dc_num_buckets; bucket_low = bucket_high, k++) {
+      for(bucket_high = bucket_low + 1; bucket_high < __tmap_bwt_gen_dc_num_buckets
+          && bucket_start[bucket_high+1] - bucket_start[bucket_low] <= block_max; bucket_high++);
+      block_len = bucket_start[bucket_high] - bucket_start[bucket_low];
+      if(0 == block_len) continue;
+
+      tmap_progress_print2("sorting block %d of %d with %llu suffixes",
+                           k + 1, num_blocks, (unsigned long long int)block_len);
+
+      // gather and sort
+      for(b = bucket_low; b <= bucket_high; b++) {
+          block.bucket_start[b] = bucket_start[b] - bucket_start[bucket_low];
+      }
+      block.bucket_high = bucket_high;
+      tmap_bwt_gen_dc_fill(&block, thread_data, num_threads, bucket_start, bucket_low, bucket_high, n);
+      tmap_bwt_gen_dc_sort_block(&block, thread_data, num_threads, bucket_low);
+
+      // the BWT bases
+      for(t = 0; t < num_threads; t++) {
+          thread_data[t].block = &block;
+          thread_data[t].bases = bases;
+          thread_data[t].low = (block_len * t) / num_threads;
+          thread_data[t].high = (block_len * (t + 1)) / num_threads;
+      }
+      tmap_bwt_gen_dc_run(tmap_bwt_gen_dc_bases_worker, thread_data, num_threads);
+      for(i = 0; i < block_len; i++, row++) {
+          if(4 == bases[i]) { // the primary is not stored
+              bwt->primary = row;
+              continue;
+          }
+          // 2-bit packing for DNA
+          bwt->bwt[out >> 4] |= (uint32_t)bases[i] << ((15 - (out & 15)) << 1);
+          out++;
+      }
+  }
+  if(out != n) {
+      tmap_error("bug encountered", Exit, OutOfRange);
+  }
+
+  // free
+  for(t = 0; t < num_threads; t++) {
+      free(thread_data[t].cnt);
+  }
+  free(thread_data);
+  free(bases);
+  free(block.pos);
+  free(block.tmp);
+  free(block.bucket_start);
+  free(bucket_start);
+  free(dc.text);
+  free(dc.cover);
+  free(dc.cover_class);
+  free(dc.delta);
+  free(dc.class_start);
+  free(dc.rank);
+}
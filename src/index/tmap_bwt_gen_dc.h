@@ -0,0 +1,48 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef TMAP_BWT_GEN_DC_H
+#define TMAP_BWT_GEN_DC_H
+
+#include "../util/tmap_definitions.h"
+#include "tmap_refseq.h"
+#include "tmap_bwt.h"
+
+/*!
+  Multi-threaded BWT construction.  The suffixes are bucketed by their
+  leading bases and the buckets are sorted in parallel, a few blocks of
+  buckets at a time.  Comparisons are bounded by a difference cover sample:
+  the suffixes starting at the sampled positions are ranked first, so any
+  two suffixes are ordered after comparing fewer bases than the cover
+  modulus, regardless of how repetitive the reference is.
+  */
+
+/*!
+  The square root of the difference cover modulus (a power of two)
+  */
+#define TMAP_BWT_GEN_DC_ROOT 64
+
+/*!
+  The number of leading bases by which suffixes are bucketed
+  */
+#define TMAP_BWT_GEN_DC_BUCKET_WIDTH 10
+
+/*!
+  The minimum number of blocks in which the suffixes are sorted, bounding the memory used
+  */
+#define TMAP_BWT_GEN_DC_NUM_BLOCKS 16
+
+/*!
+  The number of suffixes below which a bucket is sorted by insertion
+  */
+#define TMAP_BWT_GEN_DC_INSERTION_SORT 16
+
+/*!
+  constructs the BWT string of the reference with multiple threads
+  @param  refseq       the packed reference sequence (forward and reverse compliment)
+  @param  bwt          the BWT with its sequence length set; the 2-bit packed BWT string and the primary index will be set
+  @param  num_threads  the number of threads
+  @details             the BWT string is identical to that of the "is" and "bwtsw" algorithms
+  */
+void
+tmap_bwt_gen_dc(const tmap_refseq_t *refseq, tmap_bwt_t *bwt, int32_t num_threads);
+
+#endif
@@ -0,0 +1,501 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <config.h>
+
+#include "../util/tmap_error.h"
+#include "../util/tmap_alloc.h"
+#include "../util/tmap_progress.h"
+#include "../util/tmap_definitions.h"
+#include "../io/tmap_file.h"
+#include "tmap_bwt.h"
+#include "tmap_bwt_kmer.h"
+
+// the number of 64-bit header fields, in the order written
+#define __TMAP_BWT_KMER_N_HEADER 5
+
+int32_t
+tmap_bwt_kmer_exists(const char *fn_fasta)
+{
+  char *fn_kmer = NULL;
+  int32_t ret;
+
+  fn_kmer = tmap_get_file_name(fn_fasta, TMAP_KMER_FILE);
+  ret = (0 == access(fn_kmer, R_OK)) ? 1 : 0;
+  free(fn_kmer);
+
+  return ret;
+}
+
+static void
+tmap_bwt_kmer_read_header(tmap_bwt_kmer_t *kmer, tmap_file_t *fp_kmer)
+{
+  if(1 != tmap_file_fread(&kmer->width, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fread(&kmer->seq_len, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fread(&kmer->n_blocks, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fread(&kmer->n_words, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fread(&kmer->n_gaps, sizeof(uint64_t), 1, fp_kmer)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+}
+
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_read(const char *fn_fasta)
+{
+  char *fn_kmer = NULL;
+  tmap_file_t *fp_kmer = NULL;
+  tmap_bwt_kmer_t *kmer = NULL;
+  uint64_t n_blocks;
+
+  fn_kmer = tmap_get_file_name(fn_fasta, TMAP_KMER_FILE);
+  fp_kmer = tmap_file_fopen(fn_kmer, "rb", TMAP_KMER_COMPRESSION);
+
+  kmer = tmap_calloc(1, sizeof(tmap_bwt_kmer_t), "kmer");
+
+  tmap_bwt_kmer_read_header(kmer, fp_kmer);
+  n_blocks = kmer->n_blocks + 1;
+
+  kmer->blocks = tmap_malloc(sizeof(uint64_t) * 2 * n_blocks, "kmer->blocks");
+  kmer->words = tmap_malloc(sizeof(uint64_t) * (1 + kmer->n_words), "kmer->words");
+  kmer->gaps = tmap_malloc(sizeof(uint64_t) * (1 + 2 * kmer->n_gaps), "kmer->gaps");
+
+  if(2 * n_blocks != tmap_file_fread(kmer->blocks, sizeof(uint64_t), 2 * n_blocks, fp_kmer)
+     || kmer->n_words != tmap_file_fread(kmer->words, sizeof(uint64_t), kmer->n_words, fp_kmer)
+     || 2 * kmer->n_gaps != tmap_file_fread(kmer->gaps, sizeof(uint64_t), 2 * kmer->n_gaps, fp_kmer)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+
+  tmap_file_fclose(fp_kmer);
+  free(fn_kmer);
+
+  kmer->is_shm = 0;
+
+  return kmer;
+}
+
+// sets the table arrays in a buffer holding them in the order written by tmap_bwt_kmer_write
+static uint8_t *
+tmap_bwt_kmer_set_buffer(tmap_bwt_kmer_t *kmer, uint8_t *buf)
+{
+  kmer->blocks = (uint64_t*)buf;
+  buf += sizeof(uint64_t) * 2 * (kmer->n_blocks + 1);
+  kmer->words = (uint64_t*)buf;
+  buf += sizeof(uint64_t) * kmer->n_words;
+  kmer->gaps = (uint64_t*)buf;
+  buf += sizeof(uint64_t) * 2 * kmer->n_gaps;
+  return buf;
+}
+
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_mmap(const char *fn_fasta, int32_t populate)
+{
+  char *fn_kmer = NULL;
+  tmap_bwt_kmer_t *kmer = NULL;
+  uint8_t *buf = NULL;
+
+  fn_kmer = tmap_get_file_name(fn_fasta, TMAP_KMER_FILE);
+
+  kmer = tmap_calloc(1, sizeof(tmap_bwt_kmer_t), "kmer");
+  kmer->mmap_buf = buf = tmap_file_mmap(fn_kmer, &kmer->mmap_len, populate);
+
+  // fixed length data, in the order written by tmap_bwt_kmer_write
+  if(kmer->mmap_len < __TMAP_BWT_KMER_N_HEADER*sizeof(uint64_t)) {
+      tmap_error(fn_kmer, Exit, ReadFileError);
+  }
+  memcpy(&kmer->width, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->seq_len, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->n_blocks, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->n_words, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->n_gaps, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+
+  // variable length data
+  if(kmer->mmap_len < tmap_bwt_kmer_shm_num_bytes(kmer)) {
+      tmap_error(fn_kmer, Exit, ReadFileError);
+  }
+  tmap_bwt_kmer_set_buffer(kmer, buf);
+
+  free(fn_kmer);
+
+  kmer->is_shm = 0;
+
+  return kmer;
+}
+
+void
+tmap_bwt_kmer_write(const char *fn_fasta, tmap_bwt_kmer_t *kmer)
+{
+  char *fn_kmer = NULL;
+  tmap_file_t *fp_kmer = NULL;
+  uint64_t n_blocks = kmer->n_blocks + 1;
+
+  fn_kmer = tmap_get_file_name(fn_fasta, TMAP_KMER_FILE);
+  fp_kmer = tmap_file_fopen(fn_kmer, "wb", TMAP_KMER_COMPRESSION);
+
+  if(1 != tmap_file_fwrite(&kmer->width, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fwrite(&kmer->seq_len, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fwrite(&kmer->n_blocks, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fwrite(&kmer->n_words, sizeof(uint64_t), 1, fp_kmer)
+     || 1 != tmap_file_fwrite(&kmer->n_gaps, sizeof(uint64_t), 1, fp_kmer)
+     || 2 * n_blocks != tmap_file_fwrite(kmer->blocks, sizeof(uint64_t), 2 * n_blocks, fp_kmer)
+     || kmer->n_words != tmap_file_fwrite(kmer->words, sizeof(uint64_t), kmer->n_words, fp_kmer)
+     || 2 * kmer->n_gaps != tmap_file_fwrite(kmer->gaps, sizeof(uint64_t), 2 * kmer->n_gaps, fp_kmer)) {
+      tmap_error(NULL, Exit, WriteFileError);
+  }
+
+  tmap_file_fclose(fp_kmer);
+  free(fn_kmer);
+}
+
+size_t
+tmap_bwt_kmer_shm_num_bytes(tmap_bwt_kmer_t *kmer)
+{
+  // returns the number of bytes to allocate for shared memory
+  size_t n = 0;
+
+  n += sizeof(uint64_t) * __TMAP_BWT_KMER_N_HEADER; // width, seq_len, n_blocks, n_words, n_gaps
+  n += sizeof(uint64_t) * 2 * (kmer->n_blocks + 1); // blocks
+  n += sizeof(uint64_t) * kmer->n_words; // words
+  n += sizeof(uint64_t) * 2 * kmer->n_gaps; // gaps
+
+  return n;
+}
+
+size_t
+tmap_bwt_kmer_shm_read_num_bytes(const char *fn_fasta)
+{
+  char *fn_kmer = NULL;
+  tmap_file_t *fp_kmer = NULL;
+  tmap_bwt_kmer_t kmer;
+
+  fn_kmer = tmap_get_file_name(fn_fasta, TMAP_KMER_FILE);
+  fp_kmer = tmap_file_fopen(fn_kmer, "rb", TMAP_KMER_COMPRESSION);
+
+  // No need to read in the arrays
+  tmap_bwt_kmer_read_header(&kmer, fp_kmer);
+
+  tmap_file_fclose(fp_kmer);
+  free(fn_kmer);
+
+  return tmap_bwt_kmer_shm_num_bytes(&kmer);
+}
+
+uint8_t *
+tmap_bwt_kmer_shm_pack(tmap_bwt_kmer_t *kmer, uint8_t *buf)
+{
+  // fixed length data
+  memcpy(buf, &kmer->width, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &kmer->seq_len, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &kmer->n_blocks, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &kmer->n_words, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &kmer->n_gaps, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  // variable length data
+  memcpy(buf, kmer->blocks, sizeof(uint64_t) * 2 * (kmer->n_blocks + 1)); buf += sizeof(uint64_t) * 2 * (kmer->n_blocks + 1);
+  memcpy(buf, kmer->words, sizeof(uint64_t) * kmer->n_words); buf += sizeof(uint64_t) * kmer->n_words;
+  memcpy(buf, kmer->gaps, sizeof(uint64_t) * 2 * kmer->n_gaps); buf += sizeof(uint64_t) * 2 * kmer->n_gaps;
+
+  return buf;
+}
+
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_shm_unpack(uint8_t *buf)
+{
+  tmap_bwt_kmer_t *kmer = NULL;
+
+  if(NULL == buf) return NULL;
+
+  kmer = tmap_calloc(1, sizeof(tmap_bwt_kmer_t), "kmer");
+
+  // fixed length data
+  memcpy(&kmer->width, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->seq_len, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->n_blocks, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->n_words, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&kmer->n_gaps, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  // variable length data
+  tmap_bwt_kmer_set_buffer(kmer, buf);
+
+  kmer->is_shm = 1;
+
+  return kmer;
+}
+
+void
+tmap_bwt_kmer_destroy(tmap_bwt_kmer_t *kmer)
+{
+  if(NULL == kmer) return;
+  if(1 == kmer->is_shm) {
+      free(kmer);
+  }
+  else if(NULL != kmer->mmap_buf) {
+      tmap_file_munmap(kmer->mmap_buf, kmer->mmap_len);
+      free(kmer);
+  }
+  else {
+      free(kmer->blocks);
+      free(kmer->words);
+      free(kmer->gaps);
+      free(kmer);
+  }
+}
+
+// the i-th difference of a block whose differences are w bits
+static inline uint64_t
+tmap_bwt_kmer_get_diff(const uint64_t *words, uint64_t w, uint64_t i)
+{
+  uint64_t p, v;
+  if(0 == w) return 0;
+  p = i * w;
+  v = words[p >> 6] >> (p & 63);
+  if(64 < (p & 63) + w) v |= words[(p >> 6) + 1] << (64 - (p & 63));
+  return (64 == w) ? v : (v & ((1ull << w) - 1));
+}
+
+// sets the i-th difference of a block whose differences are w bits, the words starting zeroed
+static inline void
+tmap_bwt_kmer_set_diff(uint64_t *words, uint64_t w, uint64_t i, uint64_t v)
+{
+  uint64_t p;
+  if(0 == w) return;
+  p = i * w;
+  words[p >> 6] |= v << (p & 63);
+  if(64 < (p & 63) + w) words[(p >> 6) + 1] |= v >> (64 - (p & 63));
+}
+
+tmap_bwt_int_t
+tmap_bwt_kmer_get(const tmap_bwt_kmer_t *kmer, uint64_t key, tmap_bwt_int_t *k, tmap_bwt_int_t *l)
+{
+  const uint64_t *block = kmer->blocks + ((key >> TMAP_BWT_KMER_BLOCK_LOG2) << 1);
+  const uint64_t *words = kmer->words + block[1];
+  uint64_t i = key & (TMAP_BWT_KMER_BLOCK_SIZE - 1);
+  uint64_t w = block[3] - block[1]; // the block holds TMAP_BWT_KMER_BLOCK_SIZE differences of w bits in w words
+  uint64_t s, e;
+  int64_t low, high, mid;
+
+  s = block[0] + tmap_bwt_kmer_get_diff(words, w, i);
+  e = (i < TMAP_BWT_KMER_BLOCK_SIZE - 1) ? (block[0] + tmap_bwt_kmer_get_diff(words, w, i + 1)) : block[2];
+
+  // short suffixes between this k-mer and the next
+  if(0 < kmer->n_gaps && kmer->gaps[0] <= key && key <= kmer->gaps[(kmer->n_gaps - 1) << 1]) {
+      low = 0; high = kmer->n_gaps - 1;
+      while(low <= high) {
+          mid = (low + high) >> 1;
+          if(kmer->gaps[mid << 1] < key) low = mid + 1;
+          else if(key < kmer->gaps[mid << 1]) high = mid - 1;
+          else {
+              e -= kmer->gaps[(mid << 1) + 1];
+              break;
+          }
+      }
+  }
+
+  if(e <= s) return 0; // does not occur
+  (*k) = s;
+  (*l) = e - 1;
+  return e - s;
+}
+
+// appends the lower bounds of a block of k-mers to the table
+static void
+tmap_bwt_kmer_add_block(tmap_bwt_kmer_t *kmer, const uint64_t *s, uint64_t *m_words)
+{
+  uint64_t i, w, d, *words;
+
+  d = s[TMAP_BWT_KMER_BLOCK_SIZE - 1] - s[0];
+  for(w = 0; 0 < d; d >>= 1) w++;
+
+  kmer->blocks[kmer->n_blocks << 1] = s[0];
+  kmer->blocks[(kmer->n_blocks << 1) + 1] = kmer->n_words;
+  kmer->n_blocks++;
+
+  while((*m_words) < kmer->n_words + w + 1) {
+      (*m_words) <<= 1;
+      kmer->words = tmap_realloc(kmer->words, sizeof(uint64_t) * (*m_words), "kmer->words");
+  }
+  words = kmer->words + kmer->n_words;
+  memset(words, 0, sizeof(uint64_t) * w);
+  for(i = 0; i < TMAP_BWT_KMER_BLOCK_SIZE; i++) {
+      tmap_bwt_kmer_set_diff(words, w, i, s[i] - s[0]);
+  }
+  kmer->n_words += w;
+}
+
+// records the short suffixes between a k-mer and the next
+static void
+tmap_bwt_kmer_add_gap(tmap_bwt_kmer_t *kmer, uint64_t key, uint64_t gap, uint64_t *m_gaps)
+{
+  if((*m_gaps) <= kmer->n_gaps) {
+      (*m_gaps) = (0 == (*m_gaps)) ? 16 : ((*m_gaps) << 1);
+      kmer->gaps = tmap_realloc(kmer->gaps, sizeof(uint64_t) * 2 * (*m_gaps), "kmer->gaps");
+  }
+  kmer->gaps[kmer->n_gaps << 1] = key;
+  kmer->gaps[(kmer->n_gaps << 1) + 1] = gap;
+  kmer->n_gaps++;
+}
+
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_gen(const tmap_bwt_t *bwt, int32_t width)
+{
+  tmap_bwt_kmer_t *kmer = NULL;
+  tmap_bwt_int_t *fk = NULL, *fl = NULL;
+  tmap_bwt_int_t bk[TMAP_BWT_KMER_BLOCK_SIZE], bl[TMAP_BWT_KMER_BLOCK_SIZE];
+  tmap_bwt_int_t cntk[4], cntl[4], ok, ol;
+  uint64_t s[TMAP_BWT_KMER_BLOCK_SIZE];
+  uint64_t i, f, t, p, n, n_front, n_ext, key, end, m_words, m_gaps;
+  int32_t d, front_width, ext_width;
+  uint8_t c;
+
+  if(width < TMAP_BWT_KMER_WIDTH_MIN || TMAP_BWT_KMER_WIDTH_MAX < width) {
+      tmap_error("k-mer width out of range", Exit, OutOfRange);
+  }
+
+  front_width = (width < TMAP_BWT_KMER_FRONTIER_WIDTH) ? width : TMAP_BWT_KMER_FRONTIER_WIDTH;
+  ext_width = width - front_width;
+  n_front = 1ull << (front_width << 1);
+  n_ext = 1ull << (ext_width << 1);
+
+  tmap_progress_print("constructing the k-mer table of width %d", width);
+
+  // the SA intervals of the leading bases, the first base searched the least
+  // significant, built one base at a time in place
+  fk = tmap_malloc(sizeof(tmap_bwt_int_t) * n_front, "fk");
+  fl = tmap_malloc(sizeof(tmap_bwt_int_t) * n_front, "fl");
+  for(c = 0; c < 4; c++) {
+      fk[c] = bwt->L2[c] + 1;
+      fl[c] = bwt->L2[c+1];
+  }
+  for(d = 1; d < front_width; d++) {
+      n = 1ull << (d << 1); // the number of parents
+      for(f = 0; f < n; f += TMAP_BWT_KMER_BLOCK_SIZE) {
+          uint64_t f_end = (f + TMAP_BWT_KMER_BLOCK_SIZE < n) ? (f + TMAP_BWT_KMER_BLOCK_SIZE) : n;
+          for(p = f; p < f_end; p++) {
+              if(fk[p] <= fl[p]) {
+                  tmap_bwt_prefetch_occ(bwt, fk[p] - 1);
+                  tmap_bwt_prefetch_occ(bwt, fl[p]);
+              }
+          }
+          for(p = f; p < f_end; p++) {
+              tmap_bwt_int_t k = fk[p], l = fl[p];
+              // NB: the children of p are p + c*n, and only p itself has been read
+              if(k <= l) {
+                  tmap_bwt_2occ4(bwt, k - 1, l, cntk, cntl);
+                  for(c = 4; 0 < c; c--) {
+                      fk[p + (c-1) * n] = bwt->L2[c-1] + cntk[c-1] + 1;
+                      fl[p + (c-1) * n] = bwt->L2[c-1] + cntl[c-1];
+                  }
+              }
+              else {
+                  for(c = 0; c < 4; c++) {
+                      fk[p + c * n] = 1;
+                      fl[p + c * n] = 0;
+                  }
+              }
+          }
+      }
+  }
+
+  kmer = tmap_calloc(1, sizeof(tmap_bwt_kmer_t), "kmer");
+  kmer->width = width;
+  kmer->seq_len = bwt->seq_len;
+  n = 1ull << (width << 1); // the number of k-mers
+  kmer->blocks = tmap_malloc(sizeof(uint64_t) * 2 * ((n >> TMAP_BWT_KMER_BLOCK_LOG2) + 1), "kmer->blocks");
+  m_words = 1024;
+  kmer->words = tmap_malloc(sizeof(uint64_t) * m_words, "kmer->words");
+  m_gaps = 0;
+
+  // extend the leading bases by the trailing bases of each k-mer, a block of k-mers at a time, in order
+  end = 1; // one past the upper bound of the last k-mer that occurs
+  for(t = 0; t < n_ext; t++) {
+      for(f = 0; f < n_front; f += TMAP_BWT_KMER_BLOCK_SIZE) {
+          for(i = 0; i < TMAP_BWT_KMER_BLOCK_SIZE; i++) {
+              bk[i] = fk[f + i];
+              bl[i] = fl[f + i];
+          }
+          for(d = 0; d < ext_width; d++) {
+              c = (t >> (d << 1)) & 3;
+              for(i = 0; i < TMAP_BWT_KMER_BLOCK_SIZE; i++) {
+                  if(bk[i] <= bl[i]) {
+                      tmap_bwt_prefetch_occ(bwt, bk[i] - 1);
+                      tmap_bwt_prefetch_occ(bwt, bl[i]);
+                  }
+              }
+              for(i = 0; i < TMAP_BWT_KMER_BLOCK_SIZE; i++) {
+                  if(bk[i] <= bl[i]) {
+                      tmap_bwt_2occ(bwt, bk[i] - 1, bl[i], c, &ok, &ol);
+                      bk[i] = bwt->L2[c] + ok + 1;
+                      bl[i] = bwt->L2[c] + ol;
+                  }
+              }
+          }
+          // the lower bounds, those of k-mers that do not occur being the next lower bound
+          key = (t << (front_width << 1)) + f;
+          for(i = 0; i < TMAP_BWT_KMER_BLOCK_SIZE; i++) {
+              if(bk[i] <= bl[i]) {
+                  if(bk[i] != end && 0 < key + i) {
+                      tmap_bwt_kmer_add_gap(kmer, key + i - 1, bk[i] - end, &m_gaps);
+                  }
+                  s[i] = bk[i];
+                  end = bl[i] + 1;
+              }
+              else {
+                  s[i] = end;
+              }
+          }
+          tmap_bwt_kmer_add_block(kmer, s, &m_words);
+      }
+  }
+  if(end != bwt->seq_len + 1) {
+      tmap_bwt_kmer_add_gap(kmer, n - 1, bwt->seq_len + 1 - end, &m_gaps);
+  }
+  kmer->blocks[kmer->n_blocks << 1] = bwt->seq_len + 1;
+  kmer->blocks[(kmer->n_blocks << 1) + 1] = kmer->n_words;
+
+  free(fk);
+  free(fl);
+
+  tmap_progress_print2("constructed the k-mer table [%llu bytes]",
+                       (unsigned long long int)tmap_bwt_kmer_shm_num_bytes(kmer));
+
+  return kmer;
+}
+
+void
+tmap_bwt_kmer_update(const char *fn_fasta, int32_t width)
+{
+  tmap_bwt_t *bwt = NULL;
+  tmap_bwt_kmer_t *kmer = NULL;
+
+  bwt = tmap_bwt_read(fn_fasta);
+  kmer = tmap_bwt_kmer_gen(bwt, width);
+  tmap_bwt_kmer_write(fn_fasta, kmer);
+  tmap_bwt_kmer_destroy(kmer);
+  tmap_bwt_destroy(bwt);
+}
+
+int
+tmap_bwt_kmer_main(int argc, char *argv[])
+{
+  int c, help = 0;
+  int32_t width = TMAP_BWT_KMER_WIDTH;
+
+  while((c = getopt(argc, argv, "w:vh")) >= 0) {
+      switch(c) {
+        case 'w': width = atoi(optarg); break;
+        case 'v': tmap_progress_set_verbosity(1); break;
+        case 'h': help = 1; break;
+        default: return 1;
+      }
+  }
+  if(1 != argc - optind || 1 == help) {
+      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-w INT -v -h] <in.fasta>\n", PACKAGE, argv[0]);
+      return 1;
+  }
+  if(width < TMAP_BWT_KMER_WIDTH_MIN || TMAP_BWT_KMER_WIDTH_MAX < width) {
+      tmap_error("option -w out of range", Exit, CommandLineArgument);
+  }
+  tmap_bwt_kmer_update(argv[optind], width);
+
+  return 0;
+}
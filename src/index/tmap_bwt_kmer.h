@@ -0,0 +1,186 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef TMAP_BWT_KMER_H
+#define TMAP_BWT_KMER_H
+
+#include <stdint.h>
+#include "../util/tmap_definitions.h"
+#include "tmap_bwt.h"
+
+/*!
+  A k-mer prefix table for the BWT.  It gives the SA interval of every
+  k-mer with one lookup, so an exact search skips its first k steps, for
+  k-mers longer than the occurrence hash can afford.  The k-mers are keyed
+  with the first base searched as the least significant, so their lower
+  bounds never decrease.  The lower bounds are stored in blocks, each as the
+  first lower bound and the bit-packed differences from it, using the fewest
+  bits for the block.  The upper bound of a k-mer is one less than the next
+  lower bound, except for the few k-mers followed by suffixes shorter than k
+  bases, which are stored apart.
+  */
+
+/*!
+  The default k-mer width
+  */
+#define TMAP_BWT_KMER_WIDTH 14
+
+/*!
+  The minimum k-mer width
+  */
+#define TMAP_BWT_KMER_WIDTH_MIN 4
+
+/*!
+  The maximum k-mer width
+  */
+#define TMAP_BWT_KMER_WIDTH_MAX 16
+
+/*!
+  The log2 of the number of k-mers in a block
+  */
+#define TMAP_BWT_KMER_BLOCK_LOG2 6
+
+/*!
+  The number of k-mers in a block
+  */
+#define TMAP_BWT_KMER_BLOCK_SIZE (1 << TMAP_BWT_KMER_BLOCK_LOG2)
+
+/*!
+  The number of leading bases whose SA intervals are kept in memory during construction
+  */
+#define TMAP_BWT_KMER_FRONTIER_WIDTH 11
+
+/*!
+  The k-mer prefix table
+  */
+typedef struct __tmap_bwt_kmer_t {
+    uint64_t width;  /*!< the k-mer width */
+    uint64_t seq_len;  /*!< the reference sequence length of the BWT */
+    uint64_t n_blocks;  /*!< the number of blocks */
+    uint64_t n_words;  /*!< the number of words of bit-packed differences */
+    uint64_t n_gaps;  /*!< the number of k-mers whose upper bounds are stored apart */
+    uint64_t *blocks;  /*!< for each block, and one past the last, the lower bound of its first k-mer and the offset of its differences */
+    uint64_t *words;  /*!< the bit-packed differences */
+    uint64_t *gaps;  /*!< for each k-mer whose upper bound is stored apart, the k-mer and the suffixes before the next lower bound */
+    uint32_t is_shm;  /*!< 1 if loaded from shared memory, 0 otherwise */
+    void *mmap_buf; /*!< the memory mapped k-mer file, NULL if not memory mapped */
+    size_t mmap_len; /*!< the length of the memory mapped k-mer file */
+} tmap_bwt_kmer_t;
+
+/*!
+  prefetches the block of a k-mer
+  @param  _kmer  the k-mer table
+  @param  _key   the k-mer
+  */
+#define tmap_bwt_kmer_prefetch_block(_kmer, _key) \
+  __builtin_prefetch((_kmer)->blocks + (((_key) >> TMAP_BWT_KMER_BLOCK_LOG2) << 1))
+
+/*!
+  prefetches the differences of a k-mer, reading its block
+  @param  _kmer  the k-mer table
+  @param  _key   the k-mer
+  */
+#define tmap_bwt_kmer_prefetch_diff(_kmer, _key) do { \
+    const uint64_t *__block = (_kmer)->blocks + (((_key) >> TMAP_BWT_KMER_BLOCK_LOG2) << 1); \
+    __builtin_prefetch((_kmer)->words + __block[1] \
+                       + ((((_key) & (TMAP_BWT_KMER_BLOCK_SIZE - 1)) * (__block[3] - __block[1])) >> 6)); \
+} while(0)
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @return           1 if the k-mer table file exists, 0 otherwise
+  */
+int32_t
+tmap_bwt_kmer_exists(const char *fn_fasta);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @return           pointer to the k-mer table
+  */
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_read(const char *fn_fasta);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @param  populate  1 to read the memory mapped file into memory now, 0 otherwise
+  @return           pointer to the k-mer table, using the memory mapped file in place
+  */
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_mmap(const char *fn_fasta, int32_t populate);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @param  kmer      the k-mer table to write
+  */
+void
+tmap_bwt_kmer_write(const char *fn_fasta, tmap_bwt_kmer_t *kmer);
+
+/*!
+  @param  kmer  the k-mer table
+  @return       the number of bytes required for this table in shared memory
+  */
+size_t
+tmap_bwt_kmer_shm_num_bytes(tmap_bwt_kmer_t *kmer);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @return           the number of bytes required for this table in shared memory
+  */
+size_t
+tmap_bwt_kmer_shm_read_num_bytes(const char *fn_fasta);
+
+/*!
+  @param  kmer  the k-mer table to pack
+  @param  buf   the byte array in which to pack the table
+  @return       a pointer to the next unused byte in memory
+  */
+uint8_t *
+tmap_bwt_kmer_shm_pack(tmap_bwt_kmer_t *kmer, uint8_t *buf);
+
+/*!
+  @param  buf  the byte array in which the table was packed
+  @return      a pointer to the k-mer table, NULL if none
+  */
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_shm_unpack(uint8_t *buf);
+
+/*!
+  @param  kmer  the k-mer table to destroy
+  */
+void
+tmap_bwt_kmer_destroy(tmap_bwt_kmer_t *kmer);
+
+/*!
+  @param  bwt    the bwt structure
+  @param  width  the k-mer width
+  @return        the k-mer table
+  */
+tmap_bwt_kmer_t *
+tmap_bwt_kmer_gen(const tmap_bwt_t *bwt, int32_t width);
+
+/*!
+  creates the k-mer table file for an existing index
+  @param  fn_fasta  the FASTA file name
+  @param  width     the k-mer width
+  */
+void
+tmap_bwt_kmer_update(const char *fn_fasta, int32_t width);
+
+/*!
+  @param  kmer  the k-mer table
+  @param  key   the k-mer, with the first base searched in the lowest two bits
+  @param  k     the lower bound of the SA interval
+  @param  l     the upper bound of the SA interval
+  @return       the size of the SA interval, 0 if the k-mer does not occur (k and l are not set)
+  */
+tmap_bwt_int_t
+tmap_bwt_kmer_get(const tmap_bwt_kmer_t *kmer, uint64_t key, tmap_bwt_int_t *k, tmap_bwt_int_t *l);
+
+/*!
+  main-like function for 'tmap bwtkmer'
+  @param  argc  the number of arguments
+  @param  argv  the argument list
+  @return       0 if executed successful
+  */
+int
+tmap_bwt_kmer_main(int argc, char *argv[]);
+
+#endif
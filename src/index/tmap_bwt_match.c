@@ -53,6 +53,20 @@ tmap_bwt_match_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t *str,
   return tmap_bwt_match_hash_exact_reverse(bwt, len, str, match_sa, NULL);
 }
 
+void
+tmap_bwt_match_exact_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                           tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size)
+{
+  tmap_bwt_match_hash_exact_batch(bwt, n, str, len, match_sa, size, NULL);
+}
+
+void
+tmap_bwt_match_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                                   tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size)
+{
+  tmap_bwt_match_hash_exact_reverse_batch(bwt, n, str, len, match_sa, size, NULL);
+}
+
 inline tmap_bwt_int_t
 tmap_bwt_match_exact_alt(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa)
 {
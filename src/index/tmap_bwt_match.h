@@ -18,6 +18,12 @@ typedef struct {
     uint32_t offset;  /*!< the number of (read) bases used so far in this search (one-based) */
 } tmap_bwt_match_occ_t;
 
+/*!
+  The number of queries advanced together by the batched searches; the occurrence arrays
+  for every query in the batch are prefetched before any of them are read
+  */
+#define TMAP_BWT_MATCH_BATCH_SIZE 32
+
 /*! 
   analagous function to tmap_bwt_occ
   @param  bwt      pointer to the bwt structure 
@@ -108,6 +114,34 @@ tmap_bwt_match_exact(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bw
 tmap_bwt_int_t
 tmap_bwt_match_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa);
 
+/*! 
+  computes the SA intervals for a batch of independent sequences, using forward search
+  @param  bwt       pointer to the bwt structure 
+  @param  n         the number of sequences
+  @param  str       the DNA sequences in 2-bit format
+  @param  len       the length of each sequence
+  @param  match_sa  the match structure returned for each sequence
+  @param  size      the size of the SA interval returned for each sequence, 0 if none found
+  @details          the results are identical to calling tmap_bwt_match_exact on each sequence
+  */
+void
+tmap_bwt_match_exact_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                           tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size);
+
+/*! 
+  computes the SA intervals for a batch of independent sequences, using reverse search
+  @param  bwt       pointer to the bwt structure 
+  @param  n         the number of sequences
+  @param  str       the DNA sequences in 2-bit format
+  @param  len       the length of each sequence
+  @param  match_sa  the match structure returned for each sequence
+  @param  size      the size of the SA interval returned for each sequence, 0 if none found
+  @details          the results are identical to calling tmap_bwt_match_exact_reverse on each sequence
+  */
+void
+tmap_bwt_match_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                                   tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size);
+
 /*! 
   computes the SA interval for the given sequence (if any), using forward search
   @param  bwt       pointer to the bwt structure 
@@ -7,6 +7,7 @@
 #include "../util/tmap_definitions.h"
 #include "tmap_bwt_match.h"
 #include "tmap_bwt_match_hash.h"
+#include "tmap_bwt_kmer.h"
 
 // TODO: use the register keyword on pointers
 #if TMAP_BWT_INT_MAX == 0xffffu
@@ -15,6 +16,76 @@ TMAP_HASH_MAP_INIT_INT(tmap_bwt_match_hash, tmap_bwt_int_t)
 TMAP_HASH_MAP_INIT_INT64(tmap_bwt_match_hash, tmap_bwt_int_t) 
 #endif
 
+// spreads the position and base over the cache entries
+#define __tmap_bwt_match_cache_index(_cache, _key, _c) \
+  (((((uint64_t)(_key) << 2) | (_c)) * 0x9E3779B97F4A7C15ULL) >> 17 & (_cache)->mask)
+
+tmap_bwt_match_cache_t*
+tmap_bwt_match_cache_init(size_t size)
+{
+  tmap_bwt_match_cache_t *cache = NULL;
+  uint64_t n = 1;
+
+  while((n << 1) * sizeof(tmap_bwt_match_cache_entry_t) <= size) {
+      n <<= 1;
+  }
+  cache = tmap_calloc(1, sizeof(tmap_bwt_match_cache_t), "cache");
+  cache->entries = tmap_calloc(n, sizeof(tmap_bwt_match_cache_entry_t), "cache->entries");
+  cache->mask = n - 1;
+  return cache;
+}
+
+void
+tmap_bwt_match_cache_destroy(tmap_bwt_match_cache_t *cache)
+{
+  if(NULL == cache) return;
+  free(cache->entries);
+  free(cache);
+}
+
+static inline void
+tmap_bwt_match_cache_put(tmap_bwt_match_cache_t *cache, tmap_bwt_int_t key, uint8_t c, tmap_bwt_int_t val)
+{
+  tmap_bwt_match_cache_entry_t *e = &cache->entries[__tmap_bwt_match_cache_index(cache, key, c)];
+  uint32_t seq;
+
+  seq = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+  if(1 == (seq & 1) 
+     || 0 == __atomic_compare_exchange_n(&e->seq, &seq, seq + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      return; // another thread is writing this entry
+  }
+  __atomic_store_n(&e->c, c, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->key, key, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->val, val, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static inline int32_t
+tmap_bwt_match_cache_get(tmap_bwt_match_cache_t *cache, tmap_bwt_int_t key, uint8_t c, tmap_bwt_int_t *val)
+{
+  tmap_bwt_match_cache_entry_t *e = &cache->entries[__tmap_bwt_match_cache_index(cache, key, c)];
+  uint32_t seq, e_c;
+  tmap_bwt_int_t e_key;
+
+  seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+  if(0 == seq || 1 == (seq & 1)) return 0; // empty or being written
+  e_c = __atomic_load_n(&e->c, __ATOMIC_RELAXED);
+  e_key = __atomic_load_n(&e->key, __ATOMIC_RELAXED);
+  (*val) = __atomic_load_n(&e->val, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if(seq != __atomic_load_n(&e->seq, __ATOMIC_RELAXED)) return 0; // overwritten while reading
+  return (e_key == key && e_c == c) ? 1 : 0;
+}
+
+tmap_bwt_match_hash_t*
+tmap_bwt_match_hash_init_shared(tmap_bwt_match_cache_t *cache)
+{
+  tmap_bwt_match_hash_t *h = NULL;
+  h = tmap_calloc(sizeof(tmap_bwt_match_hash_t), 1, "hash");
+  h->cache = cache;
+  return h;
+}
+
 tmap_bwt_match_hash_t*
 tmap_bwt_match_hash_init()
 {
@@ -31,6 +102,13 @@ void
 tmap_bwt_match_hash_destroy(tmap_bwt_match_hash_t *h)
 {
   int32_t i;
+  if(NULL == h) return;
+  if(NULL != h->cache) {
+      __atomic_add_fetch(&h->cache->hits, h->hits, __ATOMIC_RELAXED);
+      __atomic_add_fetch(&h->cache->misses, h->misses, __ATOMIC_RELAXED);
+      free(h);
+      return;
+  }
   for(i=0;i<4;i++) {
       tmap_hash_t(tmap_bwt_match_hash) *hash = (tmap_hash_t(tmap_bwt_match_hash)*)(h->hash[i]);
       tmap_hash_destroy(tmap_bwt_match_hash, hash); 
@@ -42,6 +120,7 @@ void
 tmap_bwt_match_hash_clear(tmap_bwt_match_hash_t *h)
 {
   int32_t i;
+  if(NULL != h->cache) return;
   for(i=0;i<4;i++) {
       tmap_hash_t(tmap_bwt_match_hash) *hash = (tmap_hash_t(tmap_bwt_match_hash)*)(h->hash[i]);
       tmap_hash_clear(tmap_bwt_match_hash, hash); 
@@ -53,7 +132,12 @@ tmap_bwt_match_hash_put(tmap_bwt_match_hash_t *h, tmap_bwt_int_t key, uint8_t c,
 {
   int32_t ret;
   tmap_hash_int_t iter;
-  tmap_hash_t(tmap_bwt_match_hash) *hash = (tmap_hash_t(tmap_bwt_match_hash)*)(h->hash[c]);
+  tmap_hash_t(tmap_bwt_match_hash) *hash = NULL;
+  if(NULL != h->cache) {
+      tmap_bwt_match_cache_put(h->cache, key, c, val);
+      return 1;
+  }
+  hash = (tmap_hash_t(tmap_bwt_match_hash)*)(h->hash[c]);
   // get the iter
   iter = tmap_hash_put(tmap_bwt_match_hash, hash, key, &ret); 
   // set the value
@@ -65,7 +149,19 @@ tmap_bwt_int_t
 tmap_bwt_match_hash_get(tmap_bwt_match_hash_t *h, tmap_bwt_int_t key, uint8_t c, uint32_t *found)
 {
   tmap_hash_int_t iter;
-  tmap_hash_t(tmap_bwt_match_hash) *hash = (tmap_hash_t(tmap_bwt_match_hash)*)(h->hash[c]);
+  tmap_hash_t(tmap_bwt_match_hash) *hash = NULL;
+  tmap_bwt_int_t val;
+  if(NULL != h->cache) {
+      if(1 == tmap_bwt_match_cache_get(h->cache, key, c, &val)) {
+          h->hits++;
+          *found = 1;
+          return val;
+      }
+      h->misses++;
+      *found = 0;
+      return TMAP_BWT_INT_MAX;
+  }
+  hash = (tmap_hash_t(tmap_bwt_match_hash)*)(h->hash[c]);
   // get the iter
   iter = tmap_hash_get(tmap_bwt_match_hash, hash, key); 
   // check it was found
@@ -138,7 +234,7 @@ tmap_bwt_match_hash_occ(const tmap_bwt_t *bwt, tmap_bwt_match_occ_t *prev, uint8
       uint64_t prev_hi = (NULL == prev) ? 0 : prev->hi;
       next->offset = offset + 1;
       next->hi = (prev_hi << 2) + c;
-      next->k = bwt->hash_k[next->offset-1][next->hi];
+      next->k = tmap_bwt_get_hash_k(bwt, next->offset-1, next->hi);
       next->l = TMAP_BWT_INT_MAX; 
   }
 }
@@ -187,8 +283,8 @@ tmap_bwt_match_hash_2occ(const tmap_bwt_t *bwt, tmap_bwt_match_occ_t *prev, uint
       uint64_t prev_hi = (NULL == prev) ? 0 : prev->hi;
       next->offset = offset + 1;
       next->hi = (prev_hi << 2) + c;
-      next->k = bwt->hash_k[next->offset-1][next->hi];
-      next->l = bwt->hash_l[next->offset-1][next->hi];
+      next->k = tmap_bwt_get_hash_k(bwt, next->offset-1, next->hi);
+      next->l = tmap_bwt_get_hash_l(bwt, next->offset-1, next->hi);
   }
 }
 
@@ -241,7 +337,7 @@ tmap_bwt_match_hash_occ4(const tmap_bwt_t *bwt, tmap_bwt_match_occ_t *prev,
       for(i=0;i<4;i++) {
           next[i].offset = offset + 1;
           next[i].hi = (prev_hi << 2) + i;
-          next[i].k = bwt->hash_k[next[i].offset-1][next[i].hi];
+          next[i].k = tmap_bwt_get_hash_k(bwt, next[i].offset-1, next[i].hi);
           next[i].l = TMAP_BWT_INT_MAX;
       }
   }
@@ -302,8 +398,8 @@ tmap_bwt_match_hash_2occ4(const tmap_bwt_t *bwt, tmap_bwt_match_occ_t *prev,
       for(i=0;i<4;i++) {
           next[i].offset = offset + 1;
           next[i].hi = (prev_hi << 2) + i;
-          next[i].k = bwt->hash_k[next[i].offset-1][next[i].hi];
-          next[i].l = bwt->hash_l[next[i].offset-1][next[i].hi];
+          next[i].k = tmap_bwt_get_hash_k(bwt, next[i].offset-1, next[i].hi);
+          next[i].l = tmap_bwt_get_hash_l(bwt, next[i].offset-1, next[i].hi);
       }
   }
 }
@@ -384,25 +480,25 @@ tmap_bwt_match_hash_forward_init(const tmap_bwt_t *bwt, int len, const uint8_t *
       c = str[i];
       if(TMAP_UNLIKELY(3 < c)) {
           match_sa->offset = i+1;
-          match_sa->k = bwt->hash_k[match_sa->offset-1][match_sa->hi];
-          match_sa->l = bwt->hash_l[match_sa->offset-1][match_sa->hi];
+          match_sa->k = tmap_bwt_get_hash_k(bwt, match_sa->offset-1, match_sa->hi);
+          match_sa->l = tmap_bwt_get_hash_l(bwt, match_sa->offset-1, match_sa->hi);
           return 0; 
       }
       match_sa->hi = (match_sa->hi << 2) + c;
   }
   match_sa->offset = len;
-  match_sa->k = bwt->hash_k[match_sa->offset-1][match_sa->hi];
-  match_sa->l = bwt->hash_l[match_sa->offset-1][match_sa->hi];
+  match_sa->k = tmap_bwt_get_hash_k(bwt, match_sa->offset-1, match_sa->hi);
+  match_sa->l = tmap_bwt_get_hash_l(bwt, match_sa->offset-1, match_sa->hi);
   if(match_sa->l < match_sa->k || TMAP_BWT_INT_MAX == match_sa->k) {
       for(i=len-1;0<=i&&1<match_sa->offset;i--) {
-          if(bwt->hash_k[match_sa->offset-2][match_sa->hi>>2] <= bwt->hash_l[match_sa->offset-2][match_sa->hi>>2] 
-             && TMAP_BWT_INT_MAX != bwt->hash_k[match_sa->offset-2][match_sa->hi>>2]) {
+          if(tmap_bwt_get_hash_k(bwt, match_sa->offset-2, match_sa->hi>>2) <= tmap_bwt_get_hash_l(bwt, match_sa->offset-2, match_sa->hi>>2) 
+             && TMAP_BWT_INT_MAX != tmap_bwt_get_hash_k(bwt, match_sa->offset-2, match_sa->hi>>2)) {
               break;
           }
           match_sa->hi >>= 2;
           match_sa->offset--;
-          match_sa->k = bwt->hash_k[match_sa->offset-1][match_sa->hi];
-          match_sa->l = bwt->hash_l[match_sa->offset-1][match_sa->hi];
+          match_sa->k = tmap_bwt_get_hash_k(bwt, match_sa->offset-1, match_sa->hi);
+          match_sa->l = tmap_bwt_get_hash_l(bwt, match_sa->offset-1, match_sa->hi);
       }
       return 0;
   }
@@ -421,31 +517,62 @@ tmap_bwt_match_hash_reverse_init(const tmap_bwt_t *bwt, int len, const uint8_t *
       c = str[i];
       if(TMAP_UNLIKELY(3 < c)) {
           match_sa->offset = len-i;
-          match_sa->k = bwt->hash_k[match_sa->offset-1][match_sa->hi];
-          match_sa->l = bwt->hash_l[match_sa->offset-1][match_sa->hi];
+          match_sa->k = tmap_bwt_get_hash_k(bwt, match_sa->offset-1, match_sa->hi);
+          match_sa->l = tmap_bwt_get_hash_l(bwt, match_sa->offset-1, match_sa->hi);
           return 0; 
       }
       match_sa->hi = (match_sa->hi << 2) + c;
   }
   match_sa->offset = len-low;
-  match_sa->k = bwt->hash_k[match_sa->offset-1][match_sa->hi];
-  match_sa->l = bwt->hash_l[match_sa->offset-1][match_sa->hi];
+  match_sa->k = tmap_bwt_get_hash_k(bwt, match_sa->offset-1, match_sa->hi);
+  match_sa->l = tmap_bwt_get_hash_l(bwt, match_sa->offset-1, match_sa->hi);
   if(match_sa->l < match_sa->k || TMAP_BWT_INT_MAX == match_sa->k) {
       for(i=low;i<len&&1<match_sa->offset;i++) {
-          if(bwt->hash_k[match_sa->offset-2][match_sa->hi>>2] <= bwt->hash_l[match_sa->offset-2][match_sa->hi>>2]
-             && TMAP_BWT_INT_MAX != bwt->hash_k[match_sa->offset-2][match_sa->hi>>2]) {
+          if(tmap_bwt_get_hash_k(bwt, match_sa->offset-2, match_sa->hi>>2) <= tmap_bwt_get_hash_l(bwt, match_sa->offset-2, match_sa->hi>>2)
+             && TMAP_BWT_INT_MAX != tmap_bwt_get_hash_k(bwt, match_sa->offset-2, match_sa->hi>>2)) {
               break;
           }
           match_sa->hi >>= 2;
           match_sa->offset--;
-          match_sa->k = bwt->hash_k[match_sa->offset-1][match_sa->hi];
-          match_sa->l = bwt->hash_l[match_sa->offset-1][match_sa->hi];
+          match_sa->k = tmap_bwt_get_hash_k(bwt, match_sa->offset-1, match_sa->hi);
+          match_sa->l = tmap_bwt_get_hash_l(bwt, match_sa->offset-1, match_sa->hi);
       }
       return 0;
   }
   return (match_sa->l - match_sa->k + 1);
 }
 
+// 1 if the k-mer table covers more leading bases than the occurrence hash, 0 otherwise
+#define __tmap_bwt_match_hash_use_kmer(_bwt, _len) \
+  (NULL != (_bwt)->kmer && (_bwt)->hash_width < (int32_t)(_bwt)->kmer->width && (int32_t)(_bwt)->kmer->width <= (_len))
+
+// the k-mer of the leading bases, the first base searched the least
+// significant, or UINT64_MAX if they have an ambiguous base
+static inline uint64_t
+tmap_bwt_match_hash_kmer_key(const tmap_bwt_t *bwt, int len, const uint8_t *str, int32_t is_reverse)
+{
+  int32_t i;
+  uint64_t key = 0;
+  uint8_t c;
+  for(i=bwt->kmer->width-1;0<=i;i--) {
+      c = (0 == is_reverse) ? str[i] : str[len-1-i];
+      if(TMAP_UNLIKELY(3 < c)) return UINT64_MAX;
+      key = (key << 2) | c;
+  }
+  return key;
+}
+
+// looks up the leading bases in the k-mer table, returning 0 if they have an
+// ambiguous base or do not occur, leaving the search to the occurrence hash
+static inline tmap_bwt_int_t
+tmap_bwt_match_hash_kmer_init(const tmap_bwt_t *bwt, uint64_t key, tmap_bwt_match_occ_t *match_sa)
+{
+  if(UINT64_MAX == key || 0 == tmap_bwt_kmer_get(bwt->kmer, key, &match_sa->k, &match_sa->l)) return 0;
+  match_sa->offset = bwt->kmer->width;
+  match_sa->hi = TMAP_BWT_INT_MAX;
+  return match_sa->l - match_sa->k + 1;
+}
+
 tmap_bwt_int_t
 tmap_bwt_match_hash_exact(const tmap_bwt_t *bwt, int len, const uint8_t *str, 
                           tmap_bwt_match_occ_t *match_sa, tmap_bwt_match_hash_t *hash)
@@ -454,7 +581,11 @@ tmap_bwt_match_hash_exact(const tmap_bwt_t *bwt, int len, const uint8_t *str,
   uint8_t c = 0;
   tmap_bwt_match_occ_t prev, next;
 
-  if(0 < bwt->hash_width && 0 < len) { 
+  if(__tmap_bwt_match_hash_use_kmer(bwt, len) 
+     && 0 < tmap_bwt_match_hash_kmer_init(bwt, tmap_bwt_match_hash_kmer_key(bwt, len, str, 0), &prev)) {
+      // the leading bases were found in the k-mer table
+  }
+  else if(0 < bwt->hash_width && 0 < len) { 
       if(0 == tmap_bwt_match_hash_forward_init(bwt, len, str, &prev)) {
           if(NULL != match_sa) {
               (*match_sa) = prev;
@@ -494,7 +625,11 @@ tmap_bwt_match_hash_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t
   uint8_t c = 0;
   tmap_bwt_match_occ_t prev, next;
   
-  if(0 < bwt->hash_width && 0 < len) { 
+  if(__tmap_bwt_match_hash_use_kmer(bwt, len) 
+     && 0 < tmap_bwt_match_hash_kmer_init(bwt, tmap_bwt_match_hash_kmer_key(bwt, len, str, 1), &prev)) {
+      // the trailing bases were found in the k-mer table
+  }
+  else if(0 < bwt->hash_width && 0 < len) { 
       if(0 == tmap_bwt_match_hash_reverse_init(bwt, len, str, &prev)) {
           if(NULL != match_sa) {
               (*match_sa) = prev;
@@ -526,6 +661,114 @@ tmap_bwt_match_hash_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t
   return prev.l - prev.k + 1;
 }
 
+// the size of the SA interval, 0 if none
+#define __tmap_bwt_match_hash_size(_sa) \
+  (((_sa).k > (_sa).l || TMAP_BWT_INT_MAX == (_sa).k) ? 0 : ((_sa).l - (_sa).k + 1))
+
+static void
+tmap_bwt_match_hash_exact_batch_core(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                                     tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size, 
+                                     tmap_bwt_match_hash_t *hash, int32_t is_reverse)
+{
+  int32_t i, j, m, q, b, b_n;
+  int32_t active[TMAP_BWT_MATCH_BATCH_SIZE], pos[TMAP_BWT_MATCH_BATCH_SIZE];
+  uint64_t keys[TMAP_BWT_MATCH_BATCH_SIZE];
+  tmap_bwt_match_occ_t *prev, next;
+  uint8_t c;
+
+  for(b=0;b<n;b+=TMAP_BWT_MATCH_BATCH_SIZE) {
+      b_n = (n - b < TMAP_BWT_MATCH_BATCH_SIZE) ? (n - b) : TMAP_BWT_MATCH_BATCH_SIZE;
+
+      // prefetch the k-mer table blocks, then their differences
+      for(i=0;i<b_n;i++) {
+          q = b + i;
+          keys[i] = UINT64_MAX;
+          if(__tmap_bwt_match_hash_use_kmer(bwt, len[q])) {
+              keys[i] = tmap_bwt_match_hash_kmer_key(bwt, len[q], str[q], is_reverse);
+              if(UINT64_MAX != keys[i]) tmap_bwt_kmer_prefetch_block(bwt->kmer, keys[i]);
+          }
+      }
+      for(i=0;i<b_n;i++) {
+          if(UINT64_MAX != keys[i]) tmap_bwt_kmer_prefetch_diff(bwt->kmer, keys[i]);
+      }
+
+      // initialize
+      for(i=m=0;i<b_n;i++) {
+          q = b + i;
+          prev = &match_sa[q];
+          size[q] = 0;
+          if(0 < tmap_bwt_match_hash_kmer_init(bwt, keys[i], prev)) {
+              // the leading bases were found in the k-mer table
+          }
+          else if(0 < bwt->hash_width && 0 < len[q]) { 
+              if(0 == is_reverse) {
+                  if(0 == tmap_bwt_match_hash_forward_init(bwt, len[q], str[q], prev)) continue; // no match
+              }
+              else {
+                  if(0 == tmap_bwt_match_hash_reverse_init(bwt, len[q], str[q], prev)) continue; // no match
+              }
+          }
+          else {
+              prev->k = 0; prev->l = bwt->seq_len;
+              prev->offset = 0;
+              prev->hi = 0;
+          }
+          pos[i] = (0 == is_reverse) ? prev->offset : (len[q] - prev->offset - 1);
+          if(pos[i] < 0 || len[q] <= pos[i]) { // nothing left to search
+              size[q] = __tmap_bwt_match_hash_size(*prev);
+              continue;
+          }
+          active[m++] = i;
+      }
+
+      while(0 < m) {
+          // prefetch the occurrence arrays for every query before reading any of them
+          for(i=0;i<m;i++) {
+              prev = &match_sa[b + active[i]];
+              if(bwt->hash_width <= prev->offset) { // the bwt hash is not used
+                  tmap_bwt_prefetch_occ(bwt, prev->k - 1);
+                  tmap_bwt_prefetch_occ(bwt, prev->l);
+              }
+          }
+          // advance each query by one base
+          for(i=j=0;i<m;i++) {
+              q = b + active[i];
+              prev = &match_sa[q];
+              c = str[q][pos[active[i]]];
+              if(TMAP_UNLIKELY(3 < c)) {
+                  prev->offset++;
+                  prev->k = prev->l + 1;
+                  continue; // no match
+              }
+              tmap_bwt_match_hash_2occ(bwt, prev, c, &next, hash);
+              (*prev) = next;
+              if(next.k > next.l || TMAP_BWT_INT_MAX == next.k) continue; // no match
+              pos[active[i]] += (0 == is_reverse) ? 1 : -1;
+              if(pos[active[i]] < 0 || len[q] <= pos[active[i]]) { // done
+                  size[q] = next.l - next.k + 1;
+                  continue;
+              }
+              active[j++] = active[i];
+          }
+          m = j;
+      }
+  }
+}
+
+void
+tmap_bwt_match_hash_exact_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                                tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size, tmap_bwt_match_hash_t *hash)
+{
+  tmap_bwt_match_hash_exact_batch_core(bwt, n, str, len, match_sa, size, hash, 0);
+}
+
+void
+tmap_bwt_match_hash_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                                        tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size, tmap_bwt_match_hash_t *hash)
+{
+  tmap_bwt_match_hash_exact_batch_core(bwt, n, str, len, match_sa, size, hash, 1);
+}
+
 tmap_bwt_int_t
 tmap_bwt_match_hash_exact_alt(const tmap_bwt_t *bwt, int len, const uint8_t *str, 
                          tmap_bwt_match_occ_t *match_sa, tmap_bwt_match_hash_t *hash)
@@ -560,37 +803,37 @@ tmap_bwt_match_hash_exact_alt_reverse(const tmap_bwt_t *bwt, int len, const uint
   return match_sa->l - match_sa->k + 1;
 }
 
-tmap_bwt_int_t
-tmap_bwt_match_hash_invPsi(const tmap_bwt_t *bwt, uint32_t sa_intv, tmap_bwt_int_t k, uint32_t *s, tmap_bwt_match_hash_t *hash)
+inline tmap_bwt_int_t
+tmap_bwt_match_hash_invPsi_step(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_match_hash_t *hash)
 {
   uint8_t b0;
   tmap_bwt_match_occ_t prev, next;
 
-  if(1 == sa_intv) return k;
-
-  *s = 0;
-  prev.k = k;
+  if(TMAP_UNLIKELY(k == bwt->primary)) return 0;
+  if(k < bwt->primary) {
+      b0 = tmap_bwt_B0(bwt, k);
+  }
+  else {
+      b0 = tmap_bwt_B0(bwt, k-1);
+  }
+  prev.k = k + 1; // since k-1 will be used in tmap_bwt_match_hash_occ
   prev.l = TMAP_BWT_INT_MAX;
   prev.offset = UINT32_MAX; // do not use the bwt hash
   prev.hi = TMAP_BWT_INT_MAX;
-  while(0 != (prev.k & (sa_intv-1))) { // relies on sa_intv%2 == 0
-      (*s)++;
-      if(TMAP_LIKELY(prev.k != bwt->primary)) { // likely
-          if(prev.k < bwt->primary) {
-              b0 = tmap_bwt_B0(bwt, prev.k);
-          }
-          else {
-              b0 = tmap_bwt_B0(bwt, prev.k-1);
-          }
+  tmap_bwt_match_hash_occ(bwt, &prev, b0, &next, hash); 
+  return next.k - 1; // since there was an extra one added in tmap_bwt_match_hash_occ
+}
 
-          prev.k++; // since k-1 will be used in tmap_bwt_match_hash_occ
-          tmap_bwt_match_hash_occ(bwt, &prev, b0, &next, hash); 
-          prev.k = next.k - 1; // since there was an extra one added in tmap_bwt_match_hash_occ
-      }
-      else {
-          prev.k = 0;
-      }
+tmap_bwt_int_t
+tmap_bwt_match_hash_invPsi(const tmap_bwt_t *bwt, uint32_t sa_intv, tmap_bwt_int_t k, uint32_t *s, tmap_bwt_match_hash_t *hash)
+{
+  if(1 == sa_intv) return k;
+
+  *s = 0;
+  while(0 != (k & (sa_intv-1))) { // relies on sa_intv%2 == 0
+      (*s)++;
+      k = tmap_bwt_match_hash_invPsi_step(bwt, k, hash);
   }
 
-  return prev.k;
+  return k;
 }
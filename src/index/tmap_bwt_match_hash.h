@@ -7,19 +7,67 @@
   @details  This API facilitates a secondary hash into the BWT
   */
 
+/*!
+  An entry in the shared occurrence cache
+  @details  the entry is valid when its sequence number is even and non-zero, and is being
+  written when its sequence number is odd
+  */
+typedef struct {
+    uint32_t seq; /*!< the sequence number, incremented before and after each write */
+    uint32_t c; /*!< the base in integer format */
+    tmap_bwt_int_t key; /*!< the occurrence position */
+    tmap_bwt_int_t val; /*!< the occurrence value */
+} tmap_bwt_match_cache_entry_t;
+
+/*!
+  A fixed-size occurrence cache shared across threads
+  @details  the cache is direct mapped and lock-free: a write that would race with another
+  write to the same entry is dropped, and a read that races with a write is a miss
+  */
+typedef struct {
+    tmap_bwt_match_cache_entry_t *entries; /*!< the entries */
+    uint64_t mask; /*!< the number of entries minus one */
+    uint64_t hits; /*!< the number of lookups found, summed over the hashes using this cache */
+    uint64_t misses; /*!< the number of lookups not found, summed over the hashes using this cache */
+} tmap_bwt_match_cache_t;
+
 /*!
   Hash structure
   */
 typedef struct {
    void *hash[4]; /*! the hash used by bwt match for each possible next base, the type is defined in the source */ 
+   tmap_bwt_match_cache_t *cache; /*!< the shared cache used in place of the hash, NULL if none */
+   uint64_t hits; /*!< the number of cache lookups found */
+   uint64_t misses; /*!< the number of cache lookups not found */
 } tmap_bwt_match_hash_t;
 
+/*!
+  @param  size  the maximum memory for the cache, in bytes
+  @return       the initialized cache, with the largest power of two entries that fit
+ */
+tmap_bwt_match_cache_t*
+tmap_bwt_match_cache_init(size_t size);
+
+/*!
+  @param  cache  the cache to destroy
+ */
+void
+tmap_bwt_match_cache_destroy(tmap_bwt_match_cache_t *cache);
+
 /*!
   @return  the initialized hash structure
  */
 tmap_bwt_match_hash_t*
 tmap_bwt_match_hash_init();
 
+/*!
+  @param  cache  the cache shared with other threads
+  @return        the initialized hash structure, looking up values in the shared cache
+  @details       the hits and misses are added to the cache when the hash is destroyed
+ */
+tmap_bwt_match_hash_t*
+tmap_bwt_match_hash_init_shared(tmap_bwt_match_cache_t *cache);
+
 /*!
   @param  h  the hash to destroy
  */
@@ -28,6 +76,7 @@ tmap_bwt_match_hash_destroy(tmap_bwt_match_hash_t *h);
 
 /*!
   @param  h  the hash to clear
+  @details   a shared cache is not cleared
  */
 void
 tmap_bwt_match_hash_clear(tmap_bwt_match_hash_t *h);
@@ -143,6 +192,38 @@ tmap_bwt_match_hash_exact(const tmap_bwt_t *bwt, int len, const uint8_t *str, tm
 tmap_bwt_int_t
 tmap_bwt_match_hash_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa, tmap_bwt_match_hash_t *hash);
 
+/*! 
+  computes the SA intervals for a batch of independent sequences, using forward search
+  @param  bwt       pointer to the bwt structure 
+  @param  n         the number of sequences
+  @param  str       the DNA sequences in 2-bit format
+  @param  len       the length of each sequence
+  @param  match_sa  the match structure returned for each sequence
+  @param  size      the size of the SA interval returned for each sequence, 0 if none found
+  @param  hash      a occurence array hash
+  @details          the sequences are advanced one base at a time in groups of TMAP_BWT_MATCH_BATCH_SIZE, 
+  so that the occurrence array lookups of one sequence overlap the cache misses of the others; 
+  the results are identical to calling tmap_bwt_match_hash_exact on each sequence
+  */
+void
+tmap_bwt_match_hash_exact_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                                tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size, tmap_bwt_match_hash_t *hash);
+
+/*! 
+  computes the SA intervals for a batch of independent sequences, using reverse search
+  @param  bwt       pointer to the bwt structure 
+  @param  n         the number of sequences
+  @param  str       the DNA sequences in 2-bit format
+  @param  len       the length of each sequence
+  @param  match_sa  the match structure returned for each sequence
+  @param  size      the size of the SA interval returned for each sequence, 0 if none found
+  @param  hash      a occurence array hash
+  @details          the results are identical to calling tmap_bwt_match_hash_exact_reverse on each sequence
+  */
+void
+tmap_bwt_match_hash_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const uint8_t **str, const int32_t *len, 
+                                        tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *size, tmap_bwt_match_hash_t *hash);
+
 /*! 
   computes the SA interval for the given sequence (if any), using forward search
   @param  bwt       pointer to the bwt structure 
@@ -169,6 +250,16 @@ tmap_bwt_match_hash_exact_alt(const tmap_bwt_t *bwt, int len, const uint8_t *str
 tmap_bwt_int_t
 tmap_bwt_match_hash_exact_alt_reverse(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa, tmap_bwt_match_hash_t *hash);
 
+/*!  
+  one step of the inverse Psi function
+  @param  bwt  pointer to the bwt structure
+  @param  k  the occurrence position 
+  @param  hash  a occurence array hash
+  @return  the occurrence position of the preceding suffix
+  */
+inline tmap_bwt_int_t
+tmap_bwt_match_hash_invPsi_step(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_match_hash_t *hash);
+
 /*!  
   inverse Psi function
   @param  bwt  pointer to the bwt structure
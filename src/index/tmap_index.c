@@ -10,11 +10,13 @@
 #include "tmap_refseq.h"
 #include "tmap_bwt_gen.h"
 #include "tmap_bwt.h"
+#include "tmap_bwt_kmer.h"
+#include "tmap_seed_hash.h"
 #include "tmap_sa.h"
 #include "tmap_index.h"
 
 tmap_index_t*
-tmap_index_init(const char *fn_fasta, key_t shm_key)
+tmap_index_init(const char *fn_fasta, key_t shm_key, int32_t index_mmap)
 {
   tmap_index_t *index = NULL;
 
@@ -23,11 +25,30 @@ tmap_index_init(const char *fn_fasta, key_t shm_key)
   index->shm_key = shm_key;
 
   // get the reference information
-  if(0 == index->shm_key) {
+  if(0 == index->shm_key && 0 < index_mmap) {
+      tmap_progress_print("memory mapping reference data");
+      index->refseq = tmap_refseq_mmap(fn_fasta, (2 == index_mmap) ? 1 : 0);
+      index->bwt = tmap_bwt_mmap(fn_fasta, (2 == index_mmap) ? 1 : 0);
+      index->sa = tmap_sa_mmap(fn_fasta, (2 == index_mmap) ? 1 : 0);
+      if(1 == tmap_bwt_kmer_exists(fn_fasta)) {
+          index->kmer = tmap_bwt_kmer_mmap(fn_fasta, (2 == index_mmap) ? 1 : 0);
+      }
+      if(1 == tmap_seed_hash_exists(fn_fasta)) {
+          index->seed = tmap_seed_hash_mmap(fn_fasta, (2 == index_mmap) ? 1 : 0);
+      }
+      tmap_progress_print2("reference data memory mapped");
+  }
+  else if(0 == index->shm_key) {
       tmap_progress_print("reading in reference data");
       index->refseq = tmap_refseq_read(fn_fasta);
       index->bwt = tmap_bwt_read(fn_fasta);
       index->sa = tmap_sa_read(fn_fasta);
+      if(1 == tmap_bwt_kmer_exists(fn_fasta)) {
+          index->kmer = tmap_bwt_kmer_read(fn_fasta);
+      }
+      if(1 == tmap_seed_hash_exists(fn_fasta)) {
+          index->seed = tmap_seed_hash_read(fn_fasta);
+      }
       tmap_progress_print2("reference data read in");
   }
   else {
@@ -42,6 +63,13 @@ tmap_index_init(const char *fn_fasta, key_t shm_key)
       if(NULL == (index->sa = tmap_sa_shm_unpack(tmap_shm_get_buffer(index->shm, TMAP_SHM_LISTING_SA)))) {
           tmap_error("the SA was not found in shared memory", Exit, SharedMemoryListing);
       }
+      // optional
+      if(1 == tmap_shm_listing_exists(index->shm, TMAP_SHM_LISTING_KMER)) {
+          index->kmer = tmap_bwt_kmer_shm_unpack(tmap_shm_get_buffer(index->shm, TMAP_SHM_LISTING_KMER));
+      }
+      if(1 == tmap_shm_listing_exists(index->shm, TMAP_SHM_LISTING_SEED)) {
+          index->seed = tmap_seed_hash_shm_unpack(tmap_shm_get_buffer(index->shm, TMAP_SHM_LISTING_SEED));
+      }
       tmap_progress_print2("reference data retrieved from shared memory");
   }
 
@@ -51,6 +79,15 @@ tmap_index_init(const char *fn_fasta, key_t shm_key)
   if((index->refseq->len << 1) != index->sa->seq_len) {
       tmap_error("refseq and sa lengths do not match", Exit, OutOfRange);
   }
+  if(NULL != index->kmer) {
+      if(index->kmer->seq_len != index->bwt->seq_len) {
+          tmap_error("bwt and k-mer table lengths do not match", Exit, OutOfRange);
+      }
+      index->bwt->kmer = index->kmer;
+  }
+  if(NULL != index->seed && index->seed->seq_len != index->bwt->seq_len) {
+      tmap_error("bwt and seed hash lengths do not match", Exit, OutOfRange);
+  }
   
   return index;
 }
@@ -61,6 +98,8 @@ tmap_index_destroy(tmap_index_t *index)
   tmap_refseq_destroy(index->refseq);
   tmap_bwt_destroy(index->bwt);
   tmap_sa_destroy(index->sa);
+  tmap_bwt_kmer_destroy(index->kmer);
+  tmap_seed_hash_destroy(index->seed);
   if(0 < index->shm_key) {
       tmap_shm_destroy(index->shm, 0);
   }
@@ -80,7 +119,10 @@ tmap_index_core(tmap_index_opt_t *opt)
   }
 
   // check returned genome size
-  if(opt->is_large < 0) {
+  if(1 < opt->num_threads) {
+      tmap_progress_print("using the multi-threaded BWT construction algorithm");
+  }
+  else if(opt->is_large < 0) {
       if(TMAP_INDEX_LARGE_GENOME <= ref_len) { 
           opt->is_large = 1;
           tmap_progress_print("defaulting to \"bwtsw\" BWT construction algorithm");
@@ -92,13 +134,23 @@ tmap_index_core(tmap_index_opt_t *opt)
   }
 
   // create the bwt 
-  tmap_bwt_pac2bwt(opt->fn_fasta, opt->is_large, opt->occ_interval, opt->hash_width, opt->check_hash);
+  tmap_bwt_pac2bwt(opt->fn_fasta, opt->is_large, opt->occ_interval, opt->occ_layout, opt->hash_width, opt->check_hash, opt->int_width, opt->num_threads);
 
   // create the suffix array
-  tmap_sa_bwt2sa(opt->fn_fasta, opt->sa_interval);
+  tmap_sa_bwt2sa(opt->fn_fasta, opt->sa_interval, opt->int_width, opt->num_threads);
+
+  // create the k-mer prefix table
+  if(0 < opt->kmer_width) {
+      tmap_bwt_kmer_update(opt->fn_fasta, opt->kmer_width);
+  }
 
   // pack the reference sequence
   ref_len = tmap_refseq_fasta2pac(opt->fn_fasta, TMAP_FILE_NO_COMPRESSION, 1);
+
+  // create the seed hash, from the forward reference sequence
+  if(0 < opt->seed_width) {
+      tmap_seed_hash_update(opt->fn_fasta, opt->seed_width, opt->seed_max_freq);
+  }
 }
 
 static int 
@@ -112,12 +164,24 @@ usage(tmap_index_opt_t *opt)
   tmap_file_fprintf(tmap_file_stderr, "Options (optional):\n");
   tmap_file_fprintf(tmap_file_stderr, "         -o INT      the occurrence interval (use %d, %d, %d, ...) [%d]\n", 
                     TMAP_BWT_OCC_MOD, TMAP_BWT_OCC_MOD*2, TMAP_BWT_OCC_MOD*3, opt->occ_interval);
+  tmap_file_fprintf(tmap_file_stderr, "         -c          store the occurrences in %d-byte cache lines of %d bases, ignoring -o [%d]\n", 
+                    TMAP_BWT_OCC_LINE_ALIGN, TMAP_BWT_OCC_LINE_INTERVAL, opt->occ_layout);
   tmap_file_fprintf(tmap_file_stderr, "         -w INT      the k-mer occurrence hash width [%d]\n", opt->hash_width);
   tmap_file_fprintf(tmap_file_stderr, "         -i INT      the suffix array interval (use 1, 2, 4, ...)[%d]\n", opt->sa_interval);
+  tmap_file_fprintf(tmap_file_stderr, "         -N          store the suffix array, occurrence hash, and occurrences in 32 bits if the reference\n");
+  tmap_file_fprintf(tmap_file_stderr, "                     \tis shorter than 2^31 bases (not readable by earlier versions) [%d]\n", (32 == opt->int_width) ? 1 : 0);
   tmap_file_fprintf(tmap_file_stderr, "         -a STRING   override BWT construction algorithm:\n");
   tmap_file_fprintf(tmap_file_stderr, "                     \t\"bwtsw\" (large genomes)\n");
   tmap_file_fprintf(tmap_file_stderr, "                     \t\"is\" (short genomes)\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -n INT      the number of threads used to construct the BWT string and SA,\n");
+  tmap_file_fprintf(tmap_file_stderr, "                     \tmore than one overriding -a [%d]\n", opt->num_threads);
   tmap_file_fprintf(tmap_file_stderr, "         -H          do not validate the BWT hash [%d]\n", opt->check_hash);
+  tmap_file_fprintf(tmap_file_stderr, "         -K INT      the k-mer prefix table width (%d-%d), 0 for none [%d]\n", 
+                    TMAP_BWT_KMER_WIDTH_MIN, TMAP_BWT_KMER_WIDTH_MAX, opt->kmer_width);
+  tmap_file_fprintf(tmap_file_stderr, "         -s INT      the seed hash width (%d-%d), 0 for none [%d]\n", 
+                    TMAP_SEED_HASH_WIDTH_MIN, TMAP_SEED_HASH_WIDTH_MAX, opt->seed_width);
+  tmap_file_fprintf(tmap_file_stderr, "         -S INT      the maximum number of positions of a seed hash k-mer (1-%d) [%d]\n", 
+                    TMAP_SEED_HASH_MAX_FREQ_MAX, opt->seed_max_freq);
   tmap_file_fprintf(tmap_file_stderr, "         --version   print the index format that will be created and exit\n");
   tmap_file_fprintf(tmap_file_stderr, "         -v          print verbose progress information\n");
   tmap_file_fprintf(tmap_file_stderr, "         -h          print this message\n");
@@ -133,10 +197,16 @@ tmap_index(int argc, char *argv[])
 
   opt.fn_fasta = NULL;
   opt.occ_interval = TMAP_BWT_OCC_INTERVAL; 
+  opt.occ_layout = TMAP_BWT_OCC_LAYOUT_PACKED;
   opt.hash_width = INT32_MAX;
   opt.sa_interval = TMAP_SA_INTERVAL; 
+  opt.int_width = 64;
   opt.is_large = -1;
   opt.check_hash = 1;
+  opt.num_threads = 1;
+  opt.kmer_width = 0;
+  opt.seed_width = 0;
+  opt.seed_max_freq = TMAP_SEED_HASH_MAX_FREQ;
       
   if(2 == argc && 0 == strcmp("--version", argv[1])) {
       tmap_file_stdout = tmap_file_fdopen(fileno(stdout), "wb", TMAP_FILE_NO_COMPRESSION);
@@ -145,14 +215,18 @@ tmap_index(int argc, char *argv[])
       return 0;
   }
 
-  while((c = getopt(argc, argv, "f:o:i:w:a:hvH")) >= 0) {
+  while((c = getopt(argc, argv, "f:o:ci:Nw:a:n:K:s:S:hvH")) >= 0) {
       switch(c) {
         case 'f':
           opt.fn_fasta = tmap_strdup(optarg); break;
         case 'o':
           opt.occ_interval = atoi(optarg); break;
+        case 'c':
+          opt.occ_layout = TMAP_BWT_OCC_LAYOUT_LINE; break;
         case 'i':
           opt.sa_interval = atoi(optarg); break;
+        case 'N':
+          opt.int_width = 32; break;
         case 'w':
           opt.hash_width = atoi(optarg); break;
         case 'a':
@@ -160,6 +234,14 @@ tmap_index(int argc, char *argv[])
           else if(0 == strcmp("bwtsw", optarg)) opt.is_large = 1;
           else tmap_error("Option -a value not correct", Exit, CommandLineArgument); 
           break; 
+        case 'n':
+          opt.num_threads = atoi(optarg); break;
+        case 'K':
+          opt.kmer_width = atoi(optarg); break;
+        case 's':
+          opt.seed_width = atoi(optarg); break;
+        case 'S':
+          opt.seed_max_freq = atoi(optarg); break;
         case 'v':
           tmap_progress_set_verbosity(1); break;
         case 'h':
@@ -186,6 +268,18 @@ tmap_index(int argc, char *argv[])
   if(opt.sa_interval <= 0 || (1 < opt.sa_interval && 0 != (opt.sa_interval % 2))) {
       tmap_error("option -i out of range", Exit, CommandLineArgument);
   }
+  if(opt.num_threads < 1) {
+      tmap_error("option -n out of range", Exit, CommandLineArgument);
+  }
+  if(opt.kmer_width < 0 || (0 < opt.kmer_width && (opt.kmer_width < TMAP_BWT_KMER_WIDTH_MIN || TMAP_BWT_KMER_WIDTH_MAX < opt.kmer_width))) {
+      tmap_error("option -K out of range", Exit, CommandLineArgument);
+  }
+  if(opt.seed_width < 0 || (0 < opt.seed_width && (opt.seed_width < TMAP_SEED_HASH_WIDTH_MIN || TMAP_SEED_HASH_WIDTH_MAX < opt.seed_width))) {
+      tmap_error("option -s out of range", Exit, CommandLineArgument);
+  }
+  if(opt.seed_max_freq < 1 || TMAP_SEED_HASH_MAX_FREQ_MAX < opt.seed_max_freq) {
+      tmap_error("option -S out of range", Exit, CommandLineArgument);
+  }
 
   tmap_index_core(&opt);
 
@@ -24,18 +24,21 @@ typedef struct {
     tmap_refseq_t *refseq; /*!< the packed reference sequence */
     tmap_bwt_t *bwt; /*!< the forward and reverse FM-indexes */
     tmap_sa_t *sa; /*!< the forward and reverse suffix arrays */
+    struct __tmap_bwt_kmer_t *kmer; /*!< the k-mer prefix table of the BWT, NULL if none */
+    struct __tmap_seed_hash_t *seed; /*!< the seed hash of the reference, NULL if none */
     tmap_shm_t *shm; /*!< the shared memory location if loaded from shared memory */
     key_t shm_key; /*!< the shared memory key, zero if not loaded from shared memory */
 } tmap_index_t;
 
 /*!
   Initializes the full reference data from file or shared memory.
-  @param  fn_fasta  the FASTA file name
-  @param  shm_key   the shared memory key, or zero if we are to read in from file
-  @return           the full reference index
+  @param  fn_fasta    the FASTA file name
+  @param  shm_key     the shared memory key, or zero if we are to read in from file
+  @param  index_mmap  0 to read in from file, 1 to memory map the files, 2 to memory map the files and read them into memory now
+  @return             the full reference index
  */
 tmap_index_t*
-tmap_index_init(const char *fn_fasta, key_t shm_key);
+tmap_index_init(const char *fn_fasta, key_t shm_key, int32_t index_mmap);
 
 /*!
   Destroys the index data.
@@ -50,10 +53,16 @@ tmap_index_destroy(tmap_index_t *index);
 typedef struct {
     char *fn_fasta;  /*!< the fasta file name (-f) */
     int32_t occ_interval;  /*!< the occurrence array interval (-o) */
+    int32_t occ_layout;  /*!< the occurrence array layout (-c) */
     int32_t hash_width;  /*!< the occurrence hash width (-w) */
     int32_t sa_interval;  /*!< the suffix array interval (-i) */
+    int32_t int_width;  /*!< 32 to store the suffix array and occurrence hash in 32 bits for short references, 64 otherwise (-N) */
     int32_t is_large;  /*!< 0 to use the short BWT construction algorith, 1 otherwise (large BWT construction algorithm) */
     int32_t check_hash;  /*< 1 to validate the BWT hash, 0 otherwise */
+    int32_t num_threads;  /*!< the number of threads used to construct the BWT string and SA (-n) */
+    int32_t kmer_width;  /*!< the k-mer prefix table width, zero for none (-K) */
+    int32_t seed_width;  /*!< the seed hash width, zero for none (-s) */
+    int32_t seed_max_freq;  /*!< the maximum number of positions of a seed hash k-mer (-S) */
 } tmap_index_opt_t;
 
 /*! 
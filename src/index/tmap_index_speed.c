@@ -28,29 +28,55 @@ tmap_index_speed_test(tmap_index_t *index, clock_t *total_clock, tmap_index_spee
   tmap_bwt_match_occ_t cur;
   clock_t start_clock = 0;
   tmap_bwt_int_t cntk[4], cntl[4], ok, ol;
+  int32_t b, b_n = 0, b_len[TMAP_BWT_MATCH_BATCH_SIZE];
+  const uint8_t *b_seq[TMAP_BWT_MATCH_BATCH_SIZE];
+  tmap_bwt_match_occ_t b_sa[TMAP_BWT_MATCH_BATCH_SIZE];
+  tmap_bwt_int_t b_size[TMAP_BWT_MATCH_BATCH_SIZE];
 
   rand = tmap_rand_init(13);
   if(0 == opt->func) seq = tmap_malloc(opt->kmer_length * sizeof(uint8_t), "seq");
+  else if(6 == opt->func) {
+      seq = tmap_malloc(TMAP_BWT_MATCH_BATCH_SIZE * opt->kmer_length * sizeof(uint8_t), "seq");
+      for(b=0;b<TMAP_BWT_MATCH_BATCH_SIZE;b++) {
+          b_seq[b] = seq + b * opt->kmer_length;
+          b_len[b] = opt->kmer_length;
+      }
+  }
 
   num_found = 0;
   for(i=0;i<opt->kmer_num;i++) {
       if(0 < i && 0 == (i % 1000000)) {
           tmap_progress_print2("processed %d kmers", i);
       }
-      if(0 == opt->func) {
+      if(0 == opt->func || 6 == opt->func) {
+          uint8_t *cur_seq = seq + b_n * opt->kmer_length;
           if(tmap_rand_get(rand) < opt->rand_frac) {
               for(j=0;j<opt->kmer_length;j++) {
-                  seq[j] = (uint8_t)(tmap_rand_get(rand) * 4);
+                  cur_seq[j] = (uint8_t)(tmap_rand_get(rand) * 4);
               }
           }
           else {
               // get a position (one-based)
               pacpos = 1 + (tmap_bwt_int_t)(tmap_rand_get(rand) * (index->refseq->len - opt->kmer_length + 1));
-              if(0 == tmap_refseq_subseq(index->refseq, pacpos, opt->kmer_length, seq)) {
+              if(0 == tmap_refseq_subseq(index->refseq, pacpos, opt->kmer_length, cur_seq)) {
                   i--;
                   continue;
               }
           }
+      }
+      if(6 == opt->func) {
+          // search once the batch is full
+          b_n++;
+          if(b_n < TMAP_BWT_MATCH_BATCH_SIZE && i < opt->kmer_num - 1) continue;
+          start_clock = clock();
+          tmap_bwt_match_exact_reverse_batch(index->bwt, b_n, b_seq, b_len, b_sa, b_size);
+          (*total_clock) += clock() - start_clock;
+          for(b=0;b<b_n;b++) {
+              if(0 < b_size[b]) num_found++;
+          }
+          b_n = 0;
+      }
+      else if(0 == opt->func) {
           found = 0;
           start_clock = clock();
           if(0 < tmap_bwt_match_exact_reverse(index->bwt, opt->kmer_length, seq, &cur)) {
@@ -97,7 +123,7 @@ tmap_index_speed_test(tmap_index_t *index, clock_t *total_clock, tmap_index_spee
   tmap_progress_print2("processed %d kmers", i);
 
   tmap_rand_destroy(rand);
-  if(0 == opt->func) free(seq);
+  free(seq);
 
   return num_found;
 }
@@ -111,7 +137,7 @@ tmap_index_speed_core(tmap_index_speed_opt_t *opt)
   int32_t num_found;
 
   // read in the index
-  index = tmap_index_init(opt->fn_fasta, opt->shm_key);
+  index = tmap_index_init(opt->fn_fasta, opt->shm_key, 0);
 
   // modify the hash width
   if(0 <= opt->hash_width) {
@@ -121,6 +147,12 @@ tmap_index_speed_core(tmap_index_speed_opt_t *opt)
       index->bwt->hash_width = opt->hash_width;
   }
 
+  // select the instruction set
+  if(TMAP_BWT_OCC_LAYOUT_LINE == index->bwt->occ_layout) {
+      tmap_bwt_set_occ_simd(index->bwt, opt->occ_simd);
+  }
+  tmap_progress_print2("[tmap index] occurrence array layout: %s", tmap_bwt_occ_layout_name(index->bwt));
+
   // clock on
   start_time = time(NULL);
 
@@ -159,9 +191,14 @@ usage(tmap_index_speed_opt_t *opt)
   tmap_file_fprintf(tmap_file_stderr, "                         3 - tmap_bwt_2occ\n");
   tmap_file_fprintf(tmap_file_stderr, "                         4 - tmap_bwt_2occ4\n");
   tmap_file_fprintf(tmap_file_stderr, "                         5 - tmap_sa_pac_pos\n");
+  tmap_file_fprintf(tmap_file_stderr, "                         6 - batched k-mer lookups\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -I INT      the highest instruction set used with the cache-line occurrence layout [%d]:\n", opt->occ_simd);
+  tmap_file_fprintf(tmap_file_stderr, "                         %d - scalar\n", TMAP_BWT_OCC_SIMD_NONE);
+  tmap_file_fprintf(tmap_file_stderr, "                         %d - SSE4.2\n", TMAP_BWT_OCC_SIMD_SSE42);
+  tmap_file_fprintf(tmap_file_stderr, "                         %d - AVX2\n", TMAP_BWT_OCC_SIMD_AVX2);
   tmap_file_fprintf(tmap_file_stderr, "         -e INT      the maximum number of hits to enumerate with -F 0 (-1 for unlimited, 0 to disable) [%d]\n", opt->enum_max_hits);
-  tmap_file_fprintf(tmap_file_stderr, "         -K INT      the kmer length to simulate with -F 0 [%d]\n", opt->kmer_length);
-  tmap_file_fprintf(tmap_file_stderr, "         -R FLOAT    the fraction of random kmers with -F 0 [%.2lf]\n", opt->rand_frac);
+  tmap_file_fprintf(tmap_file_stderr, "         -K INT      the kmer length to simulate with -F 0 or -F 6 [%d]\n", opt->kmer_length);
+  tmap_file_fprintf(tmap_file_stderr, "         -R FLOAT    the fraction of random kmers with -F 0 or -F 6 [%.2lf]\n", opt->rand_frac);
   tmap_file_fprintf(tmap_file_stderr, "         -v          print verbose progress information\n");
   tmap_file_fprintf(tmap_file_stderr, "         -h          print this message\n");
   tmap_file_fprintf(tmap_file_stderr, "\n");
@@ -182,8 +219,9 @@ tmap_index_speed(int argc, char *argv[])
   opt.rand_frac = 0.0;
   opt.shm_key = 0;
   opt.func = 0;
+  opt.occ_simd = TMAP_BWT_OCC_SIMD_AVX2;
       
-  while((c = getopt(argc, argv, "f:k:w:e:K:N:R:F:hv")) >= 0) {
+  while((c = getopt(argc, argv, "f:k:w:e:K:N:R:F:I:hv")) >= 0) {
       switch(c) {
         case 'f':
           opt.fn_fasta = tmap_strdup(optarg); break;
@@ -203,6 +241,8 @@ tmap_index_speed(int argc, char *argv[])
           tmap_progress_set_verbosity(1); break;
         case 'F':
           opt.func = atoi(optarg); break;
+        case 'I':
+          opt.occ_simd = atoi(optarg); break;
         case 'h':
         default:
           return usage(&opt);
@@ -227,8 +267,11 @@ tmap_index_speed(int argc, char *argv[])
   if(opt.rand_frac < 0 || 1 < opt.rand_frac) {
       tmap_error("the option -R must be between 0 and 1", Exit, CommandLineArgument);
   }
-  if(opt.func < 0 || 5 < opt.func) {
-      tmap_error("the option -F must be between 0 and 5", Exit, CommandLineArgument);
+  if(opt.func < 0 || 6 < opt.func) {
+      tmap_error("the option -F must be between 0 and 6", Exit, CommandLineArgument);
+  }
+  if(opt.occ_simd < TMAP_BWT_OCC_SIMD_NONE || TMAP_BWT_OCC_SIMD_AVX2 < opt.occ_simd) {
+      tmap_error("the option -I is out of range", Exit, CommandLineArgument);
   }
 
   tmap_index_speed_core(&opt);
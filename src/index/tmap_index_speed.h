@@ -19,6 +19,7 @@ typedef struct {
     int32_t kmer_num;  /*!< the number of kmers to simulate (-N) */
     double rand_frac;  /*!< the fraction of random kmers (-R) */
     int32_t func;  /*!< the function to test (-F) */
+    int32_t occ_simd;  /*!< the highest instruction set used to count occurrences in the cache-line layout (-I) */
 } tmap_index_speed_opt_t;
 
 /*! 
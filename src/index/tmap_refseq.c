@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
+#include <string.h>
+#include <emmintrin.h>
 #include <config.h>
 #include <unistd.h>
 
@@ -560,6 +562,36 @@ tmap_refseq_read(const char *fn_fasta)
   return refseq;
 }
 
+tmap_refseq_t *
+tmap_refseq_mmap(const char *fn_fasta, int32_t populate)
+{
+  tmap_file_t *fp_anno = NULL;
+  char *fn_pac = NULL, *fn_anno = NULL;
+  tmap_refseq_t *refseq = NULL;
+
+  // allocate some memory 
+  refseq = tmap_calloc(1, sizeof(tmap_refseq_t), "refseq");
+  refseq->is_shm = 0;
+
+  // read annotation file
+  fn_anno = tmap_get_file_name(fn_fasta, TMAP_ANNO_FILE);
+  fp_anno = tmap_file_fopen(fn_anno, "rb", TMAP_ANNO_COMPRESSION);
+  tmap_refseq_read_anno(fp_anno, refseq, 0); 
+  tmap_file_fclose(fp_anno);
+  free(fn_anno);
+
+  // map the sequence, which is stored as is
+  fn_pac = tmap_get_file_name(fn_fasta, TMAP_PAC_FILE);
+  refseq->mmap_buf = tmap_file_mmap(fn_pac, &refseq->mmap_len, populate);
+  if(refseq->mmap_len < tmap_refseq_seq_memory(refseq->len)) {
+      tmap_error(fn_pac, Exit, ReadFileError);
+  }
+  refseq->seq = (uint8_t*)refseq->mmap_buf;
+  free(fn_pac);
+
+  return refseq;
+}
+
 size_t
 tmap_refseq_approx_num_bytes(uint64_t len)
 {
@@ -767,7 +799,12 @@ tmap_refseq_destroy(tmap_refseq_t *refseq)
           free(refseq->annos[i].amb_bases);
       }
       free(refseq->annos);
-      free(refseq->seq);
+      if(NULL != refseq->mmap_buf) {
+          tmap_file_munmap(refseq->mmap_buf, refseq->mmap_len);
+      }
+      else {
+          free(refseq->seq);
+      }
       free(refseq);
   }
 }
@@ -858,11 +895,70 @@ tmap_refseq_pac2real(const tmap_refseq_t *refseq, tmap_bwt_int_t pacpos, uint32_
   return (*pos);
 }
 
+// stores the base, or its compliment at the mirrored position
+#define __tmap_refseq_unpack_store(_target, _len, _l, _c, _rc) do { \
+    if(0 == (_rc)) (_target)[_l] = (_c); \
+    else (_target)[(_len) - (_l) - 1] = 3 - (_c); \
+} while(0)
+
+/*
+  unpacks the bases [i, i+len) of the packed sequence, one per byte, sixteen
+  at a time from each four packed bytes; if rc is 1, stores their reverse
+  compliment
+  */
+static inline void
+tmap_refseq_unpack(const uint8_t *seq, uint64_t i, uint32_t len, uint8_t *target, int32_t rc)
+{
+  uint32_t l = 0;
+  uint8_t c;
+
+  // until the packed byte boundary
+  for(;l < len && 0 != ((i + l) & 0x3);l++) {
+      c = (seq[tmap_refseq_seq_byte_i(i + l)] >> tmap_refseq_seq_byte_shift(i + l)) & 0x3;
+      __tmap_refseq_unpack_store(target, len, l, c, rc);
+  }
+
+  if(l + 16 <= len) {
+      // the high and low bit of each base, the first base in the highest bits of a byte
+      const __m128i hi = _mm_set1_epi32(0x02082080), lo = _mm_set1_epi32(0x01041040);
+      const __m128i two = _mm_set1_epi8(2), one = _mm_set1_epi8(1), three = _mm_set1_epi8(3);
+      const uint8_t *p = seq + tmap_refseq_seq_byte_i(i + l);
+      __m128i x;
+      uint32_t w;
+      for(;l + 16 <= len;l += 16, p += 4) {
+          memcpy(&w, p, sizeof(uint32_t));
+          // copy each byte to the four bytes of its bases
+          x = _mm_cvtsi32_si128(w);
+          x = _mm_unpacklo_epi8(x, x);
+          x = _mm_unpacklo_epi16(x, x);
+          x = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(x, hi), hi), two),
+                           _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(x, lo), lo), one));
+          if(0 == rc) {
+              _mm_storeu_si128((__m128i*)(target + l), x);
+          }
+          else {
+              // compliment and reverse the bytes
+              x = _mm_xor_si128(x, three);
+              x = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 1, 2, 3));
+              x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+              x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+              x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+              _mm_storeu_si128((__m128i*)(target + len - l - 16), x);
+          }
+      }
+  }
+
+  // the remaining bases
+  for(;l < len;l++) {
+      c = (seq[tmap_refseq_seq_byte_i(i + l)] >> tmap_refseq_seq_byte_shift(i + l)) & 0x3;
+      __tmap_refseq_unpack_store(target, len, l, c, rc);
+  }
+}
+
 inline int32_t
 tmap_refseq_subseq(const tmap_refseq_t *refseq, tmap_bwt_int_t pacpos, uint32_t length, uint8_t *target)
 {
-  tmap_bwt_int_t k, pacpos_upper;
-  uint32_t l;
+  tmap_bwt_int_t pacpos_upper;
   if(0 == length) {
       return 0;
   }
@@ -872,42 +968,52 @@ tmap_refseq_subseq(const tmap_refseq_t *refseq, tmap_bwt_int_t pacpos, uint32_t
   else {
       pacpos_upper = refseq->len;
   }
-  for(k=pacpos,l=0;k<=pacpos_upper;k++,l++) {
-      // k-1 since pacpos is one-based
-      target[l] = tmap_refseq_seq_i(refseq, k-1);
+  if(pacpos_upper < pacpos) {
+      return 0;
   }
-  return l;
+  // pacpos-1 since pacpos is one-based
+  tmap_refseq_unpack(refseq->seq, pacpos - 1, pacpos_upper - pacpos + 1, target, 0);
+  return pacpos_upper - pacpos + 1;
 }
 
 inline uint8_t*
-tmap_refseq_subseq2(const tmap_refseq_t *refseq, uint32_t seqid, uint32_t start, uint32_t end, uint8_t *target, int32_t to_n, int32_t *conv)
+tmap_refseq_subseq2(const tmap_refseq_t *refseq, uint32_t seqid, uint32_t start, uint32_t end, int32_t strand, uint8_t *target, int32_t to_n, int32_t *conv)
 {
-  uint32_t i, j;
+  uint32_t i, b, e, low, high, mid;
+  uint8_t c;
+  tmap_anno_t *anno;
 
   if(0 == seqid || (uint32_t)refseq->num_annos < seqid || end < start) {
       return NULL;
   }
+  anno = &refseq->annos[seqid-1];
+  if(refseq->len < anno->offset + end) {
+      return NULL;
+  }
 
   if(NULL == target) { 
       target = tmap_malloc(sizeof(char) * (end - start + 1), "target");
   }
-  if((end - start + 1) != (uint32_t)tmap_refseq_subseq(refseq, refseq->annos[seqid-1].offset + start, end - start + 1, target)) {
-      free(target);
-      return NULL;
-  }
+  tmap_refseq_unpack(refseq->seq, anno->offset + start - 1, end - start + 1, target, strand);
 
-  // check if any IUPAC bases fall within the range
-  // NB: this could be done more efficiently, since we we know start <= end
+  // find the first run of IUPAC bases not before the range, the runs being sorted
   if(NULL != conv) (*conv) = 0;
-  if(0 < tmap_refseq_amb_bases(refseq, seqid, start, end)) {
-      // modify them
-      for(i=start;i<=end;i++) {
-          j = tmap_refseq_amb_bases(refseq, seqid, i, i); // Note: j is one-based
-          if(0 < j) {
-              target[i-start] = (0 == to_n) ? refseq->annos[seqid-1].amb_bases[j-1] : 4;
-              if(NULL != conv) (*conv)++;
-          }
+  low = 0;
+  high = anno->num_amb;
+  while(low < high) {
+      mid = (low + high) >> 1;
+      if(anno->amb_positions_end[mid] < start) low = mid + 1;
+      else high = mid;
+  }
+  // modify the runs that fall within the range
+  for(;low < anno->num_amb && anno->amb_positions_start[low] <= end;low++) {
+      b = (anno->amb_positions_start[low] < start) ? start : anno->amb_positions_start[low];
+      e = (end < anno->amb_positions_end[low]) ? end : anno->amb_positions_end[low];
+      c = (0 == to_n) ? anno->amb_bases[low] : 4;
+      for(i=b;i<=e;i++) {
+          target[(0 == strand) ? (i - start) : (end - i)] = c;
       }
+      if(NULL != conv) (*conv) += e - b + 1;
   }
 
   return target;
@@ -72,6 +72,8 @@ typedef struct {
     int32_t num_annos;  /*!< the number of contigs (and annotations) */
     uint64_t len;  /*!< the total length of the reference sequence */
     uint32_t is_shm;  /*!< 1 if loaded from shared memory, 0 otherwise */
+    void *mmap_buf; /*!< the memory mapped packed sequence file, NULL if not memory mapped */
+    size_t mmap_len; /*!< the length of the memory mapped packed sequence file */
 } tmap_refseq_t;
 
 /*!
@@ -111,6 +113,14 @@ tmap_refseq_write(tmap_refseq_t *refseq, const char *fn_fasta);
 tmap_refseq_t *
 tmap_refseq_read(const char *fn_fasta);
 
+/*! 
+  @param  fn_fasta  the fn_fasta of the file to be read, usually the fasta file name 
+  @param  populate  1 to read the whole packed sequence into memory now, 0 to read each page upon first access
+  @return           a pointer to the initialized memory, using the memory mapped packed sequence in place
+  */
+tmap_refseq_t *
+tmap_refseq_mmap(const char *fn_fasta, int32_t populate);
+
 /*! 
   @param  len  the refseq length
   @return      the approximate number of bytes required for this refseq in shared memory
@@ -182,13 +192,14 @@ tmap_refseq_subseq(const tmap_refseq_t *refseq, tmap_bwt_int_t pacpos, uint32_t
   @param  seqid   the sequence id (one-based)
   @param  start   the start position (one-based)
   @param  end     the end position (one-based)
+  @param  strand  0 for the forward strand, 1 for the reverse compliment of the subsequence
   @param  target  pre-allocated memory for the target
   @param  to_n    change all ambiguous bases to N, otherwise they will be returned as the correct code
   @param  conv    the number of bases converted to ambiguity bases
   @return         the target sequence if successful, NULL otherwise
   */
 inline uint8_t*
-tmap_refseq_subseq2(const tmap_refseq_t *refseq, uint32_t seqid, uint32_t start, uint32_t end, uint8_t *target, int32_t to_n, int32_t *conv);
+tmap_refseq_subseq2(const tmap_refseq_t *refseq, uint32_t seqid, uint32_t start, uint32_t end, int32_t strand, uint8_t *target, int32_t to_n, int32_t *conv);
 
 /*! 
   Checks if the given reference range has ambiguous bases
@@ -3,6 +3,11 @@
 #include <limits.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <config.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
@@ -25,6 +30,27 @@
 #include "tmap_sa_aux.h"
 #endif
 
+// the highest bit of the suffix array interval as stored, set for 32-bit entries
+#define TMAP_SA_INTV_INT32 (((tmap_bwt_int_t)1) << ((sizeof(tmap_bwt_int_t) << 3) - 1))
+
+// the highest byte of the suffix array interval as stored, reserved for flags
+#define TMAP_SA_INTV_FLAGS (((tmap_bwt_int_t)0xFF) << ((sizeof(tmap_bwt_int_t) << 3) - 8))
+
+// the suffix array interval as stored
+#define tmap_sa_get_sa_intv_stored(_sa) ((tmap_bwt_int_t)(_sa)->sa_intv | ((32 == (_sa)->int_width) ? TMAP_SA_INTV_INT32 : 0))
+
+// the number of bytes in a suffix array entry
+#define tmap_sa_get_int_size(_sa) ((32 == (_sa)->int_width) ? sizeof(uint32_t) : sizeof(tmap_bwt_int_t))
+
+static inline void
+tmap_sa_set_sa_intv_stored(tmap_sa_t *sa, tmap_bwt_int_t sa_intv)
+{
+  if(0 != (sa_intv & TMAP_SA_INTV_FLAGS & ~TMAP_SA_INTV_INT32) || 0 == (sa_intv & ~TMAP_SA_INTV_FLAGS)) {
+      tmap_error("unsupported index format (unknown SA header flags)", Exit, OutOfRange);
+  }
+  sa->int_width = (0 != (sa_intv & TMAP_SA_INTV_INT32)) ? 32 : 64;
+  sa->sa_intv = sa_intv & ~TMAP_SA_INTV_INT32;
+}
 
 tmap_sa_t *
 tmap_sa_read(const char *fn_fasta)
@@ -32,6 +58,7 @@ tmap_sa_read(const char *fn_fasta)
   char *fn_sa = NULL;
   tmap_file_t *fp_sa = NULL;
   tmap_sa_t *sa = NULL;
+  tmap_bwt_int_t sa_intv;
 
   fn_sa = tmap_get_file_name(fn_fasta, TMAP_SA_FILE);
   fp_sa = tmap_file_fopen(fn_sa, "rb", TMAP_SA_COMPRESSION);
@@ -39,16 +66,18 @@ tmap_sa_read(const char *fn_fasta)
   sa = tmap_calloc(1, sizeof(tmap_sa_t), "sa");
 
   if(1 != tmap_file_fread(&sa->primary, sizeof(tmap_bwt_int_t), 1, fp_sa)
-     || 1 != tmap_file_fread(&sa->sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa)
+     || 1 != tmap_file_fread(&sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa)
      || 1 != tmap_file_fread(&sa->seq_len, sizeof(tmap_bwt_int_t), 1, fp_sa)) {
       tmap_error(NULL, Exit, ReadFileError);
   }
+  tmap_sa_set_sa_intv_stored(sa, sa_intv);
 
   sa->n_sa = (sa->seq_len + sa->sa_intv) / sa->sa_intv;
-  sa->sa = tmap_calloc(sa->n_sa, sizeof(tmap_bwt_int_t), "sa->sa");
-  sa->sa[0] = -1;
+  sa->sa = tmap_calloc(sa->n_sa, tmap_sa_get_int_size(sa), "sa->sa");
+  if(32 == sa->int_width) ((uint32_t*)sa->sa)[0] = UINT32_MAX;
+  else sa->sa[0] = -1;
 
-  if(sa->n_sa-1 != tmap_file_fread(sa->sa + 1, sizeof(tmap_bwt_int_t), sa->n_sa - 1, fp_sa)) {
+  if(sa->n_sa-1 != tmap_file_fread((uint8_t*)sa->sa + tmap_sa_get_int_size(sa), tmap_sa_get_int_size(sa), sa->n_sa - 1, fp_sa)) {
       tmap_error(NULL, Exit, ReadFileError);
   }
 
@@ -62,19 +91,65 @@ tmap_sa_read(const char *fn_fasta)
   return sa;
 }
 
+tmap_sa_t *
+tmap_sa_mmap(const char *fn_fasta, int32_t populate)
+{
+  char *fn_sa = NULL;
+  tmap_sa_t *sa = NULL;
+  uint8_t *buf = NULL;
+  tmap_bwt_int_t sa_intv;
+
+  fn_sa = tmap_get_file_name(fn_fasta, TMAP_SA_FILE);
+
+  sa = tmap_calloc(1, sizeof(tmap_sa_t), "sa");
+  sa->mmap_buf = buf = tmap_file_mmap(fn_sa, &sa->mmap_len, populate);
+
+  // fixed length data, in the order written by tmap_sa_write
+  if(sa->mmap_len < 3*sizeof(tmap_bwt_int_t)) {
+      tmap_error(fn_sa, Exit, ReadFileError);
+  }
+  memcpy(&sa->primary, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(&sa_intv, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(&sa->seq_len, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  tmap_sa_set_sa_intv_stored(sa, sa_intv);
+
+  sa->n_sa = (sa->seq_len + sa->sa_intv) / sa->sa_intv;
+  if(sa->mmap_len < 3*sizeof(tmap_bwt_int_t) + (sa->n_sa-1)*tmap_sa_get_int_size(sa)) {
+      tmap_error(fn_sa, Exit, ReadFileError);
+  }
+
+  // NB: the first entry is not stored, so it overlays the last header field,
+  // whose page is made writable so that only it is copied
+  sa->sa = (tmap_bwt_int_t*)(buf - tmap_sa_get_int_size(sa));
+  if(0 != mprotect(sa->mmap_buf, sysconf(_SC_PAGESIZE), PROT_READ | PROT_WRITE)) {
+      tmap_error("mprotect", Exit, ReadFileError);
+  }
+  if(32 == sa->int_width) ((uint32_t*)sa->sa)[0] = UINT32_MAX;
+  else sa->sa[0] = -1;
+
+  sa->sa_intv_log2 = tmap_log2(sa->sa_intv);
+
+  free(fn_sa);
+
+  sa->is_shm = 0;
+
+  return sa;
+}
+
 void 
 tmap_sa_write(const char *fn_fasta, tmap_sa_t *sa)
 {
   char *fn_sa = NULL;
   tmap_file_t *fp_sa = NULL;
+  tmap_bwt_int_t sa_intv = tmap_sa_get_sa_intv_stored(sa);
   
   fn_sa = tmap_get_file_name(fn_fasta, TMAP_SA_FILE);
   fp_sa = tmap_file_fopen(fn_sa, "wb", TMAP_SA_COMPRESSION);
 
   if(1 != tmap_file_fwrite(&sa->primary, sizeof(tmap_bwt_int_t), 1, fp_sa)
-     || 1 != tmap_file_fwrite(&sa->sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa) 
+     || 1 != tmap_file_fwrite(&sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa) 
      || 1 != tmap_file_fwrite(&sa->seq_len, sizeof(tmap_bwt_int_t), 1, fp_sa)
-     || sa->n_sa-1 != tmap_file_fwrite(sa->sa+1, sizeof(tmap_bwt_int_t), sa->n_sa-1, fp_sa)) {
+     || sa->n_sa-1 != tmap_file_fwrite((uint8_t*)sa->sa + tmap_sa_get_int_size(sa), tmap_sa_get_int_size(sa), sa->n_sa-1, fp_sa)) {
       tmap_error(NULL, Exit, WriteFileError);
   }
 
@@ -106,7 +181,7 @@ tmap_sa_shm_num_bytes(tmap_sa_t *sa)
   n += sizeof(tmap_bwt_int_t); // sa_intv
   n += sizeof(tmap_bwt_int_t); // seq_len
   n += sizeof(tmap_bwt_int_t); // n_sa
-  n += sizeof(tmap_bwt_int_t)*sa->n_sa; // sa
+  n += tmap_sa_get_int_size(sa)*sa->n_sa; // sa
 
   return n;
 }
@@ -118,6 +193,7 @@ tmap_sa_shm_read_num_bytes(const char *fn_fasta)
   char *fn_sa = NULL;
   tmap_file_t *fp_sa = NULL;
   tmap_sa_t *sa = NULL;
+  tmap_bwt_int_t sa_intv;
 
   fn_sa = tmap_get_file_name(fn_fasta, TMAP_SA_FILE);
   fp_sa = tmap_file_fopen(fn_sa, "rb", TMAP_SA_COMPRESSION);
@@ -125,10 +201,11 @@ tmap_sa_shm_read_num_bytes(const char *fn_fasta)
   sa = tmap_calloc(1, sizeof(tmap_sa_t), "sa");
 
   if(1 != tmap_file_fread(&sa->primary, sizeof(tmap_bwt_int_t), 1, fp_sa)
-     || 1 != tmap_file_fread(&sa->sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa)
+     || 1 != tmap_file_fread(&sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa)
      || 1 != tmap_file_fread(&sa->seq_len, sizeof(tmap_bwt_int_t), 1, fp_sa)) {
       tmap_error(NULL, Exit, ReadFileError);
   }
+  tmap_sa_set_sa_intv_stored(sa, sa_intv);
 
   sa->n_sa = (sa->seq_len + sa->sa_intv) / sa->sa_intv;
 
@@ -151,13 +228,14 @@ tmap_sa_shm_read_num_bytes(const char *fn_fasta)
 uint8_t *
 tmap_sa_shm_pack(tmap_sa_t *sa, uint8_t *buf)
 {
+  tmap_bwt_int_t sa_intv = tmap_sa_get_sa_intv_stored(sa);
   // fixed length data
   memcpy(buf, &sa->primary, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
-  memcpy(buf, &sa->sa_intv, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(buf, &sa_intv, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(buf, &sa->seq_len, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(buf, &sa->n_sa, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   // variable length data
-  memcpy(buf, sa->sa, sa->n_sa*sizeof(tmap_bwt_int_t)); buf += sa->n_sa*sizeof(tmap_bwt_int_t);
+  memcpy(buf, sa->sa, sa->n_sa*tmap_sa_get_int_size(sa)); buf += sa->n_sa*tmap_sa_get_int_size(sa);
 
   return buf;
 }
@@ -166,6 +244,7 @@ tmap_sa_t *
 tmap_sa_shm_unpack(uint8_t *buf)
 {
   tmap_sa_t *sa = NULL;
+  tmap_bwt_int_t sa_intv;
 
   if(NULL == buf) return NULL;
 
@@ -173,12 +252,13 @@ tmap_sa_shm_unpack(uint8_t *buf)
 
   // fixed length data
   memcpy(&sa->primary, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
-  memcpy(&sa->sa_intv, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  memcpy(&sa_intv, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(&sa->seq_len, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
   memcpy(&sa->n_sa, buf, sizeof(tmap_bwt_int_t)); buf += sizeof(tmap_bwt_int_t);
+  tmap_sa_set_sa_intv_stored(sa, sa_intv);
   // variable length data
   sa->sa = (tmap_bwt_int_t*)buf;
-  buf += sa->n_sa*sizeof(tmap_bwt_int_t);
+  buf += sa->n_sa*tmap_sa_get_int_size(sa);
   
   sa->sa_intv_log2 = tmap_log2(sa->sa_intv);
 
@@ -193,6 +273,10 @@ tmap_sa_destroy(tmap_sa_t *sa)
   if(1 == sa->is_shm) {
   free(sa);
   }
+  else if(NULL != sa->mmap_buf) {
+  tmap_file_munmap(sa->mmap_buf, sa->mmap_len);
+  free(sa);
+  }
   else {
   free(sa->sa);
   free(sa);
@@ -211,9 +295,9 @@ tmap_bwt_int_t
 tmap_sa_pac_pos_hash(const tmap_sa_t *sa, const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_match_hash_t *hash)
 {
   uint32_t s = 0;
-  if(1 == sa->sa_intv) return sa->sa[k];
+  if(1 == sa->sa_intv) return tmap_sa_get(sa, k);
   k = tmap_bwt_match_hash_invPsi(bwt, sa->sa_intv, k, &s, hash);
-  return s + sa->sa[k >> sa->sa_intv_log2];
+  return s + tmap_sa_get(sa, k >> sa->sa_intv_log2);
   //return s + sa->sa[k/sa->sa_intv];
 }
 
@@ -244,10 +328,186 @@ tmap_sa_pac_pos(const tmap_sa_t *sa, const tmap_bwt_t *bwt, tmap_bwt_int_t k)
 #endif
 }
 
+void
+tmap_sa_pac_pos_batch(const tmap_sa_t *sa, const tmap_bwt_t *bwt, int32_t n, const tmap_bwt_int_t *k, 
+                      tmap_bwt_int_t *pacpos, tmap_bwt_match_hash_t *hash)
+{
+  int32_t i, m, next;
+  int32_t q[TMAP_SA_PAC_POS_BATCH_SIZE]; // the lookup being walked in each slot
+  tmap_bwt_int_t r[TMAP_SA_PAC_POS_BATCH_SIZE]; // the current occurrence position of each slot
+  uint32_t s[TMAP_SA_PAC_POS_BATCH_SIZE]; // the number of steps walked in each slot
+  tmap_bwt_int_t mask = sa->sa_intv - 1;
+
+  if(1 == sa->sa_intv) {
+      for(i=0;i<n;i++) {
+          pacpos[i] = tmap_sa_get(sa, k[i]);
+      }
+      return;
+  }
+
+  // fill the slots
+  for(m=next=0;m<TMAP_SA_PAC_POS_BATCH_SIZE && next<n;m++,next++) {
+      q[m] = next; r[m] = k[next]; s[m] = 0;
+  }
+  while(0 < m) {
+      // prefetch the next access of every walk
+      for(i=0;i<m;i++) {
+          if(0 == (r[i] & mask)) __builtin_prefetch((const uint8_t*)sa->sa + (r[i] >> sa->sa_intv_log2) * tmap_sa_get_int_size(sa));
+          else tmap_bwt_prefetch_occ(bwt, r[i]);
+      }
+      // advance every walk
+      for(i=0;i<m;) {
+          if(0 != (r[i] & mask)) {
+              r[i] = tmap_bwt_match_hash_invPsi_step(bwt, r[i], hash);
+              s[i]++;
+              i++;
+          }
+          else { // reached a sampled position
+              pacpos[q[i]] = s[i] + tmap_sa_get(sa, r[i] >> sa->sa_intv_log2);
+              if(next < n) { // start the next lookup in this slot
+                  q[i] = next; r[i] = k[next]; s[i] = 0;
+                  next++;
+                  i++;
+              }
+              else { // move the last slot here
+                  m--;
+                  q[i] = q[m]; r[i] = r[m]; s[i] = s[m];
+              }
+          }
+      }
+  }
+}
+
 extern int32_t debug_on;
 
+#ifdef HAVE_LIBPTHREAD
+/*
+  The data shared by the threads sampling the SA
+ */
+typedef struct {
+    const tmap_bwt_t *bwt; /*!< the BWT */
+    tmap_sa_t *sa; /*!< the SA, holding the offset of each sample from the start of its segment */
+    uint16_t *sa_seg; /*!< the segment of each sample */
+    tmap_bwt_int_t seg_width; /*!< the segments start at the rows that are multiples of this (a power of two) */
+    int32_t num_segs; /*!< the number of segments */
+    tmap_bwt_int_t *seg_next; /*!< the first row of the next segment, divided by the segment width */
+    tmap_bwt_int_t *seg_len; /*!< the number of rows in each segment */
+    int32_t seg_next_to_walk; /*!< the next segment to walk */
+    tmap_bwt_int_t num_walked; /*!< the number of rows walked so far */
+    int32_t percent_walked; /*!< the last reported percentage of rows walked */
+    pthread_mutex_t *mutex; /*!< the mutex guarding the next segment and the progress */
+} tmap_sa_bwt2sa_data_t;
+
+// walks segments of the text backwards from their first rows until the first row of another segment
+static void *
+tmap_sa_bwt2sa_worker(void *arg)
+{
+  tmap_sa_bwt2sa_data_t *data = (tmap_sa_bwt2sa_data_t*)arg;
+  const tmap_bwt_t *bwt = data->bwt;
+  tmap_bwt_int_t isa, k, intv = data->sa->sa_intv;
+  int32_t seg, percent;
+
+  while(1) {
+      pthread_mutex_lock(data->mutex);
+      seg = data->seg_next_to_walk++;
+      pthread_mutex_unlock(data->mutex);
+      if(data->num_segs <= seg) break;
+
+      isa = seg * data->seg_width;
+      k = 0;
+      do {
+          if(0 == isa % intv) {
+              data->sa->sa[isa/intv] = k;
+              data->sa_seg[isa/intv] = seg;
+          }
+          k++;
+          isa = tmap_bwt_invPsi(bwt, isa);
+      } while(0 != (isa & (data->seg_width - 1)));
+      data->seg_next[seg] = isa / data->seg_width;
+      data->seg_len[seg] = k;
+
+      pthread_mutex_lock(data->mutex);
+      data->num_walked += k;
+      percent = (int32_t)((100 * (double)data->num_walked) / (bwt->seq_len + 1));
+      if(data->percent_walked / 10 < percent / 10) {
+          data->percent_walked = percent;
+          tmap_progress_print2("sampled %d%% of the SA", percent);
+      }
+      pthread_mutex_unlock(data->mutex);
+  }
+
+  return arg;
+}
+
+// splits the cycle of LF steps into segments starting at evenly spaced rows, walks
+// the segments in parallel, then chains the segments from the last suffix to find
+// the text position at which each segment starts
+static void
+tmap_sa_bwt2sa_threads(const tmap_bwt_t *bwt, tmap_sa_t *sa, int32_t num_threads)
+{
+  tmap_sa_bwt2sa_data_t data;
+  pthread_t *threads = NULL;
+  pthread_attr_t attr;
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  tmap_bwt_int_t *seg_pos = NULL, i, n = bwt->seq_len + 1;
+  int32_t j;
+
+  memset(&data, 0, sizeof(tmap_sa_bwt2sa_data_t));
+  data.bwt = bwt;
+  data.sa = sa;
+  data.mutex = &mutex;
+  // many more segments than threads to balance the work, since segment lengths vary
+  for(data.seg_width = 1; 
+      data.seg_width * TMAP_SA_BWT2SA_SEGS_PER_THREAD * num_threads < n || UINT16_MAX < (n + data.seg_width - 1) / data.seg_width; 
+      data.seg_width <<= 1);
+  data.num_segs = (n + data.seg_width - 1) / data.seg_width;
+  data.sa_seg = tmap_malloc(sizeof(uint16_t) * sa->n_sa, "data.sa_seg");
+  data.seg_next = tmap_malloc(sizeof(tmap_bwt_int_t) * data.num_segs, "data.seg_next");
+  data.seg_len = tmap_malloc(sizeof(tmap_bwt_int_t) * data.num_segs, "data.seg_len");
+
+  tmap_progress_print2("sampling the SA with %d threads in %d segments", num_threads, data.num_segs);
+
+  threads = tmap_calloc(num_threads, sizeof(pthread_t), "threads");
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+  for(j = 0; j < num_threads; j++) {
+      if(0 != pthread_create(&threads[j], &attr, tmap_sa_bwt2sa_worker, &data)) {
+          tmap_error("error creating threads", Exit, ThreadError);
+      }
+  }
+  for(j = 0; j < num_threads; j++) {
+      if(0 != pthread_join(threads[j], NULL)) {
+          tmap_error("error joining threads", Exit, ThreadError);
+      }
+  }
+  pthread_attr_destroy(&attr);
+  free(threads);
+
+  // the first segment starts at the last suffix (the first row)
+  seg_pos = tmap_malloc(sizeof(tmap_bwt_int_t) * data.num_segs, "seg_pos");
+  seg_pos[0] = bwt->seq_len;
+  for(i = 0, j = 0; 0 != data.seg_next[j]; j = data.seg_next[j]) {
+      seg_pos[data.seg_next[j]] = seg_pos[j] - data.seg_len[j];
+      i += data.seg_len[j];
+  }
+  if(n != i + data.seg_len[j]) {
+      tmap_bug();
+  }
+
+  // the text position of each sample
+  for(i = 0; i < sa->n_sa; i++) {
+      sa->sa[i] = seg_pos[data.sa_seg[i]] - sa->sa[i];
+  }
+
+  free(seg_pos);
+  free(data.sa_seg);
+  free(data.seg_next);
+  free(data.seg_len);
+}
+#endif
+
 void
-tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv)
+tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv, int32_t int_width, int32_t num_threads)
 {
   int64_t isa, s; // S(isa) = sa
   uint64_t i;
@@ -267,15 +527,33 @@ tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv)
 
   // calculate SA value
   sa->sa = tmap_calloc(sa->n_sa, sizeof(tmap_bwt_int_t), "sa->sa");
-  isa = 0; s = bwt->seq_len;
-  for(i = 0; i < bwt->seq_len; ++i) {
+#ifdef HAVE_LIBPTHREAD
+  if(1 < num_threads) {
+      tmap_sa_bwt2sa_threads(bwt, sa, num_threads);
+  }
+  else {
+#endif
+      isa = 0; s = bwt->seq_len;
+      for(i = 0; i < bwt->seq_len; ++i) {
+          if(isa % intv == 0) sa->sa[isa/intv] = s;
+          --s;
+          isa = tmap_bwt_invPsi(bwt, isa);
+      }
       if(isa % intv == 0) sa->sa[isa/intv] = s;
-      --s;
-      isa = tmap_bwt_invPsi(bwt, isa);
+#ifdef HAVE_LIBPTHREAD
   }
-  if(isa % intv == 0) sa->sa[isa/intv] = s;
+#endif
   sa->sa[0] = (tmap_bwt_int_t)-1; // before this line, bwt->sa[0] = bwt->seq_len
 
+  // store the entries in 32 bits if asked and they fit
+  if(32 == int_width && sizeof(uint32_t) < sizeof(tmap_bwt_int_t) && 32 == tmap_bwt_int_width(sa->seq_len)) {
+      sa->sa = tmap_bwt_int_pack32(sa->sa, sa->n_sa);
+      sa->int_width = 32;
+  }
+  else {
+      sa->int_width = 64;
+  }
+
   tmap_sa_write(fn_fasta, sa);
 
   tmap_bwt_destroy(bwt);
@@ -938,28 +1216,44 @@ tmap_sa_gen_short(const uint8_t *T, int32_t *SA, uint32_t n)
   return tmap_sa_sais_main(T, SA+1, 0, n, 256, 1);
 }
 
+int32_t
+tmap_sa_gen_int(const int32_t *T, int32_t *SA, int32_t n, int32_t k)
+{
+  if ((T == NULL) || (SA == NULL) || (n < 0) || (k <= 0)) return -1;
+  if (n <= 1) {
+      if (n == 1) SA[0] = 0;
+      return 0;
+  }
+  return tmap_sa_sais_main((const unsigned char *) T, SA, 0, n, k, sizeof(int32_t));
+}
+
 int
 tmap_sa_bwt2sa_main(int argc, char *argv[])
 {
-  int c, intv = TMAP_SA_INTERVAL, help=0;
+  int c, intv = TMAP_SA_INTERVAL, help=0, num_threads = 1, int_width = 64;
 
-  while((c = getopt(argc, argv, "i:vh")) >= 0) {
+  while((c = getopt(argc, argv, "i:n:Nvh")) >= 0) {
       switch(c) {
         case 'i': intv = atoi(optarg); break;
+        case 'N': int_width = 32; break;
+        case 'n': num_threads = atoi(optarg); break;
         case 'v': tmap_progress_set_verbosity(1); break;
         case 'h': help = 1; break;
         default: return 1;
       }
   }
   if(1 != argc - optind || 1 == help) {
-      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-i INT -vh] <in.fasta>\n", PACKAGE, argv[0]);
+      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-i INT -n INT -N -vh] <in.fasta>\n", PACKAGE, argv[0]);
       return 1;
   }
   if(intv <= 0 || (1 < intv && 0 != (intv % 2))) {
       tmap_error("option -i out of range", Exit, CommandLineArgument);
   }
+  if(num_threads < 1) {
+      tmap_error("option -n out of range", Exit, CommandLineArgument);
+  }
 
-  tmap_sa_bwt2sa(argv[optind], intv);
+  tmap_sa_bwt2sa(argv[optind], intv, int_width, num_threads);
 
   return 0;
 }
@@ -4,6 +4,16 @@
 
 #define TMAP_SA_INTERVAL 32
 
+/*!
+  The number of segments per thread when sampling the SA with multiple threads
+  */
+#define TMAP_SA_BWT2SA_SEGS_PER_THREAD 64
+
+/*!
+  The number of suffix array lookups walked together by tmap_sa_pac_pos_batch
+  */
+#define TMAP_SA_PAC_POS_BATCH_SIZE 32
+
 #include <stdint.h>
 #include "tmap_bwt.h"
 #include "tmap_bwt_match.h"
@@ -24,8 +34,19 @@ typedef struct {
     uint32_t is_shm;  /*!< 1 if loaded from shared memory, 0 otherwise */
     // Not stored in the file
     uint32_t sa_intv_log2;  /*!< the log2 suffix array interval (sampled) */
+    void *mmap_buf; /*!< the memory mapped SA file, NULL if not memory mapped */
+    size_t mmap_len; /*!< the length of the memory mapped SA file */
+    uint32_t int_width; /*!< the width in bits of the suffix array entries, stored in the file as the highest bit of the suffix array interval (32 if set) */
 } tmap_sa_t;
 
+/*!
+  @param  _sa  the suffix array
+  @param  _i   the index of the sampled suffix array entry
+  @return      the suffix array entry
+  */
+#define tmap_sa_get(_sa, _i) \
+  ((32 == (_sa)->int_width) ? tmap_bwt_int_from32(((const uint32_t*)(_sa)->sa)[_i]) : (_sa)->sa[_i])
+
 /*! 
   @param  fn_fasta  the FASTA file name
   @return           pointer to the sa structure 
@@ -33,6 +54,14 @@ typedef struct {
 tmap_sa_t *
 tmap_sa_read(const char *fn_fasta);
 
+/*! 
+  @param  fn_fasta  the FASTA file name
+  @param  populate  1 to read the whole file into memory now, 0 to read each page upon first access
+  @return           pointer to the sa structure, using the memory mapped file in place
+  */
+tmap_sa_t *
+tmap_sa_mmap(const char *fn_fasta, int32_t populate);
+
 /*! 
   @param  fn_fasta  the FASTA file name
   @param  sa        the sa structure to write
@@ -105,11 +134,30 @@ tmap_bwt_int_t
 tmap_sa_pac_pos(const tmap_sa_t *sa, const tmap_bwt_t *bwt, tmap_bwt_int_t k);
 
 /*! 
-  @param  fn_fasta  the FASTA file name
-  @param  intv      the suffix array interval
+  returns the suffix array positions given a batch of occurrence positions
+  @param  sa      the suffix array
+  @param  bwt     the bwt structure 
+  @param  n       the number of occurrence positions
+  @param  k       the occurrence positions
+  @param  pacpos  the pac positions returned, one per occurrence position; this may be the same array as k
+  @param  hash    the user occurence hash
+  @details        up to TMAP_SA_PAC_POS_BATCH_SIZE positions are walked to their sampled suffix array
+  position together, with the next bwt or suffix array access of every walk prefetched before any 
+  walk is advanced; the results are identical to tmap_sa_pac_pos_hash
+*/
+void
+tmap_sa_pac_pos_batch(const tmap_sa_t *sa, const tmap_bwt_t *bwt, int32_t n, const tmap_bwt_int_t *k, 
+                      tmap_bwt_int_t *pacpos, tmap_bwt_match_hash_t *hash);
+
+/*! 
+  @param  fn_fasta     the FASTA file name
+  @param  intv         the suffix array interval
+  @param  int_width    32 to store the entries in 32 bits if the reference is short enough, 64 otherwise
+  @param  num_threads  the number of threads
+  @details             with more than one thread, the text is split into segments that are sampled in parallel
   */
 void
-tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv);
+tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv, int32_t int_width, int32_t num_threads);
 
 /*! 
   constructs the suffix array of a given string.
@@ -121,6 +169,17 @@ tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv);
 uint32_t 
 tmap_sa_gen_short(const uint8_t *T, int32_t *SA, uint32_t n);
 
+/*! 
+  constructs the suffix array of a given integer string.
+  @param T   T[0..n-1] The input string, with symbols in [0, k).
+  @param SA  SA[0..n-1] The output array of suffixes (the empty suffix is not included).
+  @param n   the length of the given string.
+  @param k   the alphabet size.
+  @return    0 if no error occurred
+ */
+int32_t
+tmap_sa_gen_int(const int32_t *T, int32_t *SA, int32_t n, int32_t k);
+
 /*! 
   main-like function for 'tmap bwt2sa'
   @param  argc  the number of arguments
@@ -139,8 +139,8 @@ tmap_bwt_aux_invPsi(const tmap_bwt_t *bwt, tmap_bwt_int_t isa)
       c = tmap_bwt_B0(bwt, _i);
       if (TMAP_LIKELY(isa < bwt->seq_len)) {
           const uint32_t *p;
-          isa = bwt->L2[c] + ((const tmap_bwt_int_t *)(p = tmap_bwt_occ_intv(bwt, _i)))[c];
-          p += sizeof(tmap_bwt_int_t) + ((_i&0x60)>>4);
+          isa = bwt->L2[c] + tmap_bwt_get_occ_cnt(bwt, (p = tmap_bwt_occ_intv(bwt, _i)), c);
+          p += bwt->occ_cnt_words + ((_i&0x60)>>4);
           c = tmap_bwt_aux_occ(_i, tmap_bwt_aux_n_mask_64[c], p);
           isa += c * 0x101010101010101ul >> 56;
       } else {
@@ -164,6 +164,6 @@ tmap_sa_pac_pos_aux(const tmap_sa_t *sa, const tmap_bwt_t *bwt, tmap_bwt_int_t k
   }
   /* without setting bwt->sa[0] = -1, the following line should be
      changed to (s + bwt->sa[k/bwt->sa_intv]) % (bwt->seq_len + 1) */
-  return s + sa->sa[k/sa->sa_intv];
+  return s + tmap_sa_get(sa, k/sa->sa_intv);
 }
 #endif
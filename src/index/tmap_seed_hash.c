@@ -0,0 +1,473 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <config.h>
+
+#include "../util/tmap_error.h"
+#include "../util/tmap_alloc.h"
+#include "../util/tmap_progress.h"
+#include "../util/tmap_definitions.h"
+#include "../io/tmap_file.h"
+#include "tmap_refseq.h"
+#include "tmap_bwt.h"
+#include "tmap_bwt_match.h"
+#include "tmap_sa.h"
+#include "tmap_seed_hash.h"
+
+// the number of 64-bit header fields, in the order written
+#define __TMAP_SEED_HASH_N_HEADER 6
+
+// the number of positions of the k-mer in a slot, zero if the slot is empty
+#define __TMAP_SEED_HASH_N_MASK 0xFFFFull
+
+// the number of bytes in a stored position
+#define tmap_seed_hash_get_pos_size(_seed) ((32 == (_seed)->int_width) ? sizeof(uint32_t) : sizeof(uint64_t))
+
+// the i-th stored position
+#define tmap_seed_hash_get_pos(_seed, _i) \
+  ((32 == (_seed)->int_width) ? (tmap_bwt_int_t)((const uint32_t*)(_seed)->pos)[_i] : (tmap_bwt_int_t)((const uint64_t*)(_seed)->pos)[_i])
+
+// the first slot probed for a k-mer (Fibonacci hashing)
+#define tmap_seed_hash_get_slot(_seed, _key) (((_key) * 0x9E3779B97F4A7C15ull) >> (64 - (_seed)->slots_log2))
+
+// the i-th base of the forward and reverse complement reference sequence
+static inline uint8_t
+tmap_seed_hash_text_i(const tmap_refseq_t *refseq, uint64_t i)
+{
+  if(i < refseq->len) return tmap_refseq_seq_i(refseq, i);
+  return 3 - tmap_refseq_seq_i(refseq, (refseq->len << 1) - i - 1);
+}
+
+// the stored integer width is flagged to record that the positions of each k-mer are in suffix array order
+#define __TMAP_SEED_HASH_SA_ORDER 0x100ull
+
+// strips the flags from the stored integer width, failing for files without the suffix array order
+static void
+tmap_seed_hash_set_int_width_stored(tmap_seed_hash_t *seed)
+{
+  if(__TMAP_SEED_HASH_SA_ORDER != (seed->int_width & ~0xFFull)) {
+      tmap_error("unsupported seed hash format (positions not in suffix array order), rebuild it with tmap seedhash", Exit, OutOfRange);
+  }
+  seed->int_width &= 0xFFull;
+}
+
+int32_t
+tmap_seed_hash_exists(const char *fn_fasta)
+{
+  char *fn_seed = NULL;
+  int32_t ret;
+
+  fn_seed = tmap_get_file_name(fn_fasta, TMAP_SEED_FILE);
+  ret = (0 == access(fn_seed, R_OK)) ? 1 : 0;
+  free(fn_seed);
+
+  return ret;
+}
+
+static void
+tmap_seed_hash_read_header(tmap_seed_hash_t *seed, tmap_file_t *fp_seed)
+{
+  if(1 != tmap_file_fread(&seed->width, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fread(&seed->seq_len, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fread(&seed->max_freq, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fread(&seed->slots_log2, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fread(&seed->n_pos, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fread(&seed->int_width, sizeof(uint64_t), 1, fp_seed)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }  tmap_seed_hash_set_int_width_stored(seed);
+}
+
+tmap_seed_hash_t *
+tmap_seed_hash_read(const char *fn_fasta)
+{
+  char *fn_seed = NULL;
+  tmap_file_t *fp_seed = NULL;
+  tmap_seed_hash_t *seed = NULL;
+  uint64_t n_slots;
+
+  fn_seed = tmap_get_file_name(fn_fasta, TMAP_SEED_FILE);
+  fp_seed = tmap_file_fopen(fn_seed, "rb", TMAP_SEED_COMPRESSION);
+
+  seed = tmap_calloc(1, sizeof(tmap_seed_hash_t), "seed");
+
+  tmap_seed_hash_read_header(seed, fp_seed);
+  n_slots = 1ull << seed->slots_log2;
+
+  seed->slots = tmap_malloc(sizeof(uint64_t) * 2 * n_slots, "seed->slots");
+  seed->pos = tmap_malloc(tmap_seed_hash_get_pos_size(seed) * (1 + seed->n_pos), "seed->pos");
+
+  if(2 * n_slots != tmap_file_fread(seed->slots, sizeof(uint64_t), 2 * n_slots, fp_seed)
+     || seed->n_pos != tmap_file_fread(seed->pos, tmap_seed_hash_get_pos_size(seed), seed->n_pos, fp_seed)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+
+  tmap_file_fclose(fp_seed);
+  free(fn_seed);
+
+  seed->is_shm = 0;
+
+  return seed;
+}
+
+// sets the arrays in a buffer holding them in the order written by tmap_seed_hash_write
+static uint8_t *
+tmap_seed_hash_set_buffer(tmap_seed_hash_t *seed, uint8_t *buf)
+{
+  seed->slots = (uint64_t*)buf;
+  buf += sizeof(uint64_t) * 2 * (1ull << seed->slots_log2);
+  seed->pos = buf;
+  buf += tmap_seed_hash_get_pos_size(seed) * seed->n_pos;
+  return buf;
+}
+
+tmap_seed_hash_t *
+tmap_seed_hash_mmap(const char *fn_fasta, int32_t populate)
+{
+  char *fn_seed = NULL;
+  tmap_seed_hash_t *seed = NULL;
+  uint8_t *buf = NULL;
+
+  fn_seed = tmap_get_file_name(fn_fasta, TMAP_SEED_FILE);
+
+  seed = tmap_calloc(1, sizeof(tmap_seed_hash_t), "seed");
+  seed->mmap_buf = buf = tmap_file_mmap(fn_seed, &seed->mmap_len, populate);
+
+  // fixed length data, in the order written by tmap_seed_hash_write
+  if(seed->mmap_len < __TMAP_SEED_HASH_N_HEADER*sizeof(uint64_t)) {
+      tmap_error(fn_seed, Exit, ReadFileError);
+  }
+  memcpy(&seed->width, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->seq_len, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->max_freq, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->slots_log2, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->n_pos, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->int_width, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  tmap_seed_hash_set_int_width_stored(seed);
+
+  // variable length data
+  if(seed->mmap_len < tmap_seed_hash_shm_num_bytes(seed)) {
+      tmap_error(fn_seed, Exit, ReadFileError);
+  }
+  tmap_seed_hash_set_buffer(seed, buf);
+
+  free(fn_seed);
+
+  seed->is_shm = 0;
+
+  return seed;
+}
+
+void
+tmap_seed_hash_write(const char *fn_fasta, tmap_seed_hash_t *seed)
+{
+  char *fn_seed = NULL;
+  tmap_file_t *fp_seed = NULL;
+  uint64_t n_slots = 1ull << seed->slots_log2;
+  uint64_t int_width = seed->int_width | __TMAP_SEED_HASH_SA_ORDER;
+
+  fn_seed = tmap_get_file_name(fn_fasta, TMAP_SEED_FILE);
+  fp_seed = tmap_file_fopen(fn_seed, "wb", TMAP_SEED_COMPRESSION);
+
+  if(1 != tmap_file_fwrite(&seed->width, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fwrite(&seed->seq_len, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fwrite(&seed->max_freq, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fwrite(&seed->slots_log2, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fwrite(&seed->n_pos, sizeof(uint64_t), 1, fp_seed)
+     || 1 != tmap_file_fwrite(&int_width, sizeof(uint64_t), 1, fp_seed)
+     || 2 * n_slots != tmap_file_fwrite(seed->slots, sizeof(uint64_t), 2 * n_slots, fp_seed)
+     || seed->n_pos != tmap_file_fwrite(seed->pos, tmap_seed_hash_get_pos_size(seed), seed->n_pos, fp_seed)) {
+      tmap_error(NULL, Exit, WriteFileError);
+  }
+
+  tmap_file_fclose(fp_seed);
+  free(fn_seed);
+}
+
+size_t
+tmap_seed_hash_shm_num_bytes(tmap_seed_hash_t *seed)
+{
+  // returns the number of bytes to allocate for shared memory
+  size_t n = 0;
+
+  n += sizeof(uint64_t) * __TMAP_SEED_HASH_N_HEADER; // width, seq_len, max_freq, slots_log2, n_pos, int_width
+  n += sizeof(uint64_t) * 2 * (1ull << seed->slots_log2); // slots
+  n += tmap_seed_hash_get_pos_size(seed) * seed->n_pos; // pos
+
+  return n;
+}
+
+size_t
+tmap_seed_hash_shm_read_num_bytes(const char *fn_fasta)
+{
+  char *fn_seed = NULL;
+  tmap_file_t *fp_seed = NULL;
+  tmap_seed_hash_t seed;
+
+  fn_seed = tmap_get_file_name(fn_fasta, TMAP_SEED_FILE);
+  fp_seed = tmap_file_fopen(fn_seed, "rb", TMAP_SEED_COMPRESSION);
+
+  // No need to read in the arrays
+  tmap_seed_hash_read_header(&seed, fp_seed);
+
+  tmap_file_fclose(fp_seed);
+  free(fn_seed);
+
+  return tmap_seed_hash_shm_num_bytes(&seed);
+}
+
+uint8_t *
+tmap_seed_hash_shm_pack(tmap_seed_hash_t *seed, uint8_t *buf)
+{
+  // fixed length data
+  memcpy(buf, &seed->width, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &seed->seq_len, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &seed->max_freq, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &seed->slots_log2, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &seed->n_pos, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(buf, &seed->int_width, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  // variable length data
+  memcpy(buf, seed->slots, sizeof(uint64_t) * 2 * (1ull << seed->slots_log2)); buf += sizeof(uint64_t) * 2 * (1ull << seed->slots_log2);
+  memcpy(buf, seed->pos, tmap_seed_hash_get_pos_size(seed) * seed->n_pos); buf += tmap_seed_hash_get_pos_size(seed) * seed->n_pos;
+
+  return buf;
+}
+
+tmap_seed_hash_t *
+tmap_seed_hash_shm_unpack(uint8_t *buf)
+{
+  tmap_seed_hash_t *seed = NULL;
+
+  if(NULL == buf) return NULL;
+
+  seed = tmap_calloc(1, sizeof(tmap_seed_hash_t), "seed");
+
+  // fixed length data
+  memcpy(&seed->width, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->seq_len, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->max_freq, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->slots_log2, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->n_pos, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  memcpy(&seed->int_width, buf, sizeof(uint64_t)); buf += sizeof(uint64_t);
+  // variable length data
+  tmap_seed_hash_set_buffer(seed, buf);
+
+  seed->is_shm = 1;
+
+  return seed;
+}
+
+void
+tmap_seed_hash_destroy(tmap_seed_hash_t *seed)
+{
+  if(NULL == seed) return;
+  if(1 == seed->is_shm) {
+      free(seed);
+  }
+  else if(NULL != seed->mmap_buf) {
+      tmap_file_munmap(seed->mmap_buf, seed->mmap_len);
+      free(seed);
+  }
+  else {
+      free(seed->slots);
+      free(seed->pos);
+      free(seed);
+  }
+}
+
+// the slot of a k-mer, or the empty slot where it would be added
+static inline uint64_t
+tmap_seed_hash_get_slot_i(const tmap_seed_hash_t *seed, uint64_t key)
+{
+  uint64_t i, mask = (1ull << seed->slots_log2) - 1;
+
+  i = tmap_seed_hash_get_slot(seed, key);
+  while(0 != (seed->slots[(i << 1) + 1] & __TMAP_SEED_HASH_N_MASK) && key != seed->slots[i << 1]) {
+      i = (i + 1) & mask; // linear probing
+  }
+  return i;
+}
+
+tmap_seed_hash_t *
+tmap_seed_hash_gen(const tmap_refseq_t *refseq, const tmap_bwt_t *bwt, const tmap_sa_t *sa, int32_t width, int32_t max_freq)
+{
+  tmap_seed_hash_t *seed = NULL;
+  tmap_bwt_match_occ_t match_sa;
+  tmap_bwt_int_t *rows = NULL, *pacpos = NULL;
+  uint8_t *str = NULL;
+  uint64_t i, p, key, n, n_kmers, n_slots, cur, *slot;
+  uint64_t key_mask = (32 == width) ? UINT64_MAX : ((1ull << (width << 1)) - 1);
+
+  if(width < TMAP_SEED_HASH_WIDTH_MIN || TMAP_SEED_HASH_WIDTH_MAX < width) {
+      tmap_error("seed hash width out of range", Exit, OutOfRange);
+  }
+  if(max_freq < 1 || TMAP_SEED_HASH_MAX_FREQ_MAX < max_freq) {
+      tmap_error("seed hash maximum frequency out of range", Exit, OutOfRange);
+  }
+  if((refseq->len << 1) < (uint64_t)width) {
+      tmap_error("seed hash width greater than the reference length", Exit, OutOfRange);
+  }
+
+  tmap_progress_print("constructing the seed hash of width %d", width);
+
+  seed = tmap_calloc(1, sizeof(tmap_seed_hash_t), "seed");
+  seed->width = width;
+  seed->seq_len = refseq->len << 1;
+  seed->max_freq = max_freq;
+  seed->int_width = tmap_bwt_int_width(seed->seq_len);
+
+  // at most half of the slots are used, with every k-mer of the reference
+  n_kmers = seed->seq_len - width + 1;
+  if(width < 32 && (1ull << (width << 1)) < n_kmers) n_kmers = 1ull << (width << 1);
+  for(seed->slots_log2 = 1, n_slots = 2; n_slots < (n_kmers << 1); seed->slots_log2++, n_slots <<= 1);
+  seed->slots = tmap_calloc(2 * n_slots, sizeof(uint64_t), "seed->slots");
+
+  // count the positions of each k-mer, the first base the most significant
+  tmap_progress_print2("counting the k-mers");
+  for(p = key = 0; p < seed->seq_len; p++) {
+      key = ((key << 2) | tmap_seed_hash_text_i(refseq, p)) & key_mask;
+      if(p + 1 < (uint64_t)width) continue;
+      slot = seed->slots + (tmap_seed_hash_get_slot_i(seed, key) << 1);
+      slot[0] = key;
+      if(__TMAP_SEED_HASH_N_MASK != (slot[1] & __TMAP_SEED_HASH_N_MASK)) slot[1]++;
+  }
+
+  // the positions of each stored k-mer start at its offset
+  for(i = cur = 0; i < n_slots; i++) {
+      n = seed->slots[(i << 1) + 1] & __TMAP_SEED_HASH_N_MASK;
+      if(0 < n && n <= seed->max_freq) {
+          seed->slots[(i << 1) + 1] = (cur << 16) | n;
+          cur += n;
+      }
+  }
+  seed->n_pos = cur;
+  seed->pos = tmap_malloc(tmap_seed_hash_get_pos_size(seed) * (1 + seed->n_pos), "seed->pos");
+
+  // add the positions of each stored k-mer in suffix array order, as an exact search of
+  // the BWT finds them, by looking up the rows of its BWT interval in the suffix array
+  tmap_progress_print2("adding the k-mer positions");
+  str = tmap_malloc(sizeof(uint8_t) * width, "str");
+  rows = tmap_malloc(sizeof(tmap_bwt_int_t) * seed->max_freq, "rows");
+  pacpos = tmap_malloc(sizeof(tmap_bwt_int_t) * seed->max_freq, "pacpos");
+  for(i = 0; i < n_slots; i++) {
+      n = seed->slots[(i << 1) + 1] & __TMAP_SEED_HASH_N_MASK;
+      if(0 == n || seed->max_freq < n) continue;
+      key = seed->slots[i << 1];
+      for(p = 0; p < (uint64_t)width; p++) { // NB: searched reversed, so the last base is the most significant
+          str[p] = (key >> (p << 1)) & 3;
+      }
+      if(n != tmap_bwt_match_exact(bwt, width, str, &match_sa)) {
+          tmap_error("the seed hash does not match the BWT", Exit, OutOfRange);
+      }
+      for(p = 0; p < n; p++) {
+          rows[p] = match_sa.k + p;
+      }
+      tmap_sa_pac_pos_batch(sa, bwt, n, rows, pacpos, NULL);
+      cur = seed->slots[(i << 1) + 1] >> 16;
+      for(p = 0; p < n; p++) {
+          if(32 == seed->int_width) ((uint32_t*)seed->pos)[cur + p] = pacpos[p];
+          else ((uint64_t*)seed->pos)[cur + p] = pacpos[p];
+      }
+  }
+  free(str);
+  free(rows);
+  free(pacpos);
+
+  tmap_progress_print2("constructed the seed hash [%llu bytes]",
+                       (unsigned long long int)tmap_seed_hash_shm_num_bytes(seed));
+
+  return seed;
+}
+
+void
+tmap_seed_hash_update(const char *fn_fasta, int32_t width, int32_t max_freq)
+{
+  tmap_refseq_t *refseq = NULL;
+  tmap_bwt_t *bwt = NULL;
+  tmap_sa_t *sa = NULL;
+  tmap_seed_hash_t *seed = NULL;
+
+  refseq = tmap_refseq_read(fn_fasta);
+  bwt = tmap_bwt_read(fn_fasta);
+  sa = tmap_sa_read(fn_fasta);
+  seed = tmap_seed_hash_gen(refseq, bwt, sa, width, max_freq);
+  tmap_seed_hash_write(fn_fasta, seed);
+  tmap_seed_hash_destroy(seed);
+  tmap_sa_destroy(sa);
+  tmap_bwt_destroy(bwt);
+  tmap_refseq_destroy(refseq);
+}
+
+int32_t
+tmap_seed_hash_find(const tmap_seed_hash_t *seed, const tmap_refseq_t *refseq, int32_t len, const uint8_t *str,
+                    int32_t max_hits, tmap_bwt_int_t *hits)
+{
+  int32_t i, j, m, width = seed->width;
+  uint64_t key, n, offset, *slot;
+  tmap_bwt_int_t p;
+
+  // NB: the string is matched reversed in the reference, so the k-mer is its last bases
+  for(i = 0, key = 0; i < width; i++) {
+      if(TMAP_UNLIKELY(3 < str[len - 1 - i])) return 0;
+      key = (key << 2) | str[len - 1 - i];
+  }
+  slot = seed->slots + (tmap_seed_hash_get_slot_i(seed, key) << 1);
+  n = slot[1] & __TMAP_SEED_HASH_N_MASK;
+  if(0 == n) return 0; // does not occur
+  if(seed->max_freq < n) { // the positions were not stored
+      return (len == width && max_hits < n) ? (int32_t)n : -1;
+  }
+  offset = slot[1] >> 16;
+  if(len == width) {
+      if(max_hits < n) return n;
+      for(i = 0; i < n; i++) {
+          hits[i] = tmap_seed_hash_get_pos(seed, offset + i);
+      }
+      return n;
+  }
+
+  // check the remaining bases
+  for(i = m = 0; i < n; i++) {
+      p = tmap_seed_hash_get_pos(seed, offset + i);
+      if(seed->seq_len < p + len) continue;
+      for(j = width; j < len; j++) {
+          if(tmap_seed_hash_text_i(refseq, p + j) != str[len - 1 - j]) break;
+      }
+      if(j < len) continue;
+      if(max_hits <= m) return m + 1;
+      hits[m++] = p;
+  }
+  return m;
+}
+
+int
+tmap_seed_hash_main(int argc, char *argv[])
+{
+  int c, help = 0;
+  int32_t width = TMAP_SEED_HASH_WIDTH, max_freq = TMAP_SEED_HASH_MAX_FREQ;
+
+  while((c = getopt(argc, argv, "w:m:vh")) >= 0) {
+      switch(c) {
+        case 'w': width = atoi(optarg); break;
+        case 'm': max_freq = atoi(optarg); break;
+        case 'v': tmap_progress_set_verbosity(1); break;
+        case 'h': help = 1; break;
+        default: return 1;
+      }
+  }
+  if(1 != argc - optind || 1 == help) {
+      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-w INT -m INT -v -h] <in.fasta>\n", PACKAGE, argv[0]);
+      return 1;
+  }
+  if(width < TMAP_SEED_HASH_WIDTH_MIN || TMAP_SEED_HASH_WIDTH_MAX < width) {
+      tmap_error("option -w out of range", Exit, CommandLineArgument);
+  }
+  if(max_freq < 1 || TMAP_SEED_HASH_MAX_FREQ_MAX < max_freq) {
+      tmap_error("option -m out of range", Exit, CommandLineArgument);
+  }
+  tmap_seed_hash_update(argv[optind], width, max_freq);
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef TMAP_SEED_HASH_H
+#define TMAP_SEED_HASH_H
+
+#include <stdint.h>
+#include "../util/tmap_definitions.h"
+#include "tmap_refseq.h"
+#include "tmap_bwt.h"
+#include "tmap_sa.h"
+
+/*!
+  A seed hash of the reference sequence.  It gives the positions of every
+  k-mer of the forward and reverse complement reference sequence, as they are
+  indexed by the BWT, so an exact search of a seed at least k bases long
+  finds its suffix array positions without searching the BWT or walking the
+  suffix array.  The k-mers are stored in an open addressing hash table, each
+  slot holding a k-mer and the offset and number of its positions, which are
+  stored together in suffix array order, as the BWT finds them.  The
+  positions of k-mers occurring more often than a given frequency are not
+  stored.
+  */
+
+/*!
+  The default k-mer width
+  */
+#define TMAP_SEED_HASH_WIDTH 12
+
+/*!
+  The minimum k-mer width
+  */
+#define TMAP_SEED_HASH_WIDTH_MIN 4
+
+/*!
+  The maximum k-mer width
+  */
+#define TMAP_SEED_HASH_WIDTH_MAX 32
+
+/*!
+  The default maximum number of positions stored for a k-mer
+  */
+#define TMAP_SEED_HASH_MAX_FREQ 1024
+
+/*!
+  The largest maximum number of positions stored for a k-mer
+  */
+#define TMAP_SEED_HASH_MAX_FREQ_MAX 0xFFFE
+
+/*!
+  The seed hash
+  */
+typedef struct __tmap_seed_hash_t {
+    uint64_t width;  /*!< the k-mer width */
+    uint64_t seq_len;  /*!< the length of the forward and reverse complement reference sequence */
+    uint64_t max_freq;  /*!< the maximum number of positions stored for a k-mer */
+    uint64_t slots_log2;  /*!< the log2 of the number of slots */
+    uint64_t n_pos;  /*!< the number of positions stored */
+    uint64_t int_width;  /*!< the width in bits of the stored positions */
+    uint64_t *slots;  /*!< for each slot, the k-mer followed by the offset of its positions (upper 48 bits) and their number (lower 16 bits, zero if the slot is empty) */
+    void *pos;  /*!< the positions of the k-mers, in suffix array order for each k-mer */
+    uint32_t is_shm;  /*!< 1 if loaded from shared memory, 0 otherwise */
+    void *mmap_buf; /*!< the memory mapped seed hash file, NULL if not memory mapped */
+    size_t mmap_len; /*!< the length of the memory mapped seed hash file */
+} tmap_seed_hash_t;
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @return           1 if the seed hash file exists, 0 otherwise
+  */
+int32_t
+tmap_seed_hash_exists(const char *fn_fasta);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @return           pointer to the seed hash
+  */
+tmap_seed_hash_t *
+tmap_seed_hash_read(const char *fn_fasta);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @param  populate  1 to read the memory mapped file into memory now, 0 otherwise
+  @return           pointer to the seed hash, using the memory mapped file in place
+  */
+tmap_seed_hash_t *
+tmap_seed_hash_mmap(const char *fn_fasta, int32_t populate);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @param  seed      the seed hash to write
+  */
+void
+tmap_seed_hash_write(const char *fn_fasta, tmap_seed_hash_t *seed);
+
+/*!
+  @param  seed  the seed hash
+  @return       the number of bytes required for this seed hash in shared memory
+  */
+size_t
+tmap_seed_hash_shm_num_bytes(tmap_seed_hash_t *seed);
+
+/*!
+  @param  fn_fasta  the FASTA file name
+  @return           the number of bytes required for this seed hash in shared memory
+  */
+size_t
+tmap_seed_hash_shm_read_num_bytes(const char *fn_fasta);
+
+/*!
+  @param  seed  the seed hash to pack
+  @param  buf   the byte array in which to pack the seed hash
+  @return       a pointer to the next unused byte in memory
+  */
+uint8_t *
+tmap_seed_hash_shm_pack(tmap_seed_hash_t *seed, uint8_t *buf);
+
+/*!
+  @param  buf  the byte array in which the seed hash was packed
+  @return      a pointer to the seed hash, NULL if none
+  */
+tmap_seed_hash_t *
+tmap_seed_hash_shm_unpack(uint8_t *buf);
+
+/*!
+  @param  seed  the seed hash to destroy
+  */
+void
+tmap_seed_hash_destroy(tmap_seed_hash_t *seed);
+
+/*!
+  @param  refseq    the packed forward reference sequence
+  @param  bwt       the BWT of the reference, giving the suffix array order of the positions
+  @param  sa        the suffix array of the reference
+  @param  width     the k-mer width
+  @param  max_freq  the maximum number of positions stored for a k-mer
+  @return           the seed hash
+  */
+tmap_seed_hash_t *
+tmap_seed_hash_gen(const tmap_refseq_t *refseq, const tmap_bwt_t *bwt, const tmap_sa_t *sa, int32_t width, int32_t max_freq);
+
+/*!
+  creates the seed hash file for an existing index
+  @param  fn_fasta  the FASTA file name
+  @param  width     the k-mer width
+  @param  max_freq  the maximum number of positions stored for a k-mer
+  */
+void
+tmap_seed_hash_update(const char *fn_fasta, int32_t width, int32_t max_freq);
+
+/*!
+  finds the suffix array positions of a string, as an exact search of the BWT would
+  @param  seed      the seed hash
+  @param  refseq    the packed forward reference sequence
+  @param  len       the length of the string, at least the k-mer width
+  @param  str       the string, as given to tmap_bwt_match_hash_exact
+  @param  max_hits  the maximum number of positions to return
+  @param  hits      the suffix array positions returned, at least max_hits
+  @return           the number of positions, -1 if they were not stored; if greater than max_hits, hits is incomplete
+  */
+int32_t
+tmap_seed_hash_find(const tmap_seed_hash_t *seed, const tmap_refseq_t *refseq, int32_t len, const uint8_t *str,
+                    int32_t max_hits, tmap_bwt_int_t *hits);
+
+/*!
+  main-like function for 'tmap seedhash'
+  @param  argc  the number of arguments
+  @param  argv  the argument list
+  @return       0 if executed successful
+  */
+int
+tmap_seed_hash_main(int argc, char *argv[]);
+
+#endif
@@ -7,6 +7,9 @@
 #include <bzlib.h>
 #include <zlib.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <config.h>
 
 #include "../util/tmap_error.h"
@@ -157,10 +160,119 @@ tmap_file_fdopen(int filedes, const char *mode, int32_t compression)
   return fp;
 }
 
+tmap_file_t *
+tmap_file_mopen()
+{
+  tmap_file_t *fp = NULL;
+
+  fp = tmap_calloc(1, sizeof(tmap_file_t), "fp");
+  fp->c = TMAP_FILE_NO_COMPRESSION;
+  fp->mem_max = 1024;
+  fp->mem = tmap_malloc(sizeof(char) * fp->mem_max, "fp->mem");
+  fp->mem_len = 0;
+
+  return fp;
+}
+
+void
+tmap_file_mreset(tmap_file_t *fp)
+{
+  fp->mem_len = 0;
+}
+
+void
+tmap_file_mtrim(tmap_file_t *fp, size_t mem_max)
+{
+  if(0 < fp->mem_len || fp->mem_max <= mem_max) return;
+  while(mem_max < fp->mem_max && 1024 < fp->mem_max) {
+      fp->mem_max >>= 1;
+  }
+  fp->mem = tmap_realloc(fp->mem, sizeof(char) * fp->mem_max, "fp->mem");
+}
+
+// makes room for at least len more bytes in the memory buffer
+static inline void
+tmap_file_mreserve(tmap_file_t *fp, size_t len)
+{
+  if(fp->mem_max < fp->mem_len + len) {
+      while(fp->mem_max < fp->mem_len + len) {
+          fp->mem_max <<= 1;
+      }
+      fp->mem = tmap_realloc(fp->mem, sizeof(char) * fp->mem_max, "fp->mem");
+  }
+}
+
+static int32_t
+tmap_file_mvprintf(tmap_file_t *fp, const char *format, va_list ap)
+{
+  int32_t n;
+  va_list ap2;
+
+  va_copy(ap2, ap);
+  n = vsnprintf(fp->mem + fp->mem_len, fp->mem_max - fp->mem_len, format, ap2);
+  va_end(ap2);
+  if(n < 0) {
+      tmap_error("vsnprintf failed", Exit, WriteFileError);
+  }
+  if(fp->mem_max - fp->mem_len <= (size_t)n) { // not enough room, try again
+      tmap_file_mreserve(fp, n + 1);
+      va_copy(ap2, ap);
+      n = vsnprintf(fp->mem + fp->mem_len, fp->mem_max - fp->mem_len, format, ap2);
+      va_end(ap2);
+  }
+  fp->mem_len += n;
+
+  return n;
+}
+
+void *
+tmap_file_mmap(const char *path, size_t *len, int32_t populate)
+{
+  int fd, flags = MAP_PRIVATE;
+  struct stat st;
+  void *buf = NULL;
+
+  fd = open(path, O_RDONLY);
+  if(fd < 0) {
+      tmap_error(path, Exit, OpenFileError);
+  }
+  if(0 != fstat(fd, &st) || 0 == st.st_size) {
+      tmap_error(path, Exit, ReadFileError);
+  }
+  (*len) = st.st_size;
+#ifdef MAP_POPULATE
+  if(1 == populate) flags |= MAP_POPULATE;
+#endif
+  buf = mmap(NULL, (*len), PROT_READ, flags, fd, 0);
+  if(MAP_FAILED == buf) {
+      tmap_error(path, Exit, ReadFileError);
+  }
+  if(1 == populate) {
+      madvise(buf, (*len), MADV_WILLNEED);
+  }
+  close(fd); // NB: the mapping keeps the file open
+
+  return buf;
+}
+
+void
+tmap_file_munmap(void *buf, size_t len)
+{
+  if(NULL == buf) return;
+  if(0 != munmap(buf, len)) {
+      tmap_error("munmap", Exit, CloseFileError);
+  }
+}
+
 void 
 tmap_file_fclose1(tmap_file_t *fp, int32_t close_underlyingfp) 
 {
   int closed_ok = 1;
+  if(NULL != fp->mem) {
+      free(fp->mem);
+      free(fp);
+      return;
+  }
   switch(fp->c) {
     case TMAP_FILE_NO_COMPRESSION:
       if(1 == close_underlyingfp) {
@@ -331,6 +443,13 @@ tmap_file_fwrite(void *ptr, size_t size, size_t count, tmap_file_t *fp)
 {
   size_t num_written = 0;
 
+  if(NULL != fp->mem) {
+      tmap_file_mreserve(fp, size*count);
+      memcpy(fp->mem + fp->mem_len, ptr, size*count);
+      fp->mem_len += size*count;
+      return count;
+  }
+
   switch(fp->c) {
     case TMAP_FILE_NO_COMPRESSION:
       num_written = fwrite(ptr, size, count, fp->fp);
@@ -360,6 +479,10 @@ tmap_file_vfprintf(tmap_file_t *fp, const char *format, va_list ap)
 {
   int32_t n;
 
+  if(NULL != fp->mem) {
+      return tmap_file_mvprintf(fp, format, ap);
+  }
+
   if(TMAP_FILE_NO_COMPRESSION != fp->c) {
       tmap_error("compression not supported", Exit, OutOfRange);
   }
@@ -382,7 +505,12 @@ tmap_file_fprintf(tmap_file_t *fp, const char *format, ...)
   if(NULL == fp) tmap_error("input file pointer was null", Exit, WriteFileError);
 
   va_start(ap, format);
-  n = vfprintf(fp->fp, format, ap);
+  if(NULL != fp->mem) {
+      n = tmap_file_mvprintf(fp, format, ap);
+  }
+  else {
+      n = vfprintf(fp->fp, format, ap);
+  }
   va_end(ap);
 
   return n;
@@ -408,6 +536,8 @@ tmap_file_fflush(tmap_file_t *fp, int32_t gz_flush)
 {
   int32_t ret = EOF;
 
+  if(NULL != fp->mem) return 0; // nothing to flush
+
   switch(fp->c) {
     case TMAP_FILE_NO_COMPRESSION:
       ret = fflush(fp->fp);
@@ -47,6 +47,9 @@ typedef struct {
     int32_t bzerror;  /*!< stores the last BZ2 error */
     int32_t open_type;  /*!< the type of bzip2 stream */
 #endif
+    char *mem;  /*!< the memory buffer written to, NULL if writing to a file */
+    size_t mem_len;  /*!< the number of bytes written to the memory buffer */
+    size_t mem_max;  /*!< the number of bytes allocated for the memory buffer */
 } tmap_file_t;
 
 extern tmap_file_t *tmap_file_stdout; // to use, initialize this in your main
@@ -72,6 +75,48 @@ tmap_file_fopen(const char* path, const char *mode, int32_t compression);
 tmap_file_t *
 tmap_file_fdopen(int filedes, const char *mode, int32_t compression);
 
+/*! 
+  opens a file that writes to a growable memory buffer
+  @return              a pointer to the initialized file structure
+  @details             the written data is available in mem, and may be discarded with tmap_file_mreset
+  */
+tmap_file_t *
+tmap_file_mopen();
+
+/*! 
+  discards the data written to a memory buffer file, keeping its memory
+  @param  fp  pointer to the file structure opened with tmap_file_mopen
+  */
+void
+tmap_file_mreset(tmap_file_t *fp);
+
+/*! 
+  releases the memory of an empty memory buffer file beyond the given size
+  @param  fp       pointer to the file structure opened with tmap_file_mopen
+  @param  mem_max  the number of bytes to keep
+  */
+void
+tmap_file_mtrim(tmap_file_t *fp, size_t mem_max);
+
+/*! 
+  memory maps an uncompressed file read-only
+  @param  path      the file name
+  @param  len       the length of the file, in bytes, is stored here
+  @param  populate  1 to read the whole file into memory now, 0 to read each page upon first access
+  @return           the start of the mapped file
+  @details          the mapping is private, and shares the page cache with other processes mapping the file
+  */
+void *
+tmap_file_mmap(const char *path, size_t *len, int32_t populate);
+
+/*! 
+  unmaps a file mapped with tmap_file_mmap
+  @param  buf  the start of the mapped file
+  @param  len  the length of the file, in bytes
+  */
+void
+tmap_file_munmap(void *buf, size_t len);
+
 /*! 
   closes the file associated with the file pointer
   @param  fp  pointer to the file structure to close
@@ -311,6 +311,7 @@ tmap_map1_sam_to_real(tmap_map_sams_t *sams, tmap_map1_aux_occ_t *occs, tmap_str
   tmap_map_sam_t *sam_cur = NULL;
   uint32_t i, j, aln_ref;
   tmap_bwt_int_t k, n, num_all_sa;
+  tmap_bwt_int_t b, b_start, b_end, pacposs[TMAP_SA_PAC_POS_BATCH_SIZE];
 
   // max # of entries
   for(i=n=0;i<sams->n;i++) {
@@ -334,6 +335,7 @@ tmap_map1_sam_to_real(tmap_map_sams_t *sams, tmap_map1_aux_occ_t *occs, tmap_str
       sam = &sams->sams[i];
 
       // go through SA interval
+      b_start = b_end = occs[i].k;
       for(k=occs[i].k;k<=occs[i].l;k++) {
           uint32_t pos = 0, seqid = 0;
           tmap_bwt_int_t pacpos = 0;
@@ -344,8 +346,19 @@ tmap_map1_sam_to_real(tmap_map_sams_t *sams, tmap_map1_aux_occ_t *occs, tmap_str
 
           strand = sams->sams[i].strand;
           aln_ref = sam->aux.map1_aux->aln_ref;
+
+          if(b_end == k) { // look up the packed positions of the next occurrences together, no more than will be saved
+              b_start = k;
+              b_end = occs[i].l + 1;
+              if(n - j < b_end - b_start) b_end = b_start + (n - j);
+              if(TMAP_SA_PAC_POS_BATCH_SIZE < b_end - b_start) b_end = b_start + TMAP_SA_PAC_POS_BATCH_SIZE;
+              for(b=b_start;b<b_end;b++) {
+                  pacposs[b-b_start] = b;
+              }
+              tmap_sa_pac_pos_batch(sa, bwt, b_end - b_start, pacposs, pacposs, hash);
+          }
               
-          pacpos = bwt->seq_len - tmap_sa_pac_pos_hash(sa, bwt, k, hash);
+          pacpos = bwt->seq_len - pacposs[k-b_start];
           pacpos = (pacpos < aln_ref) ? 0 : (pacpos - aln_ref);
           pacpos++; // make one-based
           
@@ -43,6 +43,7 @@ tmap_map2_aux_sa_pac_pos(const tmap_refseq_t *refseq, const tmap_bwt_t *bwt, con
   int64_t n;
   //uint32_t seqid, pos;
   uint8_t is_rev;
+  tmap_bwt_int_t *pacposs = NULL;
   if(b->n == 0) return 1;
   if(NULL != bwt && NULL != sa) { // convert to chromosomal coordinates if suitable
       tmap_map2_aln_t *tmp_b;
@@ -68,6 +69,21 @@ tmap_map2_aux_sa_pac_pos(const tmap_refseq_t *refseq, const tmap_bwt_t *bwt, con
       // realloc
       tmap_map2_aln_realloc(b, n);
       b->n = n;
+      // look up the packed positions of all the hits together
+      pacposs = tmap_malloc((0 < n ? n : 1) * sizeof(tmap_bwt_int_t), "pacposs");
+      for(i = j = 0; i < tmp_b->n; ++i) {
+          tmap_map2_hit_t *p = tmp_b->hits + i;
+          if(0 == p->k && 0 == p->l && 0 == p->qlen) continue;
+          if(p->l - p->k + 1 <= IS && TMAP_MAP2_MINUS_INF < p->G) {
+              tmap_bwt_int_t k;
+              for(k = p->k; k <= p->l; ++k) {
+                  pacposs[j++] = k;
+              }
+          } else if(p->G > min_as) {
+              pacposs[j++] = p->k;
+          }
+      }
+      tmap_sa_pac_pos_batch(sa, bwt, j, pacposs, pacposs, hash);
       // copy over
       for(i = j = 0; i < tmp_b->n; ++i) {
           tmap_map2_hit_t *p = tmp_b->hits + i;
@@ -76,7 +92,7 @@ tmap_map2_aux_sa_pac_pos(const tmap_refseq_t *refseq, const tmap_bwt_t *bwt, con
               tmap_bwt_int_t k;
               for(k = p->k; k <= p->l; ++k) {
                   b->hits[j] = *p;
-                  b->hits[j].k = tmap_sa_pac_pos_hash(sa, bwt, k, hash); // NB: keep zero based for now
+                  b->hits[j].k = pacposs[j]; // NB: keep zero based for now
                   b->hits[j].l = 0;
                   is_rev = (refseq->len < b->hits[j].k) ? 1 : 0;
                   b->hits[j].is_rev = is_rev;
@@ -87,7 +103,7 @@ tmap_map2_aux_sa_pac_pos(const tmap_refseq_t *refseq, const tmap_bwt_t *bwt, con
               }
           } else if(p->G > min_as) {
               b->hits[j] = *p;
-              b->hits[j].k = tmap_sa_pac_pos_hash(sa, bwt, p->k, hash); // NB: keep zero based for now
+              b->hits[j].k = pacposs[j]; // NB: keep zero based for now
               b->hits[j].l = 0;
               is_rev = (refseq->len < b->hits[j].k) ? 1 : 0;
               b->hits[j].is_rev = is_rev;
@@ -99,6 +115,7 @@ tmap_map2_aux_sa_pac_pos(const tmap_refseq_t *refseq, const tmap_bwt_t *bwt, con
           }
       }
       tmap_map2_aln_destroy(tmp_b);
+      free(pacposs);
   }
   return 1;
 }
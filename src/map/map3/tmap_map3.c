@@ -159,7 +159,7 @@ tmap_map3_thread_map(void **data, tmap_seq_t **seqs, tmap_index_t *index, tmap_b
   }
   
   // align
-  sams = tmap_map3_aux_core(seqs[3], d->flow_order, d->flow_order_len, index->refseq, index->bwt, index->sa, hash, opt);
+  sams = tmap_map3_aux_core(seqs[3], d->flow_order, d->flow_order_len, index->refseq, index->bwt, index->sa, hash, index->seed, opt);
 
   return sams;
 }
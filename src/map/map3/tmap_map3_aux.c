@@ -8,6 +8,7 @@
 #include "../../index/tmap_index.h"
 #include "../../index/tmap_bwt_match.h"
 #include "../../index/tmap_bwt_match_hash.h"
+#include "../../index/tmap_seed_hash.h"
 #include "../../sw/tmap_sw.h"
 #include "../util/tmap_map_util.h"
 #include "tmap_map3.h"
@@ -20,7 +21,8 @@ tmap_map3_aux_seed_add(tmap_map3_aux_seed_t **seeds,
                        tmap_bwt_int_t k,
                        tmap_bwt_int_t l,
                        int32_t start, 
-                       int16_t seed_length)
+                       int16_t seed_length,
+                       uint8_t is_pos)
 {
   /*
   if(offset < INT8_MIN || INT8_MAX < offset) {
@@ -35,6 +37,7 @@ tmap_map3_aux_seed_add(tmap_map3_aux_seed_t **seeds,
   (*seeds)[(*n_seeds)].l = l;
   (*seeds)[(*n_seeds)].start = start;
   (*seeds)[(*n_seeds)].seed_length = seed_length;
+  (*seeds)[(*n_seeds)].is_pos = is_pos;
   (*n_seeds)++;
 }
 
@@ -107,7 +110,7 @@ tmap_map3_aux_core_seed_helper(uint8_t *query,
               tmp_sa = next_sa;
               if(0 < tmap_bwt_match_hash_exact_alt(bwt, bases_to_align, query + i + n_bases, &tmp_sa, hash)
                  && (tmp_sa.l - tmp_sa.k + 1) <= opt->max_seed_hits) {
-                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, tmp_sa.k, tmp_sa.l, offset, seed_length + n_bases - k);
+                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, tmp_sa.k, tmp_sa.l, offset, seed_length + n_bases - k, 0);
               }
           }
 
@@ -131,7 +134,7 @@ tmap_map3_aux_core_seed_helper(uint8_t *query,
               // match exactly from here onwards
               if(0 < tmap_bwt_match_hash_exact_alt(bwt, seed_length - (i - offset) - n_bases, query + i + n_bases, &tmp_sa, hash)
                  && (tmp_sa.l - tmp_sa.k + 1) <= opt->max_seed_hits) {
-                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, tmp_sa.k, tmp_sa.l, offset, seed_length + k);
+                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, tmp_sa.k, tmp_sa.l, offset, seed_length + k, 0);
               }
               // move to the next
               cur_sa = tmp_sa;
@@ -148,7 +151,7 @@ tmap_map3_aux_core_seed_helper(uint8_t *query,
 
   // add in the seed with no hp indels
   if((next_sa.l - next_sa.k + 1) <= opt->max_seed_hits) {
-      tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, next_sa.k, next_sa.l, offset, seed_length);
+      tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, next_sa.k, next_sa.l, offset, seed_length, 0);
   }
 }
 
@@ -161,10 +164,14 @@ tmap_map3_aux_core_seed(uint8_t *query,
                         tmap_bwt_t *bwt,
                         tmap_sa_t *sa,
                         tmap_bwt_match_hash_t *hash,
+                        tmap_seed_hash_t *seed_hash,
                         tmap_map_opt_t *opt,
                         tmap_map3_aux_seed_t **seeds,
                         int32_t *n_seeds,
                         int32_t *m_seeds,
+                        tmap_bwt_int_t **hits,
+                        int32_t *n_hits,
+                        int32_t *m_hits,
                         int32_t seed_length,
                         int32_t seed_step,
                         int32_t fwd_search)
@@ -224,7 +231,7 @@ tmap_map3_aux_core_seed(uint8_t *query,
                           }
                       }
                       k--; // k is always one greater
-                      tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, k, seed_length + k - i);
+                      tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, k, seed_length + k - i, 0);
                       j++;
                       // skip over 
                       if(0 < opt->skip_seed_frac) {
@@ -238,7 +245,7 @@ tmap_map3_aux_core_seed(uint8_t *query,
                           int32_t n = 0;
                           while(k + seed_step < query_length && 0 < tmap_bwt_match_hash_exact(bwt, seed_step, query + k, &cur_sa, hash)) {
                               if((cur_sa.l - cur_sa.k + 1) <= opt->max_seed_hits) {
-                                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length + k - i);
+                                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length + k - i, 0);
                                   j++;
                                   // skip over 
                                   if(0 < opt->skip_seed_frac) {
@@ -254,12 +261,100 @@ tmap_map3_aux_core_seed(uint8_t *query,
               }
           }
       }
+      else if(NULL != seed_hash && seed_hash->width <= seed_length) {
+          // the positions of each seed are looked up in the seed hash, falling back to
+          // the BWT for seeds whose k-mer is too frequent for its positions to be stored
+          int32_t n_found, searched, m = (seed_hash->max_freq < opt->max_seed_hits) ? seed_hash->max_freq : opt->max_seed_hits;
+          for(i=query_length-seed_length;0<=i;i--) {
+              if((*m_hits) <= (*n_hits) + m) {
+                  (*m_hits) = (*n_hits) + m + 1;
+                  tmap_roundup32((*m_hits));
+                  (*hits) = tmap_realloc((*hits), sizeof(tmap_bwt_int_t) * (*m_hits), "(*hits)");
+              }
+              n_found = tmap_seed_hash_find(seed_hash, refseq, seed_length, query + i, opt->max_seed_hits, (*hits) + (*n_hits));
+              searched = 0;
+              if(n_found < 0) { // not stored
+                  n_found = 0;
+                  searched = 1;
+                  if(0 < tmap_bwt_match_hash_exact(bwt, seed_length, query + i, &cur_sa, hash)) {
+                      n_found = ((cur_sa.l - cur_sa.k + 1) <= opt->max_seed_hits) ? (cur_sa.l - cur_sa.k + 1) : (opt->max_seed_hits + 1);
+                      if(n_found <= opt->max_seed_hits) {
+                          tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length, 0);
+                      }
+                  }
+              }
+              else if(0 < n_found && n_found <= opt->max_seed_hits) {
+                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, (*n_hits), (*n_hits) + n_found - 1, i, seed_length, 1);
+                  (*n_hits) += n_found;
+              }
+              if(0 < n_found && n_found <= opt->max_seed_hits) {
+                  count++;
+                  j++;
+                  if(0 < opt->skip_seed_frac) {
+                      i -= opt->skip_seed_frac * (seed_length - 1); // -1 since i will be incremented
+                  }
+              }
+              else if(0 < n_found) {
+                  count++;
+                  // seed stepping
+                  if(0 < seed_step) {
+                      int32_t k = i + seed_length;
+                      // NB: the stepping extends the BWT match of this seed
+                      if(0 == searched) {
+                          tmap_bwt_match_hash_exact(bwt, seed_length, query + i, &cur_sa, hash);
+                      }
+                      while(k + seed_step < query_length && 0 < tmap_bwt_match_hash_exact_alt(bwt, seed_step, query + k, &cur_sa, hash)) {
+                          if((cur_sa.l - cur_sa.k + 1) <= opt->max_seed_hits) {
+                              tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length + k - i, 0);
+                              j++;
+                              if(0 < opt->skip_seed_frac) {
+                                  i -= opt->skip_seed_frac * (seed_length + k - i - 1); // -1 since i will be incremented
+                              }
+                              break;
+                          }
+                          k += seed_step;
+                      }
+                  }
+              }
+              else {
+                  // skip over if we came up short, by as much as the BWT search would
+                  if(0 == searched) {
+                      tmap_bwt_match_hash_exact(bwt, seed_length, query + i, &cur_sa, hash);
+                  }
+                  i -= (seed_length - cur_sa.offset);
+              }
+          }
+      }
       else {
+          // the seeds are searched in batches, predicting the positions visited when each seed
+          // is found; the batch grows while the prediction holds, and shrinks when it fails
+          int32_t b_i, b_n, b_m, b_pos[TMAP_BWT_MATCH_BATCH_SIZE], b_len[TMAP_BWT_MATCH_BATCH_SIZE];
+          const uint8_t *b_str[TMAP_BWT_MATCH_BATCH_SIZE];
+          tmap_bwt_match_occ_t b_sa[TMAP_BWT_MATCH_BATCH_SIZE];
+          tmap_bwt_int_t b_size[TMAP_BWT_MATCH_BATCH_SIZE];
+          b_i = b_n = 0; b_m = 2;
           for(i=query_length-seed_length;0<=i;i--) {
-              if(0 < tmap_bwt_match_hash_exact(bwt, seed_length, query + i, &cur_sa, hash)) {
+              if(b_i == b_n || b_pos[b_i] != i) { 
+                  if(b_i < b_n) b_m = 2; // the prediction failed
+                  else if(0 < b_n && b_m < TMAP_BWT_MATCH_BATCH_SIZE) b_m <<= 1;
+                  for(b_n=0,k=i;b_n<b_m && 0<=k;b_n++) {
+                      b_pos[b_n] = k;
+                      b_str[b_n] = query + k;
+                      b_len[b_n] = seed_length;
+                      // the next position if this seed is found
+                      if(0 < opt->skip_seed_frac) {
+                          k -= opt->skip_seed_frac * (seed_length - 1);
+                      }
+                      k--;
+                  }
+                  tmap_bwt_match_hash_exact_batch(bwt, b_n, b_str, b_len, b_sa, b_size, hash);
+                  b_i = 0;
+              }
+              cur_sa = b_sa[b_i];
+              if(0 < b_size[b_i++]) {
                   count++;
                   if((cur_sa.l - cur_sa.k + 1) <= opt->max_seed_hits) {
-                      tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length);
+                      tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length, 0);
                       j++;
                       if(0 < opt->skip_seed_frac) {
                           i -= opt->skip_seed_frac * (seed_length - 1); // -1 since i will be incremented
@@ -272,7 +367,7 @@ tmap_map3_aux_core_seed(uint8_t *query,
                           int32_t n = 0;
                           while(k + seed_step < query_length && 0 < tmap_bwt_match_hash_exact_alt(bwt, seed_step, query + k, &cur_sa, hash)) {
                               if((cur_sa.l - cur_sa.k + 1) <= opt->max_seed_hits) {
-                                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length + k - i);
+                                  tmap_map3_aux_seed_add(seeds, n_seeds, m_seeds, cur_sa.k, cur_sa.l, i, seed_length + k - i, 0);
                                   j++;
                                   if(0 < opt->skip_seed_frac) {
                                       i -= opt->skip_seed_frac * (seed_length + k - i - 1); // -1 since i will be incremented
@@ -310,6 +405,7 @@ tmap_map3_aux_core(tmap_seq_t *seq,
                    tmap_bwt_t *bwt,
                    tmap_sa_t *sa,
                    tmap_bwt_match_hash_t *hash,
+                   tmap_seed_hash_t *seed_hash,
                    tmap_map_opt_t *opt)
 {
   int32_t i, j, n, seed_length, hp_diff = 0;
@@ -319,6 +415,8 @@ tmap_map3_aux_core(tmap_seq_t *seq,
   uint8_t *flow=NULL;
   tmap_map3_aux_seed_t *seeds;
   int32_t m_seeds, n_seeds;
+  tmap_bwt_int_t *pacposs = NULL, *hits = NULL;
+  int32_t n_hits = 0, m_hits = 0;
   tmap_map_sams_t *sams = NULL;
 
   if(0 < opt->hp_diff) {
@@ -382,12 +480,12 @@ tmap_map3_aux_core(tmap_seq_t *seq,
 
   // seed the alignment
   tmap_map3_aux_core_seed(query, seq_len, flow, hp_diff,
-                          refseq, bwt, sa, hash, opt, &seeds, &n_seeds, &m_seeds,
-                          seed_length, opt->seed_step, opt->fwd_search);
+                          refseq, bwt, sa, hash, seed_hash, opt, &seeds, &n_seeds, &m_seeds,
+                          &hits, &n_hits, &m_hits, seed_length, opt->seed_step, opt->fwd_search);
   if(0 == n_seeds) { // try the seeding in the opposite direction
       tmap_map3_aux_core_seed(query, seq_len, flow, hp_diff,
-                              refseq, bwt, sa, hash, opt, &seeds, &n_seeds, &m_seeds,
-                              seed_length, opt->seed_step, 1-opt->fwd_search);
+                              refseq, bwt, sa, hash, seed_hash, opt, &seeds, &n_seeds, &m_seeds,
+                              &hits, &n_hits, &m_hits, seed_length, opt->seed_step, 1-opt->fwd_search);
   }
 
   // for SAM storage
@@ -398,9 +496,21 @@ tmap_map3_aux_core(tmap_seq_t *seq,
 
   // make enough room
   tmap_map_sams_realloc(sams, n);
+
+  // look up the packed positions of all the occurrences together, except those
+  // already given by the seed hash
+  pacposs = tmap_malloc((0 < n ? n : 1) * sizeof(tmap_bwt_int_t), "pacposs");
+  for(j=n=0;j<n_seeds;j++) {
+      tmap_bwt_int_t k;
+      if(1 == seeds[j].is_pos) continue;
+      for(k=seeds[j].k;k<=seeds[j].l;k++) {
+          pacposs[n++] = k;
+      }
+  }
+  tmap_sa_pac_pos_batch(sa, bwt, n, pacposs, pacposs, hash);
   
   // convert seeds to chr/pos
-  n = 0;
+  n = i = 0;
   for(j=0;j<n_seeds;j++) { // go through all seeds
       uint32_t seqid, pos, pos_adj;
       tmap_bwt_int_t k, pacpos;
@@ -409,7 +519,7 @@ tmap_map3_aux_core(tmap_seq_t *seq,
       uint8_t strand;
       for(k=seeds[j].k;k<=seeds[j].l;k++) { // through all occurrences
           tmap_map_sam_t *s = NULL;
-          pacpos = bwt->seq_len - tmap_sa_pac_pos_hash(sa, bwt, k, hash);
+          pacpos = bwt->seq_len - ((1 == seeds[j].is_pos) ? hits[k] : pacposs[i++]);
           if(0 < tmap_refseq_pac2real(refseq, pacpos, 1, &seqid, &pos, &strand)) {
               // adjust based on offset
               pos_adj = start + seed_length_ext - 1; // NB: we only used the forward read, so adjustment is based off of this...
@@ -451,6 +561,8 @@ tmap_map3_aux_core(tmap_seq_t *seq,
   // free the seeds
   free(seeds);
   seeds=NULL;
+  free(pacposs);
+  free(hits);
 
   // free
   if(0 < hp_diff) {
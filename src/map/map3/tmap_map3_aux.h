@@ -8,10 +8,11 @@
   Holds the seed matches
   */
 typedef struct {
-    tmap_bwt_int_t k; /*!< the lower SA interval */
-    tmap_bwt_int_t l; /*!< the upper SA interval */
+    tmap_bwt_int_t k; /*!< the lower SA interval, or the first index of the positions in the seed hash hits */
+    tmap_bwt_int_t l; /*!< the upper SA interval, or the last index of the positions in the seed hash hits */
     uint16_t start; /*!< the # of bases from the start of the read (0-based) */
     uint16_t seed_length; /*!< the effective seed length */
+    uint8_t is_pos; /*!< 1 if k and l index the seed hash hits, 0 if they are an SA interval */
 } tmap_map3_aux_seed_t;
 
 /*!
@@ -23,6 +24,7 @@ typedef struct {
   @param  bwt            the BWT structure 
   @param  sa             the SA structure 
   @param  hash           the occurrence hash
+  @param  seed_hash      the seed hash, NULL if none
   @param  opt            the program options
   @return                the alignments
   the sequences should be in 2-bit format
@@ -35,6 +37,7 @@ tmap_map3_aux_core(tmap_seq_t *seq,
                    tmap_bwt_t *bwt,
                    tmap_sa_t *sa,
                    tmap_bwt_match_hash_t *hash,
+                   struct __tmap_seed_hash_t *seed_hash,
                    tmap_map_opt_t *opt);
 
 #endif
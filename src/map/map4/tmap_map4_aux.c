@@ -108,10 +108,10 @@ tmap_map4_aux_core(tmap_seq_t *seq,
                    tmap_rand_t *rand,
                    tmap_map_opt_t *opt)
 {
-  int32_t i, n;
+  int32_t i, j, n;
   int32_t start, by, end;
   int32_t min_seed_length, max_seed_length;
-  tmap_bwt_int_t k;
+  tmap_bwt_int_t k, *pacposs = NULL;
   tmap_map_sams_t *sams;
   tmap_bwt_smem_intv_vec_t *matches;
   int32_t total = 0;
@@ -242,12 +242,22 @@ tmap_map4_aux_core(tmap_seq_t *seq,
           n += p->size;
       }
       tmap_map_sams_realloc(sams, n);
-      // go through the matches
+      // look up the packed positions of all the matches together
+      pacposs = tmap_malloc((0 < n ? n : 1) * sizeof(tmap_bwt_int_t), "pacposs");
       for (i = n = 0; i < matches->n; ++i) {
+          tmap_bwt_smem_intv_t *p = &matches->a[i];
+          for (k = 0; k < p->size; ++k) {
+              pacposs[n] = p->x[0] + k;
+              if(bwt->seq_len < pacposs[n]) pacposs[n] = bwt->seq_len;
+              n++;
+          }
+      }
+      tmap_sa_pac_pos_batch(sa, bwt, n, pacposs, pacposs, hash);
+      // go through the matches
+      for (i = n = j = 0; i < matches->n; ++i) {
           tmap_bwt_smem_intv_t *p = &matches->a[i];
           for (k = 0; k < p->size; ++k) {
               tmap_bwt_int_t pacpos;
-              tmap_bwt_int_t tmp;
               uint32_t seqid, pos;
               uint8_t strand;
               uint32_t qstart, qend, len;
@@ -256,12 +266,8 @@ tmap_map4_aux_core(tmap_seq_t *seq,
               qend = (uint32_t)(p->info & 0xFFFF) - 1; // should be qlen if moved all the way to the end of the query
               len = qend - qstart + 1; 
               
-              pacpos = p->x[0] + k;
-              tmp = pacpos;
-              if(bwt->seq_len < pacpos) pacpos = bwt->seq_len;
-
               // get the packed position
-              pacpos = tmap_sa_pac_pos_hash(sa, bwt, pacpos, hash) + 1; // make zero based
+              pacpos = pacposs[j++] + 1; // make zero based
               //fprintf(stderr, "X0 p->x[0]=%llu p->x[1]=%llu p->size=%llu k=%llu bwt->seq_len=%llu pacpos=%llu tmp=%llu\n", p->x[0], p->x[1], p->size, k, bwt->seq_len, pacpos, tmp);
               
               // convert to reference co-ordinates
@@ -306,6 +312,7 @@ tmap_map4_aux_core(tmap_seq_t *seq,
       }
       // realloc
       tmap_map_sams_realloc(sams, n);
+      free(pacposs);
   }
 
   tmap_bwt_smem_intv_vec_destroy(matches);
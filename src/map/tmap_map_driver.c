@@ -1,5 +1,6 @@
 /* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
 #include <config.h>
@@ -9,8 +10,11 @@
 #include <unistd.h>
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
+#include "../util/tmap_arena.h"
 #include "../util/tmap_definitions.h"
+#include "../util/tmap_hash.h"
 #include "../util/tmap_progress.h"
+#include "../util/tmap_time.h"
 #include "../util/tmap_sam_print.h"
 #include "../util/tmap_sort.h"
 #include "../util/tmap_rand.h"
@@ -150,76 +154,384 @@ static void
 tmap_map_driver_init_seqs(tmap_seq_t **seqs, tmap_seq_t *seq, int32_t max_length)
 {
   int32_t i;
-  // init seqs
+  // fill the forward, reverse compliment, reverse, and compliment views,
+  // reusing their memory
   for(i=0;i<4;i++) {
-      // TODO: only if necessary
-      seqs[i] = tmap_seq_clone(seq); // clone the sequence 
-      // modify the length before reversing or reverse complimenting 
-      if(0 < max_length && max_length < tmap_seq_get_bases_length(seq)) { // NB: does not modify quality string or other meta data
-          tmap_seq_get_bases(seqs[i])->l = max_length;
-          tmap_seq_get_bases(seqs[i])->s[max_length] = '\0';
-      }
-      switch(i) {
-        case 0: // forward
-          break;
-        case 1: // reverse compliment
-          tmap_seq_reverse_compliment(seqs[i]); break;
-        case 2: // reverse
-          tmap_seq_reverse(seqs[i]); break;
-        case 3: // compliment
-          tmap_seq_compliment(seqs[i]); break;
-      }
-      tmap_seq_to_int(seqs[i]); // convert to integers
+      seqs[i] = tmap_seq_view(seqs[i], seq, i, max_length);
   }
 }
 
-void
-tmap_map_driver_core_worker(int32_t num_ends, 
-                            tmap_seq_t ***seq_buffer, 
-                            tmap_map_record_t **records, 
-                            int32_t seq_buffer_length,
-                            tmap_index_t *index,
-                            tmap_map_driver_t *driver,
-                            tmap_map_stats_t *stat,
-                            tmap_rand_t *rand,
-                            int32_t tid)
-{
-  int32_t i, j, k, low = 0;
-  int32_t flow_order_len = 0, key_seq_len = 0;
-  uint8_t *flow_order = NULL, *key_seq = NULL;
-  int32_t found;
-  tmap_fsw_flowseq_t *fs = NULL;
-  tmap_seq_t ***seqs = NULL;
-  tmap_bwt_match_hash_t *hash=NULL;
+static void
+tmap_map_driver_core_thread_init(tmap_map_driver_thread_data_t *thread_data)
+{
+  int32_t i;
 
+  // init the occurence hash, looking up values in the cache shared across threads if available
+  if(NULL != thread_data->cache) {
+      thread_data->hash = tmap_bwt_match_hash_init_shared(thread_data->cache);
+  }
 #ifdef TMAP_DRIVER_USE_HASH
-  // init the occurence hash
-  hash = tmap_bwt_match_hash_init(); 
+  else {
+      thread_data->hash = tmap_bwt_match_hash_init(); 
+  }
 #endif
 
   // initialize flow space info
-  if(0 < seq_buffer_length) {
-      fs = tmap_map_driver_get_flow_info(seq_buffer[0][0], driver->opt, &flow_order, &flow_order_len, &key_seq, &key_seq_len);
-  }
+  // NB: the flow information is taken from the first read
+  thread_data->fs = tmap_map_driver_get_flow_info(thread_data->seq_buffer[0][0], thread_data->driver->opt, 
+                                                  &thread_data->flow_order, &thread_data->flow_order_len, 
+                                                  &thread_data->key_seq, &thread_data->key_seq_len);
   // init memory
-  seqs = tmap_malloc(sizeof(tmap_seq_t**)*num_ends, "seqs");
-  for(i=0;i<num_ends;i++) {
-      seqs[i] = tmap_malloc(sizeof(tmap_seq_t*)*4, "seqs[i]");
+  thread_data->seqs = tmap_malloc(sizeof(tmap_seq_t**)*thread_data->num_ends, "thread_data->seqs");
+  for(i=0;i<thread_data->num_ends;i++) {
+      thread_data->seqs[i] = tmap_calloc(4, sizeof(tmap_seq_t*), "thread_data->seqs[i]");
   }
+  thread_data->stage_seqs = tmap_calloc(4, sizeof(tmap_seq_t*), "thread_data->stage_seqs");
+  thread_data->arena = tmap_arena_init(TMAP_ARENA_BLOCK_SIZE);
   
   // initialize thread data
-  tmap_map_driver_do_threads_init(driver, flow_order, flow_order_len, key_seq, key_seq_len, tid);
-          
+  tmap_map_driver_do_threads_init(thread_data->driver, 
+                                  thread_data->flow_order, thread_data->flow_order_len, 
+                                  thread_data->key_seq, thread_data->key_seq_len, 
+                                  thread_data->tid);
+
+  thread_data->initialized = 1;
+}
+
+static void
+tmap_map_driver_core_thread_cleanup(tmap_map_driver_thread_data_t *thread_data)
+{
+  int32_t i, j;
+
+  if(0 == thread_data->initialized) return;
+
+  // free thread variables
+  if(NULL != thread_data->fs) {
+      tmap_fsw_flowseq_destroy(thread_data->fs);
+  }
+  free(thread_data->flow_order);
+  free(thread_data->key_seq);
+  for(i=0;i<thread_data->num_ends;i++) {
+      for(j=0;j<4;j++) {
+          tmap_seq_destroy(thread_data->seqs[i][j]);
+      }
+      free(thread_data->seqs[i]);
+  }
+  free(thread_data->seqs);
+  for(j=0;j<4;j++) {
+      tmap_seq_destroy(thread_data->stage_seqs[j]);
+  }
+  free(thread_data->stage_seqs);
+  tmap_arena_destroy(thread_data->arena);
+  thread_data->arena = NULL;
+
+  // cleanup
+  tmap_map_driver_do_threads_cleanup(thread_data->driver, thread_data->tid);
+  // free hash
+  tmap_bwt_match_hash_destroy(thread_data->hash);
+  thread_data->hash = NULL;
+
+  thread_data->initialized = 0;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*
+  A pool of mapping threads that lives for the whole run, so the thread
+  persistent data is initialized once rather than once per batch.
+ */
+typedef struct {
+    pthread_t *threads; /*!< the mapping threads */
+    tmap_map_driver_thread_data_t *thread_data; /*!< the data for each mapping thread */
+    int32_t num_threads; /*!< the number of mapping threads */
+    pthread_mutex_t mutex; /*!< the mutex guarding the fields below */
+    pthread_cond_t work_cond; /*!< signalled when a new batch is available or on shutdown */
+    pthread_cond_t done_cond; /*!< signalled when a thread has finished its portion of a batch */
+    int32_t batch_id; /*!< incremented for each new batch */
+    int32_t num_done; /*!< the number of threads that have finished the current batch */
+    int32_t next_read; /*!< the next read in the current batch to be handed out */
+    int32_t shutdown; /*!< 1 if the threads should exit, 0 otherwise */
+} tmap_map_driver_pool_t;
+#endif
+
+// charges the SAM records formatted since the last block to the batch, and
+// returns 1 if the batch has reached its memory limit after mapping some reads
+#define __tmap_map_driver_core_mem_full(_thread_data, _low) \
+  ((*(_thread_data)->mem) += (_thread_data)->sam_mem, (_thread_data)->sam_mem = 0, \
+   (0 < (_thread_data)->mem_max && (_thread_data)->mem_max <= (*(_thread_data)->mem) \
+    && (_thread_data)->seq_buffer_start < (_low)) ? 1 : 0)
+
+// gets the next block of reads [low, high) to map, returning zero when none
+// remain or the batch has reached its memory limit
+static int32_t
+tmap_map_driver_core_next_block(tmap_map_driver_thread_data_t *thread_data, int32_t *low, int32_t *high)
+{
+#ifdef HAVE_LIBPTHREAD
+  tmap_map_driver_pool_t *pool = (tmap_map_driver_pool_t*)thread_data->pool;
+  int32_t block_size, max_block_size;
+
+  if(NULL != pool) {
+      pthread_mutex_lock(&pool->mutex);
+      (*low) = pool->next_read;
+      if(1 == __tmap_map_driver_core_mem_full(thread_data, (*low))) {
+          // leave the rest for once the SAM records so far are written
+          pthread_mutex_unlock(&pool->mutex);
+          return 0;
+      }
+      // guided: hand out smaller blocks as the batch is consumed, so threads finish together
+      block_size = (thread_data->seq_buffer_length - (*low)) / (2 * pool->num_threads);
+      if(TMAP_MAP_DRIVER_THREAD_BLOCK_SIZE < block_size) {
+          block_size = TMAP_MAP_DRIVER_THREAD_BLOCK_SIZE;
+      }
+      // bound the block by the time it is expected to take
+      if(0 < thread_data->read_cost) {
+          max_block_size = (int32_t)(TMAP_MAP_DRIVER_THREAD_BLOCK_TIME / thread_data->read_cost);
+          if(max_block_size < block_size) {
+              block_size = max_block_size;
+          }
+      }
+      if(block_size < 1) {
+          block_size = 1;
+      }
+      pool->next_read += block_size;
+      if(thread_data->seq_buffer_length <= (*low)) {
+          pthread_mutex_unlock(&pool->mutex);
+          return 0;
+      }
+      (*high) = (*low) + block_size;
+      if(thread_data->seq_buffer_length < (*high)) {
+          (*high) = thread_data->seq_buffer_length;
+      }
+      (*thread_data->seq_buffer_mapped) = (*high);
+      pthread_mutex_unlock(&pool->mutex);
+      return 1;
+  }
+#endif
+  // no other threads, so take the rest of the batch, or with a memory limit
+  // one read at a time
+  if(1 == __tmap_map_driver_core_mem_full(thread_data, (*high))
+     || thread_data->seq_buffer_length <= (*high)) {
+      return 0;
+  }
+  (*low) = (*high);
+  (*high) = (0 < thread_data->mem_max) ? (*low) + 1 : thread_data->seq_buffer_length;
+  (*thread_data->seq_buffer_mapped) = (*high);
+  return 1;
+}
+
+// adds a run of a step, started at _start_ns, and the hits after it to the stats
+#define __tmap_map_driver_stats_step(_stat, _step, _start_ns, _hits) do { \
+    (_stat)->step_calls[_step]++; \
+    (_stat)->step_hits[_step] += (_hits); \
+    (_stat)->step_time[_step] += tmap_time_nanoseconds() - (_start_ns); \
+} while(0)
+
+// formats the SAM records for the given read into the thread's SAM buffer
+static void
+tmap_map_driver_core_print(tmap_map_driver_thread_data_t *thread_data, tmap_map_record_t *record, int32_t idx)
+{
+  int32_t i;
+  int32_t num_ends = thread_data->num_ends;
+  tmap_seq_t ***seq_buffer = thread_data->seq_buffer;
+  tmap_file_t *sam_buffer = thread_data->sam_buffer;
+  tmap_refseq_t *refseq = thread_data->index->refseq;
+  tmap_map_opt_t *opt = thread_data->driver->opt;
+
+  thread_data->sam_tid[idx] = thread_data->tid;
+  thread_data->sam_start[idx] = sam_buffer->mem_len;
+  if(1 == num_ends) {
+      tmap_map_sams_print(sam_buffer, seq_buffer[0][idx], refseq, record->sams[0], 
+                          0, NULL, opt->sam_flowspace_tags, opt->bidirectional, opt->seq_eq);
+  }
+  else {
+      for(i=0;i<num_ends;i++) {
+          tmap_map_sams_print(sam_buffer, seq_buffer[i][idx], refseq, record->sams[i],
+                              (0 == i) ? 1 : ((num_ends-1 == i) ? 2 : 0),
+                              record->sams[(i+1) % num_ends], 
+                              opt->sam_flowspace_tags, opt->bidirectional, opt->seq_eq);
+      }
+  }
+  thread_data->sam_end[idx] = sam_buffer->mem_len;
+  thread_data->sam_mem += thread_data->sam_end[idx] - thread_data->sam_start[idx];
+}
+
+// picks the alignments to report for the read at idx among those scored in
+// the given stage, and generates their cigars; returns 1 if any were found
+static int32_t
+tmap_map_driver_core_choose(tmap_map_driver_thread_data_t *thread_data, tmap_map_driver_stage_t *stage, 
+                            tmap_map_record_t *record, int32_t idx, tmap_map_stats_t *stage_stat)
+{
+  int32_t j, found = 0;
+  uint64_t start_ns;
+  int32_t num_ends = thread_data->num_ends;
+  tmap_seq_t ***seq_buffer = thread_data->seq_buffer;
+  tmap_seq_t ***seqs = thread_data->seqs;
+  tmap_index_t *index = thread_data->index;
+  tmap_map_driver_t *driver = thread_data->driver;
+  tmap_map_stats_t *stat = thread_data->stat;
+  tmap_rand_t *rand = thread_data->rand;
+  tmap_arena_t *arena = thread_data->arena;
+
+  if(0 <= driver->opt->strandedness && 0 <= driver->opt->positioning
+     && 2 == num_ends && 0 < record->sams[0]->n && 0 < record->sams[1]->n) { // pairs of reads!
+
+      start_ns = tmap_time_nanoseconds();
+      // read rescue
+      if(1 == stage->opt->read_rescue) {
+          int32_t flag = tmap_map_pairing_read_rescue(index->refseq, 
+                                                      record->sams[0], record->sams[1],
+                                                      seqs[0], seqs[1],
+                                                      rand, stage->opt);
+          // recalculate mapping qualities if necessary
+          if(0 < (flag & 0x1)) { // first end was rescued
+              //fprintf(stderr, "re-doing mapq for end #1\n");
+              driver->func_mapq(record->sams[0], tmap_seq_get_bases_length(seqs[0][0]), stage->opt);
+          }
+          if(0 < (flag & 0x2)) { // second end was rescued
+              //fprintf(stderr, "re-doing mapq for end #2\n");
+              driver->func_mapq(record->sams[1], tmap_seq_get_bases_length(seqs[1][0]), stage->opt);
+          }
+      }
+      // pick pairs
+      tmap_map_pairing_pick_pairs(record->sams[0], record->sams[1],
+                                  seqs[0][0], seqs[1][0],
+                                  rand, stage->opt);
+      __tmap_map_driver_stats_step(stat, TMAP_MAP_STATS_STEP_PAIRING, start_ns, 
+                                   record->sams[0]->n + record->sams[1]->n);
+      // TODO: if we have one end for a pair, do we go onto the second
+      // stage?
+  }
+  else {
+
+      // choose alignments
+      for(j=0;j<num_ends;j++) { // for each end
+          tmap_map_sams_filter1(record->sams[j], stage->opt->aln_output_mode, TMAP_MAP_ALGO_NONE, rand);
+          stage_stat->num_after_filter += record->sams[j]->n;
+      }
+  }
+
+  // generate the cigars
+  for(j=0;j<num_ends;j++) { // for each end
+      start_ns = tmap_time_nanoseconds();
+      record->sams[j] = tmap_map_util_sw_gen_cigar(index->refseq, record->sams[j], seq_buffer[j][idx], seqs[j], arena, stage->opt);
+      __tmap_map_driver_stats_step(stat, TMAP_MAP_STATS_STEP_CIGAR, start_ns, record->sams[j]->n);
+      if(0 < record->sams[j]->n) {
+          stage_stat->num_with_mapping++;
+          found = 1;
+      }
+  }
+
+  return found;
+}
+
+// re-aligns the alignments of the read at idx in flow space, and sorts them by score
+static void
+tmap_map_driver_core_flowspace(tmap_map_driver_thread_data_t *thread_data, tmap_map_record_t *record, int32_t idx)
+{
+  int32_t i;
+  uint64_t start_ns;
+  int32_t num_ends = thread_data->num_ends;
+  tmap_seq_t ***seq_buffer = thread_data->seq_buffer;
+  tmap_map_driver_t *driver = thread_data->driver;
+  tmap_map_stats_t *stat = thread_data->stat;
+  tmap_index_t *index = thread_data->index;
+  tmap_fsw_flowseq_t *fs = thread_data->fs;
+  uint8_t *flow_order = thread_data->flow_order;
+  int32_t flow_order_len = thread_data->flow_order_len;
+  uint8_t *key_seq = thread_data->key_seq;
+  int32_t key_seq_len = thread_data->key_seq_len;
+  tmap_arena_t *arena = thread_data->arena;
+
+  if(1 == driver->opt->aln_flowspace) {
+      for(i=0;i<num_ends;i++) {
+          if(0 < record->sams[i]->n) {
+              //stat->num_with_mapping++;
+              // re-align the alignments in flow-space
+              if(NULL != fs) {
+                  tmap_seq_t *seq = seq_buffer[i][idx];
+                  // TODO: if this is run, we do not need to run tmap_sw_global_banded_core...
+                  // NB: seq_buffer should have its key sequence if 0 < key_seq_len
+                  start_ns = tmap_time_nanoseconds();
+                  tmap_map_util_fsw(fs, seq,
+                                    flow_order, flow_order_len,
+                                    key_seq, key_seq_len,
+                                    record->sams[i], index->refseq, 
+                                    driver->opt->bw, driver->opt->softclip_type, driver->opt->score_thr,
+                                    driver->opt->score_match, driver->opt->pen_mm, driver->opt->pen_gapo,
+                                    driver->opt->pen_gape, driver->opt->fscore, 1-driver->opt->ignore_flowgram,
+                                    arena);
+                  __tmap_map_driver_stats_step(stat, TMAP_MAP_STATS_STEP_FSW, start_ns, record->sams[i]->n);
+              }
+
+              // sort by alignment score
+              if(1 < record->sams[i]->n) {
+                  tmap_sort_introsort(tmap_map_sam_sort_score,
+                                      record->sams[i]->n, 
+                                      record->sams[i]->sams);
+              }
+          }
+          if(NULL == seq_buffer[i][idx]) {
+              tmap_error("bug encoutereed", Exit, OutOfRange);
+          }
+      }
+  }
+}
 
-  // Go through the buffer
-  while(low < seq_buffer_length) {
-      if(tid == (low % driver->opt->num_threads)) {
+void
+tmap_map_driver_core_worker(tmap_map_driver_thread_data_t *thread_data)
+{
+  int32_t i, j, k, low = 0, high = 0;
+  int32_t found = 0, algo_offset;
+  uint64_t start_ns, algo_start_ns;
+  int32_t num_ends = thread_data->num_ends;
+  tmap_seq_t ***seq_buffer = thread_data->seq_buffer;
+  int32_t seq_buffer_length = thread_data->seq_buffer_length;
+  tmap_index_t *index = thread_data->index;
+  tmap_map_driver_t *driver = thread_data->driver;
+  tmap_map_stats_t *stat = thread_data->stat;
+  tmap_rand_t *rand = thread_data->rand;
+  int32_t tid = thread_data->tid;
+  int32_t key_seq_len;
+  uint8_t *key_seq;
+  tmap_seq_t ***seqs;
+  tmap_bwt_match_hash_t *hash;
+  tmap_arena_t *arena;
+
+  if(0 == seq_buffer_length) return;
+  low = high = thread_data->seq_buffer_start;
+
+  // initialize the thread persistent data once, when the first reads are seen
+  if(0 == thread_data->initialized) {
+      tmap_map_driver_core_thread_init(thread_data);
+  }
+  key_seq = thread_data->key_seq;
+  key_seq_len = thread_data->key_seq_len;
+  seqs = thread_data->seqs;
+  hash = thread_data->hash;
+  arena = thread_data->arena;
+
+  // Go through the buffer, a block of reads at a time
+  while(0 < tmap_map_driver_core_next_block(thread_data, &low, &high)) {
+      double start_time = tmap_time_realtime();
+      int32_t n = high - low;
+      for(;low<high;low++) {
           tmap_map_stats_t *stage_stat = NULL;
-          tmap_map_record_t *record_prev = NULL;
+          tmap_map_record_t *record = NULL, *record_prev = NULL, *record_dup = NULL;
+          tmap_map_driver_stage_t *stage_dup = NULL;
+          tmap_map_stats_t stat_dup;
+
+          // identical reads are formatted along with the read mapped in their place
+          if(NULL != thread_data->dup_of && 0 <= thread_data->dup_of[low]) {
+              continue;
+          }
+
+          // the random draws depend only on the position of the read in the
+          // input, not on which thread maps it
+          tmap_rand_reinit(rand, thread_data->seq_buffer_offset + low);
           
 #ifdef TMAP_DRIVER_USE_HASH
 #ifdef TMAP_DRIVER_CLEAR_HASH_PER_READ
           // TODO: should we hash each read, or across the thread?
+          // NB: a shared cache is not cleared
           tmap_bwt_match_hash_clear(hash);
 #endif
 #endif
@@ -240,23 +552,26 @@ tmap_map_driver_core_worker(int32_t num_ends,
               stat->num_reads++;
           }
 
-          // init records
-          records[low] = tmap_map_record_init(num_ends);
+          // init record
+          record = tmap_map_record_init(num_ends, arena);
 
           // go through each stage
+          algo_offset = 0;
           for(i=0;i<driver->num_stages;i++) { // for each stage
               tmap_map_driver_stage_t *stage = driver->stages[i];
 
               // stage stats
-              stage_stat = tmap_map_stats_init();
+              stage_stat = tmap_arena_calloc(arena, 1, sizeof(tmap_map_stats_t), "stage_stat");
 
               // seed
               for(j=0;j<num_ends;j++) { // for each end
                   tmap_seq_t **stage_seqs = NULL;
+                  start_ns = tmap_time_nanoseconds();
                   // should we seed using the whole read?
                   if(0 < stage->opt->stage_seed_max_length && stage->opt->stage_seed_max_length < tmap_seq_get_bases_length(seqs[j][0])) {
-                      stage_seqs = tmap_calloc(4, sizeof(tmap_seq_t*), "seqs[i]");
-                      tmap_map_driver_init_seqs(stage_seqs, seq_buffer[i][low], stage->opt->stage_seed_max_length);
+                      stage_seqs = thread_data->stage_seqs;
+                      // NB: index by the end (j), not the stage (i)
+                      tmap_map_driver_init_seqs(stage_seqs, seq_buffer[j][low], stage->opt->stage_seed_max_length);
                   }
                   else {
                       stage_seqs = seqs[j];
@@ -268,32 +583,31 @@ tmap_map_driver_core_worker(int32_t num_ends,
                           tmap_bug();
                       }
                       // map
+                      algo_start_ns = tmap_time_nanoseconds();
                       sams = algorithm->func_thread_map(&algorithm->thread_data[tid], stage_seqs, index, hash, rand, algorithm->opt);
                       if(NULL == sams) {
                           tmap_error("the thread function did not return a mapping", Exit, OutOfRange);
                       }
+                      stat->algo_calls[algo_offset+k]++;
+                      stat->algo_hits[algo_offset+k] += sams->n;
+                      stat->algo_time[algo_offset+k] += tmap_time_nanoseconds() - algo_start_ns;
                       // append
-                      tmap_map_sams_merge(records[low]->sams[j], sams);
+                      tmap_map_sams_merge(record->sams[j], sams);
                       // destroy
                       tmap_map_sams_destroy(sams);
                   }
-                  stage_stat->num_after_seeding += records[low]->sams[j]->n;
-                  if(0 < stage->opt->stage_seed_max_length && stage->opt->stage_seed_max_length < tmap_seq_get_bases_length(seqs[j][0])) {
-                      // free
-                      for(j=0;j<4;j++) {
-                          tmap_seq_destroy(stage_seqs[j]);
-                          stage_seqs[j] = NULL;
-                      }
-                  }
+                  stage_stat->num_after_seeding += record->sams[j]->n;
+                  __tmap_map_driver_stats_step(stat, TMAP_MAP_STATS_STEP_SEED, start_ns, record->sams[j]->n);
                   stage_seqs = NULL; // do not use
               }
+              algo_offset += stage->num_algorithms;
 
               // keep mappings for subsequent stages or restore mappings from
               // previous stages
               if(1 == stage->opt->stage_keep_all) {
                   // merge from the previous stage
                   if(0 < i) {
-                      tmap_map_record_merge(records[low], record_prev);
+                      tmap_map_record_merge(record, record_prev);
                       // destroy the record
                       tmap_map_record_destroy(record_prev);
                       record_prev = NULL;
@@ -301,78 +615,48 @@ tmap_map_driver_core_worker(int32_t num_ends,
 
                   // keep for the next stage
                   if(i < driver->num_stages-1) { // more stages left
-                      record_prev = tmap_map_record_clone(records[low]);
+                      record_prev = tmap_map_record_clone(record, arena);
                   }
               }
 
               // generate scores with smith waterman
               for(j=0;j<num_ends;j++) { // for each end
-                  records[low]->sams[j] = tmap_map_util_sw_gen_score(index->refseq, records[low]->sams[j], seqs[j], rand, stage->opt);
-                  stage_stat->num_after_scoring += records[low]->sams[j]->n;
+                  start_ns = tmap_time_nanoseconds();
+                  record->sams[j] = tmap_map_util_sw_gen_score(index->refseq, record->sams[j], seqs[j], rand, arena, stage->opt);
+                  __tmap_map_driver_stats_step(stat, TMAP_MAP_STATS_STEP_SCORE, start_ns, record->sams[j]->n);
+                  stage_stat->num_after_scoring += record->sams[j]->n;
               }
 
               // remove duplicates
               for(j=0;j<num_ends;j++) { // for each end
-                  tmap_map_util_remove_duplicates(records[low]->sams[j], stage->opt->dup_window, rand);
-                  stage_stat->num_after_rmdup += records[low]->sams[j]->n;
+                  start_ns = tmap_time_nanoseconds();
+                  tmap_map_util_remove_duplicates(record->sams[j], stage->opt->dup_window, rand);
+                  __tmap_map_driver_stats_step(stat, TMAP_MAP_STATS_STEP_RMDUP, start_ns, record->sams[j]->n);
+                  stage_stat->num_after_rmdup += record->sams[j]->n;
               }
               
               // (single-end) mapping quality
               for(j=0;j<num_ends;j++) { // for each end
-                  driver->func_mapq(records[low]->sams[j], tmap_seq_get_bases_length(seqs[j][0]), stage->opt);
+                  driver->func_mapq(record->sams[j], tmap_seq_get_bases_length(seqs[j][0]), stage->opt);
               }
 
               // filter if we have more stages
               if(i < driver->num_stages-1) {
                   for(j=0;j<num_ends;j++) { // for each end
-                      tmap_map_sams_filter2(records[low]->sams[j], stage->opt->stage_score_thr, stage->opt->stage_mapq_thr);
-                  }
-              }
-
-              if(0 <= driver->opt->strandedness && 0 <= driver->opt->positioning
-                 && 2 == num_ends && 0 < records[low]->sams[0]->n && 0 < records[low]->sams[1]->n) { // pairs of reads!
-
-                  // read rescue
-                  if(1 == stage->opt->read_rescue) {
-                      int32_t flag = tmap_map_pairing_read_rescue(index->refseq, 
-                                                                  records[low]->sams[0], records[low]->sams[1],
-                                                                  seqs[0], seqs[1],
-                                                                  rand, stage->opt);
-                      // recalculate mapping qualities if necessary
-                      if(0 < (flag & 0x1)) { // first end was rescued
-                          //fprintf(stderr, "re-doing mapq for end #1\n");
-                          driver->func_mapq(records[low]->sams[0], tmap_seq_get_bases_length(seqs[0][0]), stage->opt);
-                      }
-                      if(0 < (flag & 0x2)) { // second end was rescued
-                          //fprintf(stderr, "re-doing mapq for end #2\n");
-                          driver->func_mapq(records[low]->sams[1], tmap_seq_get_bases_length(seqs[1][0]), stage->opt);
-                      }
+                      tmap_map_sams_filter2(record->sams[j], stage->opt->stage_score_thr, stage->opt->stage_mapq_thr);
                   }
-                  // pick pairs
-                  tmap_map_pairing_pick_pairs(records[low]->sams[0], records[low]->sams[1],
-                                              seqs[0][0], seqs[1][0],
-                                              rand, stage->opt);
-                  // TODO: if we have one end for a pair, do we go onto the second
-                  // stage?
               }
-              else {
 
-                  // choose alignments
-                  for(j=0;j<num_ends;j++) { // for each end
-                      tmap_map_sams_filter1(records[low]->sams[j], stage->opt->aln_output_mode, TMAP_MAP_ALGO_NONE, rand);
-                      stage_stat->num_after_filter += records[low]->sams[j]->n;
-                  }
+              // keep the alignments to choose from for the identical reads
+              if(NULL != thread_data->dup_next && 0 <= thread_data->dup_next[low]) {
+                  tmap_map_record_destroy(record_dup);
+                  record_dup = tmap_map_record_clone(record, arena);
+                  stat_dup = (*stage_stat);
+                  stage_dup = stage;
               }
 
-              // generate the cigars
-              found = 0;
-              for(j=0;j<num_ends;j++) { // for each end
-                  records[low]->sams[j] = tmap_map_util_sw_gen_cigar(index->refseq, records[low]->sams[j], seqs[j], stage->opt);
-                  if(0 < records[low]->sams[j]->n) {
-                      stage_stat->num_with_mapping++;
-                      found = 1;
-                  }
-              }
+              // choose the alignments and generate their cigars
+              found = tmap_map_driver_core_choose(thread_data, stage, record, low, stage_stat);
 
               // TODO
               // if paired, update pairing score based on target start?
@@ -380,113 +664,752 @@ tmap_map_driver_core_worker(int32_t num_ends,
               // did we find any mappings?
               if(1 == found) { // yes
                   tmap_map_stats_add(stat, stage_stat);
-                  tmap_map_stats_destroy(stage_stat);
                   break;
               }
               else { // no
-                  tmap_map_record_destroy(records[low]);
+                  tmap_map_record_destroy(record);
                   // re-init
-                  records[low] = tmap_map_record_init(num_ends);
+                  record = tmap_map_record_init(num_ends, arena);
               }
-              tmap_map_stats_destroy(stage_stat);
           }
 
           // flowspace re-align and sorting
-          if(1 == driver->opt->aln_flowspace) {
-              for(i=0;i<num_ends;i++) {
-                  if(0 < records[low]->sams[i]->n) {
-                      //stat->num_with_mapping++;
-                      // re-align the alignments in flow-space
-                      if(NULL != fs) {
-                          tmap_seq_t *seq = seq_buffer[i][low];
-                          // TODO: if this is run, we do not need to run tmap_sw_global_banded_core...
-                          // NB: seq_buffer should have its key sequence if 0 < key_seq_len
-                          tmap_map_util_fsw(fs, seq,
-                                            flow_order, flow_order_len,
-                                            key_seq, key_seq_len,
-                                            records[low]->sams[i], index->refseq, 
-                                            driver->opt->bw, driver->opt->softclip_type, driver->opt->score_thr,
-                                            driver->opt->score_match, driver->opt->pen_mm, driver->opt->pen_gapo,
-                                            driver->opt->pen_gape, driver->opt->fscore, 1-driver->opt->ignore_flowgram);
-                      }
-
-                      // sort by alignment score
-                      if(1 < records[low]->sams[i]->n) {
-                          tmap_sort_introsort(tmap_map_sam_sort_score,
-                                              records[low]->sams[i]->n, 
-                                              records[low]->sams[i]->sams);
+          tmap_map_driver_core_flowspace(thread_data, record, low);
+
+          // format the SAM records
+          start_ns = tmap_time_nanoseconds();
+          tmap_map_driver_core_print(thread_data, record, low);
+          // the identical reads get the same alignments to choose from
+          if(NULL != thread_data->dup_next) {
+              for(j=thread_data->dup_next[low];0 <= j;j=thread_data->dup_next[j]) {
+                  for(i=0;i<num_ends;i++) {
+                      tmap_seq_remove_key_sequence(seq_buffer[i][j], driver->opt->remove_sff_clipping, key_seq, key_seq_len);
+                      stat->num_reads++;
+                  }
+                  if(1 == found) {
+                      tmap_map_record_t *record_copy = tmap_map_record_clone(record_dup, arena);
+                      tmap_map_stats_t stat_copy = stat_dup;
+                      // re-draw the choice among equally good alignments for the copy, as
+                      // if it had been mapped in its own place in the input
+                      tmap_rand_reinit(rand, thread_data->seq_buffer_offset + j);
+                      if(1 == tmap_map_driver_core_choose(thread_data, stage_dup, record_copy, j, &stat_copy)) {
+                          tmap_map_stats_add(stat, &stat_copy);
                       }
+                      tmap_map_driver_core_flowspace(thread_data, record_copy, j);
+                      tmap_map_driver_core_print(thread_data, record_copy, j);
+                      tmap_map_record_destroy(record_copy);
                   }
-                  if(NULL == seq_buffer[i][low]) {
-                      tmap_error("bug encoutereed", Exit, OutOfRange);
+                  else {
+                      tmap_map_driver_core_print(thread_data, record, j);
                   }
               }
           }
+          __tmap_map_driver_stats_step(stat, TMAP_MAP_STATS_STEP_PRINT, start_ns, 0);
+
+          // free alignments
+          tmap_map_record_destroy(record);
 
-          // free seqs
-          for(i=0;i<num_ends;i++) {
-              for(j=0;j<4;j++) {
-                  tmap_seq_destroy(seqs[i][j]);
-                  seqs[i][j] = NULL;
-              }
-          }
           tmap_map_record_destroy(record_prev);
+          tmap_map_record_destroy(record_dup);
+          // reclaim the scratch memory for this read
+          tmap_arena_reset(arena);
+      }
+
+      // update the running average time to map one read
+      if(0 < thread_data->read_cost) {
+          thread_data->read_cost = 0.75 * thread_data->read_cost + 0.25 * (tmap_time_realtime() - start_time) / n;
+      }
+      else {
+          thread_data->read_cost = (tmap_time_realtime() - start_time) / n;
       }
-      // next
-      low++;
   }
-                  
-  // free thread variables
-  if(NULL != fs) {
-      tmap_fsw_flowseq_destroy(fs);
+}
+
+#ifdef HAVE_LIBPTHREAD
+
+void *
+tmap_map_driver_core_thread_worker(void *arg)
+{
+  tmap_map_driver_thread_data_t *thread_data = (tmap_map_driver_thread_data_t*)arg;
+  tmap_map_driver_pool_t *pool = (tmap_map_driver_pool_t*)thread_data->pool;
+  int32_t batch_id = 0;
+
+  while(1) {
+      // wait for a new batch
+      pthread_mutex_lock(&pool->mutex);
+      while(batch_id == pool->batch_id && 0 == pool->shutdown) {
+          pthread_cond_wait(&pool->work_cond, &pool->mutex);
+      }
+      if(1 == pool->shutdown) {
+          pthread_mutex_unlock(&pool->mutex);
+          break;
+      }
+      batch_id = pool->batch_id;
+      pthread_mutex_unlock(&pool->mutex);
+
+      tmap_map_driver_core_worker(thread_data);
+
+      // signal we are done
+      pthread_mutex_lock(&pool->mutex);
+      pool->num_done++;
+      pthread_cond_signal(&pool->done_cond);
+      pthread_mutex_unlock(&pool->mutex);
+  }
+
+  tmap_map_driver_core_thread_cleanup(thread_data);
+
+  return arg;
+}
+
+static tmap_map_driver_pool_t *
+tmap_map_driver_pool_init(tmap_map_driver_thread_data_t *thread_data, int32_t num_threads)
+{
+  int32_t i;
+  tmap_map_driver_pool_t *pool = NULL;
+  pthread_attr_t attr;
+
+  pool = tmap_calloc(1, sizeof(tmap_map_driver_pool_t), "pool");
+  pool->thread_data = thread_data;
+  pool->num_threads = num_threads;
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->work_cond, NULL);
+  pthread_cond_init(&pool->done_cond, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  // create threads
+  pool->threads = tmap_calloc(num_threads, sizeof(pthread_t), "pool->threads");
+  for(i=0;i<num_threads;i++) {
+      thread_data[i].pool = pool;
+      if(0 != pthread_create(&pool->threads[i], &attr, tmap_map_driver_core_thread_worker, &thread_data[i])) {
+          tmap_error("error creating threads", Exit, ThreadError);
+      }
+  }
+  pthread_attr_destroy(&attr);
+
+  return pool;
+}
+
+// maps the batch already set in each thread's data, returning once all threads are done
+static void
+tmap_map_driver_pool_run(tmap_map_driver_pool_t *pool)
+{
+  pthread_mutex_lock(&pool->mutex);
+  pool->num_done = 0;
+  pool->next_read = pool->thread_data[0].seq_buffer_start;
+  pool->batch_id++;
+  pthread_cond_broadcast(&pool->work_cond);
+  while(pool->num_done < pool->num_threads) {
+      pthread_cond_wait(&pool->done_cond, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+static void
+tmap_map_driver_pool_destroy(tmap_map_driver_pool_t *pool)
+{
+  int32_t i;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->work_cond);
+  pthread_mutex_unlock(&pool->mutex);
+
+  // join threads
+  for(i=0;i<pool->num_threads;i++) {
+      if(0 != pthread_join(pool->threads[i], NULL)) {
+          tmap_error("error joining threads", Exit, ThreadError);
+      }
   }
-  free(flow_order);
-  free(key_seq);
+
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->work_cond);
+  pthread_cond_destroy(&pool->done_cond);
+  free(pool->threads);
+  free(pool);
+}
+#endif
+
+static tmap_map_driver_batch_t *
+tmap_map_driver_batch_init(int32_t num_ends, int32_t seq_type, int32_t reads_queue_size, size_t mem_max, int32_t num_threads, int32_t collapse_dups)
+{
+  int32_t i, j;
+  tmap_map_driver_batch_t *batch = NULL;
+
+  batch = tmap_calloc(1, sizeof(tmap_map_driver_batch_t), "batch");
+  batch->seq_buffer = tmap_malloc(sizeof(tmap_seq_t**)*num_ends, "batch->seq_buffer");
   for(i=0;i<num_ends;i++) {
-      free(seqs[i]);
+      batch->seq_buffer[i] = tmap_calloc(reads_queue_size, sizeof(tmap_seq_t*), "batch->seq_buffer[i]");
+      // NB: with a memory limit, the sequences are only allocated once a read is loaded into them
+      for(j=0;0 == mem_max && j<reads_queue_size;j++) { // initialize the buffer
+          batch->seq_buffer[i][j] = tmap_seq_init(seq_type);
+      }
+  }
+  batch->mem_max = mem_max;
+  batch->num_sam_buffers = num_threads;
+  batch->sam_buffers = tmap_malloc(sizeof(tmap_file_t*)*num_threads, "batch->sam_buffers");
+  for(i=0;i<num_threads;i++) {
+      batch->sam_buffers[i] = tmap_file_mopen();
   }
-  free(seqs);
+  batch->sam_tid = tmap_calloc(reads_queue_size, sizeof(int32_t), "batch->sam_tid");
+  batch->sam_start = tmap_calloc(reads_queue_size, sizeof(size_t), "batch->sam_start");
+  batch->sam_end = tmap_calloc(reads_queue_size, sizeof(size_t), "batch->sam_end");
+  if(1 == collapse_dups) {
+      batch->dup_of = tmap_calloc(reads_queue_size, sizeof(int32_t), "batch->dup_of");
+      batch->dup_next = tmap_calloc(reads_queue_size, sizeof(int32_t), "batch->dup_next");
+  }
+  batch->seq_buffer_length = 0;
+  batch->state = TMAP_MAP_DRIVER_BATCH_EMPTY;
 
-  // cleanup
-  tmap_map_driver_do_threads_cleanup(driver, tid);
-#ifdef TMAP_DRIVER_USE_HASH
-  // free hash
-  tmap_bwt_match_hash_destroy(hash);
+  return batch;
+}
+
+static void
+tmap_map_driver_batch_destroy(tmap_map_driver_batch_t *batch, int32_t num_ends, int32_t reads_queue_size)
+{
+  int32_t i, j;
+  if(NULL == batch) return;
+  for(i=0;i<num_ends;i++) {
+      for(j=0;j<reads_queue_size;j++) {
+          tmap_seq_destroy(batch->seq_buffer[i][j]);
+      }
+      free(batch->seq_buffer[i]);
+  }
+  free(batch->seq_buffer);
+  for(i=0;i<batch->num_sam_buffers;i++) {
+      tmap_file_fclose(batch->sam_buffers[i]);
+  }
+  free(batch->sam_buffers);
+  free(batch->sam_tid);
+  free(batch->sam_start);
+  free(batch->sam_end);
+  free(batch->dup_of);
+  free(batch->dup_next);
+  free(batch);
+}
+
+TMAP_HASH_MAP_INIT_INT64(tmap_map_driver_dups, int32_t)
+
+#define __tmap_map_driver_fnv1a(_h, _c) ((_h) = ((_h) ^ (uint8_t)(_c)) * 1099511628211ULL)
+
+// gets the flowgram of a read, growing the memory as needed
+static int32_t
+tmap_map_driver_batch_flowgram(tmap_seq_t *seq, uint16_t **flowgram, int32_t *flowgram_mem)
+{
+  int32_t n = tmap_seq_get_flowgram(seq, flowgram, (*flowgram_mem));
+  if((*flowgram_mem) < n) (*flowgram_mem) = n;
+  return n;
+}
+
+// hashes the bases, read group, and (optionally) flowgram of all the ends of a read
+static uint64_t
+tmap_map_driver_batch_dup_hash(tmap_seq_t ***seq_buffer, int32_t num_ends, int32_t idx, int32_t use_flowgram,
+                               uint16_t **flowgram, int32_t *flowgram_mem)
+{
+  int32_t i, j, n;
+  uint64_t h = 14695981039346656037ULL;
+  
+  for(i=0;i<num_ends;i++) {
+      tmap_seq_t *seq = seq_buffer[i][idx];
+      tmap_string_t *bases = tmap_seq_get_bases(seq);
+      char *rg_id = tmap_seq_get_rg_id(seq);
+      for(j=0;j<bases->l;j++) {
+          __tmap_map_driver_fnv1a(h, bases->s[j]);
+      }
+      __tmap_map_driver_fnv1a(h, '\0');
+      if(NULL != rg_id) {
+          for(j=0;'\0' != rg_id[j];j++) {
+              __tmap_map_driver_fnv1a(h, rg_id[j]);
+          }
+      }
+      __tmap_map_driver_fnv1a(h, '\0');
+      if(1 == use_flowgram) {
+          n = tmap_map_driver_batch_flowgram(seq, flowgram, flowgram_mem);
+          for(j=0;j<n;j++) {
+              __tmap_map_driver_fnv1a(h, (*flowgram)[j] & 0xff);
+              __tmap_map_driver_fnv1a(h, (*flowgram)[j] >> 8);
+          }
+      }
+  }
+  return h;
+}
+
+// returns 1 if the two reads would be mapped identically, 0 otherwise
+static int32_t
+tmap_map_driver_batch_dup_equal(tmap_seq_t ***seq_buffer, int32_t num_ends, int32_t a, int32_t b, int32_t use_flowgram,
+                                uint16_t **flowgram, int32_t *flowgram_mem)
+{
+  int32_t i, n_a, n_b;
+
+  for(i=0;i<num_ends;i++) {
+      tmap_string_t *bases_a = tmap_seq_get_bases(seq_buffer[i][a]);
+      tmap_string_t *bases_b = tmap_seq_get_bases(seq_buffer[i][b]);
+      char *rg_id_a = tmap_seq_get_rg_id(seq_buffer[i][a]);
+      char *rg_id_b = tmap_seq_get_rg_id(seq_buffer[i][b]);
+      if(bases_a->l != bases_b->l || 0 != memcmp(bases_a->s, bases_b->s, bases_a->l)) {
+          return 0;
+      }
+      if((NULL == rg_id_a) != (NULL == rg_id_b) 
+         || (NULL != rg_id_a && 0 != strcmp(rg_id_a, rg_id_b))) {
+          return 0;
+      }
+      if(1 == use_flowgram) {
+          n_a = tmap_map_driver_batch_flowgram(seq_buffer[i][a], &flowgram[0], &flowgram_mem[0]);
+          n_b = tmap_map_driver_batch_flowgram(seq_buffer[i][b], &flowgram[1], &flowgram_mem[1]);
+          if(n_a != n_b || 0 != memcmp(flowgram[0], flowgram[1], sizeof(uint16_t) * n_a)) {
+              return 0;
+          }
+      }
+  }
+  return 1;
+}
+
+// finds reads identical to an earlier read in the batch, so they are mapped once
+static void
+tmap_map_driver_batch_collapse(tmap_map_driver_batch_t *batch, int32_t num_ends, tmap_map_opt_t *opt)
+{
+  int32_t i, j, ret, use_flowgram, n_dups = 0;
+  uint64_t key;
+  tmap_hash_t(tmap_map_driver_dups) *hash = NULL;
+  tmap_hash_iter_t iter;
+  uint16_t *flowgram[2] = {NULL, NULL};
+  int32_t flowgram_mem[2] = {0, 0};
+
+  // NB: the flowgram only matters for the final flow space alignment
+  use_flowgram = (1 == opt->aln_flowspace && 0 == opt->ignore_flowgram) ? 1 : 0;
+
+  hash = tmap_hash_init(tmap_map_driver_dups);
+  tmap_hash_resize(tmap_map_driver_dups, hash, batch->seq_buffer_length);
+  for(i=0;i<batch->seq_buffer_length;i++) {
+      batch->dup_of[i] = batch->dup_next[i] = -1;
+      key = tmap_map_driver_batch_dup_hash(batch->seq_buffer, num_ends, i, use_flowgram, &flowgram[0], &flowgram_mem[0]);
+      iter = tmap_hash_put(tmap_map_driver_dups, hash, key, &ret);
+      if(0 != ret) { // the first read with this hash
+          tmap_hash_value(hash, iter) = i;
+      }
+      else {
+          j = tmap_hash_value(hash, iter);
+          // NB: reads that only share a hash value are mapped separately
+          if(1 == tmap_map_driver_batch_dup_equal(batch->seq_buffer, num_ends, i, j, use_flowgram, flowgram, flowgram_mem)) {
+              batch->dup_of[i] = j;
+              batch->dup_next[i] = batch->dup_next[j];
+              batch->dup_next[j] = i;
+              n_dups++;
+          }
+      }
+  }
+  tmap_hash_destroy(tmap_map_driver_dups, hash);
+  free(flowgram[0]);
+  free(flowgram[1]);
+
+  tmap_progress_print2("collapsed %d duplicate reads out of %d", n_dups, batch->seq_buffer_length);
+}
+
+// the memory, in bytes, held by the read at idx and its entries in the batch
+static size_t
+tmap_map_driver_batch_seq_mem(tmap_map_driver_batch_t *batch, int32_t num_ends, int32_t idx)
+{
+  int32_t i;
+  size_t mem;
+  // the SAM buffer and the start and end of the records
+  mem = sizeof(int32_t) + 2 * sizeof(size_t);
+  if(NULL != batch->dup_of) mem += 2 * sizeof(int32_t);
+  for(i=0;i<num_ends;i++) {
+      mem += sizeof(tmap_seq_t*) + tmap_seq_get_mem(batch->seq_buffer[i][idx]);
+  }
+  return mem;
+}
+
+// loads reads until either the batch holds the given number of reads or half
+// its memory limit is reached, always loading at least one read
+// NB: the other half is left for the SAM records, which are charged as they
+// are formatted
+static int32_t
+tmap_map_driver_batch_read_buffer(tmap_map_driver_batch_t *batch, 
+                                  tmap_seq_io_t **seqio,
+                                  int32_t num_ends,
+                                  int32_t reads_queue_size)
+{
+  int32_t i, n = 0;
+  size_t mem = 0;
+
+  if(0 == batch->mem_max) {
+      n = tmap_seq_io_read_buffer(seqio[0], batch->seq_buffer[0], reads_queue_size);
+      for(i=1;i<num_ends;i++) {
+          if(n != tmap_seq_io_read_buffer(seqio[i], batch->seq_buffer[i], reads_queue_size)) {
+              tmap_error("the input read files were of differing length", Exit, OutOfRange);
+          }
+      }
+      return n;
+  }
+
+  while(n < reads_queue_size && mem < batch->mem_max / 2) {
+      if(0 == tmap_seq_io_read_buffer(seqio[0], batch->seq_buffer[0] + n, 1)) {
+          break;
+      }
+      for(i=1;i<num_ends;i++) {
+          if(1 != tmap_seq_io_read_buffer(seqio[i], batch->seq_buffer[i] + n, 1)) {
+              tmap_error("the input read files were of differing length", Exit, OutOfRange);
+          }
+      }
+      mem += tmap_map_driver_batch_seq_mem(batch, num_ends, n);
+      n++;
+  }
+  batch->mem = mem;
+  if(n < reads_queue_size && mem < batch->mem_max / 2) { // check the other ends are exhausted too
+      for(i=1;i<num_ends;i++) {
+          if(0 != tmap_seq_io_read_buffer(seqio[i], batch->seq_buffer[i] + n, 1)) {
+              tmap_error("the input read files were of differing length", Exit, OutOfRange);
+          }
+      }
+  }
+
+  return n;
+}
+
+// returns the number of reads loaded, zero when the input is exhausted
+static int32_t
+tmap_map_driver_batch_read(tmap_map_driver_batch_t *batch, 
+                           tmap_seq_io_t **seqio,
+                           int32_t num_ends,
+                           int32_t reads_queue_size,
+                           tmap_map_driver_t *driver,
+                           tmap_rand_t *rand_core)
+{
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+  int32_t i, j, k;
+#endif
+
+  // nothing mapped or written yet
+  batch->seq_buffer_mapped = batch->seq_buffer_written = 0;
+  batch->mem = 0;
+
+  while(1) {
+      // get the reads
+      batch->seq_buffer_length = tmap_map_driver_batch_read_buffer(batch, seqio, num_ends, reads_queue_size);
+      tmap_progress_print2("loaded %d reads", batch->seq_buffer_length);
+      if(0 == batch->seq_buffer_length) {
+          break;
+      }
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+      // sample reads
+      if(driver->opt->sample_reads < 1) {
+          for(i=j=0;i<batch->seq_buffer_length;i++) {
+              if(driver->opt->sample_reads < tmap_rand_get(rand_core)) continue; // skip
+              if(j < i) {
+                  for(k=0;k<num_ends;k++) {
+                      // swap
+                      tmap_seq_t *seq;
+                      seq = batch->seq_buffer[k][j];
+                      batch->seq_buffer[k][j] = batch->seq_buffer[k][i]; 
+                      batch->seq_buffer[k][i] = seq;
+                  }
+              }
+              j++;
+          }
+          tmap_progress_print2("sampling %d out of %d [%.2lf%%]", j, batch->seq_buffer_length, 100.0*j/(double)batch->seq_buffer_length);
+          batch->seq_buffer_length = j;
+          if(0 == batch->seq_buffer_length) continue;
+      }
 #endif
+      break;
+  }
+
+  if(0 < batch->seq_buffer_length && 1 == driver->opt->collapse_dups) {
+      tmap_map_driver_batch_collapse(batch, num_ends, driver->opt);
+  }
+
+  return batch->seq_buffer_length;
 }
 
-void *
-tmap_map_driver_core_thread_worker(void *arg)
+static void
+tmap_map_driver_batch_map(tmap_map_driver_batch_t *batch,
+                          uint64_t seq_buffer_offset,
+                          tmap_map_driver_thread_data_t *thread_data,
+                          int32_t num_threads,
+#ifdef HAVE_LIBPTHREAD
+                          tmap_map_driver_pool_t *pool,
+#endif
+                          tmap_map_stats_t *stat)
 {
-  tmap_map_driver_thread_data_t *thread_data = (tmap_map_driver_thread_data_t*)arg;
+  int32_t i;
 
-  tmap_map_driver_core_worker(thread_data->num_ends, thread_data->seq_buffer, thread_data->records, thread_data->seq_buffer_length, 
-                           thread_data->index, thread_data->driver, thread_data->stat, thread_data->rand, thread_data->tid);
+  for(i=0;i<num_threads;i++) {
+      thread_data[i].seq_buffer = batch->seq_buffer;
+      thread_data[i].seq_buffer_length = batch->seq_buffer_length;
+      thread_data[i].seq_buffer_start = batch->seq_buffer_mapped;
+      thread_data[i].seq_buffer_mapped = &batch->seq_buffer_mapped;
+      thread_data[i].seq_buffer_offset = seq_buffer_offset;
+      thread_data[i].mem = &batch->mem;
+      thread_data[i].mem_max = batch->mem_max;
+      thread_data[i].sam_mem = 0;
+      thread_data[i].sam_buffer = batch->sam_buffers[i];
+      thread_data[i].sam_tid = batch->sam_tid;
+      thread_data[i].sam_start = batch->sam_start;
+      thread_data[i].sam_end = batch->sam_end;
+      thread_data[i].dup_of = batch->dup_of;
+      thread_data[i].dup_next = batch->dup_next;
+  }
+
+#ifdef HAVE_LIBPTHREAD
+  if(NULL == pool) {
+      tmap_map_driver_core_worker(&thread_data[0]);
+  }
+  else {
+      tmap_map_driver_pool_run(pool);
+      // add the stats
+      for(i=0;i<num_threads;i++) {
+          tmap_map_stats_add(stat, thread_data[i].stat);
+          tmap_map_stats_reset(thread_data[i].stat);
+      }
+  }
+#else 
+  tmap_map_driver_core_worker(&thread_data[0]);
+#endif
+}
+
+// returns 1 if the records of the sequence at idx were formatted along with
+// its identical sequence, before the sequence itself was reached
+#define __tmap_map_driver_batch_dup_done(_batch, _idx) \
+  ((NULL != (_batch)->dup_of && 0 <= (_batch)->dup_of[_idx] \
+    && (_batch)->dup_of[_idx] < (_batch)->seq_buffer_mapped) ? 1 : 0)
+
+// writes the records of the sequences mapped since the last write, and
+// releases their SAM buffers
+static void
+tmap_map_driver_batch_write(tmap_map_driver_batch_t *batch,
+                            tmap_map_driver_t *driver)
+{
+  int32_t i, j;
+  size_t n, len;
+  char *keep = NULL;
+
+  // write the records in input order, coalescing records that are adjacent
+  // in the same SAM buffer
+  for(i=batch->seq_buffer_written;i<batch->seq_buffer_mapped;i=j) {
+      tmap_file_t *sam_buffer = batch->sam_buffers[batch->sam_tid[i]];
+      for(j=i+1;j<batch->seq_buffer_mapped;j++) {
+          if(batch->sam_tid[j] != batch->sam_tid[i] 
+             || batch->sam_start[j] != batch->sam_end[j-1]) {
+              break;
+          }
+      }
+      tmap_file_fwrite(sam_buffer->mem + batch->sam_start[i], sizeof(char), 
+                       batch->sam_end[j-1] - batch->sam_start[i], tmap_file_stdout);
+  }
+  // set aside the records of the identical sequences not yet written
+  for(i=batch->seq_buffer_mapped,n=0;i<batch->seq_buffer_length;i++) {
+      if(1 == __tmap_map_driver_batch_dup_done(batch, i)) {
+          n += batch->sam_end[i] - batch->sam_start[i];
+      }
+  }
+  if(0 < n) {
+      keep = tmap_malloc(sizeof(char) * n, "keep");
+      for(i=batch->seq_buffer_mapped,n=0;i<batch->seq_buffer_length;i++) {
+          if(1 == __tmap_map_driver_batch_dup_done(batch, i)) {
+              len = batch->sam_end[i] - batch->sam_start[i];
+              memcpy(keep + n, batch->sam_buffers[batch->sam_tid[i]]->mem + batch->sam_start[i], len);
+              batch->sam_start[i] = n;
+              batch->sam_end[i] = n = n + len;
+          }
+      }
+  }
+  for(i=0;i<batch->num_sam_buffers;i++) {
+      batch->mem -= batch->sam_buffers[i]->mem_len;
+      tmap_file_mreset(batch->sam_buffers[i]);
+      if(0 < batch->mem_max) { // release the memory beyond this thread's share
+          tmap_file_mtrim(batch->sam_buffers[i], batch->mem_max / 2 / batch->num_sam_buffers);
+      }
+  }
+  // and put them back
+  if(NULL != keep) {
+      for(i=batch->seq_buffer_mapped;i<batch->seq_buffer_length;i++) {
+          if(1 == __tmap_map_driver_batch_dup_done(batch, i)) {
+              tmap_file_t *sam_buffer = batch->sam_buffers[batch->sam_tid[i]];
+              len = batch->sam_end[i] - batch->sam_start[i];
+              batch->sam_start[i] = sam_buffer->mem_len;
+              tmap_file_fwrite(keep + batch->sam_end[i] - len, sizeof(char), len, sam_buffer);
+              batch->sam_end[i] = sam_buffer->mem_len;
+              batch->mem += len;
+          }
+      }
+      free(keep);
+  }
+  batch->seq_buffer_written = batch->seq_buffer_mapped;
+  if(-1 == driver->opt->reads_queue_size) {
+      tmap_file_fflush(tmap_file_stdout, 1);
+  }
+  else {
+      tmap_file_fflush(tmap_file_stdout, 0); // flush
+  }
+}
+
+static void
+tmap_map_driver_print_stats(tmap_map_stats_t *stat, uint32_t n_reads_processed)
+{
+  tmap_progress_print2("processed %d reads", n_reads_processed);
+  tmap_progress_print2("stats [%.2lf,%.2lf,%.2lf,%.2lf,%.2lf]",
+                       stat->num_with_mapping * 100.0 / (double)stat->num_reads,
+                       stat->num_after_seeding/(double)stat->num_with_mapping,
+                       stat->num_after_scoring/(double)stat->num_with_mapping,
+                       stat->num_after_rmdup/(double)stat->num_with_mapping,
+                       stat->num_after_filter/(double)stat->num_with_mapping);
+}
+
+// writes the counts and times of each algorithm and step as tab-separated values
+static void
+tmap_map_driver_write_stats(tmap_map_driver_t *driver, tmap_map_stats_t *stat, double real_time)
+{
+  int32_t i, j, k;
+  tmap_file_t *fp = NULL;
+
+  fp = tmap_file_fopen(driver->opt->fn_stats, "wb", TMAP_FILE_NO_COMPRESSION);
+  tmap_file_fprintf(fp, "#stage\tname\tcalls\thits\tseconds\n");
+  // the mapping algorithms
+  for(i=k=0;i<driver->num_stages;i++) {
+      for(j=0;j<driver->stages[i]->num_algorithms;j++,k++) {
+          tmap_file_fprintf(fp, "%d\t%s\t%llu\t%llu\t%.6lf\n",
+                            driver->stages[i]->stage,
+                            tmap_algo_id_to_name(driver->stages[i]->algorithms[j]->opt->algo_id),
+                            (unsigned long long int)stat->algo_calls[k],
+                            (unsigned long long int)stat->algo_hits[k],
+                            stat->algo_time[k] * 1e-9);
+      }
+  }
+  // the steps, across all stages
+  for(i=0;i<TMAP_MAP_STATS_STEP_NUM;i++) {
+      tmap_file_fprintf(fp, "all\t%s\t%llu\t%llu\t%.6lf\n",
+                        tmap_map_stats_step_name(i),
+                        (unsigned long long int)stat->step_calls[i],
+                        (unsigned long long int)stat->step_hits[i],
+                        stat->step_time[i] * 1e-9);
+  }
+  // the reads, with the real time of the run
+  tmap_file_fprintf(fp, "all\treads\t%llu\t%llu\t%.6lf\n",
+                    (unsigned long long int)stat->num_reads,
+                    (unsigned long long int)stat->num_with_mapping,
+                    real_time);
+  tmap_file_fclose(fp);
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*
+  The pipeline shared between the reader, mapping, and writer stages.  Batches
+  are used in a round-robin fashion, with each stage waiting for the batch to
+  reach its state, so reads are always written in the order they were read.
+ */
+typedef struct {
+    tmap_map_driver_batch_t **batches; /*!< the ring of batches */
+    int32_t num_batches; /*!< the number of batches */
+    pthread_mutex_t mutex; /*!< the mutex guarding the batch states */
+    pthread_cond_t cond; /*!< signalled whenever a batch changes state */
+    int32_t num_written; /*!< the number of batches written by the writer stage */
+    tmap_seq_io_t **seqio; /*!< the input reads */
+    int32_t num_ends; /*!< the number of ends */
+    int32_t reads_queue_size; /*!< the maximum number of reads per batch */
+    tmap_map_driver_t *driver; /*!< the driver */
+    tmap_rand_t *rand_core; /*!< the random number generator for sampling reads */
+} tmap_map_driver_pipeline_t;
+
+static tmap_map_driver_batch_t *
+tmap_map_driver_pipeline_wait(tmap_map_driver_pipeline_t *pipeline, int32_t n, int32_t state)
+{
+  tmap_map_driver_batch_t *batch = pipeline->batches[n % pipeline->num_batches];
+  pthread_mutex_lock(&pipeline->mutex);
+  while(state != batch->state) {
+      pthread_cond_wait(&pipeline->cond, &pipeline->mutex);
+  }
+  pthread_mutex_unlock(&pipeline->mutex);
+  return batch;
+}
+
+// waits until the writer stage has written the first n batches
+static void
+tmap_map_driver_pipeline_wait_written(tmap_map_driver_pipeline_t *pipeline, int32_t n)
+{
+  pthread_mutex_lock(&pipeline->mutex);
+  while(pipeline->num_written < n) {
+      pthread_cond_wait(&pipeline->cond, &pipeline->mutex);
+  }
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void
+tmap_map_driver_pipeline_set(tmap_map_driver_pipeline_t *pipeline, tmap_map_driver_batch_t *batch, int32_t state)
+{
+  pthread_mutex_lock(&pipeline->mutex);
+  batch->state = state;
+  pthread_cond_broadcast(&pipeline->cond);
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void *
+tmap_map_driver_pipeline_reader(void *arg)
+{
+  tmap_map_driver_pipeline_t *pipeline = (tmap_map_driver_pipeline_t*)arg;
+  tmap_map_driver_batch_t *batch = NULL;
+  int32_t n = 0, seq_buffer_length;
+
+  while(1) {
+      batch = tmap_map_driver_pipeline_wait(pipeline, n, TMAP_MAP_DRIVER_BATCH_EMPTY);
+      tmap_progress_print("loading reads");
+      seq_buffer_length = tmap_map_driver_batch_read(batch, pipeline->seqio, pipeline->num_ends, pipeline->reads_queue_size,
+                                                     pipeline->driver, pipeline->rand_core);
+      // NB: an empty batch signals the end of the input
+      tmap_map_driver_pipeline_set(pipeline, batch, TMAP_MAP_DRIVER_BATCH_LOADED);
+      if(0 == seq_buffer_length) break;
+      n++;
+  }
+
+  return arg;
+}
+
+static void *
+tmap_map_driver_pipeline_writer(void *arg)
+{
+  tmap_map_driver_pipeline_t *pipeline = (tmap_map_driver_pipeline_t*)arg;
+  tmap_map_driver_batch_t *batch = NULL;
+  int32_t n = 0;
+
+  while(1) {
+      batch = tmap_map_driver_pipeline_wait(pipeline, n, TMAP_MAP_DRIVER_BATCH_MAPPED);
+      if(0 == batch->seq_buffer_length) break;
+      if(-1 != pipeline->driver->opt->reads_queue_size) {
+          tmap_progress_print("writing alignments");
+      }
+      tmap_map_driver_batch_write(batch, pipeline->driver);
+      pthread_mutex_lock(&pipeline->mutex);
+      pipeline->num_written++;
+      pthread_mutex_unlock(&pipeline->mutex);
+      tmap_map_driver_pipeline_set(pipeline, batch, TMAP_MAP_DRIVER_BATCH_EMPTY);
+      n++;
+  }
 
   return arg;
 }
+#endif
 
 void 
 tmap_map_driver_core(tmap_map_driver_t *driver)
 {
   uint32_t i, j, n_reads_processed=0;
-  int32_t seq_buffer_length=0;
   tmap_seq_io_t **seqio=NULL;
-  tmap_seq_t ***seq_buffer = NULL;
-  tmap_map_record_t **records=NULL;
+  tmap_map_driver_batch_t **batches = NULL;
+  int32_t num_batches;
   tmap_index_t *index = NULL;
   tmap_map_stats_t *stat = NULL;
+  tmap_bwt_match_cache_t *cache = NULL;
+  tmap_map_driver_thread_data_t *thread_data = NULL;
+  int32_t num_threads;
 #ifdef HAVE_LIBPTHREAD
-  tmap_rand_t **rand = NULL;
-  tmap_map_stats_t **stats = NULL;
-#else
-  tmap_rand_t *rand = NULL;
-#endif
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-  tmap_rand_t *rand_core = tmap_rand_init(13);
-  uint32_t k;
+  tmap_map_driver_pool_t *pool = NULL;
+  tmap_map_driver_pipeline_t pipeline;
+  pthread_t reader, writer;
 #endif
-  int32_t seq_type, reads_queue_size, num_ends;
+  tmap_rand_t *rand_core = NULL;
+  int32_t seq_type, reads_queue_size, num_ends, num_algorithms;
+  double start_time = tmap_time_realtime();
 
   /*
   if(NULL == driver->opt->fn_reads) {
@@ -499,7 +1422,8 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
                        (0 == driver->opt->num_threads_autodetected) ? "user set" : "autodetected");
   
   // print out the algorithms and stages
-  for(i=0;i<driver->num_stages;i++) {
+  for(i=num_algorithms=0;i<driver->num_stages;i++) {
+      num_algorithms += driver->stages[i]->num_algorithms;
       for(j=0;j<driver->stages[i]->num_algorithms;j++) {
           tmap_progress_print("%s will be run in stage %d", 
                                tmap_algo_id_to_name(driver->stages[i]->algorithms[j]->opt->algo_id),
@@ -519,37 +1443,67 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
   }
 
   // get the index
-  index = tmap_index_init(driver->opt->fn_fasta, driver->opt->shm_key);
+  index = tmap_index_init(driver->opt->fn_fasta, driver->opt->shm_key, driver->opt->index_mmap);
 
   // initialize the driver->options and print any relevant information
   tmap_map_driver_do_init(driver, index->refseq);
 
-  // allocate the buffer
+#ifdef HAVE_LIBPTHREAD
+  num_threads = driver->opt->num_threads;
+#else
+  num_threads = 1;
+#endif
+
+  // allocate the buffers
   if(-1 == driver->opt->reads_queue_size) {
       reads_queue_size = 1;
   }
   else {
       reads_queue_size = driver->opt->reads_queue_size;
   }
-  seq_buffer = tmap_malloc(sizeof(tmap_seq_t**)*num_ends, "seq_buffer");
-  for(i=0;i<num_ends;i++) {
-      seq_buffer[i] = tmap_malloc(sizeof(tmap_seq_t*)*reads_queue_size, "seq_buffer[i]");
-      for(j=0;j<reads_queue_size;j++) { // initialize the buffer
-          seq_buffer[i][j] = tmap_seq_init(seq_type);
-      }
+#ifdef HAVE_LIBPTHREAD
+  num_batches = TMAP_MAP_DRIVER_NUM_BATCHES;
+#else
+  num_batches = 1;
+#endif
+  batches = tmap_malloc(sizeof(tmap_map_driver_batch_t*)*num_batches, "batches");
+  for(i=0;i<num_batches;i++) {
+      // NB: the memory limit is split between the batches in flight
+      batches[i] = tmap_map_driver_batch_init(num_ends, seq_type, reads_queue_size, 
+                                              ((size_t)driver->opt->reads_queue_mem << 20) / num_batches,
+                                              num_threads, driver->opt->collapse_dups);
   }
-  records = tmap_malloc(sizeof(tmap_map_record_t*)*reads_queue_size, "records");
 
-  stat = tmap_map_stats_init();
-#ifdef HAVE_LIBPTHREAD
-  stats = tmap_malloc(driver->opt->num_threads * sizeof(tmap_map_stats_t*), "stats");
-  rand = tmap_malloc(driver->opt->num_threads * sizeof(tmap_rand_t*), "rand");
-  for(i=0;i<driver->opt->num_threads;i++) {
-      stats[i] = tmap_map_stats_init();
-      rand[i] = tmap_rand_init(i);
+  stat = tmap_map_stats_init(num_algorithms);
+
+  // the occurrence cache shared by the mapping threads
+  if(0 < driver->opt->occ_cache_size) {
+      cache = tmap_bwt_match_cache_init((size_t)driver->opt->occ_cache_size << 20);
   }
+
+  // the data for each mapping thread, persistent across batches
+  thread_data = tmap_calloc(num_threads, sizeof(tmap_map_driver_thread_data_t), "thread_data");
+  for(i=0;i<num_threads;i++) {
+      thread_data[i].num_ends = num_ends;
+      thread_data[i].index = index;
+      thread_data[i].driver = driver;
+#ifdef HAVE_LIBPTHREAD
+      thread_data[i].stat = (1 == num_threads) ? stat : tmap_map_stats_init(num_algorithms);
+      thread_data[i].rand = tmap_rand_init(i);
 #else
-  rand = tmap_rand_init(13);
+      thread_data[i].stat = stat;
+      thread_data[i].rand = tmap_rand_init(13);
+#endif
+      thread_data[i].tid = i;
+      thread_data[i].cache = cache;
+  }
+#ifdef HAVE_LIBPTHREAD
+  if(1 < num_threads) {
+      pool = tmap_map_driver_pool_init(thread_data, num_threads);
+  }
+#endif
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+  rand_core = tmap_rand_init(13);
 #endif
 
   // Note: 'tmap_file_stdout' should not have been previously modified
@@ -566,138 +1520,96 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
                         driver->opt->argc, driver->opt->argv);
 
   tmap_progress_print("processing reads");
-  while(1) {
-      tmap_progress_print("loading reads");
-      // get the reads
-      seq_buffer_length = tmap_seq_io_read_buffer(seqio[0], seq_buffer[0], reads_queue_size);
-      for(i=1;i<num_ends;i++) {
-          if(seq_buffer_length != tmap_seq_io_read_buffer(seqio[i], seq_buffer[i], reads_queue_size)) {
-              tmap_error("the input read files were of differing length", Exit, OutOfRange);
+#ifdef HAVE_LIBPTHREAD
+  // start the reader and writer stages, while mapping in this thread
+  pipeline.batches = batches;
+  pipeline.num_batches = num_batches;
+  pthread_mutex_init(&pipeline.mutex, NULL);
+  pthread_cond_init(&pipeline.cond, NULL);
+  pipeline.num_written = 0;
+  pipeline.seqio = seqio;
+  pipeline.num_ends = num_ends;
+  pipeline.reads_queue_size = reads_queue_size;
+  pipeline.driver = driver;
+  pipeline.rand_core = rand_core;
+  if(0 != pthread_create(&reader, NULL, tmap_map_driver_pipeline_reader, &pipeline)
+     || 0 != pthread_create(&writer, NULL, tmap_map_driver_pipeline_writer, &pipeline)) {
+      tmap_error("error creating threads", Exit, ThreadError);
+  }
+  for(i=0;;i++) {
+      tmap_map_driver_batch_t *batch = tmap_map_driver_pipeline_wait(&pipeline, i, TMAP_MAP_DRIVER_BATCH_LOADED);
+      int32_t seq_buffer_length = batch->seq_buffer_length;
+      if(0 < seq_buffer_length) {
+          // do alignment
+          tmap_map_driver_batch_map(batch, n_reads_processed, thread_data, num_threads, pool, stat);
+          while(batch->seq_buffer_mapped < seq_buffer_length) {
+              // the batch reached its memory limit, so write the records so
+              // far, once the earlier batches are written, and continue
+              tmap_map_driver_pipeline_wait_written(&pipeline, i);
+              tmap_map_driver_batch_write(batch, driver);
+              tmap_map_driver_batch_map(batch, n_reads_processed, thread_data, num_threads, pool, stat);
           }
-      }
-      tmap_progress_print2("loaded %d reads", seq_buffer_length);
-      if(0 == seq_buffer_length) {
-          break;
-      }
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-      // sample reads
-      if(driver->opt->sample_reads < 1) {
-          for(i=j=0;i<seq_buffer_length;i++) {
-              if(driver->opt->sample_reads < tmap_rand_get(rand_core)) continue; // skip
-              if(j < i) {
-                  for(k=0;k<num_ends;k++) {
-                      // swap
-                      tmap_seq_t *seq;
-                      seq = seq_buffer[k][j];
-                      seq_buffer[k][j] = seq_buffer[k][i]; 
-                      seq_buffer[k][i] = seq;
-                  }
-              }
-              j++;
+          n_reads_processed += batch->seq_buffer_length;
+          if(-1 != driver->opt->reads_queue_size) {
+              tmap_map_driver_print_stats(stat, n_reads_processed);
           }
-          tmap_progress_print2("sampling %d out of %d [%.2lf%%]", j, seq_buffer_length, 100.0*j/(double)seq_buffer_length);
-          seq_buffer_length = j;
-          if(0 == seq_buffer_length) continue;
       }
-#endif
-
-      // do alignment
-#ifdef HAVE_LIBPTHREAD
-      if(1 == driver->opt->num_threads) {
-          tmap_map_driver_core_worker(num_ends, seq_buffer, records, seq_buffer_length, index,
-                                      driver, stat, rand[0], 0);
+      // NB: an empty batch tells the writer to stop
+      // NB: the batch may be re-used by the reader once it has been set
+      tmap_map_driver_pipeline_set(&pipeline, batch, TMAP_MAP_DRIVER_BATCH_MAPPED);
+      if(0 == seq_buffer_length) break;
+  }
+  if(0 != pthread_join(reader, NULL) || 0 != pthread_join(writer, NULL)) {
+      tmap_error("error joining threads", Exit, ThreadError);
+  }
+  pthread_mutex_destroy(&pipeline.mutex);
+  pthread_cond_destroy(&pipeline.cond);
+#else
+  while(1) {
+      tmap_progress_print("loading reads");
+      if(0 == tmap_map_driver_batch_read(batches[0], seqio, num_ends, reads_queue_size, driver, rand_core)) {
+          break;
       }
-      else {
-          pthread_attr_t attr;
-          pthread_t *threads = NULL;
-          tmap_map_driver_thread_data_t *thread_data=NULL;
-
-          pthread_attr_init(&attr);
-          pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-          threads = tmap_calloc(driver->opt->num_threads, sizeof(pthread_t), "threads");
-          thread_data = tmap_calloc(driver->opt->num_threads, sizeof(tmap_map_driver_thread_data_t), "thread_data");
-
-          // create threads
-          for(i=0;i<driver->opt->num_threads;i++) {
-              thread_data[i].num_ends = num_ends;
-              thread_data[i].seq_buffer = seq_buffer;
-              thread_data[i].seq_buffer_length = seq_buffer_length;
-              thread_data[i].records = records;
-              thread_data[i].index = index;
-              thread_data[i].driver = driver;
-              thread_data[i].stat = stats[i];
-              thread_data[i].rand = rand[i];
-              thread_data[i].tid = i;
-              if(0 != pthread_create(&threads[i], &attr, tmap_map_driver_core_thread_worker, &thread_data[i])) {
-                  tmap_error("error creating threads", Exit, ThreadError);
-              }
-          }
-
-          // join threads
-          for(i=0;i<driver->opt->num_threads;i++) {
-              if(0 != pthread_join(threads[i], NULL)) {
-                  tmap_error("error joining threads", Exit, ThreadError);
-              }
-              // add the stats
-              tmap_map_stats_add(stat, stats[i]);
-          }
 
-          free(threads);
-          free(thread_data);
-      }
-#else 
-      tmap_map_driver_core_worker(num_ends, seq_buffer, records, seq_buffer_length, index,
-                                  driver, stat, rand, 0);
-#endif
+      // do alignment, writing the records so far whenever the batch
+      // reaches its memory limit
+      do {
+          tmap_map_driver_batch_map(batches[0], n_reads_processed, thread_data, num_threads, stat);
 
-      if(-1 != driver->opt->reads_queue_size) {
-          tmap_progress_print("writing alignments");
-      }
-      for(i=0;i<seq_buffer_length;i++) {
-          // write
-          if(1 == num_ends) {
-              tmap_map_sams_print(seq_buffer[0][i], index->refseq, records[i]->sams[0], 
-                                  0, NULL, driver->opt->sam_flowspace_tags, driver->opt->bidirectional, driver->opt->seq_eq);
+          if(-1 != driver->opt->reads_queue_size) {
+              tmap_progress_print("writing alignments");
           }
-          else {
-              for(j=0;j<num_ends;j++) {
-                  tmap_map_sams_print(seq_buffer[j][i], index->refseq, records[i]->sams[j],
-                                    (0 == j) ? 1 : ((num_ends-1 == j) ? 2 : 0),
-                                    records[i]->sams[(j+1) % num_ends], 
-                                    driver->opt->sam_flowspace_tags, driver->opt->bidirectional, driver->opt->seq_eq);
-              }
-          }
-          // free alignments
-          tmap_map_record_destroy(records[i]); 
-          records[i] = NULL;
-      }
-      if(-1 == driver->opt->reads_queue_size) {
-          tmap_file_fflush(tmap_file_stdout, 1);
-      }
-      else {
-          tmap_file_fflush(tmap_file_stdout, 0); // flush
-      }
+          tmap_map_driver_batch_write(batches[0], driver);
+      } while(batches[0]->seq_buffer_mapped < batches[0]->seq_buffer_length);
 
-      n_reads_processed += seq_buffer_length;
+      n_reads_processed += batches[0]->seq_buffer_length;
       if(-1 != driver->opt->reads_queue_size) {
-          tmap_progress_print2("processed %d reads", n_reads_processed);
-          tmap_progress_print2("stats [%.2lf,%.2lf,%.2lf,%.2lf,%.2lf]",
-                               stat->num_with_mapping * 100.0 / (double)stat->num_reads,
-                               stat->num_after_seeding/(double)stat->num_with_mapping,
-                               stat->num_after_scoring/(double)stat->num_with_mapping,
-                               stat->num_after_rmdup/(double)stat->num_with_mapping,
-                               stat->num_after_filter/(double)stat->num_with_mapping);
+          tmap_map_driver_print_stats(stat, n_reads_processed);
       }
   }
+#endif
   if(-1 == driver->opt->reads_queue_size) {
-      tmap_progress_print2("processed %d reads", n_reads_processed);
-      tmap_progress_print2("stats [%.2lf,%.2lf,%.2lf,%.2lf,%.2lf]",
-                           stat->num_with_mapping * 100.0 / (double)stat->num_reads,
-                           stat->num_after_seeding/(double)stat->num_with_mapping,
-                           stat->num_after_scoring/(double)stat->num_with_mapping,
-                           stat->num_after_rmdup/(double)stat->num_with_mapping,
-                           stat->num_after_filter/(double)stat->num_with_mapping);
+      tmap_map_driver_print_stats(stat, n_reads_processed);
+  }
+  if(NULL != driver->opt->fn_stats) {
+      tmap_map_driver_write_stats(driver, stat, tmap_time_realtime() - start_time);
+  }
+
+  // cleanup the thread persistent data
+#ifdef HAVE_LIBPTHREAD
+  if(NULL != pool) {
+      tmap_map_driver_pool_destroy(pool);
+  }
+  else {
+      tmap_map_driver_core_thread_cleanup(&thread_data[0]);
+  }
+#else
+  tmap_map_driver_core_thread_cleanup(&thread_data[0]);
+#endif
+  if(NULL != cache) {
+      tmap_progress_print2("occurrence cache: %llu hits, %llu misses",
+                           (unsigned long long)cache->hits, (unsigned long long)cache->misses);
+      tmap_bwt_match_cache_destroy(cache);
   }
 
   // cleanup the algorithm persistent data
@@ -710,28 +1622,23 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
   tmap_index_destroy(index);
   for(i=0;i<num_ends;i++) {
       tmap_seq_io_destroy(seqio[i]);
-      for(j=0;j<reads_queue_size;j++) {
-          tmap_seq_destroy(seq_buffer[i][j]);
-      }
-      free(seq_buffer[i]);
   }
   free(seqio);
-  free(seq_buffer);
-  free(records);
+  for(i=0;i<num_batches;i++) {
+      tmap_map_driver_batch_destroy(batches[i], num_ends, reads_queue_size);
+  }
+  free(batches);
+  for(i=0;i<num_threads;i++) {
+      if(stat != thread_data[i].stat) {
+          tmap_map_stats_destroy(thread_data[i].stat);
+      }
+      tmap_rand_destroy(thread_data[i].rand);
+  }
+  free(thread_data);
   tmap_map_stats_destroy(stat);
-#ifdef HAVE_LIBPTHREAD
-  for(i=0;i<driver->opt->num_threads;i++) {
-      tmap_map_stats_destroy(stats[i]);
-      tmap_rand_destroy(rand[i]);
+  if(NULL != rand_core) {
+      tmap_rand_destroy(rand_core);
   }
-  free(stats);
-  free(rand);
-#else
-  tmap_rand_destroy(rand);
-#endif
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-  tmap_rand_destroy(rand_core);
-#endif
 }
 
 /* MAIN API */
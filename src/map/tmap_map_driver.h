@@ -3,12 +3,34 @@
 #define TMAP_MAP_DRIVER_H
 
 #include <sys/types.h>
+#include "../util/tmap_arena.h"
 #include "../index/tmap_index.h"
+#include "../sw/tmap_fsw.h"
 
 #ifdef HAVE_LIBPTHREAD
+/*!
+  The maximum number of reads handed to a mapping thread at a time.
+  */
 #define TMAP_MAP_DRIVER_THREAD_BLOCK_SIZE 512
+/*!
+  The target real time, in seconds, for a mapping thread to map a block of reads.
+  */
+#define TMAP_MAP_DRIVER_THREAD_BLOCK_TIME 0.05
+/*!
+  The number of read batches in flight: one being loaded, one being mapped, and one being written.
+  */
+#define TMAP_MAP_DRIVER_NUM_BATCHES 3
 #endif
 
+/*!
+  The pipeline states of a batch of reads
+  */
+enum {
+    TMAP_MAP_DRIVER_BATCH_EMPTY = 0, /*!< the batch may be loaded */
+    TMAP_MAP_DRIVER_BATCH_LOADED = 1, /*!< the batch has been loaded and may be mapped */
+    TMAP_MAP_DRIVER_BATCH_MAPPED = 2 /*!< the batch has been mapped and may be written */
+};
+
 /*!
   This function will be invoked after reading in all the reference data
   to initialize any program options and print messages.
@@ -37,7 +59,7 @@ typedef int32_t (*tmap_map_driver_func_thread_init)(void **data,
 /*!
   This function will be invoked to map a sequence.
   @param  data    the thread persistent data
-  @param  seqs    the sequence to map (forward, reverse compliment, reverse, compliment)
+  @param  seqs    the views of the bases to map (forward, reverse compliment, reverse, compliment), see tmap_seq_view
   @param  index   the reference index
   @param  stat    the driver statistics (for mapall only)
   @param  rand    the random number generator
@@ -146,46 +168,76 @@ tmap_map_driver_run(tmap_map_driver_t *driver);
 void
 tmap_map_driver_destroy(tmap_map_driver_t *driver);
 
+/*!
+  A batch of reads with their formatted SAM records.
+  */
+typedef struct {
+    tmap_seq_t ***seq_buffer;  /*!< the buffers of sequences, one per end */
+    int32_t seq_buffer_length;  /*!< the number of sequences loaded (zero at the end of the input) */
+    int32_t seq_buffer_mapped;  /*!< the number of sequences mapped so far */
+    int32_t seq_buffer_written;  /*!< the number of sequences whose SAM records have been written */
+    size_t mem;  /*!< the memory, in bytes, held by the sequences and the SAM records not yet written */
+    size_t mem_max;  /*!< the memory, in bytes, for the sequences and SAM records of the batch, 0 for no limit */
+    tmap_file_t **sam_buffers;  /*!< the SAM records formatted by each mapping thread */
+    int32_t num_sam_buffers;  /*!< the number of SAM buffers (one per mapping thread) */
+    int32_t *sam_tid;  /*!< the SAM buffer holding the records for each sequence */
+    size_t *sam_start;  /*!< the start of the records for each sequence in its SAM buffer */
+    size_t *sam_end;  /*!< the end of the records for each sequence in its SAM buffer */
+    int32_t *dup_of;  /*!< the earlier identical sequence mapped in place of each sequence, -1 if none (NULL unless collapsing duplicates) */
+    int32_t *dup_next;  /*!< the next identical sequence, forming a list from the sequence that is mapped, -1 if none (NULL unless collapsing duplicates) */
+    int32_t state; /*!< the pipeline state of the batch */
+} tmap_map_driver_batch_t;
+
 /*! 
   Driver data to be passed to a thread                         
   */
 typedef struct {                                            
     int32_t num_ends;  /*!< the number of mates (one for fragments) */
-    tmap_seq_t ***seq_buffer;  /*!< the buffers of sequences */    
+    tmap_seq_t ***seq_buffer;  /*!< the buffers of sequences for the current batch */    
     int32_t seq_buffer_length;  /*!< the buffers length */
-    tmap_map_record_t **records;  /*!< the alignments for each sequence */
+    int32_t seq_buffer_start;  /*!< the first sequence to map, the ones before having been mapped already */
+    int32_t *seq_buffer_mapped;  /*!< the end of the sequences handed out for mapping */
+    uint64_t seq_buffer_offset;  /*!< the number of sequences read before the current batch */
+    size_t *mem;  /*!< the memory held by the current batch, to which the SAM records are charged */
+    size_t mem_max;  /*!< the memory limit of the current batch, 0 for no limit */
+    size_t sam_mem;  /*!< the bytes of SAM records formatted by this thread and not yet charged to the batch */
+    tmap_file_t *sam_buffer;  /*!< the SAM buffer for the current batch to which this thread formats its records */
+    int32_t *sam_tid;  /*!< the SAM buffer holding the records for each sequence */
+    size_t *sam_start;  /*!< the start of the records for each sequence in its SAM buffer */
+    size_t *sam_end;  /*!< the end of the records for each sequence in its SAM buffer */
+    int32_t *dup_of;  /*!< the earlier identical sequence mapped in place of each sequence, NULL if not collapsing duplicates */
+    int32_t *dup_next;  /*!< the next identical sequence, NULL if not collapsing duplicates */
     tmap_index_t *index;  /*!< pointer to the reference index */
     tmap_map_driver_t *driver;  /*!< the main driver object */
     tmap_map_stats_t *stat; /*!< the driver statistics */
-    tmap_rand_t *rand;  /*!< the random number generator */
+    tmap_rand_t *rand;  /*!< the random number generator, re-seeded by the position of each read in the input */
     int32_t tid;  /*!< the zero-based thread id */
+    void *pool; /*!< the thread pool this thread belongs to, if any */
+    // thread persistent data, initialized with the first batch and kept across batches
+    int32_t initialized; /*!< 1 if the thread persistent data has been initialized, 0 otherwise */
+    tmap_fsw_flowseq_t *fs; /*!< the flow space sequence, NULL if flow information is not available */
+    uint8_t *flow_order; /*!< the flow order */
+    int32_t flow_order_len; /*!< the flow order length */
+    uint8_t *key_seq; /*!< the key sequence */
+    int32_t key_seq_len; /*!< the key sequence length */
+    tmap_seq_t ***seqs; /*!< the forward, reverse compliment, reverse, and compliment views of the bases for each end, reused across reads */
+    tmap_seq_t **stage_seqs; /*!< the views of the bases seeded in a stage with a maximum seed length, reused across reads */
+    tmap_bwt_match_hash_t *hash; /*!< the occurrence hash */
+    tmap_bwt_match_cache_t *cache; /*!< the occurrence cache shared by all threads, NULL if none */
+    tmap_arena_t *arena; /*!< the scratch memory for mapping one read, reset after each read */
+    double read_cost; /*!< the running average real time, in seconds, to map one read */
 } tmap_map_driver_thread_data_t;
 
 /*!
   The core worker routine of mapall
-  @param  num_ends             the number of ends
-  @param  seq_buffer           the buffer of sequences
-  @param  records              the records to return
-  @param  seq_buffer_length    the number of sequences in the buffer
-  @param  index                the reference index
-  @param  driver               the driver
-  @param  stat                 the driver statistics
-  @param  rand                 the random number generator
-  @param  tid                  the thread ids
+  @param  thread_data  the thread data, with the batch of sequences to map
+  @details             the thread persistent data is initialized upon the first call with a non-empty batch
  */
 void
-tmap_map_driver_core_worker(int32_t num_ends, 
-                            tmap_seq_t ***seq_buffer, 
-                            tmap_map_record_t **records,
-                            int32_t seq_buffer_length,
-                            tmap_index_t *index,
-                            tmap_map_driver_t *driver,
-                            tmap_map_stats_t* stat,
-                            tmap_rand_t *rand,
-                            int32_t tid);
-
-/*!
- A wrapper around the core function of mapall
+tmap_map_driver_core_worker(tmap_map_driver_thread_data_t *thread_data);
+
+/*!
+ The mapping thread routine, mapping batches until the thread pool is shut down
  @param  arg  the worker arguments in the type: tmap_map_driver_thread_data_t
  @return      the worker arguments
  */
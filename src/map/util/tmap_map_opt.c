@@ -148,6 +148,11 @@ __tmap_map_opt_option_print_func_int_init(shm_key)
 __tmap_map_opt_option_print_func_double_init(sample_reads)
 #endif
 __tmap_map_opt_option_print_func_int_init(vsw_type)
+__tmap_map_opt_option_print_func_tf_init(collapse_dups)
+__tmap_map_opt_option_print_func_int_init(occ_cache_size)
+__tmap_map_opt_option_print_func_int_init(reads_queue_mem)
+__tmap_map_opt_option_print_func_chars_init(fn_stats, "not using")
+__tmap_map_opt_option_print_func_int_init(index_mmap)
 __tmap_map_opt_option_print_func_verbosity_init()
 // flowspace
 __tmap_map_opt_option_print_func_int_init(fscore)
@@ -398,6 +403,7 @@ tmap_map_opt_init_helper(tmap_map_opt_t *opt)
   static char *pairing[] = {"0 - no pairing is to be performed", "1 - mate pairs (-S 0 -P 1)", "2 - paired end (-S 1 -P 0)", NULL};
   static char *strandedness[] = {"0 - same strand", "1 - opposite strand", NULL};
   static char *positioning[] = {"0 - read one before read two", "1 - read two before read one", NULL};
+  static char *index_mmap[] = {"0 - read in the index files", "1 - memory map the index files", "2 - memory map the index files and read them into memory now", NULL};
 
   opt->options = tmap_map_opt_options_init();
 
@@ -582,6 +588,36 @@ tmap_map_opt_init_helper(tmap_map_opt_t *opt)
                            vsw_type,
                            tmap_map_opt_option_print_func_vsw_type,
                            TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "collapse-duplicates", no_argument, 0, 0,
+                           TMAP_MAP_OPT_TYPE_NONE,
+                           "map identical reads in a batch once, giving each copy the same alignments to choose from (copies may report a different MAPQ or XA than if mapped separately)",
+                           NULL,
+                           tmap_map_opt_option_print_func_collapse_dups,
+                           TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "occ-cache-size", required_argument, 0, 0,
+                           TMAP_MAP_OPT_TYPE_INT,
+                           "the memory (in megabytes) for a cache of BWT occurrence lookups shared by all threads (0 to disable)",
+                           NULL,
+                           tmap_map_opt_option_print_func_occ_cache_size,
+                           TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "reads-queue-memory", required_argument, 0, 0,
+                           TMAP_MAP_OPT_TYPE_INT,
+                           "the memory (in megabytes) for the reads and alignments held at one time, loading fewer reads than -q if needed (0 for no limit)",
+                           NULL,
+                           tmap_map_opt_option_print_func_reads_queue_mem,
+                           TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "stats-file", required_argument, 0, 0,
+                           TMAP_MAP_OPT_TYPE_FILE,
+                           "the file name for the tab-separated counts and times of each mapping algorithm and step",
+                           NULL,
+                           tmap_map_opt_option_print_func_fn_stats,
+                           TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "index-mmap", required_argument, 0, 0,
+                           TMAP_MAP_OPT_TYPE_INT,
+                           "memory map the reference index files rather than reading them in",
+                           index_mmap,
+                           tmap_map_opt_option_print_func_index_mmap,
+                           TMAP_MAP_ALGO_GLOBAL);
   tmap_map_opt_options_add(opt->options, "help", no_argument, 0, 'h', 
                            TMAP_MAP_OPT_TYPE_NONE,
                            "print this message",
@@ -1027,6 +1063,11 @@ tmap_map_opt_init(int32_t algo_id)
   opt->sample_reads = 1.0;
 #endif
   opt->vsw_type = 4;
+  opt->collapse_dups = 0;
+  opt->occ_cache_size = 0;
+  opt->reads_queue_mem = 0;
+  opt->fn_stats = NULL;
+  opt->index_mmap = 0;
 
   // flowspace options
   opt->fscore = TMAP_MAP_OPT_FSCORE;
@@ -1145,6 +1186,7 @@ tmap_map_opt_destroy(tmap_map_opt_t *opt)
   }
   free(opt->fn_reads);
   free(opt->fn_sam);
+  free(opt->fn_stats);
   free(opt->sam_rg);
 
   for(i=0;i<opt->num_sub_opts;i++) {
@@ -1449,6 +1491,22 @@ tmap_map_opt_parse(int argc, char *argv[], tmap_map_opt_t *opt)
               tmap_get_reads_file_format_from_fn_int(opt->fn_reads[i], &opt->reads_format, &opt->input_compr);
           }
       }
+      else if(0 == c && 0 == strcmp("collapse-duplicates", options[option_index].name)) {
+          opt->collapse_dups = 1;
+      }
+      else if(0 == c && 0 == strcmp("occ-cache-size", options[option_index].name)) {
+          opt->occ_cache_size = atoi(optarg);
+      }
+      else if(0 == c && 0 == strcmp("reads-queue-memory", options[option_index].name)) {
+          opt->reads_queue_mem = atoi(optarg);
+      }
+      else if(0 == c && 0 == strcmp("stats-file", options[option_index].name)) {
+          free(opt->fn_stats);
+          opt->fn_stats = tmap_strdup(optarg);
+      }
+      else if(0 == c && 0 == strcmp("index-mmap", options[option_index].name)) {
+          opt->index_mmap = atoi(optarg);
+      }
       // End of global options
       // Flowspace options
       else if(c == 'F' || (0 == c && 0 == strcmp("final-flowspace", options[option_index].name))) {       
@@ -1778,6 +1836,21 @@ tmap_map_opt_check_global(tmap_map_opt_t *opt_a, tmap_map_opt_t *opt_b)
     if(opt_a->vsw_type != opt_b->vsw_type) {
         tmap_error("option -H was specified outside of the common options", Exit, CommandLineArgument);
     }
+    if(opt_a->collapse_dups != opt_b->collapse_dups) {
+        tmap_error("option --collapse-duplicates was specified outside of the common options", Exit, CommandLineArgument);
+    }
+    if(opt_a->occ_cache_size != opt_b->occ_cache_size) {
+        tmap_error("option --occ-cache-size was specified outside of the common options", Exit, CommandLineArgument);
+    }
+    if(opt_a->reads_queue_mem != opt_b->reads_queue_mem) {
+        tmap_error("option --reads-queue-memory was specified outside of the common options", Exit, CommandLineArgument);
+    }
+    if(0 != tmap_map_opt_file_check_with_null(opt_a->fn_stats, opt_b->fn_stats)) {
+        tmap_error("option --stats-file was specified outside of the common options", Exit, CommandLineArgument);
+    }
+    if(opt_a->index_mmap != opt_b->index_mmap) {
+        tmap_error("option --index-mmap was specified outside of the common options", Exit, CommandLineArgument);
+    }
     // flowspace
     if(opt_a->fscore != opt_b->fscore) {
         tmap_error("option -X was specified outside of the common options", Exit, CommandLineArgument);
@@ -1941,6 +2014,13 @@ tmap_map_opt_check(tmap_map_opt_t *opt)
   tmap_error_cmd_check_int(opt->sample_reads, 0, 1, "-x");
 #endif
   tmap_error_cmd_check_int(opt->vsw_type, 1, 10, "-H");
+  tmap_error_cmd_check_int(opt->collapse_dups, 0, 1, "--collapse-duplicates");
+  tmap_error_cmd_check_int(opt->occ_cache_size, 0, INT32_MAX, "--occ-cache-size");
+  tmap_error_cmd_check_int(opt->reads_queue_mem, 0, INT32_MAX, "--reads-queue-memory");
+  tmap_error_cmd_check_int(opt->index_mmap, 0, 2, "--index-mmap");
+  if(0 < opt->index_mmap && 0 != opt->shm_key) {
+      tmap_error("options --index-mmap and -k cannot be used together", Exit, CommandLineArgument);
+  }
   // Warn users
   switch(opt->vsw_type) {
     case 1:
@@ -2079,6 +2159,11 @@ tmap_map_opt_copy_global(tmap_map_opt_t *opt_dest, tmap_map_opt_t *opt_src)
     opt_dest->sample_reads = opt_src->sample_reads;
 #endif
     opt_dest->vsw_type = opt_src->vsw_type;
+    opt_dest->collapse_dups = opt_src->collapse_dups;
+    opt_dest->occ_cache_size = opt_src->occ_cache_size;
+    opt_dest->reads_queue_mem = opt_src->reads_queue_mem;
+    opt_dest->fn_stats = tmap_strdup(opt_src->fn_stats);
+    opt_dest->index_mmap = opt_src->index_mmap;
     
     // flowspace options
     opt_dest->fscore = opt_src->fscore;
@@ -2157,6 +2242,11 @@ tmap_map_opt_print(tmap_map_opt_t *opt)
   fprintf(stderr, "sample_reads=%lf\n", opt->sample_reads);
 #endif
   fprintf(stderr, "vsw_type=%d\n", opt->vsw_type);
+  fprintf(stderr, "collapse_dups=%d\n", opt->collapse_dups);
+  fprintf(stderr, "occ_cache_size=%d\n", opt->occ_cache_size);
+  fprintf(stderr, "reads_queue_mem=%d\n", opt->reads_queue_mem);
+  fprintf(stderr, "fn_stats=%s\n", opt->fn_stats);
+  fprintf(stderr, "index_mmap=%d\n", opt->index_mmap);
   fprintf(stderr, "min_seq_len=%d\n", opt->min_seq_len);
   fprintf(stderr, "max_seq_len=%d\n", opt->max_seq_len);
   fprintf(stderr, "seed_length=%d\n", opt->seed_length);
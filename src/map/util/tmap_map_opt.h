@@ -194,6 +194,11 @@ typedef struct __tmap_map_opt_t {
     double sample_reads;  /*!< sample the reads at this fraction (-x,--sample-reads) */
 #endif
     int32_t vsw_type; /*!< the vectorized smith waterman algorithm (-H,--vsw-type) */
+    int32_t collapse_dups; /*!< map identical reads in a batch once (--collapse-duplicates) */
+    int32_t occ_cache_size; /*!< the memory in megabytes for the shared occurrence cache, 0 to disable (--occ-cache-size) */
+    int32_t reads_queue_mem; /*!< the memory in megabytes for the reads and alignments held at one time, 0 for no limit (--reads-queue-memory) */
+    char *fn_stats; /*!< the file name for the mapping algorithm and step counts and times (--stats-file) */
+    int32_t index_mmap; /*!< 0 to read in the reference index, 1 to memory map it, 2 to memory map and read it in now (--index-mmap) */
 
     // flowspace tags
     int32_t fscore;  /*!< the flow score penalty (-X,--pen-flow-error) */
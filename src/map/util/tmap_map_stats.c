@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <config.h>
 #include <unistd.h>
 #include "../../util/tmap_error.h"
@@ -9,27 +10,77 @@
 #include "../../util/tmap_definitions.h"
 #include "tmap_map_stats.h"
 
+static const char *tmap_map_stats_step_names[TMAP_MAP_STATS_STEP_NUM] = {
+    "seed", "score", "rmdup", "pairing", "cigar", "fsw", "print"
+};
+
 tmap_map_stats_t*
-tmap_map_stats_init()
+tmap_map_stats_init(int32_t num_algorithms)
 {
-  return tmap_calloc(1, sizeof(tmap_map_stats_t), "return");
+  tmap_map_stats_t *s = NULL;
+  s = tmap_calloc(1, sizeof(tmap_map_stats_t), "s");
+  s->num_algorithms = num_algorithms;
+  if(0 < num_algorithms) {
+      s->algo_calls = tmap_calloc(num_algorithms, sizeof(uint64_t), "s->algo_calls");
+      s->algo_hits = tmap_calloc(num_algorithms, sizeof(uint64_t), "s->algo_hits");
+      s->algo_time = tmap_calloc(num_algorithms, sizeof(uint64_t), "s->algo_time");
+  }
+  return s;
 }
 
 void
 tmap_map_stats_destroy(tmap_map_stats_t *s)
 {
+  if(NULL == s) return;
+  free(s->algo_calls);
+  free(s->algo_hits);
+  free(s->algo_time);
   free(s);
 }
 
 void
 tmap_map_stats_add(tmap_map_stats_t *dest, tmap_map_stats_t *src)
 {
+  int32_t i;
   dest->num_reads += src->num_reads;
   dest->num_with_mapping += src->num_with_mapping;
   dest->num_after_seeding += src->num_after_seeding;
   dest->num_after_scoring += src->num_after_scoring;
   dest->num_after_rmdup += src->num_after_rmdup;
   dest->num_after_filter += src->num_after_filter;
+  for(i=0;i<TMAP_MAP_STATS_STEP_NUM;i++) {
+      dest->step_calls[i] += src->step_calls[i];
+      dest->step_hits[i] += src->step_hits[i];
+      dest->step_time[i] += src->step_time[i];
+  }
+  for(i=0;i<dest->num_algorithms && i<src->num_algorithms;i++) {
+      dest->algo_calls[i] += src->algo_calls[i];
+      dest->algo_hits[i] += src->algo_hits[i];
+      dest->algo_time[i] += src->algo_time[i];
+  }
+}
+
+void
+tmap_map_stats_reset(tmap_map_stats_t *s)
+{
+  s->num_reads = s->num_with_mapping = 0;
+  s->num_after_seeding = s->num_after_scoring = 0;
+  s->num_after_rmdup = s->num_after_filter = 0;
+  memset(s->step_calls, 0, sizeof(uint64_t) * TMAP_MAP_STATS_STEP_NUM);
+  memset(s->step_hits, 0, sizeof(uint64_t) * TMAP_MAP_STATS_STEP_NUM);
+  memset(s->step_time, 0, sizeof(uint64_t) * TMAP_MAP_STATS_STEP_NUM);
+  if(0 < s->num_algorithms) {
+      memset(s->algo_calls, 0, sizeof(uint64_t) * s->num_algorithms);
+      memset(s->algo_hits, 0, sizeof(uint64_t) * s->num_algorithms);
+      memset(s->algo_time, 0, sizeof(uint64_t) * s->num_algorithms);
+  }
+}
+
+const char *
+tmap_map_stats_step_name(int32_t step)
+{
+  if(step < 0 || TMAP_MAP_STATS_STEP_NUM <= step) return NULL;
+  return tmap_map_stats_step_names[step];
 }
 
 void
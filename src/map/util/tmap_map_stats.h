@@ -2,6 +2,22 @@
 #ifndef TMAP_MAP_STATS_H
 #define TMAP_MAP_STATS_H
 
+#include <stdint.h>
+
+/*!
+  The steps of mapping a read that are timed
+  */
+enum {
+    TMAP_MAP_STATS_STEP_SEED = 0, /*!< running the mapping algorithms */
+    TMAP_MAP_STATS_STEP_SCORE = 1, /*!< scoring the mappings with Smith Waterman */
+    TMAP_MAP_STATS_STEP_RMDUP = 2, /*!< removing duplicate mappings */
+    TMAP_MAP_STATS_STEP_PAIRING = 3, /*!< read rescue and picking pairs */
+    TMAP_MAP_STATS_STEP_CIGAR = 4, /*!< generating the cigars */
+    TMAP_MAP_STATS_STEP_FSW = 5, /*!< re-aligning in flow space */
+    TMAP_MAP_STATS_STEP_PRINT = 6, /*!< formatting the SAM records */
+    TMAP_MAP_STATS_STEP_NUM = 7 /*!< the number of steps */
+};
+
 /*!
   The mapping statistics structure.
  */
@@ -12,13 +28,21 @@ typedef struct {
     uint64_t num_after_scoring; /*!< the number of hits after scoring */
     uint64_t num_after_rmdup; /*!< the number of hits after duplicate removal */
     uint64_t num_after_filter; /*!< the number of hits after filtering */
+    uint64_t step_calls[TMAP_MAP_STATS_STEP_NUM]; /*!< the number of times each step was run */
+    uint64_t step_hits[TMAP_MAP_STATS_STEP_NUM]; /*!< the number of hits after each step */
+    uint64_t step_time[TMAP_MAP_STATS_STEP_NUM]; /*!< the time, in nanoseconds, spent in each step */
+    int32_t num_algorithms; /*!< the number of mapping algorithms across all stages */
+    uint64_t *algo_calls; /*!< the number of times each mapping algorithm was run */
+    uint64_t *algo_hits; /*!< the number of hits found by each mapping algorithm */
+    uint64_t *algo_time; /*!< the time, in nanoseconds, spent in each mapping algorithm */
 } tmap_map_stats_t;
 
 /*!
-  @return  a new stats structure
+  @param  num_algorithms  the number of mapping algorithms to time
+  @return                 a new stats structure
  */
 tmap_map_stats_t*
-tmap_map_stats_init();
+tmap_map_stats_init(int32_t num_algorithms);
 
 /*!
   @param  s  the mapping driver stats to destroy
@@ -30,8 +54,23 @@ tmap_map_stats_destroy(tmap_map_stats_t *s);
   Adds the src stats to the dest stats
   @param  dest  the destination
   @param  src   the source
+  @details      only the algorithms timed by both are added
  */
 void
 tmap_map_stats_add(tmap_map_stats_t *dest, tmap_map_stats_t *src);
 
+/*!
+  Zeroes the stats
+  @param  s  the stats to reset
+ */
+void
+tmap_map_stats_reset(tmap_map_stats_t *s);
+
+/*!
+  @param  step  the step
+  @return       the name of the step
+ */
+const char *
+tmap_map_stats_step_name(int32_t step);
+
 #endif 
@@ -9,6 +9,7 @@
 #include "../../util/tmap_sort.h"
 #include "../../util/tmap_definitions.h"
 #include "../../util/tmap_rand.h"
+#include "../../util/tmap_arena.h"
 #include "../../seq/tmap_seq.h"
 #include "../../index/tmap_refseq.h"
 #include "../../index/tmap_bwt.h"
@@ -64,19 +65,19 @@ tmap_map_sam_malloc_aux(tmap_map_sam_t *s)
 {
   switch(s->algo_id) {
     case TMAP_MAP_ALGO_MAP1:
-      s->aux.map1_aux = tmap_calloc(1, sizeof(tmap_map_map1_aux_t), "s->aux.map1_aux");
+      s->aux.map1_aux = tmap_arena_calloc(s->arena, 1, sizeof(tmap_map_map1_aux_t), "s->aux.map1_aux");
       break;
     case TMAP_MAP_ALGO_MAP2:
-      s->aux.map2_aux = tmap_calloc(1, sizeof(tmap_map_map2_aux_t), "s->aux.map2_aux");
+      s->aux.map2_aux = tmap_arena_calloc(s->arena, 1, sizeof(tmap_map_map2_aux_t), "s->aux.map2_aux");
       break;
     case TMAP_MAP_ALGO_MAP3:
-      s->aux.map3_aux = tmap_calloc(1, sizeof(tmap_map_map3_aux_t), "s->aux.map3_aux");
+      s->aux.map3_aux = tmap_arena_calloc(s->arena, 1, sizeof(tmap_map_map3_aux_t), "s->aux.map3_aux");
       break;
     case TMAP_MAP_ALGO_MAP4:
-      s->aux.map4_aux = tmap_calloc(1, sizeof(tmap_map_map4_aux_t), "s->aux.map4_aux");
+      s->aux.map4_aux = tmap_arena_calloc(s->arena, 1, sizeof(tmap_map_map4_aux_t), "s->aux.map4_aux");
       break;
     case TMAP_MAP_ALGO_MAPVSW:
-      s->aux.map_vsw_aux = tmap_calloc(1, sizeof(tmap_map_map_vsw_aux_t), "s->aux.map_vsw_aux");
+      s->aux.map_vsw_aux = tmap_arena_calloc(s->arena, 1, sizeof(tmap_map_map_vsw_aux_t), "s->aux.map_vsw_aux");
       break;
     default:
       break;
@@ -88,23 +89,23 @@ tmap_map_sam_destroy_aux(tmap_map_sam_t *s)
 {
   switch(s->algo_id) {
     case TMAP_MAP_ALGO_MAP1:
-      free(s->aux.map1_aux);
+      tmap_arena_free(s->arena, s->aux.map1_aux);
       s->aux.map1_aux = NULL;
       break;
     case TMAP_MAP_ALGO_MAP2:
-      free(s->aux.map2_aux);
+      tmap_arena_free(s->arena, s->aux.map2_aux);
       s->aux.map2_aux = NULL;
       break;
     case TMAP_MAP_ALGO_MAP3:
-      free(s->aux.map3_aux);
+      tmap_arena_free(s->arena, s->aux.map3_aux);
       s->aux.map3_aux = NULL;
       break;
     case TMAP_MAP_ALGO_MAP4:
-      free(s->aux.map4_aux);
+      tmap_arena_free(s->arena, s->aux.map4_aux);
       s->aux.map4_aux = NULL;
       break;
     case TMAP_MAP_ALGO_MAPVSW:
-      free(s->aux.map_vsw_aux);
+      tmap_arena_free(s->arena, s->aux.map_vsw_aux);
       s->aux.map_vsw_aux = NULL;
       break;
     default:
@@ -116,21 +117,28 @@ void
 tmap_map_sam_destroy(tmap_map_sam_t *s)
 {
   tmap_map_sam_destroy_aux(s);
-  free(s->cigar);
+  tmap_arena_free(s->arena, s->cigar);
   s->cigar = NULL;
   s->n_cigar = 0;
 }
 
-tmap_map_sams_t *
-tmap_map_sams_init(tmap_map_sams_t *prev)
+static tmap_map_sams_t *
+tmap_map_sams_init1(tmap_map_sams_t *prev, tmap_arena_t *arena)
 {
-  tmap_map_sams_t *sams = tmap_calloc(1, sizeof(tmap_map_sams_t), "sams");
+  tmap_map_sams_t *sams = tmap_arena_calloc(arena, 1, sizeof(tmap_map_sams_t), "sams");
   sams->sams = NULL;
   sams->n = 0;
+  sams->arena = arena;
   if(NULL != prev) sams->max = prev->max;
   return sams;
 }
 
+tmap_map_sams_t *
+tmap_map_sams_init(tmap_map_sams_t *prev)
+{
+  return tmap_map_sams_init1(prev, (NULL == prev) ? NULL : prev->arena);
+}
+
 void
 tmap_map_sams_realloc(tmap_map_sams_t *s, int32_t n)
 {
@@ -139,10 +147,11 @@ tmap_map_sams_realloc(tmap_map_sams_t *s, int32_t n)
   for(i=n;i<s->n;i++) {
       tmap_map_sam_destroy(&s->sams[i]);
   }
-  s->sams = tmap_realloc(s->sams, sizeof(tmap_map_sam_t) * n, "s->sams");
+  s->sams = tmap_arena_realloc(s->arena, s->sams, sizeof(tmap_map_sam_t) * s->n, sizeof(tmap_map_sam_t) * n, "s->sams");
   for(i=s->n;i<n;i++) {
       // nullify
       tmap_map_sam_init(&s->sams[i]);
+      s->sams[i].arena = s->arena;
   }
   s->n = n;
 }
@@ -155,27 +164,28 @@ tmap_map_sams_destroy(tmap_map_sams_t *s)
   for(i=0;i<s->n;i++) {
       tmap_map_sam_destroy(&s->sams[i]);
   }
-  free(s->sams);
-  free(s);
+  tmap_arena_free(s->arena, s->sams);
+  tmap_arena_free(s->arena, s);
 }
 
 tmap_map_record_t*
-tmap_map_record_init(int32_t num_ends)
+tmap_map_record_init(int32_t num_ends, tmap_arena_t *arena)
 {
   tmap_map_record_t *record = NULL;
   int32_t i;
 
-  record = tmap_calloc(1, sizeof(tmap_map_record_t), "record");
-  record->sams = tmap_calloc(num_ends, sizeof(tmap_map_sams_t*), "record->sams");
+  record = tmap_arena_calloc(arena, 1, sizeof(tmap_map_record_t), "record");
+  record->sams = tmap_arena_calloc(arena, num_ends, sizeof(tmap_map_sams_t*), "record->sams");
   record->n = num_ends;
+  record->arena = arena;
   for(i=0;i<num_ends;i++) {
-      record->sams[i] = tmap_map_sams_init(NULL);
+      record->sams[i] = tmap_map_sams_init1(NULL, arena);
   }
   return record;
 }
 
 tmap_map_record_t*
-tmap_map_record_clone(tmap_map_record_t *src)
+tmap_map_record_clone(tmap_map_record_t *src, tmap_arena_t *arena)
 {
   int32_t i;
   tmap_map_record_t *dest = NULL;
@@ -183,14 +193,16 @@ tmap_map_record_clone(tmap_map_record_t *src)
   if(NULL == src) return NULL;
   
   // init
-  dest = tmap_calloc(1, sizeof(tmap_map_record_t), "dest");
-  dest->sams = tmap_calloc(src->n, sizeof(tmap_map_sams_t*), "dest->sams");
+  dest = tmap_arena_calloc(arena, 1, sizeof(tmap_map_record_t), "dest");
+  dest->sams = tmap_arena_calloc(arena, src->n, sizeof(tmap_map_sams_t*), "dest->sams");
   dest->n = src->n;
+  dest->arena = arena;
   if(0 == src->n) return dest;
 
   // copy over data
   for(i=0;i<src->n;i++) {
-      dest->sams[i] = tmap_map_sams_clone(src->sams[i]);
+      dest->sams[i] = tmap_map_sams_init1(src->sams[i], arena);
+      tmap_map_sams_merge(dest->sams[i], src->sams[i]);
   }
 
   return dest;
@@ -215,16 +227,19 @@ tmap_map_record_destroy(tmap_map_record_t *record)
   for(i=0;i<record->n;i++) {
       tmap_map_sams_destroy(record->sams[i]);
   }
-  free(record->sams);
-  free(record);
+  tmap_arena_free(record->arena, record->sams);
+  tmap_arena_free(record->arena, record);
 }
 
 inline void
 tmap_map_sam_copy(tmap_map_sam_t *dest, tmap_map_sam_t *src)
 {
   int32_t i;
+  tmap_arena_t *arena = dest->arena;
   // shallow copy
   (*dest) = (*src);
+  // the copy lives where the destination does
+  dest->arena = arena;
   // aux data
   tmap_map_sam_malloc_aux(dest);
   switch(src->algo_id) {
@@ -248,7 +263,7 @@ tmap_map_sam_copy(tmap_map_sam_t *dest, tmap_map_sam_t *src)
   }
   // cigar
   if(0 < src->n_cigar && NULL != src->cigar) {
-      dest->cigar = tmap_malloc(sizeof(uint32_t) * (1 + dest->n_cigar), "dest->cigar");
+      dest->cigar = tmap_arena_malloc(arena, sizeof(uint32_t) * (1 + dest->n_cigar), "dest->cigar");
       for(i=0;i<dest->n_cigar;i++) {
           dest->cigar[i] = src->cigar[i];
       }
@@ -315,7 +330,7 @@ tmap_map_sam_copy_and_nullify(tmap_map_sam_t *dest, tmap_map_sam_t *src)
 }
 
 static void
-tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam, int32_t sam_flowspace_tags, int32_t bidirectional, int32_t seq_eq, 
+tmap_map_sam_print(tmap_file_t *fp, tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam, int32_t sam_flowspace_tags, int32_t bidirectional, int32_t seq_eq, 
                    int32_t nh, int32_t aln_num, int32_t end_num, int32_t mate_unmapped, tmap_map_sam_t *mate)
 {
   int64_t mate_strand, mate_seqid, mate_pos, mate_tlen;
@@ -327,7 +342,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
       mate_pos = mate->pos;
   }
   if(NULL == sam) { // unmapped
-      tmap_sam_print_unmapped(tmap_file_stdout, seq, sam_flowspace_tags, bidirectional, refseq,
+      tmap_sam_print_unmapped(fp, seq, sam_flowspace_tags, bidirectional, refseq,
                               end_num, mate_unmapped, 0,
                               mate_strand, mate_seqid, mate_pos, NULL);
   }
@@ -355,7 +370,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
       }
       switch(sam->algo_id) {
         case TMAP_MAP_ALGO_MAP1:
-          tmap_sam_print_mapped(tmap_file_stdout, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
+          tmap_sam_print_mapped(fp, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
                                 sam->strand, sam->seqid, sam->pos, aln_num,
                                 end_num, mate_unmapped, sam->proper_pair, sam->num_stds,
                                 mate_strand, mate_seqid, mate_pos, mate_tlen,
@@ -364,7 +379,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
           break;
         case TMAP_MAP_ALGO_MAP2:
           if(0 < sam->aux.map2_aux->XI) {
-              tmap_sam_print_mapped(tmap_file_stdout, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
+              tmap_sam_print_mapped(fp, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
                                     sam->strand, sam->seqid, sam->pos, aln_num,
                                     end_num, mate_unmapped, sam->proper_pair, sam->num_stds,
                                     mate_strand, mate_seqid, mate_pos, mate_tlen,
@@ -377,7 +392,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
                                     sam->aux.map2_aux->XI);
           }
           else {
-              tmap_sam_print_mapped(tmap_file_stdout, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
+              tmap_sam_print_mapped(fp, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
                                     sam->strand, sam->seqid, sam->pos, aln_num,
                                     end_num, mate_unmapped, sam->proper_pair, sam->num_stds,
                                     mate_strand, mate_seqid, mate_pos, mate_tlen,
@@ -390,7 +405,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
           }
           break;
         case TMAP_MAP_ALGO_MAP3:
-          tmap_sam_print_mapped(tmap_file_stdout, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
+          tmap_sam_print_mapped(fp, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
                                 sam->strand, sam->seqid, sam->pos, aln_num,
                                 end_num, mate_unmapped, sam->proper_pair, sam->num_stds,
                                 mate_strand, mate_seqid, mate_pos, mate_tlen,
@@ -403,7 +418,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
                                 sam->seed_end);
           break;
         case TMAP_MAP_ALGO_MAP4:
-          tmap_sam_print_mapped(tmap_file_stdout, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
+          tmap_sam_print_mapped(fp, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
                                 sam->strand, sam->seqid, sam->pos, aln_num,
                                 end_num, mate_unmapped, sam->proper_pair, sam->num_stds,
                                 mate_strand, mate_seqid, mate_pos, mate_tlen,
@@ -413,7 +428,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
                                 sam->score_subo);
           break;
         case TMAP_MAP_ALGO_MAPVSW:
-          tmap_sam_print_mapped(tmap_file_stdout, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
+          tmap_sam_print_mapped(fp, seq, sam_flowspace_tags, bidirectional, seq_eq, refseq, 
                                 sam->strand, sam->seqid, sam->pos, aln_num,
                                 end_num, mate_unmapped, sam->proper_pair, sam->num_stds,
                                 mate_strand, mate_seqid, mate_pos, mate_tlen,
@@ -427,7 +442,7 @@ tmap_map_sam_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sam_t *sam,
 }
 
 void 
-tmap_map_sams_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sams_t *sams, int32_t end_num,
+tmap_map_sams_print(tmap_file_t *fp, tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sams_t *sams, int32_t end_num,
                     tmap_map_sams_t *mates, int32_t sam_flowspace_tags, int32_t bidirectional, int32_t seq_eq) 
 {
   int32_t i;
@@ -444,11 +459,11 @@ tmap_map_sams_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sams_t *sam
   }
   if(0 < sams->n) {
       for(i=0;i<sams->n;i++) {
-          tmap_map_sam_print(seq, refseq, &sams->sams[i], sam_flowspace_tags, bidirectional, seq_eq, sams->max, i, end_num, mate_unmapped, mate);
+          tmap_map_sam_print(fp, seq, refseq, &sams->sams[i], sam_flowspace_tags, bidirectional, seq_eq, sams->max, i, end_num, mate_unmapped, mate);
       }
   }
   else {
-      tmap_map_sam_print(seq, refseq, NULL, sam_flowspace_tags, bidirectional, seq_eq, sams->max, 0, end_num, mate_unmapped, mate);
+      tmap_map_sam_print(fp, seq, refseq, NULL, sam_flowspace_tags, bidirectional, seq_eq, sams->max, 0, end_num, mate_unmapped, mate);
   }
 }
 
@@ -894,7 +909,7 @@ tmap_map_util_sw_gen_score_helper(tmap_refseq_t *refseq, tmap_map_sams_t *sams,
                         int32_t *idx, int32_t start, int32_t end,
                         uint8_t strand, tmap_vsw_t *vsw,
                         int32_t seq_len, uint32_t start_pos, uint32_t end_pos,
-                        int32_t *target_mem, uint8_t **target,
+                        tmap_arena_t *arena, int32_t *target_mem, uint8_t **target,
                         int32_t softclip_start, int32_t softclip_end,
                         int32_t prev_n_best,
                         int32_t max_seed_band, // NB: this may be modified as banding is unrolled
@@ -938,20 +953,17 @@ tmap_map_util_sw_gen_score_helper(tmap_refseq_t *refseq, tmap_map_sams_t *sams,
   // get the target sequence
   tlen = end_pos - start_pos + 1;
   if((*target_mem) < tlen) { // more memory?
+      int32_t old_mem = (*target_mem);
       (*target_mem) = tlen;
       tmap_roundup32((*target_mem));
-      (*target) = tmap_realloc((*target), sizeof(uint8_t)*(*target_mem), "target");
+      (*target) = tmap_arena_realloc(arena, (*target), sizeof(uint8_t)*old_mem, sizeof(uint8_t)*(*target_mem), "target");
   }
   // NB: IUPAC codes are turned into mismatches
-  if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, (*target), 1, NULL)) {
+  // NB: the target is reverse complimented for the reverse strand
+  if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, strand, (*target), 1, NULL)) {
       tmap_error("bug encountered", Exit, OutOfRange);
   }
 
-  // reverse compliment the target
-  if(1 == strand) {
-      tmap_reverse_compliment_int((*target), tlen);
-  }
-
   // Debugging
 #ifdef TMAP_VSW_DEBUG
   int j;
@@ -1078,7 +1090,7 @@ tmap_map_util_sw_gen_score_helper(tmap_refseq_t *refseq, tmap_map_sams_t *sams,
                   // recurse
                   cur_score = tmap_map_util_sw_gen_score_helper(refseq, sams, seq, sams_tmp, idx, start, end,
                                                                 strand, vsw, seq_len, start_pos, end_pos,
-                                                                target_mem, target,
+                                                                arena, target_mem, target,
                                                                 softclip_start, softclip_end,
                                                                 tmp_sam.result.n_best,
                                                                 (max_seed_band <= 0) ? -1 : (max_seed_band >> 1),
@@ -1111,6 +1123,7 @@ tmap_map_util_sw_gen_score_helper(tmap_refseq_t *refseq, tmap_map_sams_t *sams,
           s = &sams_tmp->sams[(*idx)];
           // shallow copy previous data 
           (*s) = tmp_sam; 
+          s->arena = sams_tmp->arena;
           //s->result = tmp_sam.result;
 
           // nullify the cigar
@@ -1188,6 +1201,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
                  tmap_map_sams_t *sams, 
                  tmap_seq_t **seqs,
                  tmap_rand_t *rand,
+                 tmap_arena_t *arena,
                  tmap_map_opt_t *opt)
 {
   int32_t i, j;
@@ -1229,7 +1243,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
   vsw = tmap_vsw_init((uint8_t*)tmap_seq_get_bases(seqs[0])->s, seq_len, softclip_start, softclip_end, opt->vsw_type, vsw_opt); 
 
   // pre-allocate groups
-  groups = tmap_calloc(sams->n, sizeof(tmap_map_util_gen_score_t), "groups");
+  groups = tmap_arena_calloc(arena, sams->n, sizeof(tmap_map_util_gen_score_t), "groups");
 
   // determine groups
   num_groups = num_groups_filtered = 0;
@@ -1299,7 +1313,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
   }
 
   // resize
-  if(num_groups < sams->n) {
+  if(NULL == arena && num_groups < sams->n) {
       groups = tmap_realloc(groups, num_groups * sizeof(tmap_map_util_gen_score_t), "groups");
   }
 
@@ -1417,7 +1431,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
       // generate the score
       tmap_map_util_sw_gen_score_helper(refseq, sams, seqs[0], sams_tmp, &j, group->start, group->end,
                                         group->strand, vsw, seq_len, group->start_pos, group->end_pos,
-                                        &target_mem, &target,
+                                        arena, &target_mem, &target,
                                         softclip_start, softclip_end,
                                         -1, // this is our first call
                                         opt->max_seed_band, // NB: this may be modified as banding is unrolled
@@ -1466,7 +1480,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
               // generate the score
               tmap_map_util_sw_gen_score_helper(refseq, sams, seqs[0], sams_tmp, &j, group->start, group->end,
                                                 group->strand, vsw, seq_len, group->start_pos, group->end_pos,
-                                                &target_mem, &target,
+                                                arena, &target_mem, &target,
                                                 softclip_start, softclip_end,
                                                 -1, // this is our first call
                                                 opt->max_seed_band, // NB: this may be modified as banding is unrolled
@@ -1485,7 +1499,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
                   // generate the score
                   tmap_map_util_sw_gen_score_helper(refseq, sams, seqs[0], sams_tmp, &j, group->start, group->end,
                                                     group->strand, vsw, seq_len, group->start_pos, group->end_pos,
-                                                    &target_mem, &target,
+                                                    arena, &target_mem, &target,
                                                     softclip_start, softclip_end,
                                                     -1, // this is our first call
                                                     opt->max_seed_band, // NB: this may be modified as banding is unrolled
@@ -1519,7 +1533,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
                   // generate the score
                   tmap_map_util_sw_gen_score_helper(refseq, sams, seqs[0], sams_tmp, &j, group->start, group->end,
                                                     group->strand, vsw, seq_len, group->start_pos, group->end_pos,
-                                                    &target_mem, &target,
+                                                    arena, &target_mem, &target,
                                                     softclip_start, softclip_end,
                                                     -1, // this is our first call
                                                     opt->max_seed_band, // NB: this may be modified as banding is unrolled
@@ -1546,10 +1560,10 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
 
   // free memory
   tmap_map_sams_destroy(sams);
-  free(target);
+  tmap_arena_free(arena, target);
   tmap_vsw_opt_destroy(vsw_opt);
   tmap_vsw_destroy(vsw);
-  free(groups);
+  tmap_arena_free(arena, groups);
 
   return sams_tmp;
 }
@@ -1593,7 +1607,7 @@ tmap_map_util_keytrim(uint8_t *query, int32_t qlen,
               if(j == 0) {
                   // reallocate
                   s->n_cigar++;
-                  s->cigar = tmap_realloc(s->cigar, sizeof(uint32_t)*s->n_cigar, "s->cigar");
+                  s->cigar = tmap_arena_realloc(s->arena, s->cigar, sizeof(uint32_t)*(s->n_cigar-1), sizeof(uint32_t)*s->n_cigar, "s->cigar");
                   for(k=s->n_cigar-1;0<k;k--) { // shift up
                       s->cigar[k] = s->cigar[k-1];
                   }
@@ -1655,7 +1669,7 @@ tmap_map_util_keytrim(uint8_t *query, int32_t qlen,
               if(j == s->n_cigar-1) {
                   // reallocate
                   s->n_cigar++;
-                  s->cigar = tmap_realloc(s->cigar, sizeof(uint32_t)*s->n_cigar, "s->cigar");
+                  s->cigar = tmap_arena_realloc(s->arena, s->cigar, sizeof(uint32_t)*(s->n_cigar-1), sizeof(uint32_t)*s->n_cigar, "s->cigar");
                   s->cigar[s->n_cigar-1] = 0;
               }
               // add to the ending soft-clip
@@ -1686,7 +1700,9 @@ tmap_map_util_keytrim(uint8_t *query, int32_t qlen,
 tmap_map_sams_t *
 tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
                  tmap_map_sams_t *sams, 
+                 tmap_seq_t *seq,
                  tmap_seq_t **seqs,
+                 tmap_arena_t *arena,
                  tmap_map_opt_t *opt)
 {
   int32_t i, j, matrix[25], matrix_iupac[80];
@@ -1733,7 +1749,7 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
   if(1 == opt->softclip_key) {
       uint8_t *key_seq = NULL;
       int32_t key_seq_len;
-      key_seq_len = tmap_seq_get_key_seq_int(seqs[0], &key_seq);
+      key_seq_len = tmap_seq_get_key_seq_int(seq, &key_seq);
       if(NULL == key_seq) {
           key_base = 0;
       }
@@ -1773,20 +1789,17 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
       // get the target sequence
       tlen = tmp_sam.result.target_end + 1; // adjust based on the target end
       if(target_mem < tlen) { // more memory?
+          int32_t old_mem = target_mem;
           target_mem = tlen;
           tmap_roundup32(target_mem);
-          target = tmap_realloc(target, sizeof(uint8_t)*target_mem, "target");
+          target = tmap_arena_realloc(arena, target, sizeof(uint8_t)*old_mem, sizeof(uint8_t)*target_mem, "target");
       }
       // NB: IUPAC codes are turned into mismatches
-      if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, target, 1, &conv)) {
+      // NB: the target is reverse complimented for the forward strand
+      if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, (0 == strand) ? 1 : 0, target, 1, &conv)) {
           tmap_bug();
       }
 
-      // reverse compliment the target
-      if(0 == strand) {
-          tmap_reverse_compliment_int(target, tlen);
-      }
-
       // NB: if match/mismatch penalties are on the opposite strands, we may
       // have wrong scores
       // NB: this aligns in the opposite direction than sequencing 
@@ -1852,16 +1865,17 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
           // Get the new target
           // NB: IUPAC codes are turned into mismatches
           start_pos += tmp_sam.result.target_start;
-          if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, target, 0, NULL)) {
+          if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, 0, target, 0, NULL)) {
               tmap_bug();
           }
       }
 
       // path memory
       if(path_mem <= tlen + seq_len) { // lengthen the path
+          int32_t old_mem = path_mem;
           path_mem = tlen + seq_len;
           tmap_roundup32(path_mem);
-          path = tmap_realloc(path, sizeof(tmap_sw_path_t)*path_mem, "path");
+          path = tmap_arena_realloc(arena, path, sizeof(tmap_sw_path_t)*old_mem, sizeof(tmap_sw_path_t)*path_mem, "path");
       }
 
       /*
@@ -1878,15 +1892,17 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
 
       // path memory
       if(path_mem <= tlen + qlen) { // lengthen the path
+          int32_t old_mem = path_mem;
           path_mem = tlen + qlen;
           tmap_roundup32(path_mem);
-          path = tmap_realloc(path, sizeof(tmap_sw_path_t)*path_mem, "path");
+          path = tmap_arena_realloc(arena, path, sizeof(tmap_sw_path_t)*old_mem, sizeof(tmap_sw_path_t)*path_mem, "path");
       }
 
       s = &sams_tmp->sams[i];
       
       // shallow copy previous data 
       (*s) = tmp_sam; 
+      s->arena = sams_tmp->arena;
 
       // Smith Waterman with banding
       // NB: we store the score from the banded version, which does not allow
@@ -1907,7 +1923,7 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
       if(path[path_len-1].ctype == TMAP_SW_FROM_I) {
           s->pos++;
       }
-      s->cigar = tmap_sw_path2cigar(path, path_len, &s->n_cigar);
+      s->cigar = tmap_sw_path2cigar(path, path_len, &s->n_cigar, s->arena);
       if(0 == s->n_cigar) {
           tmap_bug();
       }
@@ -1927,7 +1943,7 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
       // add soft clipping 
       if(0 < query_start) {
           // soft clip the front of the read
-          s->cigar = tmap_realloc(s->cigar, sizeof(uint32_t)*(1+s->n_cigar), "s->cigar");
+          s->cigar = tmap_arena_realloc(s->arena, s->cigar, sizeof(uint32_t)*s->n_cigar, sizeof(uint32_t)*(1+s->n_cigar), "s->cigar");
           for(j=s->n_cigar-1;0<=j;j--) { // shift up
               s->cigar[j+1] = s->cigar[j];
           }
@@ -1936,7 +1952,7 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
       }
       if(query_end < seq_len-1) {
           // soft clip the end of the read
-          s->cigar = tmap_realloc(s->cigar, sizeof(uint32_t)*(1+s->n_cigar), "s->cigar");
+          s->cigar = tmap_arena_realloc(s->arena, s->cigar, sizeof(uint32_t)*s->n_cigar, sizeof(uint32_t)*(1+s->n_cigar), "s->cigar");
           TMAP_SW_CIGAR_STORE(s->cigar[s->n_cigar], BAM_CSOFT_CLIP, seq_len - query_end - 1);
           s->n_cigar++;
       }
@@ -1982,8 +1998,8 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
 
   // free memory
   tmap_map_sams_destroy(sams);
-  free(path);
-  free(target);
+  tmap_arena_free(arena, path);
+  tmap_arena_free(arena, target);
   tmap_vsw_destroy(vsw);
   tmap_vsw_opt_destroy(vsw_opt);
 
@@ -1998,7 +2014,8 @@ tmap_map_util_fsw(tmap_fsw_flowseq_t *fseq, tmap_seq_t *seq,
                   tmap_map_sams_t *sams, tmap_refseq_t *refseq,
                   int32_t bw, int32_t softclip_type, int32_t score_thr,
                   int32_t score_match, int32_t pen_mm, int32_t pen_gapo, 
-                  int32_t pen_gape, int32_t fscore, int32_t use_flowgram)
+                  int32_t pen_gape, int32_t fscore, int32_t use_flowgram,
+                  tmap_arena_t *arena)
 {
   int32_t i, j, k, l;
   uint8_t *target = NULL;
@@ -2084,14 +2101,15 @@ tmap_map_util_fsw(tmap_fsw_flowseq_t *fseq, tmap_seq_t *seq,
       // get the target sequence
       target_len = ref_end - ref_start + 1;
       if(target_mem < target_len) {
+          int32_t old_mem = target_mem;
           target_mem = target_len;
           tmap_roundup32(target_mem);
-          target = tmap_realloc(target, sizeof(uint8_t)*target_mem, "target");
+          target = tmap_arena_realloc(arena, target, sizeof(uint8_t)*old_mem, sizeof(uint8_t)*target_mem, "target");
       }
       target_len = tmap_refseq_subseq(refseq, ref_start + refseq->annos[s->seqid].offset, target_len, target);
       /*
       // NB: IUPAC codes are turned into mismatches
-      if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, target, 1, NULL)) {
+      if(NULL == tmap_refseq_subseq2(refseq, sams->sams[end].seqid+1, start_pos, end_pos, 0, target, 1, NULL)) {
           tmap_bug();
       }
       */
@@ -2105,9 +2123,10 @@ tmap_map_util_fsw(tmap_fsw_flowseq_t *fseq, tmap_seq_t *seq,
 
       // make sure we have enough memory for the path
       while(path_mem <= target_len + fseq->num_flows) { // lengthen the path
+          int32_t old_mem = path_mem;
           path_mem = target_len + fseq->num_flows + 1;
           tmap_roundup32(path_mem);
-          path = tmap_realloc(path, sizeof(tmap_fsw_path_t)*path_mem, "path");
+          path = tmap_arena_realloc(arena, path, sizeof(tmap_fsw_path_t)*old_mem, sizeof(tmap_fsw_path_t)*path_mem, "path");
       }
 
       /*
@@ -2189,8 +2208,8 @@ tmap_map_util_fsw(tmap_fsw_flowseq_t *fseq, tmap_seq_t *seq,
 
 
           // new cigar
-          free(s->cigar);
-          s->cigar = tmap_fsw_path2cigar(path, path_len, &s->n_cigar, 1);
+          tmap_arena_free(s->arena, s->cigar);
+          s->cigar = tmap_fsw_path2cigar(path, path_len, &s->n_cigar, 1, s->arena);
 
           // reverse the cigar
           if(1 == s->strand) {
@@ -2223,7 +2242,7 @@ tmap_map_util_fsw(tmap_fsw_flowseq_t *fseq, tmap_seq_t *seq,
               skipped_end = k;
           }
           if(0 < skipped_start) { // start soft clip
-              s->cigar = tmap_realloc(s->cigar, sizeof(uint32_t)*(1 + s->n_cigar), "s->cigar");
+              s->cigar = tmap_arena_realloc(s->arena, s->cigar, sizeof(uint32_t)*s->n_cigar, sizeof(uint32_t)*(1 + s->n_cigar), "s->cigar");
               for(l=s->n_cigar-1;0<=l;l--) {
                   s->cigar[l+1] = s->cigar[l];
               }
@@ -2231,15 +2250,15 @@ tmap_map_util_fsw(tmap_fsw_flowseq_t *fseq, tmap_seq_t *seq,
               s->n_cigar++;
           }
           if(0 < skipped_end) { // end soft clip
-              s->cigar = tmap_realloc(s->cigar, sizeof(uint32_t)*(1 + s->n_cigar), "s->cigar");
+              s->cigar = tmap_arena_realloc(s->arena, s->cigar, sizeof(uint32_t)*s->n_cigar, sizeof(uint32_t)*(1 + s->n_cigar), "s->cigar");
               s->cigar[s->n_cigar] = (skipped_end << 4) | 4;
               s->n_cigar++;
           }
       }
   }
   // free
-  free(target);
-  free(path);
+  tmap_arena_free(arena, target);
+  tmap_arena_free(arena, path);
 
   if(0 == was_int) {
       tmap_seq_to_char(seq);
@@ -4,6 +4,8 @@
 
 #include <sys/types.h>
 #include "../../util/tmap_rand.h"
+#include "../../util/tmap_arena.h"
+#include "../../io/tmap_file.h"
 #include "../../sw/tmap_fsw.h"
 #include "../../sw/tmap_vsw.h"
 #include "tmap_map_opt.h"
@@ -103,6 +105,7 @@ typedef struct {
     tmap_vsw_result_t result; /*!< the VSW boundaries (query/target start/end and scores) */
     uint32_t seed_start; /*!< the start of the seed in genomic coordinates used to map this read */
     uint32_t seed_end; /*!< the end of the seed in genomic coordinates used to map this read */
+    tmap_arena_t *arena; /*!< the arena holding the cigar and auxiliary data, NULL for the heap */
 } tmap_map_sam_t;
 
 /*!
@@ -112,6 +115,7 @@ typedef struct {
     int32_t n; /*!< the number of hits */
     int32_t max; /*!< the number of hits before filtering */
     tmap_map_sam_t *sams; /*!< array of hits */
+    tmap_arena_t *arena; /*!< the arena holding this structure and its hits, NULL for the heap */
 } tmap_map_sams_t;
 
 /*!
@@ -120,6 +124,7 @@ typedef struct {
 typedef struct {
     tmap_map_sams_t **sams; /*!< the sam records */
     int32_t n; /*!< the number of records (multi-end) */
+    tmap_arena_t *arena; /*!< the arena holding this structure, NULL for the heap */
 } tmap_map_record_t;
 
 
@@ -161,7 +166,7 @@ tmap_map_sam_destroy(tmap_map_sam_t *s);
 
 /*!
   allocate memory for an empty mapping structure, with no auxiliary data
-  @param   prev  copies over the max from prev
+  @param   prev  copies over the max and the arena from prev
   @return        a pointer to the initialized memory
   */
 tmap_map_sams_t *
@@ -185,18 +190,20 @@ tmap_map_sams_destroy(tmap_map_sams_t *s);
 /*!
   Initializes a new multi-end mapping structure
   @param  num_ends  the number of ends in this record
+  @param  arena     the arena for the record and its mappings, NULL to use the heap
   @return  the new multi-end mapping structure
  */
 tmap_map_record_t*
-tmap_map_record_init(int32_t num_ends);
+tmap_map_record_init(int32_t num_ends, tmap_arena_t *arena);
 
 /*!
   Clones a new multi-end mapping structure
-  @param  src  the multi-end mapping structure to clone
+  @param  src    the multi-end mapping structure to clone
+  @param  arena  the arena for the clone and its mappings, NULL to use the heap
   @return  the new multi-end mapping structure
  */
 tmap_map_record_t*
-tmap_map_record_clone(tmap_map_record_t *src);
+tmap_map_record_clone(tmap_map_record_t *src, tmap_arena_t *arena);
 
 /*!
   Merges the mappings of two multi-end mappings 
@@ -238,6 +245,7 @@ tmap_map_sam_copy_and_nullify(tmap_map_sam_t *dest, tmap_map_sam_t *src);
 
 /*!
   prints the SAM records
+  @param  fp            the file to which to print
   @param  seq           the original read sequence
   @param  refseq        the reference sequence
   @param  sams          the mappings to print
@@ -248,7 +256,7 @@ tmap_map_sam_copy_and_nullify(tmap_map_sam_t *dest, tmap_map_sam_t *src);
   @param  seq_eq        1 if the SEQ field is to use '=' symbols, 0 otherwise
   */
 void
-tmap_map_sams_print(tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sams_t *sams, int32_t end_num, 
+tmap_map_sams_print(tmap_file_t *fp, tmap_seq_t *seq, tmap_refseq_t *refseq, tmap_map_sams_t *sams, int32_t end_num, 
                     tmap_map_sams_t *mates, int32_t sam_flowspace_tags, int32_t bidirectional, int32_t seq_eq);
 
 /*!
@@ -328,6 +336,7 @@ tmap_map_util_mapq(tmap_map_sams_t *sams, int32_t seq_len, tmap_map_opt_t *opt);
   @param  sams          the seeded sams
   @param  seqs          the query sequence (forward, reverse compliment, reverse, and compliment)
   @param  rand          the random number generator
+  @param  arena         the arena for scratch memory, NULL to use the heap
   @param  opt           the program parameters
   @return               the locally aligned sams
   */
@@ -336,6 +345,7 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
                  tmap_map_sams_t *sams,
                  tmap_seq_t **seqs,
                  tmap_rand_t *rand,
+                 tmap_arena_t *arena,
                  tmap_map_opt_t *opt);
 
 /*!
@@ -343,14 +353,18 @@ tmap_map_util_sw_gen_score(tmap_refseq_t *refseq,
   @details              generates the cigar after tmap_map_util_sw_gen_score has been called
   @param  refseq        the reference sequence
   @param  sams          the seeded sams
+  @param  seq           the original query sequence, for its key sequence
   @param  seqs          the query sequence (forward, reverse compliment, reverse, and compliment)
+  @param  arena         the arena for scratch memory, NULL to use the heap
   @param  opt           the program parameters
   @return               the locally aligned sams
   */
 tmap_map_sams_t *
 tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
                  tmap_map_sams_t *sams, 
+                 tmap_seq_t *seq,
                  tmap_seq_t **seqs,
+                 tmap_arena_t *arena,
                  tmap_map_opt_t *opt);
 
 /*!
@@ -372,6 +386,7 @@ tmap_map_util_sw_gen_cigar(tmap_refseq_t *refseq,
   @param  pen_gape       the gap extension penalty
   @param  fscore         the flow penalty
   @param  use_flowgram   1 to use the flowgram if available, 0 otherwise
+  @param  arena          the arena for scratch memory, NULL to use the heap
   */
 void
 tmap_map_util_fsw(tmap_fsw_flowseq_t *fs, tmap_seq_t *seq, 
@@ -380,5 +395,6 @@ tmap_map_util_fsw(tmap_fsw_flowseq_t *fs, tmap_seq_t *seq,
                   tmap_map_sams_t *sams, tmap_refseq_t *refseq,
                   int32_t bw, int32_t softclip_type, int32_t score_thr,
                   int32_t score_match, int32_t pen_mm, int32_t pen_gapo, 
-                  int32_t pen_gape, int32_t fscore, int32_t use_flowgram);
+                  int32_t pen_gape, int32_t fscore, int32_t use_flowgram,
+                  tmap_arena_t *arena);
 #endif
@@ -210,7 +210,7 @@ tmap_sam2fs_copy_to_sam(bam1_t *bam_old, tmap_fsw_path_t *path, int32_t path_len
   bam_new->data_len = 0; //bam_new->m_data;
   
   // get the cigar
-  cigar = tmap_fsw_path2cigar(path, path_len, &n_cigar, 1);
+  cigar = tmap_fsw_path2cigar(path, path_len, &n_cigar, 1, NULL);
 
   // check if the read should be unmapped
   for(i=0,unmapped=1;1 == unmapped && i<n_cigar;i++) {
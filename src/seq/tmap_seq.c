@@ -3,6 +3,7 @@
 
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
+#include "../util/tmap_definitions.h"
 #include "tmap_fq.h"
 #include "tmap_sff.h"
 #include "tmap_seq.h"
@@ -39,6 +40,7 @@ tmap_seq_init(int8_t type)
 void
 tmap_seq_destroy(tmap_seq_t *seq)
 {
+  if(NULL == seq) return;
   switch(seq->type) {
     case TMAP_SEQ_TYPE_FQ:
       tmap_fq_destroy(seq->data.fq);
@@ -396,6 +398,38 @@ tmap_seq_get_flowgram(tmap_seq_t *seq, uint16_t **flowgram, int32_t mem)
   return 0;
 }
 
+// NB: the SFF global header is shared by all the reads, so is not included
+size_t
+tmap_seq_get_mem(tmap_seq_t *seq)
+{
+  size_t mem = sizeof(tmap_seq_t);
+  switch(seq->type) {
+    case TMAP_SEQ_TYPE_FQ:
+      mem += sizeof(tmap_fq_t) + 4 * sizeof(tmap_string_t);
+      mem += seq->data.fq->name->m + seq->data.fq->comment->m + seq->data.fq->seq->m + seq->data.fq->qual->m;
+      break;
+    case TMAP_SEQ_TYPE_SFF:
+      mem += sizeof(tmap_sff_t) + sizeof(tmap_sff_read_header_t) + sizeof(tmap_sff_read_t) + 3 * sizeof(tmap_string_t);
+      mem += seq->data.sff->rheader->name->m + seq->data.sff->read->bases->m + seq->data.sff->read->quality->m;
+      mem += sizeof(uint16_t) * seq->data.sff->gheader->flow_length; // the flowgram
+      mem += sizeof(uint8_t) * seq->data.sff->rheader->n_bases; // the flow index
+      break;
+#ifdef HAVE_SAMTOOLS
+    case TMAP_SEQ_TYPE_SAM:
+    case TMAP_SEQ_TYPE_BAM:
+      mem += sizeof(tmap_sam_t) + sizeof(bam1_t) + 3 * sizeof(tmap_string_t);
+      mem += seq->data.sam->b->m_data;
+      mem += seq->data.sam->name->m + seq->data.sam->seq->m + seq->data.sam->qual->m;
+      mem += sizeof(uint16_t) * seq->data.sam->flowgram_len; // the flowgram
+      break;
+#endif
+    default:
+      tmap_error("type is unrecognized", Exit, OutOfRange);
+      break;
+  }
+  return mem;
+}
+
 int32_t
 tmap_seq_get_flow_start_index(tmap_seq_t *seq)
 {
@@ -437,3 +471,55 @@ tmap_seq_get_rg_id(tmap_seq_t *seq)
   }
   return NULL;
 }
+
+tmap_seq_t *
+tmap_seq_view(tmap_seq_t *view, tmap_seq_t *seq, int32_t strand, int32_t max_length)
+{
+  tmap_string_t *src = NULL, *dst = NULL;
+  int32_t i, len, is_int;
+  uint8_t *s = NULL;
+
+  if(NULL == view) {
+      view = tmap_seq_init(TMAP_SEQ_TYPE_FQ);
+  }
+  else if(TMAP_SEQ_TYPE_FQ != view->type) {
+      tmap_error("the view must be in FASTQ format", Exit, OutOfRange);
+  }
+
+  src = tmap_seq_get_bases(seq);
+  is_int = tmap_seq_is_int(seq);
+  len = src->l;
+  if(0 < max_length && max_length < len) len = max_length; // NB: from the start of the sequence
+
+  // reuse the memory from previous calls
+  dst = view->data.fq->seq;
+  if(dst->m < len + 1) {
+      dst->m = len + 1;
+      tmap_roundup32(dst->m);
+      dst->s = tmap_realloc(dst->s, sizeof(char) * dst->m, "dst->s");
+  }
+  dst->l = len;
+  dst->s[len] = '\0';
+  view->data.fq->is_int = 1;
+
+  // copy, converting to integers and changing strands in one pass
+  s = (uint8_t*)dst->s;
+  for(i=0;i<len;i++) {
+      uint8_t b = (1 == is_int) ? (uint8_t)src->s[i] : tmap_nt_char_to_int[(int)src->s[i]];
+      switch(strand) {
+        case 0: // forward
+          s[i] = b; break;
+        case 1: // reverse compliment
+          s[len-i-1] = (4 <= b) ? b : 3 - b; break;
+        case 2: // reverse
+          s[len-i-1] = b; break;
+        case 3: // compliment
+          s[i] = (4 <= b) ? b : 3 - b; break;
+        default:
+          tmap_error("unknown strand", Exit, OutOfRange);
+          break;
+      }
+  }
+
+  return view;
+}
@@ -170,6 +170,13 @@ tmap_seq_get_key_seq_int(tmap_seq_t *seq, uint8_t **key_seq);
 int32_t
 tmap_seq_get_flowgram(tmap_seq_t *seq, uint16_t **flowgram, int32_t mem);
 
+/*!
+  @param  seq      pointer to the structure 
+  @return          the memory, in bytes, held by the structure, including its flowgram
+ */
+size_t
+tmap_seq_get_mem(tmap_seq_t *seq);
+
 /*!
   @param  seq      pointer to the structure 
   @return          the flowgram start index
@@ -184,4 +191,17 @@ tmap_seq_get_flow_start_index(tmap_seq_t *seq);
 char*
 tmap_seq_get_rg_id(tmap_seq_t *seq);
 
+/*!
+  Fills a lightweight view of one strand of the bases of a sequence
+  @param  view        the view to fill, NULL to create a new view
+  @param  seq         the sequence 
+  @param  strand      0 for forward, 1 for reverse compliment, 2 for reverse, 3 for compliment
+  @param  max_length  the number of leading bases of the sequence to use, or less than one to use all bases
+  @return             the view
+  @details            the view is a FASTQ sequence holding only the bases in integer format;
+  its memory is reused across calls, so views should be kept rather than destroyed per sequence
+  */
+tmap_seq_t *
+tmap_seq_view(tmap_seq_t *view, tmap_seq_t *seq, int32_t strand, int32_t max_length);
+
 #endif
@@ -14,6 +14,8 @@
 #include "../util/tmap_progress.h"
 #include "../index/tmap_refseq.h"
 #include "../index/tmap_bwt.h"
+#include "../index/tmap_bwt_kmer.h"
+#include "../index/tmap_seed_hash.h"
 #include "../index/tmap_sa.h"
 #include "tmap_shm.h"
 #include "tmap_server.h"
@@ -50,6 +52,8 @@ tmap_server_start(char *fn_fasta, key_t key, uint32_t listing)
   tmap_refseq_t *refseq = NULL;
   tmap_bwt_t *bwt = NULL;
   tmap_sa_t *sa = NULL;
+  tmap_bwt_kmer_t *kmer = NULL;
+  tmap_seed_hash_t *seed = NULL;
   uint8_t *buf = NULL;
   size_t n_bytes = 0, cur_bytes = 0;
   uint32_t cur_listing = 0;
@@ -67,6 +71,12 @@ tmap_server_start(char *fn_fasta, key_t key, uint32_t listing)
   if(listing & TMAP_SHM_LISTING_SA) {
       n_bytes += tmap_sa_shm_read_num_bytes(fn_fasta);
   }
+  if(listing & TMAP_SHM_LISTING_KMER) {
+      n_bytes += tmap_bwt_kmer_shm_read_num_bytes(fn_fasta);
+  }
+  if(listing & TMAP_SHM_LISTING_SEED) {
+      n_bytes += tmap_seed_hash_shm_read_num_bytes(fn_fasta);
+  }
 
   // get shared memory
   tmap_progress_print("retrieving shared memory [%llu bytes]", (long long unsigned int)n_bytes);
@@ -116,6 +126,30 @@ tmap_server_start(char *fn_fasta, key_t key, uint32_t listing)
       tmap_sa_destroy(sa);
   } 
 
+  // pack the k-mer table
+  cur_listing = TMAP_SHM_LISTING_KMER;
+  if(listing & cur_listing) {
+      tmap_progress_print("packing the k-mer table");
+      kmer = tmap_bwt_kmer_read(fn_fasta);
+      cur_bytes = tmap_bwt_kmer_shm_num_bytes(kmer);
+      tmap_bwt_kmer_shm_pack(kmer, buf);
+      tmap_shm_add_listing(shm, cur_listing, cur_bytes); 
+      buf += cur_bytes;
+      tmap_bwt_kmer_destroy(kmer);
+  } 
+
+  // pack the seed hash
+  cur_listing = TMAP_SHM_LISTING_SEED;
+  if(listing & cur_listing) {
+      tmap_progress_print("packing the seed hash");
+      seed = tmap_seed_hash_read(fn_fasta);
+      cur_bytes = tmap_seed_hash_shm_num_bytes(seed);
+      tmap_seed_hash_shm_pack(seed, buf);
+      tmap_shm_add_listing(shm, cur_listing, cur_bytes); 
+      buf += cur_bytes;
+      tmap_seed_hash_destroy(seed);
+  } 
+
   tmap_progress_print2("shared memory packed");
 
   // set as ready
@@ -183,10 +217,12 @@ usage()
   tmap_file_fprintf(tmap_file_stderr, "         -f FILE     the FASTA reference file name\n");
   tmap_file_fprintf(tmap_file_stderr, "         -c STRING   server command [start|stop|kill]\n");
   tmap_file_fprintf(tmap_file_stderr, "         -k INT      the server key\n");
-  tmap_file_fprintf(tmap_file_stderr, "         -a          load all\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -a          load all, including the k-mer table and seed hash if they exist\n");
   tmap_file_fprintf(tmap_file_stderr, "         -r          load the packed reference\n");
   tmap_file_fprintf(tmap_file_stderr, "         -b          load the bwt\n");
   tmap_file_fprintf(tmap_file_stderr, "         -s          load the SA\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -m          load the k-mer table\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -e          load the seed hash\n");
   tmap_file_fprintf(tmap_file_stderr, "         -v          print verbose progress information\n");
   tmap_file_fprintf(tmap_file_stderr, "         -h          print this message\n");
   tmap_file_fprintf(tmap_file_stderr, "\n");
@@ -209,13 +245,15 @@ tmap_server_main(int argc, char *argv[])
   char *fn_fasta=NULL;
   key_t key=13;
   uint32_t listing = 0;
+  int32_t all = 0;
 
-  while((c = getopt(argc, argv, "f:c:k:arbsvh")) >= 0) {
+  while((c = getopt(argc, argv, "f:c:k:arbsmevh")) >= 0) {
       switch(c) {
         case 'a':
           listing |= TMAP_SHM_LISTING_REFSEQ;
           listing |= TMAP_SHM_LISTING_BWT;
           listing |= TMAP_SHM_LISTING_SA;
+          all = 1;
           break;
         case 'f':
           fn_fasta = tmap_strdup(optarg); break;
@@ -229,6 +267,10 @@ tmap_server_main(int argc, char *argv[])
           listing |= TMAP_SHM_LISTING_BWT; break;
         case 's':
           listing |= TMAP_SHM_LISTING_SA; break;
+        case 'm':
+          listing |= TMAP_SHM_LISTING_KMER; break;
+        case 'e':
+          listing |= TMAP_SHM_LISTING_SEED; break;
         case 'v': 
           tmap_progress_set_verbosity(1); break;
         case 'h': 
@@ -244,6 +286,12 @@ tmap_server_main(int argc, char *argv[])
   if(TMAP_SERVER_START == cmd && 0 == listing) {
       tmap_error("no data structures to load", Exit, CommandLineArgument);
   }
+  if(1 == all && NULL != fn_fasta && 1 == tmap_bwt_kmer_exists(fn_fasta)) {
+      listing |= TMAP_SHM_LISTING_KMER;
+  }
+  if(1 == all && NULL != fn_fasta && 1 == tmap_seed_hash_exists(fn_fasta)) {
+      listing |= TMAP_SHM_LISTING_SEED;
+  }
 
   switch(cmd) {
     case TMAP_SERVER_START:
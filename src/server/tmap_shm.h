@@ -27,6 +27,8 @@ enum {
     TMAP_SHM_LISTING_REFSEQ     = 0x1, /*!< the forward packed reference sequence  */
     TMAP_SHM_LISTING_BWT        = 0x2, /*!< the BWT string */
     TMAP_SHM_LISTING_SA         = 0x4, /*!< the SA string */
+    TMAP_SHM_LISTING_KMER       = 0x8, /*!< the k-mer prefix table of the BWT */
+    TMAP_SHM_LISTING_SEED       = 0x10, /*!< the seed hash of the reference sequence */
 };
 
 /*! 
@@ -57,8 +57,6 @@ AffineSWOptimization::AffineSWOptimization(int type) {
 #else
     hash = NULL;
 #endif
-    a.reserve(512);
-    b.reserve(1024);
 }
 
 int AffineSWOptimization::process(const uint8_t *target, int32_t tlen,
@@ -66,6 +64,7 @@ int AffineSWOptimization::process(const uint8_t *target, int32_t tlen,
                                   int qsc, int qec,
                                   int mm, int mi, int o, int e, int dir,
                                   int *opt, int *te, int *qe, int *n_best) {
+#ifdef AFFINESWOPTIMIZATION_USE_HASH
     int i;
     // resize
     b.resize(tlen);
@@ -73,7 +72,6 @@ int AffineSWOptimization::process(const uint8_t *target, int32_t tlen,
     // copy
     for(i=0;i<tlen;i++) b[i] = "ACGTN"[target[i]];
     for(i=0;i<qlen;i++) a[i] = "ACGTN"[query[i]];
-#ifdef AFFINESWOPTIMIZATION_USE_HASH
     // try the hash
     if(!hash->process(b, a, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best)) {
         s->process(b, a, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best);
@@ -82,10 +80,16 @@ int AffineSWOptimization::process(const uint8_t *target, int32_t tlen,
     }
     return (*opt);
 #else
-    return s->process(b, a, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best);
+    return s->processCodes(target, tlen, query, qlen, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best);
 #endif
 }
 
+void AffineSWOptimization::setQuery(const uint8_t *query, int32_t qlen,
+                                    int qsc, int qec,
+                                    int mm, int mi, int o, int e) {
+    s->setQuery(query, qlen, qsc, qec, mm, mi, o, e);
+}
+
 AffineSWOptimization::~AffineSWOptimization()
 {
 #ifdef AFFINESWOPTIMIZATION_USE_HASH
@@ -24,6 +24,10 @@ public:
               int mm, int mi, int o, int e, int dir,
               int *opt, int *te, int *qe, int *n_best);
 
+  void setQuery(const uint8_t *query, int32_t qlen,
+                int qsc, int qec,
+                int mm, int mi, int o, int e);
+
   ~AffineSWOptimization();
 
   int getMaxQlen() { return s->getMaxQlen(); }
@@ -32,6 +36,8 @@ private:
   int myType;
   Solution *s;
   AffineSWOptimizationHash *hash;
+#ifdef AFFINESWOPTIMIZATION_USE_HASH
   string a, b;
+#endif
 };
 #endif
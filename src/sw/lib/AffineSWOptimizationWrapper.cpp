@@ -5,6 +5,7 @@
 #include <iostream>
 #include "AffineSWOptimization.h"
 #include "AffineSWOptimizationWrapper.h"
+#include "vsw16.h"
 
 using namespace std;
 
@@ -49,6 +50,15 @@ tmap_vsw_wrapper_process(tmap_vsw_wrapper_t *v,
   return v->process(target, tlen, query, qlen, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best);
 }
 
+void
+tmap_vsw_wrapper_set_query(tmap_vsw_wrapper_t *v,
+                           const uint8_t *query, int32_t qlen,
+                           int mm, int mi, int o, int e,
+                           int qsc, int qec)
+{
+  v->setQuery(query, qlen, qsc, qec, mm, mi, o, e);
+}
+
 void
 tmap_vsw_wrapper_destroy(tmap_vsw_wrapper_t *v)
 {
@@ -67,3 +77,27 @@ tmap_vsw_wrapper_get_max_tlen(tmap_vsw_wrapper_t *v)
 {
   return v->getMaxTlen();
 }
+
+int32_t
+tmap_vsw_wrapper_simd_supported(int32_t simd)
+{
+  return vsw16_simd_supported(simd);
+}
+
+int32_t
+tmap_vsw_wrapper_simd_get()
+{
+  return vsw16_simd_get();
+}
+
+void
+tmap_vsw_wrapper_simd_set(int32_t simd)
+{
+  vsw16_simd_set(simd);
+}
+
+const char *
+tmap_vsw_wrapper_simd_name(int32_t simd)
+{
+  return vsw16_simd_name(simd);
+}
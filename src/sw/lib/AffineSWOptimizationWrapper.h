@@ -18,6 +18,14 @@ extern "C" {
                                int32_t qsc, int32_t qec,
                                int32_t *opt, int32_t *target_end, int32_t *query_start, int32_t *n_best);
 
+    /* prepares for aligning the query, keeping its query profile for the calls
+     * to tmap_vsw_wrapper_process with the same query */
+    void
+      tmap_vsw_wrapper_set_query(tmap_vsw_wrapper_t *v,
+                                 const uint8_t *query, int32_t qlen,
+                                 int32_t mm, int32_t mi, int32_t o, int32_t e,
+                                 int32_t qsc, int32_t qec);
+
     void
       tmap_vsw_wrapper_destroy(tmap_vsw_wrapper_t *v);
 
@@ -26,6 +34,24 @@ extern "C" {
     
     int
       tmap_vsw_wrapper_get_max_tlen(tmap_vsw_wrapper_t *v);
+
+    /* the SIMD instruction sets of the striped vectorized algorithm (type 1), as in vsw16.h */
+#define TMAP_VSW_SIMD_SSE2 0
+#define TMAP_VSW_SIMD_AVX2 1
+#define TMAP_VSW_SIMD_AVX512BW 2
+#define TMAP_VSW_SIMD_NUM 3
+
+    int32_t
+      tmap_vsw_wrapper_simd_supported(int32_t simd);
+
+    int32_t
+      tmap_vsw_wrapper_simd_get();
+
+    void
+      tmap_vsw_wrapper_simd_set(int32_t simd);
+
+    const char *
+      tmap_vsw_wrapper_simd_name(int32_t simd);
 #ifdef __cplusplus 
 }
 #endif
@@ -5,9 +5,29 @@ using namespace std;
 
 
 Solution::Solution() {
-    // dummy ctor
+    a.reserve(512);
+    b.reserve(1024);
 }
 
 Solution::~Solution() {
     // dummy dtor
 }
+
+int Solution::processCodes(const uint8_t *target, int32_t tlen,
+                           const uint8_t *query, int32_t qlen, int qsc, int qec,
+                           int mm, int mi, int o, int e, int dir,
+                           int *opt, int *te, int *qe, int *n_best) {
+    int i;
+    // resize
+    b.resize(tlen);
+    a.resize(qlen);
+    // copy
+    for(i=0;i<tlen;i++) b[i] = "ACGTN"[target[i]];
+    for(i=0;i<qlen;i++) a[i] = "ACGTN"[query[i]];
+    return process(b, a, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best);
+}
+
+void Solution::setQuery(const uint8_t *query, int32_t qlen, int qsc, int qec,
+                        int mm, int mi, int o, int e) {
+    // nothing to prepare
+}
@@ -7,6 +7,7 @@
 
 #include <cstring>
 #include <sstream>
+#include <stdint.h>
 
 using namespace std;
 
@@ -18,6 +19,18 @@ public:
                  int mm, int mi, int o, int e, int dir,
                  int *opt, int *te, int *qe, int *n_best) = 0;
 
+  // the same as process for the 0-4 encoded target and query; by default
+  // they are converted to "ACGTN" strings for process
+  virtual int processCodes(const uint8_t *target, int32_t tlen,
+                 const uint8_t *query, int32_t qlen, int qsc, int qec,
+                 int mm, int mi, int o, int e, int dir,
+                 int *opt, int *te, int *qe, int *n_best);
+
+  // prepares for aligning the 0-4 encoded query, so that its query profile
+  // is kept for the calls that follow with the same query (by default nothing)
+  virtual void setQuery(const uint8_t *query, int32_t qlen, int qsc, int qec,
+                 int mm, int mi, int o, int e);
+
   virtual ~Solution();
 
   int getMaxQlen() { return max_qlen; }
@@ -26,6 +39,7 @@ public:
 protected:
   int max_qlen;
   int max_tlen;
+  string a, b; // the strings for the default processCodes
 };
 
 #endif
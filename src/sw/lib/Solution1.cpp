@@ -1,11 +1,13 @@
 #include <cstring>
 #include <sstream>
+#include <vector>
 #include <stdint.h>
 #include <limits.h>
 #include "../../util/tmap_alloc.h"
 #include "../../util/tmap_definitions.h"
 #include "vsw16.h"
 #include "vsw.h"
+#include "vsw8.h"
 #include "vsw16.h"
 #include "Solution1.h"
 
@@ -40,16 +42,17 @@ Solution1::Solution1() {
     // dummy ctor
     vsw_opt = NULL;
     vsw_query = NULL;
-    target = query = NULL;
-    target_len = query_len = 0;
-    q_max = t_max = 0;
+    query = NULL;
+    query_len = 0;
+    q_max = 0;
+    query_qsc = query_qec = query_simd = -1;
+    query16_set = 0;
     max_qlen = INT_MAX;
     max_tlen = INT_MAX;
 }
 
 Solution1::~Solution1() {
     free(query);
-    free(target);
     vsw_opt_destroy(vsw_opt);
     vsw_opt = NULL;
     if(NULL != vsw_query) vsw_query_destroy(vsw_query);
@@ -59,47 +62,84 @@ Solution1::~Solution1() {
 int Solution1::process(const string& b, const string& a, int qsc, int qec,
                                      int mm, int mi, int o, int e, int dir,
                                      int *_opt, int *_te, int *_qe, int *_n_best) {
-    int i, score;
+    int i;
     int n = b.size(), m = a.size();
-    int16_t query_end, target_end;
-    int32_t overflow, n_best;
+    vector<uint8_t> target(n + 1), _query(m + 1); // NB: never empty
+    for(i=0;i<n;i++) {
+        target[i] = nt_char_to_int[(int)b[i]];
+    }
+    for(i=0;i<m;i++) {
+        _query[i] = nt_char_to_int[(int)a[i]];
+    }
+    return processCodes(&target[0], n, &_query[0], m, qsc, qec, mm, mi, o, e, dir, _opt, _te, _qe, _n_best);
+}
+
+void Solution1::setQuery(const uint8_t *_query, int32_t qlen, int qsc, int qec,
+                         int mm, int mi, int o, int e) {
+    int32_t simd;
     // set opt
     if(NULL == vsw_opt) vsw_opt = vsw_opt_init(mm, -mi, -o, -e, SCORE_THR); // NB: mm/mi/o/e are fixed
+    // keep the query profiles if nothing changed
+    simd = vsw16_simd_get();
+    if(NULL != vsw_query && query_len == qlen && query_qsc == qsc && query_qec == qec && query_simd == simd
+       && 0 == memcmp(query, _query, sizeof(uint8_t) * qlen)) {
+        return;
+    }
     // set query
-    if(0 == query_cmp(a, m, query, query_len)) {
-        query_len = m;
-        if(q_max < query_len) {
-            q_max = query_len;
-            tmap_roundup32(q_max);
-            query = (uint8_t*)tmap_realloc(query, sizeof(uint8_t) * q_max, "query");
-        }
-        for(i=0;i<m;i++) {
-            query[i] = nt_char_to_int[(int)a[i]];
-        }
-        if(NULL != vsw_query) vsw_query_destroy(vsw_query);
+    query_len = qlen;
+    if(q_max < query_len) {
+        q_max = query_len;
+        tmap_roundup32(q_max);
+        query = (uint8_t*)tmap_realloc(query, sizeof(uint8_t) * q_max, "query");
+    }
+    memcpy(query, _query, sizeof(uint8_t) * qlen);
+    query_qsc = qsc;
+    query_qec = qec;
+    query_simd = simd;
+    // the 8-bit query profile, the 16-bit one when it is first needed
+    if(NULL == vsw_query) {
         vsw_query = vsw_query_init(query, query_len, query_len, qsc, qec, vsw_opt); 
+        query16_set = 1;
     }
+    else {
+        vsw_query->query8 = vsw8_query_init(vsw_query->query8, query, query_len, qsc, qec, vsw_opt);
+        vsw_query->query = query;
+        vsw_query->qlen = query_len;
+        query16_set = 0;
+    }
+}
 
-    // reset query
-    vsw_query->query16 = vsw16_query_init(vsw_query->query16, query, query_len, qsc, qec, vsw_opt);
+void Solution1::setQuery16() {
+    if(1 == query16_set) return;
+    vsw_query->query16 = vsw16_query_init(vsw_query->query16, query, query_len, query_qsc, query_qec, vsw_opt);
+    query16_set = 1;
+}
 
-    // set target
-    target_len = n;
-    if(t_max < target_len) {
-        t_max = target_len;
-        tmap_roundup32(t_max);
-        target = (uint8_t*)tmap_realloc(target, sizeof(uint8_t) * t_max, "target");
-    }
-    for(i=0;i<(int)target_len;i++) {
-        target[i] = nt_char_to_int[(int)b[i]];
-    }
+int Solution1::processCodes(const uint8_t *target, int32_t tlen,
+                            const uint8_t *_query, int32_t qlen, int qsc, int qec,
+                            int mm, int mi, int o, int e, int dir,
+                            int *_opt, int *_te, int *_qe, int *_n_best) {
+    int score;
+    int16_t query_end, target_end;
+    int32_t overflow, n_best;
+
+    // set the query profiles
+    setQuery(_query, qlen, qsc, qec, mm, mi, o, e);
 
-    // run SW
+    // run SW, first with 8-bit values
     overflow = 0;
-    score = vsw16_sse2_forward(vsw_query->query16, target, target_len,
-                               qsc, qec,
-                               vsw_opt, &query_end, &target_end,
-                               dir, &overflow, &n_best, SCORE_THR);
+    score = vsw8_forward(vsw_query->query8, target, tlen,
+                         qsc, qec,
+                         vsw_opt, &query_end, &target_end,
+                         dir, &overflow, &n_best, SCORE_THR);
+    if(1 == overflow) { // re-run with 16-bit values
+        setQuery16();
+        overflow = 0;
+        score = vsw16_forward(vsw_query->query16, target, tlen,
+                              qsc, qec,
+                              vsw_opt, &query_end, &target_end,
+                              dir, &overflow, &n_best, SCORE_THR);
+    }
 
     // return results
     (*_opt) = score;
@@ -109,22 +149,3 @@ int Solution1::process(const string& b, const string& a, int qsc, int qec,
     //fprintf(stderr, "%s SCORE=%d %d %d %d %d\n", __func__, score, target_end, query_end, n_best, overflow);
     return score;
 }
-
-/*
-   vsw_opt_t *vsw_opt = NULL;
-   vsw_query_t* vsw_query = NULL;
-   uint8_t query[Q_MAX];
-   uint32_t query_len = 0;
-   uint8_t target[T_MAX];
-   uint32_t target_len = 0;
-   */
-
-int32_t Solution1::query_cmp(string q, int n, uint8_t *query, int32_t query_len) {
-    int i;
-    if(NULL == query) return 0;
-    if(query_len != n) return 0;
-    for(i=0;i<n;i++) {
-        if(q[i] != "ACGTN"[query[i]]) return 0;
-    }
-    return 1;
-}
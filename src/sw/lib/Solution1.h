@@ -23,14 +23,22 @@ public:
                  int mm, int mi, int o, int e, int dir,
                  int *opt, int *te, int *qe, int *n_best);
 
-  int32_t query_cmp(string q, int n, uint8_t *query, int32_t query_len);
+  virtual int processCodes(const uint8_t *target, int32_t tlen,
+                 const uint8_t *query, int32_t qlen, int qsc, int qec,
+                 int mm, int mi, int o, int e, int dir,
+                 int *opt, int *te, int *qe, int *n_best);
+
+  virtual void setQuery(const uint8_t *query, int32_t qlen, int qsc, int qec,
+                 int mm, int mi, int o, int e);
+
 private:
-  int32_t q_max, t_max;
+  void setQuery16();
+  int32_t q_max;
   vsw_opt_t *vsw_opt;
   vsw_query_t* vsw_query;
   uint8_t *query;
   int32_t query_len;
-  uint8_t *target;
-  int32_t target_len;
+  int32_t query_qsc, query_qec, query_simd; // the query profiles were made with these
+  int32_t query16_set; // 1 if the 16-bit query profile is for the query, 0 otherwise
 };
 #endif
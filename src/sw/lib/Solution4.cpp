@@ -143,7 +143,7 @@ void show16(const __m128i &m) {
 }
 */
 
-NOINLINE uint64_t Solution4::hashDNA(const string &s, const int len) {
+NOINLINE uint64_t Solution4::hashDNA(const uint8_t *s, const int len) {
     uint64_t h = 1;
     if (len < 16) {
         REP(j, len) h = h * 1337 + s[j];
@@ -301,7 +301,7 @@ template <class T, int DEFAULT_VALUE> INLINE void Solution4::updateResultLast()
     }
 }
 
-template <int qec> NOINLINE void Solution4::processFastVariantB16BitA(const string &a, int mm, int mi, int o, int e) {
+template <int qec> NOINLINE void Solution4::processFastVariantB16BitA(const uint8_t *a, int mm, int mi, int o, int e) {
 
     __m128i mo = _mm_set1_epi16(o + e);
     __m128i me = _mm_set1_epi16(e);
@@ -394,7 +394,7 @@ outB11:
 
 }
 
-template <int qec> NOINLINE void Solution4::processFastVariantB16BitB(const string &a, int mm, int mi, int o, int e) {
+template <int qec> NOINLINE void Solution4::processFastVariantB16BitB(const uint8_t *a, int mm, int mi, int o, int e) {
 
     __m128i mo = _mm_set1_epi16(o + e);
     __m128i me = _mm_set1_epi16(e);
@@ -566,7 +566,7 @@ outB22:
 
 }
 
-template <int qec> NOINLINE void Solution4::processFastVariantA16Bit(const string &a, int mm, int mi, int o, int e, int iter) {
+template <int qec> NOINLINE void Solution4::processFastVariantA16Bit(const uint8_t *a, int mm, int mi, int o, int e, int iter) {
     __m128i mo = _mm_set1_epi16(o + e);
     __m128i me = _mm_set1_epi16(e);
     __m128i mmin = _mm_set1_epi16(MIN_VAL);
@@ -668,7 +668,7 @@ outA16:
 
 }
 
-template <int qec> NOINLINE int Solution4::processFastVariantA8Bit(const string &a, const int mm, const int mi, const int o, const int e) {
+template <int qec> NOINLINE int Solution4::processFastVariantA8Bit(const uint8_t *a, const int mm, const int mi, const int o, const int e) {
     const __m128i mo = _mm_set1_epi8(-(o + e));
     const __m128i me = _mm_set1_epi8(-e);
     const __m128i m1 = _mm_set1_epi8(1);
@@ -925,7 +925,7 @@ template <class T, int SIZE> NOINLINE  void Solution4::calcInvalidPos(int value)
     }
 }
 
-NOINLINE void Solution4::convert16Bit(const string &b, int qsc, int mm, int mi) {
+NOINLINE void Solution4::convert16Bit(const uint8_t *b, int qsc, int mm, int mi) {
 
     segNo *= 2;
     int len64 = len;
@@ -957,11 +957,11 @@ NOINLINE void Solution4::convert16Bit(const string &b, int qsc, int mm, int mi)
         mPos = _mm_add_epi16(mPos, mOne);
     }
 
-    const int16_t SCHAR[4] = {'A', 'C', 'G', 'T'};
+    const int16_t SCHAR[4] = {0, 1, 2, 3};
     __m128i mmul = _mm_set1_epi16(mm - mi);
     __m128i madd = _mm_set1_epi16(mi);
     REP(i, len) {
-        if(n <= POS[i]) STARG[i] = 0;
+        if(POS[i] < 0 || n <= POS[i]) STARG[i] = 4; // N, never a match (NB: 16-bit positions wrap for long targets)
         else STARG[i] = b[POS[i]];
     }
     REP(c, 4) {
@@ -980,7 +980,7 @@ NOINLINE void Solution4::convert16Bit(const string &b, int qsc, int mm, int mi)
 
 }
 
-NOINLINE void Solution4::preprocess16Bit(const string &b, int qsc, int mm, int mi) {
+NOINLINE void Solution4::preprocess16Bit(const uint8_t *b, int qsc, int mm, int mi) {
     segNo = (n + 7) / 8;
     len = segNo * 8;
     int len64 = len;
@@ -1004,11 +1004,11 @@ NOINLINE void Solution4::preprocess16Bit(const string &b, int qsc, int mm, int m
             mPos = _mm_add_epi16(mPos, mOne);
         }
 
-        const int16_t SCHAR[4] = {'A', 'C', 'G', 'T'};
+        const int16_t SCHAR[4] = {0, 1, 2, 3};
         __m128i mmul = _mm_set1_epi16(mm - mi);
         __m128i madd = _mm_set1_epi16(mi);
         REP(i, len) {
-            if(n <= POS[i]) STARG[i] = 0;
+            if(POS[i] < 0 || n <= POS[i]) STARG[i] = 4; // N, never a match (NB: 16-bit positions wrap for long targets)
             else STARG[i] = b[POS[i]];
         }
         REP(c, 4) {
@@ -1027,7 +1027,7 @@ NOINLINE void Solution4::preprocess16Bit(const string &b, int qsc, int mm, int m
     calcInvalidPos<int16_t*, 8>(mi);        
 }
 
-void Solution4::preprocess8Bit(const string &b, int qsc, int mm, int mi) {
+void Solution4::preprocess8Bit(const uint8_t *b, int qsc, int mm, int mi) {
     segNo = (n + 15) / 16;
     len = segNo * 16;
     int len64 = len / 2;
@@ -1054,10 +1054,10 @@ void Solution4::preprocess8Bit(const string &b, int qsc, int mm, int mi) {
             mPos1 = _mm_add_epi16(mPos1, mOne);
         }
 
-        const int8_t SCHAR[4] = {'A', 'C', 'G', 'T'};
+        const int8_t SCHAR[4] = {0, 1, 2, 3};
         __m128i mmul = _mm_set1_epi8(mm - mi);
         REP(i, len) {
-            if(n <= POS[i]) STARG[i] = 0;
+            if(POS[i] < 0 || n <= POS[i]) STARG[i] = 4; // N, never a match (NB: 16-bit positions wrap for long targets)
             else STARG[i] = b[POS[i]];
         }
         REP(c, 4) {
@@ -1078,9 +1078,17 @@ void Solution4::preprocess8Bit(const string &b, int qsc, int mm, int mi) {
 NOINLINE int Solution4::process(const string &b, const string &a, int qsc, int qec, 
                                 int mm, int mi, int o, int e, int dir,
                                 int *_opt, int *_te, int *_qe, int *_n_best) {
-    string _a = a;
-    n = b.S;
-    m = _a.S;
+    vector<uint8_t> target(b.S + 1), query(a.S + 1); // NB: never empty
+    REP(i, (int)b.S) target[i] = tmap_nt_char_to_int[(int)b[i]];
+    REP(i, (int)a.S) query[i] = tmap_nt_char_to_int[(int)a[i]];
+    return processCodes(&target[0], b.S, &query[0], a.S, qsc, qec, mm, mi, o, e, dir, _opt, _te, _qe, _n_best);
+}
+
+NOINLINE int Solution4::processCodes(const uint8_t *b, int32_t tlen, const uint8_t *_a, int32_t qlen, int qsc, int qec, 
+                                     int mm, int mi, int o, int e, int dir,
+                                     int *_opt, int *_te, int *_qe, int *_n_best) {
+    n = tlen;
+    m = qlen;
 
     resize(m, n);
 
@@ -1135,9 +1143,6 @@ next: ;
     }
 #endif
 
-    // To integers
-    REP(i, m) _a[i] = tmap_nt_char_to_int[(int)_a[i]];
-
     opt = MIN_VAL;
     lastMax = MIN_VAL;
 
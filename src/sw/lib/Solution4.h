@@ -27,6 +27,11 @@ public:
   virtual int process(const string& b, const string& a, int qsc, int qec, 
                       int mm, int mi, int o, int e, int dir,
                       int *opt, int *te, int *qe, int *n_best);
+
+  virtual int processCodes(const uint8_t *target, int32_t tlen,
+                      const uint8_t *query, int32_t qlen, int qsc, int qec,
+                      int mm, int mi, int o, int e, int dir,
+                      int *opt, int *te, int *qe, int *n_best);
 private:
   int MAX_DIMA;
   int MAX_DIMB;
@@ -42,7 +47,7 @@ private:
   __m128i* M1;
   __m128i* V;
   int16_t* POS;
-  int16_t INVALID_POS[16];
+  int32_t INVALID_POS[16];
   int INVALID_POS_NO;
   int lastMax;
   int opt, n_best;
@@ -55,19 +60,19 @@ private:
   int16_t findMax16(const __m128i &mMax);
   int16_t findMax16Simple(const __m128i &mMax);
   uint8_t findMax8(const __m128i &mMax);
-  uint64_t hashDNA(const string &s, const int len);
+  uint64_t hashDNA(const uint8_t *s, const int len);
   int resize(int a, int b);
   template <class T, bool BYTE> void updateResult(int i, int curMax);
   template <class T, int DEFAULT_VALUE> void updateResultLast();
-  template <int qec> void processFastVariantB16BitA(const string &a, int mm, int mi, int o, int e);
-  template <int qec> void processFastVariantB16BitB(const string &a, int mm, int mi, int o, int e);
-  template <int qec> void processFastVariantA16Bit(const string &a, int mm, int mi, int o, int e, int iter);
-  template <int qec> int processFastVariantA8Bit(const string &a, const int mm, const int mi, const int o, const int e);
+  template <int qec> void processFastVariantB16BitA(const uint8_t *a, int mm, int mi, int o, int e);
+  template <int qec> void processFastVariantB16BitB(const uint8_t *a, int mm, int mi, int o, int e);
+  template <int qec> void processFastVariantA16Bit(const uint8_t *a, int mm, int mi, int o, int e, int iter);
+  template <int qec> int processFastVariantA8Bit(const uint8_t *a, const int mm, const int mi, const int o, const int e);
   void convertTable(__m128i *T0, __m128i *T1);
   template <class T, int SIZE> void calcInvalidPos(int value);
-  void convert16Bit(const string &b, int qsc, int mm, int mi);
-  void preprocess16Bit(const string &b, int qsc, int mm, int mi);
-  void preprocess8Bit(const string &b, int qsc, int mm, int mi);
+  void convert16Bit(const uint8_t *b, int qsc, int mm, int mi);
+  void preprocess16Bit(const uint8_t *b, int qsc, int mm, int mi);
+  void preprocess8Bit(const uint8_t *b, int qsc, int mm, int mi);
 };
 
 #endif
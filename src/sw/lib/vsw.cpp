@@ -30,6 +30,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
+#include "vsw8.h"
 #include "vsw16.h"
 #include "vsw.h"
 
@@ -62,6 +63,7 @@ vsw_query_init(const uint8_t *query, int32_t qlen,
 {
   vsw_query_t *vsw_query;
   vsw_query = (vsw_query_t*)calloc(1, sizeof(vsw_query_t));
+  vsw_query->query8 = vsw8_query_init(vsw_query->query8, query, qlen, query_start_clip, query_end_clip, opt);
   vsw_query->query16 = vsw16_query_init(vsw_query->query16, query, qlen, query_start_clip, query_end_clip, opt);
   // TMP
   vsw_query->query = query;
@@ -73,6 +75,7 @@ void
 vsw_query_destroy(vsw_query_t *query)
 {
   if(NULL == query) return;
+  if(NULL != query->query8) vsw8_query_destroy(query->query8);
   if(NULL != query->query16) vsw16_query_destroy(query->query16);
   free(query);
 }
@@ -38,6 +38,8 @@
 
 // Gives the # of bytes to align the memory in 16-byte increments
 #define __vsw_16(_val) (((_val) + 15) >> 4 << 4)
+// Gives the # of bytes to align the memory in 64-byte increments
+#define __vsw_64(_val) (((_val) + 63) >> 6 << 6)
 
 /** Global SIMD macros **/
 #define __vsw_mm_store_si128(_dest, _val) _mm_store_si128(_dest, _val)
@@ -107,6 +109,13 @@ typedef int16_t vsw16_int_t;
 #define __vsw16_get_query_profile_value(_query, _base, _j) \
   (((vsw16_int_t*)((_query)->query_profile + (_base * (_query)->slen) + ((_j) % (_query)->slen)))[(_j) / (_query)->slen])
 
+/** VSW MM 8-bit mode (16 values per 128)  **/
+#define vsw8_values_per_128_bits 16
+#define vsw8_values_per_128_bits_log2 4 // should be log2(values_per_128_bits)
+#define vsw8_max_value INT8_MAX
+#define vsw8_min_value INT8_MIN 
+typedef int8_t vsw8_int_t;
+
 /** Auxiliary functions **/
 // returns the amount of memory the stripes will occupy  (align the memory by 16 bytes)
 #define __vsw_calc_qlen_mem(_slen) __vsw_16((_slen) << 4) // divide by 16, since there 16 bytes per 128
@@ -135,12 +144,19 @@ typedef struct {
     __m128i *H1; /*!< H/H' */
     __m128i *E; /*!< deletion from the query, insertion into the target */
     int32_t qlen_max; /*!< the maximum query size */
+    int32_t simd; /*!< the SIMD instruction set of the stripes (VSW16_SIMD_*) */
 } vsw16_query_t;
 
+/*!
+  The parameter and memory for the 8-bit vectorized alignment, with one byte per value.
+ */
+typedef vsw16_query_t vsw8_query_t;
+
 /*!
   Wrapper for the query memory.
  */
 typedef struct {
+    vsw8_query_t *query8; /*!< the query memory for 8-bit values */
     vsw16_query_t *query16; /*!< the query memory */
     const uint8_t *query; // TMP
     uint32_t qlen; // TMP
@@ -35,21 +35,86 @@
 
 // TODO: remove query profile so it does not need to be filled in each time
 
+// the SIMD instruction set used for new queries, -1 if not yet chosen
+static int32_t vsw16_simd = -1;
+
+int32_t
+vsw16_simd_supported(int32_t simd)
+{
+  switch(simd) {
+    case VSW16_SIMD_SSE2:
+      return 1;
+#ifdef VSW16_SIMD_AVX
+    case VSW16_SIMD_AVX2:
+      __builtin_cpu_init();
+      return (__builtin_cpu_supports("avx2")) ? 1 : 0;
+    case VSW16_SIMD_AVX512BW:
+      __builtin_cpu_init();
+      return (__builtin_cpu_supports("avx512bw")) ? 1 : 0;
+#endif
+    default:
+      break;
+  }
+  return 0;
+}
+
+int32_t
+vsw16_simd_get()
+{
+  int32_t simd;
+  if(vsw16_simd < 0) { // choose the widest supported
+      for(simd = VSW16_SIMD_NUM - 1; 0 < simd; simd--) {
+          if(1 == vsw16_simd_supported(simd)) break;
+      }
+      vsw16_simd = simd;
+  }
+  return vsw16_simd;
+}
+
+void
+vsw16_simd_set(int32_t simd)
+{
+  if(0 == vsw16_simd_supported(simd)) {
+      fprintf(stderr, "the SIMD instruction set %d is not supported\n", simd);
+      exit(1);
+  }
+  vsw16_simd = simd;
+}
+
+const char *
+vsw16_simd_name(int32_t simd)
+{
+  switch(simd) {
+    case VSW16_SIMD_SSE2:
+      return "SSE2";
+    case VSW16_SIMD_AVX2:
+      return "AVX2";
+    case VSW16_SIMD_AVX512BW:
+      return "AVX-512BW";
+    default:
+      break;
+  }
+  return "unknown";
+}
+
 vsw16_query_t *
 vsw16_query_init(vsw16_query_t *prev, const uint8_t *query, int32_t qlen, 
                  int32_t query_start_clip, int32_t query_end_clip,
                  vsw_opt_t *opt)
 {
-  int32_t qlen_mem, slen, a;
+  int32_t qlen_mem, slen, a, simd, values_log2;
   int32_t min_gap_score, min_mm_score;
   vsw16_int_t *t;
 
   // get the number of stripes
-  slen = __vsw16_calc_slen(qlen); 
+  simd = vsw16_simd_get();
+  values_log2 = __vsw16_simd_values_log2(simd);
+  slen = (qlen + (1 << values_log2) - 1) >> values_log2;
 
   // check if we need to re-size the memory
   if(NULL == prev 
      || prev->qlen_max < qlen
+     || simd != prev->simd
      || query_start_clip != prev->query_start_clip
      || query_end_clip != prev->query_end_clip) { // recompute
       // free previous
@@ -57,10 +122,11 @@ vsw16_query_init(vsw16_query_t *prev, const uint8_t *query, int32_t qlen,
           free(prev); prev = NULL;
       }
       // get the memory needed to hold the stripes for the query 
-      qlen_mem = __vsw_calc_qlen_mem(slen);
+      qlen_mem = slen << (values_log2 + 1); // two bytes per value
       //prev = memalign(16, sizeof(vsw16_query_t) + 15 + qlen_mem * (VSW_ALPHABET_SIZE + 3), "prev"); // add three for H0, H1, and E
-      prev = (vsw16_query_t*)malloc(sizeof(vsw16_query_t) + 15 + qlen_mem * (VSW_ALPHABET_SIZE + 3)); // add three for H0, H1, and E
+      prev = (vsw16_query_t*)malloc(sizeof(vsw16_query_t) + 63 + qlen_mem * (VSW_ALPHABET_SIZE + 3)); // add three for H0, H1, and E
       prev->qlen_max = qlen; 
+      prev->simd = simd;
       // update the memory
       prev->qlen_mem = qlen_mem;
       // update clipping
@@ -97,10 +163,11 @@ vsw16_query_init(vsw16_query_t *prev, const uint8_t *query, int32_t qlen,
   prev->slen = slen; // update the number of stripes
 
   // NB: align all the memory from one block
-  prev->query_profile = (__m128i*)__vsw_16((size_t)prev + sizeof(vsw16_query_t)); // skip over the struct variables, align memory 
-  prev->H0 = prev->query_profile + (prev->slen * VSW_ALPHABET_SIZE); // skip over the query profile
-  prev->H1 = prev->H0 + prev->slen; // skip over H0
-  prev->E = prev->H1 + prev->slen; // skip over H1
+  // NB: the registers are (1 << simd) times the width of __m128i
+  prev->query_profile = (__m128i*)__vsw_64((size_t)prev + sizeof(vsw16_query_t)); // skip over the struct variables, align memory 
+  prev->H0 = prev->query_profile + ((prev->slen * VSW_ALPHABET_SIZE) << simd); // skip over the query profile
+  prev->H1 = prev->H0 + (prev->slen << simd); // skip over H0
+  prev->E = prev->H1 + (prev->slen << simd); // skip over H1
 
   // create the query profile
   t = (vsw16_int_t*)prev->query_profile;
@@ -108,7 +175,7 @@ vsw16_query_init(vsw16_query_t *prev, const uint8_t *query, int32_t qlen,
       int32_t i, k;
       for(i = 0; i < prev->slen; ++i) { // for each stripe
           // fill in this stripe
-          for(k = i; k < prev->slen << vsw16_values_per_128_bits_log2; k += prev->slen) { //  for q_{i+1}, q_{2i+1}, ..., q_{2s+1}
+          for(k = i; k < prev->slen << values_log2; k += prev->slen) { //  for q_{i+1}, q_{2i+1}, ..., q_{2s+1}
               // NB: pad with zeros
               *t++ = ((k >= qlen) ? prev->min_edit_score : ((a == query[k]) ? opt->score_match : -opt->pen_mm)); 
           }
@@ -463,3 +530,25 @@ end_loop:
   }
   return best + sum - zero;
 }
+
+int32_t
+vsw16_forward(vsw16_query_t *query, const uint8_t *target, int32_t tlen, 
+                   int32_t query_start_clip, int32_t query_end_clip,
+                   vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                   int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr)
+{
+  switch(query->simd) {
+#ifdef VSW16_SIMD_AVX
+    case VSW16_SIMD_AVX512BW:
+      return vsw16_avx512bw_forward(query, target, tlen, query_start_clip, query_end_clip, 
+                                    opt, query_end, target_end, direction, overflow, n_best, score_thr);
+    case VSW16_SIMD_AVX2:
+      return vsw16_avx2_forward(query, target, tlen, query_start_clip, query_end_clip, 
+                                opt, query_end, target_end, direction, overflow, n_best, score_thr);
+#endif
+    default:
+      break;
+  }
+  return vsw16_sse2_forward(query, target, tlen, query_start_clip, query_end_clip, 
+                            opt, query_end, target_end, direction, overflow, n_best, score_thr);
+}
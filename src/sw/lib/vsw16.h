@@ -44,6 +44,46 @@
 #define UNLIKELY(x) (x)
 #endif
 
+/* The SIMD instruction sets of the striped alignment */
+#define VSW16_SIMD_SSE2 0 /*!< 128-bit registers, 8 values each */
+#define VSW16_SIMD_AVX2 1 /*!< 256-bit registers, 16 values each */
+#define VSW16_SIMD_AVX512BW 2 /*!< 512-bit registers, 32 values each */
+#define VSW16_SIMD_NUM 3 /*!< the number of SIMD instruction sets */
+
+// the wider instruction sets are compiled in regardless of the compiler flags, and are selected at run time
+#if defined(__x86_64__) && ((defined(__GNUC__) && 6 <= __GNUC__) || defined(__clang__))
+#define VSW16_SIMD_AVX 1
+#endif
+
+// returns the log2 of the number of values per register for the given instruction set
+#define __vsw16_simd_values_log2(_simd) (vsw16_values_per_128_bits_log2 + (_simd))
+
+/*!
+  @param  simd  the SIMD instruction set (VSW16_SIMD_*)
+  @return       1 if the instruction set is compiled in and supported by this CPU, 0 otherwise
+  */
+int32_t
+vsw16_simd_supported(int32_t simd);
+
+/*!
+  @return  the SIMD instruction set used for new queries; the widest supported by this CPU unless set by vsw16_simd_set
+  */
+int32_t
+vsw16_simd_get();
+
+/*!
+  @param  simd  the SIMD instruction set to use for new queries, which must be supported
+  */
+void
+vsw16_simd_set(int32_t simd);
+
+/*!
+  @param  simd  the SIMD instruction set (VSW16_SIMD_*)
+  @return       the name of the instruction set
+  */
+const char *
+vsw16_simd_name(int32_t simd);
+
 
 /*!
   @param  prev              the previous vectorized query sequence, NULL otherwise
@@ -52,7 +92,7 @@
   @param  query_start_clip  1 if we are to clip the start of the query, 0 otherwise
   @param  query_end_clip    1 if we are to clip the end of the query, 0 otherwise
   @param  opt               the previous alignment parameters, NULL if none exist
-  @return                   the query sequence in vectorized form
+  @return                   the query sequence in vectorized form, for the instruction set given by vsw16_simd_get
   */
 vsw16_query_t *
 vsw16_query_init(vsw16_query_t *prev, const uint8_t *query, int32_t qlen, 
@@ -85,4 +125,33 @@ vsw16_sse2_forward(vsw16_query_t *query, const uint8_t *target, int32_t tlen,
                         int32_t query_start_clip, int32_t query_end_clip,
                         vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
                         int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr);
+
+#ifdef VSW16_SIMD_AVX
+/*!
+  the same as vsw16_sse2_forward, but with 256-bit registers; requires a query initialized for VSW16_SIMD_AVX2
+  */
+int32_t
+vsw16_avx2_forward(vsw16_query_t *query, const uint8_t *target, int32_t tlen,
+                        int32_t query_start_clip, int32_t query_end_clip,
+                        vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                        int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr);
+
+/*!
+  the same as vsw16_sse2_forward, but with 512-bit registers; requires a query initialized for VSW16_SIMD_AVX512BW
+  */
+int32_t
+vsw16_avx512bw_forward(vsw16_query_t *query, const uint8_t *target, int32_t tlen,
+                        int32_t query_start_clip, int32_t query_end_clip,
+                        vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                        int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr);
+#endif
+
+/*!
+  the same as vsw16_sse2_forward, but using the instruction set of the query
+  */
+int32_t
+vsw16_forward(vsw16_query_t *query, const uint8_t *target, int32_t tlen,
+                        int32_t query_start_clip, int32_t query_end_clip,
+                        vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                        int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr);
 #endif
@@ -0,0 +1,214 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+/* The MIT License
+
+   Copyright (c) 2011 by Attractive Chaos <attractor@live.co.uk>
+
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include <unistd.h>
+#include <stdio.h>
+#include "vsw.h"
+#include "vsw16.h"
+#include "vsw8.h"
+
+vsw8_query_t *
+vsw8_query_init(vsw8_query_t *prev, const uint8_t *query, int32_t qlen, 
+                int32_t query_start_clip, int32_t query_end_clip,
+                vsw_opt_t *opt)
+{
+  int32_t qlen_mem, slen, a, simd, values_log2, zero;
+  vsw8_int_t *t;
+
+  // get the number of stripes
+  simd = vsw16_simd_get();
+  values_log2 = __vsw8_simd_values_log2(simd);
+  slen = (qlen + (1 << values_log2) - 1) >> values_log2;
+
+  // check if we need to re-size the memory
+  if(NULL == prev 
+     || prev->qlen_max < qlen
+     || simd != prev->simd
+     || query_start_clip != prev->query_start_clip
+     || query_end_clip != prev->query_end_clip) { // recompute
+      // free previous
+      if(NULL != prev) {
+          free(prev); prev = NULL;
+      }
+      // get the memory needed to hold the stripes for the query 
+      qlen_mem = slen << values_log2; // one byte per value
+      prev = (vsw8_query_t*)malloc(sizeof(vsw8_query_t) + 63 + qlen_mem * (VSW_ALPHABET_SIZE + 3)); // add three for H0, H1, and E
+      prev->qlen_max = qlen; 
+      prev->simd = simd;
+      // update the memory
+      prev->qlen_mem = qlen_mem;
+      // update clipping
+      prev->query_start_clip = query_start_clip;
+      prev->query_end_clip = query_end_clip;
+  }
+
+  // compute min/max edit scores
+  prev->min_edit_score = (opt->pen_gapo+opt->pen_gape < opt->pen_mm) ? -opt->pen_mm : -(opt->pen_gapo+opt->pen_gape); // minimum single-edit score
+  prev->min_edit_score--; // for N mismatches
+  prev->max_edit_score = opt->score_match;
+  // the minimum and maximum alignment scores are fixed by the value width
+  prev->min_aln_score = vsw8_min_value;
+  prev->max_aln_score = vsw8_max_value - prev->max_edit_score; // so it doesn't overflow
+  // the zero alignment score 
+  if(1 == query_start_clip) {
+      zero = vsw8_min_value - prev->min_edit_score; // no alignment falls below zero plus the minimum edit score
+  }
+  else {
+      zero = prev->max_aln_score - prev->max_edit_score - (opt->score_match * qlen); // all matches do not overflow
+  }
+  // NB: the alignment will overflow if these are bounded
+  if(zero < vsw8_min_value) zero = vsw8_min_value;
+  else if(vsw8_max_value < zero) zero = vsw8_max_value;
+  prev->zero_aln_score = zero;
+
+  prev->qlen = qlen; // update the query length
+  prev->slen = slen; // update the number of stripes
+
+  // NB: align all the memory from one block
+  // NB: the registers are (1 << simd) times the width of __m128i
+  prev->query_profile = (__m128i*)__vsw_64((size_t)prev + sizeof(vsw8_query_t)); // skip over the struct variables, align memory 
+  prev->H0 = prev->query_profile + ((prev->slen * VSW_ALPHABET_SIZE) << simd); // skip over the query profile
+  prev->H1 = prev->H0 + (prev->slen << simd); // skip over H0
+  prev->E = prev->H1 + (prev->slen << simd); // skip over H1
+
+  // create the query profile
+  t = (vsw8_int_t*)prev->query_profile;
+  for(a = 0; a < VSW_ALPHABET_SIZE; a++) {
+      int32_t i, k;
+      for(i = 0; i < prev->slen; ++i) { // for each stripe
+          // fill in this stripe
+          for(k = i; k < prev->slen << values_log2; k += prev->slen) { //  for q_{i+1}, q_{2i+1}, ..., q_{2s+1}
+              *t++ = ((k >= qlen) ? prev->min_edit_score : ((a == query[k]) ? opt->score_match : -opt->pen_mm)); 
+          }
+      }
+  }
+  return prev;
+}
+
+void
+vsw8_query_destroy(vsw8_query_t *vsw)
+{
+  // all memory was allocated as one block
+  free(vsw);
+}
+
+#ifdef VSW16_SIMD_AVX
+
+// NB: only the functions below use SSE4.1, for the signed 8-bit maximum and minimum
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+
+class vsw8_sse41_t {
+public:
+  typedef __m128i vec_t;
+  typedef int8_t int_t;
+  static const int8_t min_value = vsw8_min_value;
+  static const int8_t max_value = vsw8_max_value;
+  static const int32_t values = 16;
+  static inline __m128i set1(int8_t v) { return _mm_set1_epi8(v); }
+  static inline __m128i load(const __m128i *p) { return _mm_load_si128(p); }
+  static inline void store(__m128i *p, __m128i a) { _mm_store_si128(p, a); }
+  static inline __m128i adds(__m128i a, __m128i b) { return _mm_adds_epi8(a, b); }
+  static inline __m128i subs(__m128i a, __m128i b) { return _mm_subs_epi8(a, b); }
+  static inline __m128i max(__m128i a, __m128i b) { return _mm_max_epi8(a, b); }
+  static inline __m128i min(__m128i a, __m128i b) { return _mm_min_epi8(a, b); }
+  static inline __m128i shift(__m128i a) { return _mm_slli_si128(a, 1); }
+  static inline __m128i insert0(__m128i a, int8_t v) { return _mm_insert_epi8(a, v, 0); }
+  static inline int32_t any_gt(__m128i a, __m128i b) { return _mm_movemask_epi8(_mm_cmpgt_epi8(a, b)); }
+  static inline uint64_t gt_mask(__m128i a, __m128i b) { return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(a, b)); }
+  static inline __m128i fscan(__m128i a, __m128i fill, const __m128i *decay) {
+      a = _mm_max_epi8(a, _mm_subs_epi8(_mm_alignr_epi8(a, fill, 15), decay[0]));
+      a = _mm_max_epi8(a, _mm_subs_epi8(_mm_alignr_epi8(a, fill, 14), decay[1]));
+      a = _mm_max_epi8(a, _mm_subs_epi8(_mm_alignr_epi8(a, fill, 12), decay[2]));
+      a = _mm_max_epi8(a, _mm_subs_epi8(_mm_alignr_epi8(a, fill, 8), decay[3]));
+      return a;
+  }
+  static inline int8_t hmax(__m128i a) {
+      a = _mm_max_epi8(a, _mm_srli_si128(a, 8));
+      a = _mm_max_epi8(a, _mm_srli_si128(a, 4));
+      a = _mm_max_epi8(a, _mm_srli_si128(a, 2));
+      a = _mm_max_epi8(a, _mm_srli_si128(a, 1));
+      return (int8_t)(_mm_extract_epi8(a, 0) & 0xff);
+  }
+  static inline int8_t hmin(__m128i a) {
+      a = _mm_min_epi8(a, _mm_srli_si128(a, 8));
+      a = _mm_min_epi8(a, _mm_srli_si128(a, 4));
+      a = _mm_min_epi8(a, _mm_srli_si128(a, 2));
+      a = _mm_min_epi8(a, _mm_srli_si128(a, 1));
+      return (int8_t)(_mm_extract_epi8(a, 0) & 0xff);
+  }
+};
+
+#include "vsw_simd.h"
+
+int32_t
+vsw8_sse41_forward(vsw8_query_t *query, const uint8_t *target, int32_t tlen, 
+                   int32_t query_start_clip, int32_t query_end_clip,
+                   vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                   int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr)
+{
+  return vsw_simd_forward<vsw8_sse41_t>(query, target, tlen, query_start_clip, query_end_clip, 
+                                        opt, query_end, target_end, direction, overflow, n_best, score_thr);
+}
+
+#pragma GCC pop_options
+
+#endif
+
+int32_t
+vsw8_forward(vsw8_query_t *query, const uint8_t *target, int32_t tlen, 
+             int32_t query_start_clip, int32_t query_end_clip,
+             vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+             int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr)
+{
+#ifdef VSW16_SIMD_AVX
+  static int32_t sse41 = -1; // 1 if this CPU supports SSE4.1, -1 if not yet checked
+  switch(query->simd) {
+    case VSW16_SIMD_AVX512BW:
+      return vsw8_avx512bw_forward(query, target, tlen, query_start_clip, query_end_clip, 
+                                   opt, query_end, target_end, direction, overflow, n_best, score_thr);
+    case VSW16_SIMD_AVX2:
+      return vsw8_avx2_forward(query, target, tlen, query_start_clip, query_end_clip, 
+                               opt, query_end, target_end, direction, overflow, n_best, score_thr);
+    default:
+      if(sse41 < 0) {
+          __builtin_cpu_init();
+          sse41 = (__builtin_cpu_supports("sse4.1")) ? 1 : 0;
+      }
+      if(1 == sse41) {
+          return vsw8_sse41_forward(query, target, tlen, query_start_clip, query_end_clip, 
+                                    opt, query_end, target_end, direction, overflow, n_best, score_thr);
+      }
+      break;
+  }
+#endif
+  // not compiled in or supported, so use 16-bit values
+  if(NULL != overflow) *overflow = 1;
+  return vsw16_min_value;
+}
@@ -0,0 +1,110 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+/* The MIT License
+
+   Copyright (c) 2011 by Attractive Chaos <attractor@live.co.uk>
+
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include <unistd.h>
+#include <stdio.h>
+#include "vsw.h"
+#include "vsw16.h"
+#include "vsw8.h"
+
+#ifdef VSW16_SIMD_AVX
+
+// NB: only the functions below use AVX2, so this file is safe to compile for any CPU
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+class vsw8_avx2_t {
+public:
+  typedef __m256i vec_t;
+  typedef int8_t int_t;
+  static const int8_t min_value = vsw8_min_value;
+  static const int8_t max_value = vsw8_max_value;
+  static const int32_t values = 32;
+  static inline __m256i set1(int8_t v) { return _mm256_set1_epi8(v); }
+  static inline __m256i load(const __m256i *p) { return _mm256_load_si256(p); }
+  static inline void store(__m256i *p, __m256i a) { _mm256_store_si256(p, a); }
+  static inline __m256i adds(__m256i a, __m256i b) { return _mm256_adds_epi8(a, b); }
+  static inline __m256i subs(__m256i a, __m256i b) { return _mm256_subs_epi8(a, b); }
+  static inline __m256i max(__m256i a, __m256i b) { return _mm256_max_epi8(a, b); }
+  static inline __m256i min(__m256i a, __m256i b) { return _mm256_min_epi8(a, b); }
+  static inline __m256i shift(__m256i a) {
+      // the lower lane moves into the upper lane, zeros into the lower lane
+      return _mm256_alignr_epi8(a, _mm256_permute2x128_si256(a, a, 0x08), 15);
+  }
+  static inline __m256i insert0(__m256i a, int8_t v) { return _mm256_insert_epi8(a, v, 0); }
+  static inline int32_t any_gt(__m256i a, __m256i b) { return _mm256_movemask_epi8(_mm256_cmpgt_epi8(a, b)); }
+  static inline uint64_t gt_mask(__m256i a, __m256i b) { return (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(a, b)); }
+  static inline __m256i fscan(__m256i a, __m256i fill, const __m256i *decay) {
+      __m256i t;
+      // t holds fill in the lower lane and the lower lane of a in the upper lane
+      t = _mm256_permute2x128_si256(a, fill, 0x02);
+      a = _mm256_max_epi8(a, _mm256_subs_epi8(_mm256_alignr_epi8(a, t, 15), decay[0]));
+      t = _mm256_permute2x128_si256(a, fill, 0x02);
+      a = _mm256_max_epi8(a, _mm256_subs_epi8(_mm256_alignr_epi8(a, t, 14), decay[1]));
+      t = _mm256_permute2x128_si256(a, fill, 0x02);
+      a = _mm256_max_epi8(a, _mm256_subs_epi8(_mm256_alignr_epi8(a, t, 12), decay[2]));
+      t = _mm256_permute2x128_si256(a, fill, 0x02);
+      a = _mm256_max_epi8(a, _mm256_subs_epi8(_mm256_alignr_epi8(a, t, 8), decay[3]));
+      t = _mm256_permute2x128_si256(a, fill, 0x02);
+      a = _mm256_max_epi8(a, _mm256_subs_epi8(t, decay[4]));
+      return a;
+  }
+  static inline int8_t hmax(__m256i a) {
+      __m128i m = _mm_max_epi8(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+      m = _mm_max_epi8(m, _mm_srli_si128(m, 8));
+      m = _mm_max_epi8(m, _mm_srli_si128(m, 4));
+      m = _mm_max_epi8(m, _mm_srli_si128(m, 2));
+      m = _mm_max_epi8(m, _mm_srli_si128(m, 1));
+      return (int8_t)(_mm_extract_epi8(m, 0) & 0xff);
+  }
+  static inline int8_t hmin(__m256i a) {
+      __m128i m = _mm_min_epi8(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+      m = _mm_min_epi8(m, _mm_srli_si128(m, 8));
+      m = _mm_min_epi8(m, _mm_srli_si128(m, 4));
+      m = _mm_min_epi8(m, _mm_srli_si128(m, 2));
+      m = _mm_min_epi8(m, _mm_srli_si128(m, 1));
+      return (int8_t)(_mm_extract_epi8(m, 0) & 0xff);
+  }
+};
+
+#include "vsw_simd.h"
+
+int32_t
+vsw8_avx2_forward(vsw8_query_t *query, const uint8_t *target, int32_t tlen, 
+                  int32_t query_start_clip, int32_t query_end_clip,
+                  vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                  int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr)
+{
+  return vsw_simd_forward<vsw8_avx2_t>(query, target, tlen, query_start_clip, query_end_clip, 
+                                       opt, query_end, target_end, direction, overflow, n_best, score_thr);
+}
+
+#pragma GCC pop_options
+
+#endif
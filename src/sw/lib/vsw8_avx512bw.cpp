@@ -0,0 +1,115 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+/* The MIT License
+
+   Copyright (c) 2011 by Attractive Chaos <attractor@live.co.uk>
+
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include <unistd.h>
+#include <stdio.h>
+#include "vsw.h"
+#include "vsw16.h"
+#include "vsw8.h"
+
+#ifdef VSW16_SIMD_AVX
+
+// NB: only the functions below use AVX-512, so this file is safe to compile for any CPU
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+
+class vsw8_avx512bw_t {
+public:
+  typedef __m512i vec_t;
+  typedef int8_t int_t;
+  static const int8_t min_value = vsw8_min_value;
+  static const int8_t max_value = vsw8_max_value;
+  static const int32_t values = 64;
+  static inline __m512i set1(int8_t v) { return _mm512_set1_epi8(v); }
+  static inline __m512i load(const __m512i *p) { return _mm512_load_si512(p); }
+  static inline void store(__m512i *p, __m512i a) { _mm512_store_si512(p, a); }
+  static inline __m512i adds(__m512i a, __m512i b) { return _mm512_adds_epi8(a, b); }
+  static inline __m512i subs(__m512i a, __m512i b) { return _mm512_subs_epi8(a, b); }
+  static inline __m512i max(__m512i a, __m512i b) { return _mm512_max_epi8(a, b); }
+  static inline __m512i min(__m512i a, __m512i b) { return _mm512_min_epi8(a, b); }
+  static inline __m512i shift(__m512i a) {
+      // each lane moves into the next lane, zeros into the first lane
+      return _mm512_alignr_epi8(a, _mm512_maskz_shuffle_i32x4(0xfff0, a, a, 0x90), 15);
+  }
+  static inline __m512i insert0(__m512i a, int8_t v) { return _mm512_mask_set1_epi8(a, 1, v); }
+  static inline int32_t any_gt(__m512i a, __m512i b) { return (0 == _mm512_cmpgt_epi8_mask(a, b)) ? 0 : 1; }
+  static inline uint64_t gt_mask(__m512i a, __m512i b) { return _mm512_cmpgt_epi8_mask(a, b); }
+  static inline __m512i fscan(__m512i a, __m512i fill, const __m512i *decay) {
+      __m512i t;
+      // t holds fill in the first lane and the first three lanes of a in the others
+      t = _mm512_mask_shuffle_i32x4(fill, 0xfff0, a, a, 0x90);
+      a = _mm512_max_epi8(a, _mm512_subs_epi8(_mm512_alignr_epi8(a, t, 15), decay[0]));
+      t = _mm512_mask_shuffle_i32x4(fill, 0xfff0, a, a, 0x90);
+      a = _mm512_max_epi8(a, _mm512_subs_epi8(_mm512_alignr_epi8(a, t, 14), decay[1]));
+      t = _mm512_mask_shuffle_i32x4(fill, 0xfff0, a, a, 0x90);
+      a = _mm512_max_epi8(a, _mm512_subs_epi8(_mm512_alignr_epi8(a, t, 12), decay[2]));
+      t = _mm512_mask_shuffle_i32x4(fill, 0xfff0, a, a, 0x90);
+      a = _mm512_max_epi8(a, _mm512_subs_epi8(_mm512_alignr_epi8(a, t, 8), decay[3]));
+      t = _mm512_mask_shuffle_i32x4(fill, 0xfff0, a, a, 0x90);
+      a = _mm512_max_epi8(a, _mm512_subs_epi8(t, decay[4]));
+      // fill in the first two lanes and the first two lanes of a in the others
+      t = _mm512_mask_shuffle_i32x4(fill, 0xff00, a, a, 0x40);
+      a = _mm512_max_epi8(a, _mm512_subs_epi8(t, decay[5]));
+      return a;
+  }
+  static inline int8_t hmax(__m512i a) {
+      a = _mm512_max_epi8(a, _mm512_mask_shuffle_i64x2(a, 0xff, a, a, 0x4e)); // swap the 256-bit halves
+      a = _mm512_max_epi8(a, _mm512_mask_shuffle_i64x2(a, 0xff, a, a, 0xb1)); // swap the 128-bit lanes
+      a = _mm512_max_epi8(a, _mm512_bsrli_epi128(a, 8));
+      a = _mm512_max_epi8(a, _mm512_bsrli_epi128(a, 4));
+      a = _mm512_max_epi8(a, _mm512_bsrli_epi128(a, 2));
+      a = _mm512_max_epi8(a, _mm512_bsrli_epi128(a, 1));
+      return (int8_t)(_mm512_cvtsi512_si32(a) & 0xff);
+  }
+  static inline int8_t hmin(__m512i a) {
+      a = _mm512_min_epi8(a, _mm512_mask_shuffle_i64x2(a, 0xff, a, a, 0x4e)); // swap the 256-bit halves
+      a = _mm512_min_epi8(a, _mm512_mask_shuffle_i64x2(a, 0xff, a, a, 0xb1)); // swap the 128-bit lanes
+      a = _mm512_min_epi8(a, _mm512_bsrli_epi128(a, 8));
+      a = _mm512_min_epi8(a, _mm512_bsrli_epi128(a, 4));
+      a = _mm512_min_epi8(a, _mm512_bsrli_epi128(a, 2));
+      a = _mm512_min_epi8(a, _mm512_bsrli_epi128(a, 1));
+      return (int8_t)(_mm512_cvtsi512_si32(a) & 0xff);
+  }
+};
+
+#include "vsw_simd.h"
+
+int32_t
+vsw8_avx512bw_forward(vsw8_query_t *query, const uint8_t *target, int32_t tlen, 
+                      int32_t query_start_clip, int32_t query_end_clip,
+                      vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                      int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr)
+{
+  return vsw_simd_forward<vsw8_avx512bw_t>(query, target, tlen, query_start_clip, query_end_clip, 
+                                           opt, query_end, target_end, direction, overflow, n_best, score_thr);
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,311 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+/* The MIT License
+
+   Copyright (c) 2011 by Attractive Chaos <attractor@live.co.uk>
+
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   */
+
+#ifndef VSW_SIMD_H
+#define VSW_SIMD_H
+
+/*
+   The striped forward alignment of vsw16_sse2_forward for any register and value width.
+   This is included by the source file of each instruction set after it
+   defines a class 'V' with:
+     vec_t                  the register type
+     int_t                  the value type (int16_t, or int8_t for vsw8)
+     min_value, max_value   the minimum and maximum value
+     values                 the number of values per register
+     set1(v)                all values set to v
+     load(p), store(p, a)   aligned load and store
+     adds(a, b), subs(a, b) saturated addition and subtraction
+     max(a, b), min(a, b)   the element-wise maximum and minimum
+     shift(a)               the values shifted up by one, the first value set to zero
+     insert0(a, v)          the first value set to v
+     any_gt(a, b)           non-zero if any value in a is greater than in b
+     gt_mask(a, b)          one bit per value, in order, set if the value in a is greater than in b
+     hmax(a), hmin(a)       the maximum and minimum value
+     fscan(a, fill, decay)  each value the maximum of itself and the values below it, which
+                            are reduced by decay[i] per 2^i values moved up (fill below the first)
+   and has enabled the instruction set for the rest of the file.
+
+   With 8-bit values, any cell below -inf is raised to it.  This is exact when
+   clipping the start of the query, as no cell then falls below zero plus the
+   minimum edit score, which is -inf.  Otherwise, the overflow flag is also set
+   when a cell raised to -inf could have reached the best score.
+   */
+
+// returns the value bounded below by the minimum value
+#define vsw_simd_bound(_val, _min) (((_val) < (_min)) ? (_min) : (_val))
+
+static inline int32_t
+vsw_simd_dir_cmp(int32_t cur_score, int32_t cur_qe, int32_t cur_te,
+               int32_t next_score, int32_t next_qe, int32_t next_te,
+               int32_t dir)
+{
+  if(next_score < cur_score) return 0;
+  if(cur_score < next_score) return 1;
+  if(0 == dir) { // min qe, break ties by min te
+      if(next_qe < cur_qe) return 1;
+      if(next_qe == cur_qe && next_te < cur_te) return 1;
+  }
+  else { // max qe, break ties by max te
+      if(cur_qe < next_qe) return 1;
+      if(cur_qe == next_qe && cur_te < next_te) return 1;
+  }
+  return 0;
+}
+
+template<class V>
+static inline int32_t
+vsw_simd_forward(vsw16_query_t *query, const uint8_t *target, int32_t tlen,
+                   int32_t query_start_clip, int32_t query_end_clip,
+                   vsw_opt_t *opt, int16_t *query_end, int16_t *target_end,
+                   int32_t direction, int32_t *overflow, int32_t *n_best, int32_t score_thr)
+{
+  typedef typename V::vec_t vec_t;
+  typedef typename V::int_t int_t;
+  int32_t slen, i, j, k;
+  int_t best;
+  int_t zero, imin = 0, imax = 0;
+  int_t values[V::values] __attribute__((aligned(64)));
+  vec_t zero_mm, negative_infinity_mm, g_start;
+  vec_t pen_gapoe, pen_gape, *H0, *H1, *E, *S;
+  vec_t decay[8]; // enough for 256 values per register
+  uint64_t all_cells = (64 <= V::values) ? ~(uint64_t)0 : (((uint64_t)1 << (V::values % 64)) - 1); // one bit per value
+
+  // initialization
+  // normalize these
+  zero = query->zero_aln_score; // where the normalized zero alignment score occurs
+  negative_infinity_mm = V::set1(query->min_aln_score); // the minimum possible value
+  score_thr += zero; // for the scoring threshold
+  // these are not normalized
+  pen_gapoe = V::set1(opt->pen_gapo + opt->pen_gape); // gap open penalty
+  pen_gape = V::set1(opt->pen_gape); // gap extend penalty
+  zero_mm = V::set1(zero); // where the normalized zero alignment score occurs
+  best = V::min_value;
+  if(NULL != n_best) (*n_best) = 0;
+  // vectors
+  H0 = (vec_t*)query->H0;
+  H1 = (vec_t*)query->H1;
+  E = (vec_t*)query->E;
+  slen = query->slen;
+  if(NULL != overflow) *overflow = 0;
+  if(1 == sizeof(int_t) 
+     && (V::max_value < -query->min_edit_score
+         || (0 == query_start_clip 
+             && query->max_aln_score - query->max_edit_score <= query->min_aln_score + opt->score_match * query->qlen))) {
+      // the penalties do not fit, or the best score could never be shown exact (see below)
+      if(NULL != overflow) *overflow = 1;
+      return vsw16_min_value;
+  }
+  // the gap extension penalties over 1, 2, 4, ... values in the stripes
+  for(j = k = 1; k < V::values; j++, k <<= 1) {
+      decay[j-1] = V::set1((opt->pen_gape * slen * k < V::max_value) ? (opt->pen_gape * slen * k) : V::max_value);
+  }
+
+  if(0 == query_start_clip) {
+      vec_t f;
+      // Set start
+      for(j = 0; j < slen; j++) {
+          // initialize E to negative infinity
+          V::store(E + j, negative_infinity_mm); // E(0,j)
+      }
+      // NB: setting the start == 0 will be done later
+      // set the leading insertions
+      // NB: bound with -inf, since the values past the end of the query may not fit otherwise
+      for(j = 0; j < V::values; ++j) {
+          values[j] = vsw_simd_bound(-opt->pen_gapo + -opt->pen_gape + (-opt->pen_gape * slen * j) + zero, query->min_aln_score);
+      }
+      f = V::load((vec_t*)values);
+      for(j = 0; j < slen; j++) {
+          f = V::subs(f, pen_gape); // f=F(i,j)-pen_gape
+          f = V::max(f, negative_infinity_mm); // bound with -inf
+          V::store(H0 + ((slen + j - 1) % slen), f); // H(0,j)
+      }
+      // the leading insertions for each base in the target
+      // NB: do not include the gap extend, that will be added below
+      values[0] = vsw_simd_bound(-opt->pen_gapo + opt->pen_gape + zero, query->min_aln_score);
+      for(j = 1; j < V::values; j++) {
+          values[j] = vsw_simd_bound(-opt->pen_gapo + (-opt->pen_gape * (j * slen - 1)) + zero, query->min_aln_score);
+      }
+      g_start = V::load((vec_t*)values);
+  }
+  else {
+      // Initialize all zeros
+      for(i = 0; i < slen; ++i) {
+          V::store(E + i, zero_mm);
+          V::store(H0 + i, zero_mm);
+      }
+      g_start = negative_infinity_mm;
+  }
+
+  // the core loop
+  for(i = 0; i < tlen; i++) { // for each base in the target
+      vec_t e, h, f, g, max, min;
+
+      max = V::set1(query->min_aln_score); // max is negative infinity
+      min = V::set1(query->max_aln_score); // min is positive infinity
+      S = (vec_t*)query->query_profile + target[i] * slen; // s is the 1st score vector
+
+      // load H(i-1,-1)
+      h = V::load(H0 + slen - 1); // the last stripe, which holds the j-1
+      if(UNLIKELY(0 < i)) { // only if we have previous results
+          h = V::shift(h);
+      }
+      h = V::insert0(h, zero);
+
+      // set F to -inf
+      f = negative_infinity_mm;
+      // leading insertions
+      g = g_start;
+
+      for(j = 0; LIKELY(j < slen); ++j) { // for each stripe in the query
+          /* SW cells are computed in the following order:
+           *   H(i,j)   = max{H(i-1,j-1)+S(i,j), E(i,j), F(i,j)}
+           *   E(i+1,j) = max{H(i,j)-q, E(i,j)-r}
+           *   F(i,j+1) = max{H(i,j)-q, F(i,j)-r}
+           */
+          if(1 == query_start_clip) {
+              // start anywhere within the query, though not before the start
+              h = V::max(h, zero_mm);
+          }
+          else {
+              g = V::subs(g, pen_gape); // leading insertion
+              h = V::max(h, g);
+          }
+          // compute H(i,j);
+          h = V::adds(h, V::load(S + j)); // h=H(i-1,j-1)+S(i,j)
+          e = V::load(E + j); // e=E(i,j)
+          h = V::max(h, e); // h=H(i,j) = max{E(i,j), H(i-1,j-1)+S(i,j)}
+          h = V::max(h, f); // h=H(i,j) = max{max{E(i,j), H(i-1,j-1)+S(i,j)}, F(i,j)}
+          h = V::max(h, negative_infinity_mm); // bound with -inf
+          max = V::max(max, h); // save the max values in this stripe versus the last
+          min = V::min(min, h); // save the max values in this stripe versus the last
+          V::store(H1 + j, h); // save h to H(i,j)
+          // next, compute E(i+1,j)
+          h = V::subs(h, pen_gapoe); // h=H(i,j)-pen_gapoe
+          e = V::subs(e, pen_gape); // e=E(i,j)-pen_gape
+          e = V::max(e, h); // e=E(i+1,j) = max{E(i,j)-pen_gape, H(i,j)-pen_gapoe}
+          e = V::max(e, negative_infinity_mm); // bound with -inf
+          V::store(E + j, e); // save e to E(i+1,j)
+          // now compute F(i,j+1)
+          f = V::subs(f, pen_gape); // f=F(i,j)-pen_gape
+          f = V::max(f, h); // f=F(i,j+1) = max{F(i,j)-pen_gape, H(i,j)-pen_gapoe}
+          f = V::max(f, negative_infinity_mm); // bound with -inf
+          // get H(i-1,j) and prepare for the next j
+          h = V::load(H0 + j); // h=H(i-1,j)
+      }
+
+      // NB: we do not need to set E(i,j) as we disallow adjacent insertion and then deletion
+      // F(i,j+1) from the last stripe of each value enters the first stripe of the next value.  Instead
+      // of propagating it one value per pass over the stripes (as SWPS3), find the F entering each
+      // value at once, as its F decays by the gap extension over each value it spans; the result is the
+      // same, since H(i,j) raised by F(i,j) cannot raise F(i,j+1) further.
+      f = V::shift(f); // since x86 is little endian
+      f = V::insert0(f, query->min_aln_score); // set F(i-1,-1)[0] as negative infinity (normalized)
+      f = V::fscan(f, negative_infinity_mm, decay); // the F entering each value
+      for(j = 0; LIKELY(j < slen); ++j) { // NB: H(i,j) updated here cannot exceed max
+          h = V::load(H1 + j); // h=H(i,j)
+          V::store(H1 + j, V::max(h, f)); // save H(i,j) = max{H(i,j), F(i,j)}
+          h = V::subs(h, pen_gapoe); // h=H(i,j)-pen_gapoe
+          f = V::subs(f, pen_gape); // f=F(i,j)-pen_gape
+          f = V::max(f, negative_infinity_mm); // bound with -inf
+          // stop once F(i,j+1) was found above from H(i,j) everywhere
+          if(0 == V::any_gt(f, h)) break;
+      }
+      imax = V::hmax(max); // imax is the maximum number in max
+      if(query->max_aln_score - query->max_edit_score < imax) { // overflow
+          if(NULL != overflow) *overflow = 1;
+          return vsw16_min_value;
+      }
+      if(score_thr <= imax && best <= imax) { // potential best score
+          int_t *t;
+          if(query_end_clip == 0) { // check the last
+              j = (query->qlen-1) % slen; // stripe
+              k = (query->qlen-1) / slen; // value
+              t = (int_t*)(H1 + j);
+              if(NULL != n_best) {
+                  if(best == (int32_t)t[k]) { // duplicate best score
+                      (*n_best)++;
+                  }
+                  else if(best < (int32_t)t[k]) {
+                      (*n_best) = 1;
+                  }
+              }
+              if(1 == vsw_simd_dir_cmp(best, (*query_end), (*target_end), (int32_t)t[k], query->qlen-1, i, direction)) {
+                  (*query_end) = query->qlen-1;
+                  (*target_end) = i;
+                  best = t[k];
+              }
+          }
+          else { // check all
+              // NB: the cells past the end of the query always score less than the best
+              for(j = 0; LIKELY(j < slen); ++j) { // for each stripe in the query
+                  uint64_t cells; // the cells at least the best, as cells below it do not change it
+                  cells = (V::min_value < best) ? V::gt_mask(V::load(H1 + j), V::set1(best - 1)) : all_cells;
+                  t = (int_t*)(H1 + j);
+                  for(; 0 != cells; cells &= cells - 1) { // for each such cell in the stripe, in order
+                      int32_t cur_qe;
+                      k = __builtin_ctzll(cells);
+                      cur_qe = j + (k * slen);
+                      if(query->qlen <= cur_qe) break;
+                      if(NULL != n_best) {
+                          if(best == (int32_t)t[k]) { // duplicate best score
+                              (*n_best)++;
+                          }
+                          else if(best < (int32_t)t[k]) {
+                              (*n_best) = 1;
+                          }
+                      }
+                      if(1 == vsw_simd_dir_cmp(best, (*query_end), (*target_end), (int32_t)t[k], cur_qe, i, direction)) {
+                          best = t[k];
+                          (*query_end) = cur_qe;
+                          (*target_end) = i;
+                      }
+                  }
+              }
+          }
+      }
+      // check for underflow
+      imin = V::hmin(min); // imin is the minimum number in min
+      if(1 < sizeof(int_t) && imin < V::min_value - query->min_edit_score) { // NB: 8-bit values are bounded by -inf below
+          fprintf(stderr, "bug encountered\n");
+          exit(1);
+      }
+      S = H1; H1 = H0; H0 = S; // swap H0 and H1
+  }
+  if(1 == sizeof(int_t) && 0 == query_start_clip
+     && best - query->min_aln_score <= opt->score_match * query->qlen) {
+      // a cell below -inf was raised to it, after which it may gain at most the match score per
+      // query base; the best score is exact only if no cell raised that way could reach it
+      if(NULL != overflow) *overflow = 1;
+      return vsw16_min_value;
+  }
+  if(V::min_value == best) {
+      (*query_end) = (*target_end) = -1;
+      return vsw16_min_value; // the same for any value width
+  }
+  return best - zero;
+}
+
+#endif
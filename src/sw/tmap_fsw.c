@@ -904,7 +904,7 @@ uint32_t tmap_fsw_path2cigar_get_type(uint32_t ctype)
 }
 
 uint32_t *
-tmap_fsw_path2cigar(const tmap_fsw_path_t *path, int32_t path_len, int32_t *n_cigar, int32_t rm_hp)
+tmap_fsw_path2cigar(const tmap_fsw_path_t *path, int32_t path_len, int32_t *n_cigar, int32_t rm_hp, tmap_arena_t *arena)
 {
   int32_t i, n;
   uint32_t *cigar;
@@ -924,7 +924,7 @@ tmap_fsw_path2cigar(const tmap_fsw_path_t *path, int32_t path_len, int32_t *n_ci
           dpscore_last_type = path[i].ctype;
       }
       *n_cigar = n;
-      cigar = tmap_malloc(*n_cigar * 4, "cigar");
+      cigar = tmap_arena_malloc(arena, *n_cigar * 4, "cigar");
 
       TMAP_SW_CIGAR_STORE(cigar[0], path[path_len-1].ctype, 1u);
       dpscore_last_type = path[path_len-1].ctype;
@@ -946,7 +946,7 @@ tmap_fsw_path2cigar(const tmap_fsw_path_t *path, int32_t path_len, int32_t *n_ci
           dpscore_last_type = dpscore_cur_type;
       }
       *n_cigar = n;
-      cigar = tmap_malloc(*n_cigar * 4, "cigar");
+      cigar = tmap_arena_malloc(arena, *n_cigar * 4, "cigar");
           
       // get the last type
       dpscore_last_type = tmap_fsw_path2cigar_get_type(path[path_len-1].ctype);
@@ -2,6 +2,8 @@
 #ifndef TMAP_FSW_H
 #define TMAP_FSW_H
 
+#include "../util/tmap_arena.h"
+
 // We have 6-bits total, so 3-bits for above, and 3-bits for below
 #define TMAP_FSW_MAX_OFFSET 7
 
@@ -258,10 +260,11 @@ tmap_fsw_clipping_core(uint8_t *seq, int32_t len,
   @param  path_len  the Smith-Waterman alignment path length
   @param  n_cigar   pointer to the returned number of cigar operations
   @param  rm_hp     1 if we are to remove hp edits (merge into indels), 0 otherwise
+  @param  arena     the arena for the cigar array, NULL to use the heap
   @return           the cigar array, NULL if the path is NULL or the path length is zero 
   */
 uint32_t *
-tmap_fsw_path2cigar(const tmap_fsw_path_t *path, int32_t path_len, int32_t *n_cigar, int32_t rm_hp);
+tmap_fsw_path2cigar(const tmap_fsw_path_t *path, int32_t path_len, int32_t *n_cigar, int32_t rm_hp, tmap_arena_t *arena);
 
 /*!
   Gets the pretty-print alignment
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <emmintrin.h>
 #include "../util/tmap_alloc.h"
 #include "../util/tmap_definitions.h"
 #include "tmap_sw.h"
@@ -532,6 +533,228 @@ tmap_sw_global_core(uint8_t *seq1, int32_t len1, uint8_t *seq2, int32_t len2, co
   return max;
 }
 
+/***************************************
+ * banded global alignment, SSE2 rows *
+ ***************************************/
+/* the first and last seq1 index in row j of the band, as in tmap_sw_global_core */
+#define __tmap_sw_global_lo(_j, _b2) (((_j) <= (_b2)) ? 0 : ((_j) - (_b2) + 1))
+#define __tmap_sw_global_hi(_j, _b1, _len1) (((_j) + (_b1) - 1 < (_len1)) ? ((_j) + (_b1) - 1) : (_len1))
+
+/* the direction bits stored per cell */
+#define __TMAP_SW_DIR_MATCH 0x3
+#define __TMAP_SW_DIR_INS_M 0x4
+#define __TMAP_SW_DIR_DEL_M 0x8
+
+#define __tmap_sw_clamp16(_x) (((_x) < INT16_MIN) ? INT16_MIN : (((_x) > INT16_MAX) ? INT16_MAX : (_x)))
+
+int32_t
+tmap_sw_global_core_simd(uint8_t *seq1, int32_t len1, uint8_t *seq2, int32_t len2, const tmap_sw_param_t *ap,
+                         tmap_sw_path_t *path, int32_t *path_len, int32_t right_j)
+{
+  int32_t i, j, k, b, b1, b2, lo, hi, width, stride, n_prof, max, mat_max, mat_min, step, h;
+  int64_t bound;
+  int16_t *buf, *prof_buf, **prof, *pm, *pi, *pd, *cm, *ci, *cd, *p_row;
+  int16_t *score[2][3];
+  uint8_t *dir, *d, type, ctype, seen[256];
+  tmap_sw_path_t *p;
+  int32_t gap_open, gap_ext, *score_matrix, N_MATRIX_ROW;
+  __m128i v_inf, v_gapo, v_gape, v_gapoe, v_gape2, v_gape4, v_inf1, v_inf2, v_inf4, v_one, v_two, v_ins, v_del;
+  __m128i vm, vi, vd, vh, va, vx, v_gt_im, v_gt_dm, v_sel_i, v_sel_d, v_dir;
+
+  gap_open = ap->gap_open;
+  gap_ext = ap->gap_ext;
+  b = ap->band_width;
+  score_matrix = ap->matrix;
+  N_MATRIX_ROW = ap->row;
+
+  if(0 != right_j || 0 <= ap->gap_end || b < 1 || NULL == path || NULL == path_len
+     || len1 <= 0 || len2 <= 0 || gap_open < 0 || gap_ext < 0) {
+      return tmap_sw_global_core(seq1, len1, seq2, len2, ap, path, path_len, right_j);
+  }
+
+  /* the query codes used, and the score range they imply */
+  memset(seen, 0, sizeof(seen));
+  mat_max = mat_min = n_prof = 0;
+  for(j = 0; j < len2; j++) {
+      if(0 == seen[seq2[j]]) {
+          seen[seq2[j]] = 1;
+          if(n_prof <= seq2[j]) n_prof = seq2[j] + 1;
+          for(i = 0; i < N_MATRIX_ROW; i++) {
+              h = score_matrix[seq2[j] * N_MATRIX_ROW + i];
+              if(mat_max < h) mat_max = h;
+              if(h < mat_min) mat_min = h;
+          }
+      }
+  }
+  /* every finite score must stay well above the saturated minimum */
+  step = (gap_open + gap_ext < -mat_min) ? -mat_min : gap_open + gap_ext;
+  bound = (int64_t)(len1 + len2 + 1) * (step + mat_max) + gap_open + gap_ext;
+  if(INT16_MAX - 1024 <= bound) {
+      return tmap_sw_global_core(seq1, len1, seq2, len2, ap, path, path_len, right_j);
+  }
+
+  /* calculate b1 and b2 */
+  if(len1 > len2) {
+      b1 = len1 - len2 + b;
+      b2 = b;
+  } else {
+      b1 = b;
+      b2 = len2 - len1 + b;
+  }
+  if(b1 > len1) b1 = len1;
+  if(b2 > len2) b2 = len2;
+
+  /* the score rows are indexed by seq1 position, padded for unaligned reads and
+   * writes one lane before the band and up to seven lanes past it */
+  width = len1 + 24;
+  buf = tmap_malloc(sizeof(int16_t) * 6 * width, "buf");
+  for(i = 0; i < 6 * width; i++) buf[i] = INT16_MIN;
+  for(k = 0; k < 6; k++) score[k / 3][k % 3] = buf + k * width + 8;
+
+  /* the query profile, only for the query codes used */
+  prof = tmap_calloc(n_prof, sizeof(int16_t*), "prof");
+  prof_buf = tmap_calloc(n_prof * width, sizeof(int16_t), "prof_buf");
+  for(k = 0; k < n_prof; k++) {
+      if(0 == seen[k]) continue;
+      prof[k] = prof_buf + k * width;
+      for(i = 1; i <= len1; i++) {
+          prof[k][i] = score_matrix[k * N_MATRIX_ROW + seq1[i-1]];
+      }
+  }
+
+  /* one byte per cell in the band, rows start at the first cell in the band */
+  stride = ((b1 + b2 + 16) + 15) & ~15;
+  dir = tmap_malloc(sizeof(uint8_t) * (len2 + 1) * stride, "dir");
+
+  v_inf = _mm_set1_epi16(INT16_MIN);
+  v_gapo = _mm_set1_epi16(gap_open);
+  v_gape = _mm_set1_epi16(gap_ext);
+  v_gapoe = _mm_set1_epi16(gap_open + gap_ext);
+  v_gape2 = _mm_set1_epi16(__tmap_sw_clamp16(2 * gap_ext));
+  v_gape4 = _mm_set1_epi16(__tmap_sw_clamp16(4 * gap_ext));
+  v_inf1 = _mm_set_epi16(0, 0, 0, 0, 0, 0, 0, INT16_MIN);
+  v_inf2 = _mm_set_epi16(0, 0, 0, 0, 0, 0, INT16_MIN, INT16_MIN);
+  v_inf4 = _mm_set_epi16(0, 0, 0, 0, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN);
+  v_one = _mm_set1_epi16(TMAP_SW_FROM_I);
+  v_two = _mm_set1_epi16(TMAP_SW_FROM_D);
+  v_ins = _mm_set1_epi16(__TMAP_SW_DIR_INS_M);
+  v_del = _mm_set1_epi16(__TMAP_SW_DIR_DEL_M);
+
+  /* set first row */
+  cm = score[0][0]; cd = score[0][2];
+  cm[0] = 0;
+  dir[0] = 0;
+  for(i = 1; i < b1; i++) {
+      h = cm[i-1] - gap_open;
+      if(h > cd[i-1]) {
+          dir[i] = __TMAP_SW_DIR_DEL_M;
+          cd[i] = __tmap_sw_clamp16(h - gap_ext);
+      } else {
+          dir[i] = 0;
+          cd[i] = __tmap_sw_clamp16(cd[i-1] - gap_ext);
+      }
+  }
+
+  /* core dynamic programming, one row of the band at a time */
+  for(j = 1; j <= len2; j++) {
+      pm = score[(j-1) & 1][0]; pi = score[(j-1) & 1][1]; pd = score[(j-1) & 1][2];
+      cm = score[j & 1][0]; ci = score[j & 1][1]; cd = score[j & 1][2];
+      lo = __tmap_sw_global_lo(j, b2);
+      hi = __tmap_sw_global_hi(j, b1, len1);
+      d = dir + j * stride - lo;
+      p_row = prof[seq2[j-1]];
+
+      if(0 == lo) { /* the first column only has insertions */
+          h = pm[0] - gap_open;
+          cm[0] = cd[0] = INT16_MIN;
+          if(h > pi[0]) {
+              d[0] = __TMAP_SW_DIR_INS_M;
+              ci[0] = __tmap_sw_clamp16(h - gap_ext);
+          } else {
+              d[0] = 0;
+              ci[0] = __tmap_sw_clamp16(pi[0] - gap_ext);
+          }
+          i = 1;
+      } else {
+          cm[lo-1] = ci[lo-1] = cd[lo-1] = INT16_MIN;
+          i = lo;
+      }
+
+      for(; i <= hi; i += 8) {
+          // match, from the previous row's diagonal cells
+          vm = _mm_loadu_si128((__m128i*)(pm + i - 1));
+          vi = _mm_loadu_si128((__m128i*)(pi + i - 1));
+          vd = _mm_loadu_si128((__m128i*)(pd + i - 1));
+          v_gt_im = _mm_cmpgt_epi16(vi, vm);
+          v_gt_dm = _mm_cmpgt_epi16(vd, vm);
+          v_sel_i = _mm_and_si128(v_gt_im, _mm_cmpgt_epi16(vi, vd));
+          v_sel_d = _mm_andnot_si128(v_sel_i, _mm_or_si128(v_gt_im, v_gt_dm));
+          v_dir = _mm_or_si128(_mm_and_si128(v_sel_i, v_one), _mm_and_si128(v_sel_d, v_two));
+          vh = _mm_max_epi16(_mm_max_epi16(vm, vi), vd);
+          vh = _mm_adds_epi16(vh, _mm_loadu_si128((__m128i*)(p_row + i)));
+          _mm_storeu_si128((__m128i*)(cm + i), vh);
+
+          // insertion, from the previous row's cells
+          va = _mm_subs_epi16(_mm_loadu_si128((__m128i*)(pm + i)), v_gapo);
+          vx = _mm_loadu_si128((__m128i*)(pi + i));
+          v_dir = _mm_or_si128(v_dir, _mm_and_si128(_mm_cmpgt_epi16(va, vx), v_ins));
+          _mm_storeu_si128((__m128i*)(ci + i), _mm_subs_epi16(_mm_max_epi16(va, vx), v_gape));
+
+          // deletion, a prefix maximum across the lanes
+          vx = _mm_subs_epi16(_mm_loadu_si128((__m128i*)(cm + i - 1)), v_gapoe);
+          vx = _mm_max_epi16(vx, _mm_subs_epi16(_mm_insert_epi16(v_inf, cd[i-1], 0), v_gape));
+          vx = _mm_max_epi16(vx, _mm_subs_epi16(_mm_or_si128(_mm_slli_si128(vx, 2), v_inf1), v_gape));
+          vx = _mm_max_epi16(vx, _mm_subs_epi16(_mm_or_si128(_mm_slli_si128(vx, 4), v_inf2), v_gape2));
+          vx = _mm_max_epi16(vx, _mm_subs_epi16(_mm_or_si128(_mm_slli_si128(vx, 8), v_inf4), v_gape4));
+          _mm_storeu_si128((__m128i*)(cd + i), vx);
+          va = _mm_subs_epi16(_mm_loadu_si128((__m128i*)(cm + i - 1)), v_gapo);
+          vx = _mm_loadu_si128((__m128i*)(cd + i - 1));
+          v_dir = _mm_or_si128(v_dir, _mm_and_si128(_mm_cmpgt_epi16(va, vx), v_del));
+
+          _mm_storel_epi64((__m128i*)(d + i), _mm_packus_epi16(v_dir, v_dir));
+      }
+      // the next row reads one cell past the band
+      cm[hi+1] = ci[hi+1] = cd[hi+1] = INT16_MIN;
+  }
+
+  /* backtrace */
+  i = len1; j = len2;
+  cm = score[j & 1][0]; ci = score[j & 1][1]; cd = score[j & 1][2];
+  d = dir + j * stride - __tmap_sw_global_lo(j, b2) + i;
+  max = cm[i]; type = (*d) & __TMAP_SW_DIR_MATCH; ctype = TMAP_SW_FROM_M;
+  if(ci[i] > max) { max = ci[i]; type = ((*d) & __TMAP_SW_DIR_INS_M) ? TMAP_SW_FROM_M : TMAP_SW_FROM_I; ctype = TMAP_SW_FROM_I; }
+  if(cd[i] > max) { max = cd[i]; type = ((*d) & __TMAP_SW_DIR_DEL_M) ? TMAP_SW_FROM_M : TMAP_SW_FROM_D; ctype = TMAP_SW_FROM_D; }
+
+  p = path;
+  p->ctype = ctype; p->i = i; p->j = j;
+  ++p;
+  do {
+      switch(ctype) {
+        case TMAP_SW_FROM_M: --i; --j; break;
+        case TMAP_SW_FROM_I: --j; break;
+        case TMAP_SW_FROM_D: --i; break;
+      }
+      d = dir + j * stride - __tmap_sw_global_lo(j, b2) + i;
+      ctype = type;
+      switch(type) {
+        case TMAP_SW_FROM_M: type = (*d) & __TMAP_SW_DIR_MATCH; break;
+        case TMAP_SW_FROM_I: type = ((*d) & __TMAP_SW_DIR_INS_M) ? TMAP_SW_FROM_M : TMAP_SW_FROM_I; break;
+        case TMAP_SW_FROM_D: type = ((*d) & __TMAP_SW_DIR_DEL_M) ? TMAP_SW_FROM_M : TMAP_SW_FROM_D; break;
+      }
+      p->ctype = ctype; p->i = i; p->j = j;
+      ++p;
+  } while (i || j);
+  (*path_len) = p - path - 1;
+
+  /* free memory */
+  free(dir);
+  free(prof_buf);
+  free(prof);
+  free(buf);
+
+  return max;
+}
+
 /*************************************************
  * local alignment combined with banded strategy *
  *************************************************/
@@ -1054,7 +1277,7 @@ tmap_sw_global_banded_core(uint8_t *seq1, int32_t len1, uint8_t *seq2, int32_t l
   ap_real.band_width = ap->band_width;
   len = (len1 < len2) ? len1 : len2;
   do {
-      score_gb = tmap_sw_global_core(seq1, len1, seq2, len2, &ap_real, path, path_len, right_j);
+      score_gb = tmap_sw_global_core_simd(seq1, len1, seq2, len2, &ap_real, path, path_len, right_j);
       ap_real.band_width <<= 1; // double it
   } while(score != score_gb && ap_real.band_width <= max_bw && ap_real.band_width <= len);
   // check if we need to run it at hte maximum band width
@@ -1063,7 +1286,7 @@ tmap_sw_global_banded_core(uint8_t *seq1, int32_t len1, uint8_t *seq2, int32_t l
      && ap_real.band_width <= (max_bw << 1) 
      && ap_real.band_width <= len) {
       ap_real.band_width = max_bw;
-      score_gb = tmap_sw_global_core(seq1, len1, seq2, len2, &ap_real, path, path_len, right_j);
+      score_gb = tmap_sw_global_core_simd(seq1, len1, seq2, len2, &ap_real, path, path_len, right_j);
   }
   if(score != score_gb) {
       // NB: the vectorized smith waterman sometimes considers deletions then
@@ -1433,7 +1656,7 @@ tmap_sw_clipping_core(uint8_t *seq1, int32_t len1, uint8_t *seq2, int32_t len2,
 }
 
 uint32_t *
-tmap_sw_path2cigar(const tmap_sw_path_t *path, int32_t path_len, int32_t *n_cigar)
+tmap_sw_path2cigar(const tmap_sw_path_t *path, int32_t path_len, int32_t *n_cigar, tmap_arena_t *arena)
 {
   int32_t i, n;
   uint32_t *cigar;
@@ -1450,7 +1673,7 @@ tmap_sw_path2cigar(const tmap_sw_path_t *path, int32_t path_len, int32_t *n_ciga
       last_type = path[i].ctype;
   }
   *n_cigar = n;
-  cigar = tmap_malloc(*n_cigar * 4, "cigar");
+  cigar = tmap_arena_malloc(arena, *n_cigar * 4, "cigar");
 
   TMAP_SW_CIGAR_STORE(cigar[0], path[path_len-1].ctype, 1u);
   last_type = path[path_len-1].ctype;
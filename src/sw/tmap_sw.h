@@ -28,6 +28,7 @@
 #define TMAP_SW_H
 
 #include <stdint.h>
+#include "../util/tmap_arena.h"
 
 #define TMAP_SW_CIGAR_OP(_cigar) (((_cigar) & 0xf))
 #define TMAP_SW_CIGAR_LENGTH(_cigar) (((_cigar) >> 4))
@@ -165,6 +166,31 @@ tmap_sw_global_core(uint8_t *seq1, int32_t len1,
                     tmap_sw_path_t *path, int32_t *path_len,
                     int32_t right_j);
 
+/*!
+  Performs the global Smith-Waterman alignment using SSE2 across each band row.
+  @details          the recurrence, banding, and tie-breaking are identical to
+  tmap_sw_global_core, but the scores are kept in 16-bit lanes and the cell
+  origins in one byte per cell (two bits for the match origin, one bit each for
+  whether the insertion and deletion were opened from a match).  Falls back to
+  tmap_sw_global_core when the scores may not fit in 16 bits, when right_j is
+  set, or when end gap penalties are used.
+  @param  seq1      the first DNA sequence (in 2-bit format)
+  @param  len1      the length of the first sequence
+  @param  seq2      the second DNA sequence (in 2-bit format)
+  @param  len2      the length of the second sequence
+  @param  ap        the alignment parameters
+  @param  path      the Smith-Waterman alignment path
+  @param  path_len  the Smith-Waterman alignment path length
+  @param  right_j   0 if we are to left-justify indels, 1 otherwise
+  @return           the alignment score, 0 if none was found
+  */
+int32_t
+tmap_sw_global_core_simd(uint8_t *seq1, int32_t len1,
+                         uint8_t *seq2, int32_t len2,
+                         const tmap_sw_param_t *ap,
+                         tmap_sw_path_t *path, int32_t *path_len,
+                         int32_t right_j);
+
 /*!
   Performs the local Smith-Waterman alignment.
   @details          actually, it performs it with banding.
@@ -285,10 +311,11 @@ tmap_sw_fitting_core(uint8_t *seq1, int32_t len1, uint8_t *seq2, int32_t len2, c
   @param  path      the Smith-Waterman alignment path
   @param  path_len  the Smith-Waterman alignment path length
   @param  n_cigar   pointer to the returned number of cigar operations
+  @param  arena     the arena for the cigar array, NULL to use the heap
   @return           the cigar array, NULL if the path is NULL or the path length is zero 
   */
 uint32_t *
-tmap_sw_path2cigar(const tmap_sw_path_t *path, int32_t path_len, int32_t *n_cigar);
+tmap_sw_path2cigar(const tmap_sw_path_t *path, int32_t path_len, int32_t *n_cigar, tmap_arena_t *arena);
 
 
 /********************
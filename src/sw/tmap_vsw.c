@@ -51,6 +51,12 @@ tmap_vsw_init(const uint8_t *query, int32_t qlen,
   vsw->opt = opt;
   vsw->algorithm = tmap_vsw_wrapper_init(type);
   vsw->algorithm_default = tmap_vsw_wrapper_init(1);
+  // keep the query profile for the alignments of this query
+  if(NULL != query && 0 < qlen && NULL != opt) {
+      tmap_vsw_wrapper_set_query(vsw->algorithm, query, qlen,
+                                 opt->score_match, -opt->pen_mm, -opt->pen_gapo, -opt->pen_gape,
+                                 query_start_clip, query_end_clip);
+  }
   return vsw;
 }
 
@@ -179,7 +185,7 @@ tmap_vsw_process_compare(tmap_vsw_t *vsw,
                                         vsw->query_start_clip, vsw->query_end_clip, 
                                         path, &path_len, dir);
           // print out the path
-          cigar = tmap_sw_path2cigar(path, path_len, &n_cigar);
+          cigar = tmap_sw_path2cigar(path, path_len, &n_cigar, NULL);
           fprintf(stderr, "tmap_sw_clipping_core score=%d\n", score);
           for(i=0;i<n_cigar;i++) {
               fprintf(stderr, "%d%c", cigar[i]>>4, "MIDNSHP"[cigar[i]&0xf]);
@@ -21,10 +21,11 @@
 #include "../map/util/tmap_map_util.h"
 
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-void
+uint64_t
 tmap_vsw_bm_core(int32_t seq_len, int32_t tlen, int32_t n_iter,
                  int32_t n_sub_iter, int32_t vsw_type)
 {
+  uint64_t checksum = 0;
   int32_t i, j, k;
   tmap_vsw_t *vsw = NULL;
   tmap_vsw_opt_t *vsw_opt = NULL;
@@ -60,6 +61,7 @@ tmap_vsw_bm_core(int32_t seq_len, int32_t tlen, int32_t n_iter,
 
   int32_t front = (tlen - seq_len) / 2;
   int32_t end = tlen - seq_len - front;
+  i = 0;
   while(i<n_iter) {
       tmap_map_sam_t tmp_sam;
       int32_t overflow;
@@ -80,6 +82,9 @@ tmap_vsw_bm_core(int32_t seq_len, int32_t tlen, int32_t n_iter,
               // run the vsw
               tmap_vsw_process_fwd(vsw, seq, seq_len, target, tlen,
                             &tmp_sam.result, &overflow, opt->score_thr, 0);
+              checksum = (checksum * 31) + (uint32_t)tmp_sam.result.score_fwd;
+              checksum = (checksum * 31) + (uint32_t)tmp_sam.result.query_end;
+              checksum = (checksum * 31) + (uint32_t)tmp_sam.result.target_end;
           }
           else {
               tmap_sw_clipping_core(seq, seq_len, target, tlen,
@@ -98,11 +103,13 @@ tmap_vsw_bm_core(int32_t seq_len, int32_t tlen, int32_t n_iter,
   }
   tmap_map_opt_destroy(opt);
   tmap_rand_destroy(rand);
+
+  return checksum;
 }
 
 static int
 usage(int32_t seq_len, int32_t tlen, int32_t n_iter, 
-      int32_t n_sub_iter, int32_t vsw_type)
+      int32_t n_sub_iter, int32_t vsw_type, int32_t simd)
 {
   tmap_file_fprintf(tmap_file_stderr, "\n");
   tmap_file_fprintf(tmap_file_stderr, "Usage: %s vswbm [options]", PACKAGE);
@@ -113,6 +120,8 @@ usage(int32_t seq_len, int32_t tlen, int32_t n_iter,
   tmap_file_fprintf(tmap_file_stderr, "         -n INT      the number of iterations [%d]\n", n_iter);
   tmap_file_fprintf(tmap_file_stderr, "         -N INT      the number of re-evaluations of the same query/target combination [%d]\n", n_sub_iter);
   tmap_file_fprintf(tmap_file_stderr, "         -H INT      smith waterman algorithm [%d]\n", vsw_type);
+  tmap_file_fprintf(tmap_file_stderr, "         -s INT      the SIMD instruction set for -H 1 (-1 the widest supported, 0 SSE2, 1 AVX2, 2 AVX-512BW) [%d]\n", simd);
+  tmap_file_fprintf(tmap_file_stderr, "         -A          compare every SIMD instruction set for -H 1\n");
   tmap_file_fprintf(tmap_file_stderr, "Options (optional):\n");
   tmap_file_fprintf(tmap_file_stderr, "         -h          print this message\n");
   tmap_file_fprintf(tmap_file_stderr, "\n");
@@ -128,9 +137,10 @@ tmap_vswbm_main(int argc, char *argv[])
   int32_t n_iter = 1000;
   int32_t n_sub_iter = 1;
   int32_t vsw_type = 0;
+  int32_t simd = -1, compare_simd = 0;
   int c;
 
-  while((c = getopt(argc, argv, "q:t:n:N:H:h")) >= 0) {
+  while((c = getopt(argc, argv, "q:t:n:N:H:s:Ah")) >= 0) {
       switch(c) {
         case 'q':
           seq_len = atoi(optarg); break;
@@ -142,19 +152,47 @@ tmap_vswbm_main(int argc, char *argv[])
           n_sub_iter = atoi(optarg); break;
         case 'H':
           vsw_type = atoi(optarg); break;
+        case 's':
+          simd = atoi(optarg); break;
+        case 'A':
+          compare_simd = 1; break;
         case 'h':
         default:
-          return usage(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
+          return usage(seq_len, tlen, n_iter, n_sub_iter, vsw_type, simd);
       }
   }
   if(argc != optind || seq_len > tlen) {
-      return usage(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
+      return usage(seq_len, tlen, n_iter, n_sub_iter, vsw_type, simd);
+  }
+  if(-1 != simd && 0 == tmap_vsw_wrapper_simd_supported(simd)) {
+      tmap_error("the SIMD instruction set given by -s is not supported", Exit, CommandLineArgument);
   }
 
   tmap_progress_set_verbosity(1);
   tmap_progress_print2("starting benchmark");
 
-  tmap_vsw_bm_core(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
+  if(1 == compare_simd) {
+      uint64_t checksum, checksum_sse2 = 0;
+      clock_t start_time;
+      for(simd = 0; simd < TMAP_VSW_SIMD_NUM; simd++) {
+          if(0 == tmap_vsw_wrapper_simd_supported(simd)) {
+              tmap_progress_print2("%s is not supported", tmap_vsw_wrapper_simd_name(simd));
+              continue;
+          }
+          tmap_vsw_wrapper_simd_set(simd);
+          start_time = clock();
+          checksum = tmap_vsw_bm_core(seq_len, tlen, n_iter, n_sub_iter, 1);
+          tmap_progress_print1("%s", start_time, tmap_vsw_wrapper_simd_name(simd));
+          if(0 == simd) checksum_sse2 = checksum;
+          else if(checksum != checksum_sse2) {
+              tmap_error("the alignments differ from those with SSE2", Warn, OutOfRange);
+          }
+      }
+  }
+  else {
+      if(-1 != simd) tmap_vsw_wrapper_simd_set(simd);
+      tmap_vsw_bm_core(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
+  }
   
   tmap_progress_print2("ending benchmark");
 
@@ -49,6 +49,8 @@ static tmap_command_t commands[] = {
       {tmap_refseq_refinfo_main, "refinfo", "prints information about the reference", TMAP_COMMAND_UTILITIES},
       {tmap_refseq_pac2fasta_main, "pac2fasta", "converts a packed FASTA to a FASTA file", TMAP_COMMAND_UTILITIES},
       {tmap_bwt_bwtupdate_main, "bwtupdate", "updates the bwt hash width", TMAP_COMMAND_UTILITIES},
+      {tmap_bwt_kmer_main, "bwtkmer", "creates the k-mer prefix table file from the BWT string file", TMAP_COMMAND_UTILITIES},
+      {tmap_seed_hash_main, "seedhash", "creates the seed hash file from the packed reference file", TMAP_COMMAND_UTILITIES},
       {tmap_index_size, "indexsize", "gives the index size in bytes", TMAP_COMMAND_UTILITIES},
 #ifdef HAVE_SAMTOOLS
       {tmap_sam2fs_main, "sam2fs", "pretty print SAM records in flow space", TMAP_COMMAND_UTILITIES},
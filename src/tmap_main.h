@@ -62,6 +62,10 @@ extern int
 tmap_refseq_pac2fasta_main(int argc, char *argv[]);
 extern int
 tmap_bwt_bwtupdate_main(int argc, char *argv[]);
+extern int
+tmap_bwt_kmer_main(int argc, char *argv[]);
+extern int
+tmap_seed_hash_main(int argc, char *argv[]);
 extern int 
 tmap_index_size(int argc, char *argv[]);
 #ifdef HAVE_SAMTOOLS
@@ -0,0 +1,147 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "tmap_alloc.h"
+#include "tmap_error.h"
+#include "tmap_arena.h"
+
+#define __tmap_arena_roundup(_size) (((_size) + TMAP_ARENA_ALIGN - 1) & ~((size_t)TMAP_ARENA_ALIGN - 1))
+
+// the size of the block header, keeping the memory that follows aligned
+#define __tmap_arena_header_size __tmap_arena_roundup(sizeof(tmap_arena_block_t))
+
+#define __tmap_arena_block_mem(_block) ((uint8_t*)(_block) + __tmap_arena_header_size)
+
+static tmap_arena_block_t *
+tmap_arena_block_init(size_t size, tmap_arena_block_t *next, const char *function_name, const char *variable_name)
+{
+  tmap_arena_block_t *block = NULL;
+  block = tmap_malloc1(__tmap_arena_header_size + size, function_name, variable_name);
+  block->next = next;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+tmap_arena_t *
+tmap_arena_init(size_t block_size)
+{
+  tmap_arena_t *arena = NULL;
+  arena = tmap_calloc(1, sizeof(tmap_arena_t), "arena");
+  arena->block_size = __tmap_arena_roundup(block_size);
+  if(0 == arena->block_size) arena->block_size = TMAP_ARENA_BLOCK_SIZE;
+  arena->block = tmap_arena_block_init(arena->block_size, NULL, __func__, "arena->block");
+  arena->total = arena->block_size;
+  arena->last = NULL;
+  return arena;
+}
+
+void *
+tmap_arena_malloc1(tmap_arena_t *arena, size_t size, const char *function_name, const char *variable_name)
+{
+  tmap_arena_block_t *block = NULL;
+  void *ptr = NULL;
+
+  if(NULL == arena) return tmap_malloc1(size, function_name, variable_name);
+
+  size = __tmap_arena_roundup(size);
+  block = arena->block;
+  if(block->size - block->used < size) { // a new block
+      size_t block_size = arena->block_size;
+      // grow geometrically so that a reset coalesces into few blocks
+      if(block_size < arena->total) block_size = arena->total;
+      if(block_size < size) block_size = __tmap_arena_roundup(size);
+      block = arena->block = tmap_arena_block_init(block_size, block, function_name, variable_name);
+      arena->total += block_size;
+  }
+  ptr = __tmap_arena_block_mem(block) + block->used;
+  block->used += size;
+  arena->last = ptr;
+  return ptr;
+}
+
+void *
+tmap_arena_calloc1(tmap_arena_t *arena, size_t num, size_t size, const char *function_name, const char *variable_name)
+{
+  void *ptr = NULL;
+  if(NULL == arena) return tmap_calloc1(num, size, function_name, variable_name);
+  ptr = tmap_arena_malloc1(arena, num * size, function_name, variable_name);
+  memset(ptr, 0, num * size);
+  return ptr;
+}
+
+void *
+tmap_arena_realloc1(tmap_arena_t *arena, void *ptr, size_t old_size, size_t size, const char *function_name, const char *variable_name)
+{
+  tmap_arena_block_t *block = NULL;
+  void *new_ptr = NULL;
+
+  if(NULL == arena) return tmap_realloc1(ptr, size, function_name, variable_name);
+  if(NULL == ptr) return tmap_arena_malloc1(arena, size, function_name, variable_name);
+  if(size <= old_size) return ptr;
+
+  // grow the last memory handed out in place
+  block = arena->block;
+  if(ptr == arena->last) {
+      size_t start = (uint8_t*)ptr - __tmap_arena_block_mem(block);
+      if(__tmap_arena_roundup(size) <= block->size - start) {
+          block->used = start + __tmap_arena_roundup(size);
+          return ptr;
+      }
+  }
+
+  // copy
+  new_ptr = tmap_arena_malloc1(arena, size, function_name, variable_name);
+  memcpy(new_ptr, ptr, old_size);
+  return new_ptr;
+}
+
+void
+tmap_arena_free(tmap_arena_t *arena, void *ptr)
+{
+  if(NULL == arena) free(ptr);
+  // NB: arena memory is reclaimed upon reset
+}
+
+void
+tmap_arena_reset(tmap_arena_t *arena)
+{
+  tmap_arena_block_t *block = NULL;
+  size_t size;
+
+  if(NULL == arena) return;
+
+  // do not let one large read pin its memory for the rest of the run
+  size = arena->total;
+  if(TMAP_ARENA_RETAIN_BLOCKS * arena->block_size < size) {
+      size = TMAP_ARENA_RETAIN_BLOCKS * arena->block_size;
+  }
+
+  if(NULL != arena->block->next || size < arena->block->size) { // coalesce into one block
+      while(NULL != arena->block) {
+          block = arena->block;
+          arena->block = block->next;
+          free(block);
+      }
+      arena->block = tmap_arena_block_init(size, NULL, __func__, "arena->block");
+      arena->total = size;
+  }
+  arena->block->used = 0;
+  arena->last = NULL;
+}
+
+void
+tmap_arena_destroy(tmap_arena_t *arena)
+{
+  tmap_arena_block_t *block = NULL;
+
+  if(NULL == arena) return;
+
+  while(NULL != arena->block) {
+      block = arena->block;
+      arena->block = block->next;
+      free(block);
+  }
+  free(arena);
+}
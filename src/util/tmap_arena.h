@@ -0,0 +1,146 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef TMAP_ARENA_H
+#define TMAP_ARENA_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*!
+  A bump-pointer memory arena for short-lived scratch memory.
+  */
+
+/*!
+  The default number of bytes in the first block of an arena
+  */
+#define TMAP_ARENA_BLOCK_SIZE (1 << 16)
+
+/*!
+  The most memory, in multiples of the block size, an arena keeps upon reset
+  */
+#define TMAP_ARENA_RETAIN_BLOCKS 64
+
+/*!
+  The alignment, in bytes, of memory returned by an arena
+  */
+#define TMAP_ARENA_ALIGN 16
+
+/*!
+  A block of arena memory; the memory follows the block header
+  */
+typedef struct __tmap_arena_block_t {
+    struct __tmap_arena_block_t *next; /*!< the previously allocated block */
+    size_t size; /*!< the number of bytes available in this block */
+    size_t used; /*!< the number of bytes used in this block */
+} tmap_arena_block_t;
+
+/*!
+  A bump-pointer memory arena
+  @details  memory is never returned to the arena individually; all memory is
+  reclaimed at once with tmap_arena_reset
+  */
+typedef struct {
+    tmap_arena_block_t *block; /*!< the current block, linked to the previous blocks */
+    size_t block_size; /*!< the minimum size of a new block */
+    size_t total; /*!< the total number of bytes held by all blocks */
+    void *last; /*!< the last memory handed out, which may be grown in place */
+} tmap_arena_t;
+
+/*!
+  wrapper for tmap_arena_malloc1
+  @param  _arena          the arena, NULL to use the heap
+  @param  _size           the size of the memory block, in bytes
+  @param  _variable_name  the variable name to be assigned this memory in the calling function
+  @return                 a pointer to the memory block
+  */
+#define tmap_arena_malloc(_arena, _size, _variable_name) \
+  tmap_arena_malloc1(_arena, _size, __func__, _variable_name)
+
+/*!
+  wrapper for tmap_arena_calloc1
+  @param  _arena          the arena, NULL to use the heap
+  @param  _num            the number of elements to be allocated
+  @param  _size           the size of each element, in bytes
+  @param  _variable_name  the variable name to be assigned this memory in the calling function
+  @return                 a pointer to the zeroed memory block
+  */
+#define tmap_arena_calloc(_arena, _num, _size, _variable_name) \
+  tmap_arena_calloc1(_arena, _num, _size, __func__, _variable_name)
+
+/*!
+  wrapper for tmap_arena_realloc1
+  @param  _arena          the arena, NULL to use the heap
+  @param  _ptr            the memory to be reallocated, NULL to allocate new memory
+  @param  _old_size       the current size of the memory block, in bytes
+  @param  _size           the new size of the memory block, in bytes
+  @param  _variable_name  the variable name to be assigned this memory in the calling function
+  @return                 a pointer to the memory block
+  */
+#define tmap_arena_realloc(_arena, _ptr, _old_size, _size, _variable_name) \
+  tmap_arena_realloc1(_arena, _ptr, _old_size, _size, __func__, _variable_name)
+
+/*!
+  @param  block_size  the size of the first block, in bytes
+  @return             a new arena
+  */
+tmap_arena_t *
+tmap_arena_init(size_t block_size);
+
+/*!
+  @param  arena          the arena, NULL to use the heap
+  @param  size           the size of the memory block, in bytes
+  @param  function_name  the calling function name
+  @param  variable_name  the variable name to be assigned this memory in the calling function
+  @return                a pointer to the memory block
+  */
+void *
+tmap_arena_malloc1(tmap_arena_t *arena, size_t size, const char *function_name, const char *variable_name);
+
+/*!
+  @param  arena          the arena, NULL to use the heap
+  @param  num            the number of elements to be allocated
+  @param  size           the size of each element, in bytes
+  @param  function_name  the calling function name
+  @param  variable_name  the variable name to be assigned this memory in the calling function
+  @return                a pointer to the zeroed memory block
+  */
+void *
+tmap_arena_calloc1(tmap_arena_t *arena, size_t num, size_t size, const char *function_name, const char *variable_name);
+
+/*!
+  @param  arena          the arena, NULL to use the heap
+  @param  ptr            the memory to be reallocated, NULL to allocate new memory
+  @param  old_size       the current size of the memory block, in bytes
+  @param  size           the new size of the memory block, in bytes
+  @param  function_name  the calling function name
+  @param  variable_name  the variable name to be assigned this memory in the calling function
+  @return                a pointer to the memory block
+  @details               the last memory handed out is grown in place when possible
+  */
+void *
+tmap_arena_realloc1(tmap_arena_t *arena, void *ptr, size_t old_size, size_t size, const char *function_name, const char *variable_name);
+
+/*!
+  @param  arena  the arena, NULL if the memory came from the heap
+  @param  ptr    the memory to free
+  @details       memory from an arena is only reclaimed upon tmap_arena_reset
+  */
+void
+tmap_arena_free(tmap_arena_t *arena, void *ptr);
+
+/*!
+  Reclaims all the memory handed out by the arena
+  @param  arena  the arena
+  @details       if more than one block was needed, the blocks are replaced
+  by a single block large enough to hold them all, but no larger than
+  TMAP_ARENA_RETAIN_BLOCKS times the block size
+  */
+void
+tmap_arena_reset(tmap_arena_t *arena);
+
+/*!
+  @param  arena  the arena to destroy
+  */
+void
+tmap_arena_destroy(tmap_arena_t *arena);
+
+#endif
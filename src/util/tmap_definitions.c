@@ -193,6 +193,21 @@ inline uint32_t tmap_log2(uint32_t v)
   return c;
 }
 
+tmap_bwt_int_t *
+tmap_bwt_int_pack32(tmap_bwt_int_t *a, uint64_t n)
+{
+  uint64_t i;
+  tmap_bwt_int_t v;
+  uint32_t w;
+  // NB: the i-th 32-bit value overlaps values at or before the i-th, already read
+  for(i=0;i<n;i++) {
+      memcpy(&v, (uint8_t*)a + i*sizeof(tmap_bwt_int_t), sizeof(tmap_bwt_int_t));
+      w = (uint32_t)v; // TMAP_BWT_INT_MAX becomes UINT32_MAX
+      memcpy((uint8_t*)a + i*sizeof(uint32_t), &w, sizeof(uint32_t));
+  }
+  return tmap_realloc(a, sizeof(uint32_t) * (0 < n ? n : 1), "a");
+}
+
 inline char *
 tmap_get_file_name(const char *prefix, int32_t type)
 {
@@ -221,6 +236,16 @@ tmap_get_file_name(const char *prefix, int32_t type)
       strcpy(fn, prefix);
       strcat(fn, TMAP_SA_FILE_EXTENSION);
       break;
+    case TMAP_KMER_FILE:
+      fn = tmap_malloc(sizeof(char)*(1+strlen(prefix)+strlen(TMAP_KMER_FILE_EXTENSION)), "fn");
+      strcpy(fn, prefix);
+      strcat(fn, TMAP_KMER_FILE_EXTENSION);
+      break;
+    case TMAP_SEED_FILE:
+      fn = tmap_malloc(sizeof(char)*(1+strlen(prefix)+strlen(TMAP_SEED_FILE_EXTENSION)), "fn");
+      strcpy(fn, prefix);
+      strcat(fn, TMAP_SEED_FILE_EXTENSION);
+      break;
     default:
       return NULL;
   }
@@ -33,6 +33,14 @@
   the file extension for the SA structure
   */
 #define TMAP_SA_FILE_EXTENSION ".tmap.sa"
+/*! d TMAP_KMER_FILE_EXTENSION
+  the file extension for the k-mer prefix table of the BWT
+  */
+#define TMAP_KMER_FILE_EXTENSION ".tmap.kmer"
+/*! d TMAP_SEED_FILE_EXTENSION
+  the file extension for the seed hash of the reference sequence
+  */
+#define TMAP_SEED_FILE_EXTENSION ".tmap.seed"
 
 // The default compression types for each file
 // Note: the implementation relies on no compression
@@ -40,6 +48,8 @@
 #define TMAP_PAC_COMPRESSION TMAP_FILE_NO_COMPRESSION 
 #define TMAP_BWT_COMPRESSION TMAP_FILE_NO_COMPRESSION 
 #define TMAP_SA_COMPRESSION TMAP_FILE_NO_COMPRESSION
+#define TMAP_KMER_COMPRESSION TMAP_FILE_NO_COMPRESSION
+#define TMAP_SEED_COMPRESSION TMAP_FILE_NO_COMPRESSION
 
 /*
    CIGAR operations, from samtools.
@@ -72,6 +82,8 @@ enum {
     TMAP_PAC_FILE      = 1, /*!< the packed forward reference sequence file */
     TMAP_BWT_FILE      = 2, /*!< the packed BWT file */
     TMAP_SA_FILE       = 3, /*!< the packed SA file */
+    TMAP_KMER_FILE     = 4, /*!< the k-mer prefix table file */
+    TMAP_SEED_FILE     = 5, /*!< the seed hash file */
 };
 
 /*! 
@@ -99,6 +111,24 @@ typedef int64_t tmap_bwt_sint_t;
 #define TMAP_BWT_SINT_MAX INT64_MAX 
 #endif
 
+/*!
+  The largest BWT sequence length whose SA positions and intervals are stored
+  in 32 bits, UINT32_MAX being reserved for TMAP_BWT_INT_MAX
+  */
+#define TMAP_BWT_INT32_MAX_LEN (UINT32_MAX - 2)
+
+/*!
+  @param  _seq_len  the BWT sequence length
+  @return           the width in bits with which the SA positions and intervals are stored
+  */
+#define tmap_bwt_int_width(_seq_len) (((_seq_len) <= TMAP_BWT_INT32_MAX_LEN) ? 32 : 64)
+
+/*!
+  @param  _v  a SA position or interval stored in 32 bits
+  @return     the SA position or interval
+  */
+#define tmap_bwt_int_from32(_v) ((UINT32_MAX == (_v)) ? TMAP_BWT_INT_MAX : (tmap_bwt_int_t)(_v))
+
 /* For branch prediction */
 #ifdef __GNUC__
 #define TMAP_LIKELY(x) __builtin_expect((x),1)
@@ -229,6 +259,15 @@ tmap_reads_format_to_seq_type(int32_t reads_format);
 inline uint32_t 
 tmap_log2(uint32_t v);
 
+/*!
+  stores SA positions or intervals in 32 bits, in place
+  @param  a  the values, allocated with tmap_malloc
+  @param  n  the number of values
+  @return    the reallocated values, to be read as 32-bit values
+  */
+tmap_bwt_int_t *
+tmap_bwt_int_pack32(tmap_bwt_int_t *a, uint64_t n);
+
 /*! 
   gets the name of a specific file based on the reference sequence
   @param  prefix   the prefix of the file to be written, usually the fasta file name 
@@ -5,6 +5,9 @@
 #include <string.h>
 #include <time.h>
 #include <config.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include "tmap_error.h"
 #include "tmap_time.h"
@@ -15,6 +18,9 @@ static char tmap_progress_command[1024]="(null)";
 static clock_t tmap_progress_start_time=0;
 static int32_t tmap_progress_verbosity=0;
 static double tmap_progress_start_realtime=0;
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t tmap_progress_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 void 
 tmap_progress_set_command(const char *command)
@@ -49,6 +55,10 @@ tmap_progress_vprint1(const char *format, clock_t start_time, va_list ap)
   static char tmap_progress_format[2048]="\0";
   
   if(0 != tmap_progress_verbosity) {
+#ifdef HAVE_LIBPTHREAD
+      // NB: the format buffer is shared, and progress may be printed from multiple threads
+      pthread_mutex_lock(&tmap_progress_mutex);
+#endif
       if(0 <= (float)start_time) {
           if(sprintf(tmap_progress_format, "[%s] %.2f/%.2f sec: ", 
                      tmap_progress_command, 
@@ -66,6 +76,9 @@ tmap_progress_vprint1(const char *format, clock_t start_time, va_list ap)
       strcat(tmap_progress_format, ".\n");
 
       tmap_file_vfprintf(tmap_file_stderr, tmap_progress_format, ap);
+#ifdef HAVE_LIBPTHREAD
+      pthread_mutex_unlock(&tmap_progress_mutex);
+#endif
   }
 }
 
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <time.h>
 #include "tmap_time.h"
 
 double 
@@ -45,3 +46,11 @@ tmap_time_realtime()
   gettimeofday(&tp, &tzp);
   return tp.tv_sec + tp.tv_usec * 1e-6;
 }
+
+uint64_t
+tmap_time_nanoseconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
@@ -2,6 +2,8 @@
 #ifndef TMAP_TIME_H
 #define TMAP_TIME_H
 
+#include <stdint.h>
+
 /*! 
   CPU and Realtime timing
   */
@@ -18,4 +20,10 @@ tmap_time_cputime();
 double 
 tmap_time_realtime();
 
+/*!
+  @return returns the time of a monotonic clock in nanoseconds, for timing short intervals.
+ */
+uint64_t
+tmap_time_nanoseconds();
+
 #endif